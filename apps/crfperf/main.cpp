@@ -0,0 +1,148 @@
+/**
+ * crfperf: main.cpp
+ * Copyright (c) Torr Vision Group, University of Oxford, 2017. All rights reserved.
+ */
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+#include <boost/lexical_cast.hpp>
+
+#include <infermous/engines/DenseMeanFieldInferenceEngine.h>
+#include <infermous/engines/FullyConnectedMeanFieldInferenceEngine.h>
+#include <infermous/engines/MeanFieldInferenceEngine.h>
+using namespace infermous;
+
+#include <tvgutil/numbers/RandomNumberGenerator.h>
+#include <tvgutil/timing/Timer.h>
+using namespace tvgutil;
+
+//#################### TYPEDEFS ####################
+
+typedef int Label;
+
+//#################### NESTED TYPES ####################
+
+/**
+ * \brief An instance of this struct calculates Potts pairwise potentials.
+ */
+struct PottsPotentialCalculator : PairwisePotentialCalculator<Label>
+{
+  /** Override */
+  virtual float calculate_potential(const Label& l1, const Label& l2) const
+  {
+    return l1 == l2 ? 0.0f : 1.0f;
+  }
+};
+
+//#################### FUNCTIONS ####################
+
+/**
+ * \brief Calculates the percentage of pixels whose predicted labels match the ground truth.
+ *
+ * \param predicted   The predicted labels.
+ * \param groundTruth The ground truth labels.
+ * \return            The percentage of pixels whose predicted labels match the ground truth.
+ */
+float calculate_accuracy(const Grid<Label>& predicted, const Grid<Label>& groundTruth)
+{
+  return 100.0f * (predicted.array() == groundTruth.array()).count() / groundTruth.size();
+}
+
+/**
+ * \brief Outputs a line of the benchmark results.
+ *
+ * \param name        The name of the benchmarked configuration.
+ * \param timer       The timer for the inference.
+ * \param iterations  The number of iterations of inference that were run.
+ * \param accuracy    The percentage of pixels that were labelled correctly after inference.
+ */
+void output_result(const std::string& name, const Timer<boost::chrono::milliseconds>& timer, size_t iterations, float accuracy)
+{
+  std::cout << std::left << std::setw(32) << name << std::right
+            << std::setw(10) << timer.duration().count() / static_cast<double>(iterations) << " ms/iteration"
+            << std::setw(10) << std::fixed << std::setprecision(2) << accuracy << "% correct\n";
+}
+
+int main(int argc, char *argv[])
+{
+  if(argc != 1 && argc != 4)
+  {
+    std::cerr << "Usage: crfperf [<width> <height> <iterations>]\n";
+    return EXIT_FAILURE;
+  }
+
+  const int width = argc == 4 ? boost::lexical_cast<int>(argv[1]) : 320;
+  const int height = argc == 4 ? boost::lexical_cast<int>(argv[2]) : 240;
+  const size_t iterations = argc == 4 ? boost::lexical_cast<size_t>(argv[3]) : 5;
+  const int labelCount = 3;
+  const unsigned int seed = 12345;
+
+  // Make a synthetic scene consisting of a disc of one label in front of a background split between two other labels, together with
+  // a noisy colour image and noisy unaries in which a random subset of the pixels favour the wrong label.
+  RandomNumberGenerator rng(seed);
+  const Eigen::Vector3f labelColours[labelCount] = { Eigen::Vector3f(200, 40, 40), Eigen::Vector3f(40, 200, 40), Eigen::Vector3f(40, 40, 200) };
+
+  Grid<Label> groundTruth(height, width);
+  Grid<Eigen::Vector3f> colours(height, width);
+  ProbabilitiesGrid_Ptr<Label> unaries(new ProbabilitiesGrid<Label>(height, width));
+  for(int y = 0; y < height; ++y)
+  {
+    for(int x = 0; x < width; ++x)
+    {
+      const float dx = x - width / 2.0f, dy = y - height / 2.0f, radius = std::min(width, height) / 3.0f;
+      const Label label = dx * dx + dy * dy < radius * radius ? 2 : x < width / 2 ? 0 : 1;
+      groundTruth(y, x) = label;
+
+      Eigen::Vector3f& colour = colours(y, x);
+      for(int c = 0; c < 3; ++c) colour[c] = labelColours[label][c] + rng.generate_real_from_uniform<float>(-20.0f, 20.0f);
+
+      const Label favouredLabel = rng.generate_real_from_uniform<float>(0.0f, 1.0f) < 0.3f ? rng.generate_int_from_uniform(0, labelCount - 1) : label;
+      std::map<Label,float>& psi = (*unaries)(y, x);
+      for(Label l = 0; l < labelCount; ++l) psi[l] = l == favouredLabel ? 0.5f : 0.25f;
+    }
+  }
+
+  PairwisePotentialCalculator_CPtr<Label> ppc(new PottsPotentialCalculator);
+
+  {
+    CRF2D<Label> crf(unaries, ppc);
+    std::cout << "Image size: " << width << 'x' << height << ", iterations: " << iterations << '\n';
+    std::cout << std::left << std::setw(32) << "Unaries only" << std::right << std::setw(34) << std::fixed << std::setprecision(2)
+              << calculate_accuracy(crf.predict_labels(), groundTruth) << "% correct\n";
+  }
+
+  // Benchmark the local engines for a range of neighbourhood sizes. The cost of these grows with the size of the neighbourhood.
+  const int radii[] = { 1, 3, 5 };
+  for(size_t i = 0; i < sizeof(radii) / sizeof(int); ++i)
+  {
+    const std::vector<Eigen::Vector2i> neighbourOffsets = CRFUtil::make_circular_neighbour_offsets(radii[i]);
+    const std::string suffix = " (r = " + boost::lexical_cast<std::string>(radii[i]) + ")";
+
+    {
+      CRF2D_Ptr<Label> crf(new CRF2D<Label>(ProbabilitiesGrid_Ptr<Label>(new ProbabilitiesGrid<Label>(*unaries)), ppc));
+      MeanFieldInferenceEngine<Label> engine(crf, neighbourOffsets);
+      TIME(engine.update_crf(iterations), milliseconds, meanField);
+      output_result("MeanField" + suffix, meanField, iterations, calculate_accuracy(crf->predict_labels(), groundTruth));
+    }
+
+    {
+      CRF2D_Ptr<Label> crf(new CRF2D<Label>(ProbabilitiesGrid_Ptr<Label>(new ProbabilitiesGrid<Label>(*unaries)), ppc));
+      DenseMeanFieldInferenceEngine<Label> engine(crf, neighbourOffsets);
+      TIME(engine.update_crf(iterations), milliseconds, denseMeanField);
+      output_result("DenseMeanField" + suffix, denseMeanField, iterations, calculate_accuracy(engine.predict_labels(), groundTruth));
+    }
+  }
+
+  // Benchmark the fully-connected engine, whose cost does not depend on the extent of its kernels.
+  {
+    CRF2D_Ptr<Label> crf(new CRF2D<Label>(ProbabilitiesGrid_Ptr<Label>(new ProbabilitiesGrid<Label>(*unaries)), ppc));
+    TIME(FullyConnectedMeanFieldInferenceEngine<Label> engine(crf, colours), milliseconds, latticeConstruction);
+    TIME(engine.update_crf(iterations), milliseconds, fullyConnectedMeanField);
+    std::cout << latticeConstruction << '\n';
+    output_result("FullyConnectedMeanField", fullyConnectedMeanField, iterations, calculate_accuracy(engine.predict_labels(), groundTruth));
+  }
+
+  return 0;
+}
@@ -0,0 +1,64 @@
+/**
+ * raflconvert: main.cpp
+ * Copyright (c) Torr Vision Group, University of Oxford, 2017. All rights reserved.
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <map>
+
+#include <rafl/examples/ExampleUtil.h>
+using namespace rafl;
+
+//#################### TYPEDEFS ####################
+
+typedef int Label;
+typedef boost::shared_ptr<const Example<Label> > Example_CPtr;
+
+//#################### FUNCTIONS ####################
+
+int main(int argc, char *argv[])
+try
+{
+  if(argc != 3)
+  {
+    std::cerr << "Usage: raflconvert <text example file> <binary example file>\n";
+    return EXIT_FAILURE;
+  }
+
+  const std::string textFilename = argv[1];
+  const std::string binaryFilename = argv[2];
+
+  // Convert the text example file into a binary example file (which can be loaded much more quickly by raflperf).
+  std::cout << "Converting '" << textFilename << "' to '" << binaryFilename << "'...\n";
+  ExampleUtil::convert_examples_to_binary<Label>(textFilename, binaryFilename);
+
+  // Stream the examples back in from the binary file a chunk at a time to check that they can be read, and count how many
+  // examples there are for each label. This avoids holding all of the examples in memory at once, however large the file.
+  BinaryExampleReader<Label> reader(binaryFilename);
+  std::map<Label,size_t> labelCounts;
+  const size_t chunkSize = 65536;
+  while(reader.has_more_examples())
+  {
+    std::vector<Example_CPtr> chunk = reader.read_chunk(chunkSize);
+    for(size_t i = 0, size = chunk.size(); i < size; ++i)
+    {
+      ++labelCounts[chunk[i]->get_label()];
+    }
+  }
+
+  // Output a summary of the converted examples.
+  std::cout << "Number of examples = " << reader.get_example_count() << '\n';
+  std::cout << "Number of features = " << reader.get_feature_count() << '\n';
+  for(std::map<Label,size_t>::const_iterator it = labelCounts.begin(), iend = labelCounts.end(); it != iend; ++it)
+  {
+    std::cout << "Label " << it->first << ": " << it->second << " examples\n";
+  }
+
+  return 0;
+}
+catch(std::exception& e)
+{
+  std::cerr << e.what() << '\n';
+  return EXIT_FAILURE;
+}
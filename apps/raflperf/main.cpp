@@ -4,10 +4,15 @@
  */
 
 #include <boost/assign/list_of.hpp>
+#include <boost/bind.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/optional.hpp>
 using boost::assign::list_of;
 using boost::assign::map_list_of;
 
+#include <evaluation/core/ParallelParamSetEvaluator.h>
 #include <evaluation/core/ParamSetUtil.h>
 #include <evaluation/core/PerformanceTable.h>
 #include <evaluation/splitgenerators/CrossValidationSplitGenerator.h>
@@ -33,25 +38,46 @@ typedef boost::shared_ptr<const Example<Label> > Example_CPtr;
 
 //#################### FUNCTIONS ####################
 
-int main(int argc, char *argv[])
+/**
+ * \brief Makes a random forest evaluator for the specified parameter set.
+ *
+ * \param splitGenerator  The generator to use to split the example set.
+ * \param params          The parameter set.
+ * \return                The random forest evaluator.
+ */
+ParallelParamSetEvaluator<Example<Label> >::Evaluator_CPtr make_evaluator(const SplitGenerator_Ptr& splitGenerator, const ParamSet& params)
 {
-#if WITH_OPENMP
-  omp_set_nested(1);
-#endif
+  return ParallelParamSetEvaluator<Example<Label> >::Evaluator_CPtr(new RandomForestEvaluator<Label>(splitGenerator, params));
+}
 
+int main(int argc, char *argv[])
+{
   const unsigned int seed = 12345;
 
-  if(argc != 1 && argc != 4)
+  // If specified, read in the maximum number of (parameter set, split) pairs to evaluate at once (0 means one per hardware
+  // thread). Limiting the concurrency bounds the peak memory usage, since each pair being evaluated trains its own forest.
+  int maxConcurrency = 0;
+  int firstArg = 1;
+  if(argc >= 3 && std::string(argv[1]) == "-j")
   {
-    std::cerr << "Usage: raflperf [<training set file> <test set file> <output path>]\n";
+    try { maxConcurrency = boost::lexical_cast<int>(argv[2]); }
+    catch(boost::bad_lexical_cast&) { maxConcurrency = -1; }
+    firstArg = 3;
+  }
+
+  const int positionalArgCount = argc - firstArg;
+  if((positionalArgCount != 0 && positionalArgCount != 3 && positionalArgCount != 4) || maxConcurrency < 0)
+  {
+    std::cerr << "Usage: raflperf [-j <max concurrency>] [<training set file> <test set file> <output path> [<checkpoint file>]]\n";
     return EXIT_FAILURE;
   }
 
   std::vector<Example_CPtr> examples;
   std::vector<ParamSet> params;
   std::string outputResultPath;
+  boost::optional<std::string> checkpointPath;
 
-  if(argc == 1)
+  if(positionalArgCount == 0)
   {
 #define CLASS_IMBALANCE_TEST
 
@@ -97,15 +123,18 @@ int main(int argc, char *argv[])
 
     outputResultPath = "UnitCircleExampleGenerator-Results.txt";
   }
-  else if(argc == 4)
+  else
   {
-    std::string trainingSetPath = argv[1];
-    std::string testingSetPath = argv[2];
-    outputResultPath = argv[3];
+    std::string trainingSetPath = argv[firstArg];
+    std::string testingSetPath = argv[firstArg + 1];
+    outputResultPath = argv[firstArg + 2];
+    if(positionalArgCount == 4) checkpointPath = argv[firstArg + 3];
 
     std::cout << "Training set: " << trainingSetPath << '\n';
     std::cout << "Testing set: " << testingSetPath << '\n';
 
+    // Note: The split generators partition the example set as a whole, so all of the examples must be held in memory at once.
+    //       The example files can be converted to the binary example format (using raflconvert) to make them faster to load.
     examples = ExampleUtil::load_examples<Label>(trainingSetPath);
     std::vector<Example_CPtr> testingExamples = ExampleUtil::load_examples<Label>(testingSetPath);
 
@@ -145,15 +174,17 @@ int main(int argc, char *argv[])
   // Time the random forest.
   Timer<boost::chrono::milliseconds> timer("ForestEvaluation");
 
-  // Evaluate the random forest on the various different parameter sets.
+  // Evaluate the random forest on the various different parameter sets. The (parameter set, split) pairs are evaluated
+  // concurrently, up to the maximum concurrency. If a checkpoint file has been specified, the result for each parameter set is checkpointed as soon as it
+  // is available, so that an interrupted run can be resumed (by rerunning with the same arguments) without re-evaluating
+  // the parameter sets that have already finished. Checkpointing is opt-in, since the results in the checkpoint file are
+  // only keyed by parameter set, and so would be wrongly reused by a run with different inputs.
   PerformanceTable results(list_of("Accuracy"));
-  boost::shared_ptr<RandomForestEvaluator<Label> > evaluator;
-  for(size_t n = 0, size = params.size(); n < size; ++n)
-  {
-    evaluator.reset(new RandomForestEvaluator<Label>(splitGenerator, params[n]));
-    PerformanceResult result = evaluator->evaluate(examples);
-    results.record_performance(params[n], result);
-  }
+  ParallelParamSetEvaluator<Example<Label> > evaluator(boost::bind(make_evaluator, splitGenerator, _1), static_cast<size_t>(maxConcurrency), checkpointPath);
+  evaluator.evaluate(params, examples, results);
+
+  // Now that all of the parameter sets have been evaluated, delete the checkpoint file so that no later run can pick it up.
+  if(checkpointPath) boost::filesystem::remove(*checkpointPath);
 
   timer.stop();
   std::cout << timer << '\n';
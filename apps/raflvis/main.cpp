@@ -160,6 +160,7 @@ static float evaluate_forest_accuracy(const RF_Ptr& forest, const std::vector<Ex
     predictedLabels[i] = forest->predict(example.get_descriptor());
     expectedLabels[i] = example.get_label();
     classLabels.insert(expectedLabels[i]);
+    classLabels.insert(predictedLabels[i]);
   }
 
   Eigen::MatrixXf confusionMatrix = ConfusionMatrixUtil::make_confusion_matrix(classLabels, expectedLabels, predictedLabels);
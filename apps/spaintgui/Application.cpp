@@ -59,6 +59,15 @@ Application::Application(const MultiScenePipeline_Ptr& pipeline, bool renderFidu
   setup_meshing();
 
   const Settings_CPtr& settings = m_pipeline->get_model()->get_settings();
+
+  // Configure the executor that is used to save images and poses to disk asynchronously.
+  const static std::string persistenceNamespace = "PersistenceExecutor.";
+  PersistenceExecutor::configure(
+    settings->get_first_value<size_t>(persistenceNamespace + "maxConcurrency", 4),
+    settings->get_first_value<size_t>(persistenceNamespace + "capacity", 64),
+    settings->get_first_value<bounded_thread_pool::QueueFullStrategy>(persistenceNamespace + "queueFullStrategy", bounded_thread_pool::QFS_WAIT)
+  );
+
   int subwindowConfigurationIndex = settings->get_first_value<int>("subwindowConfigurationIndex");
   switch_to_windowed_renderer(subwindowConfigurationIndex);
 }
@@ -881,8 +890,16 @@ void Application::save_sequence_frame()
   ImagePersister::save_image_on_thread(slamState->get_input_raw_depth_image_copy(), m_sequencePathGenerator->make_path("depthm%06i.pgm"));
   ImagePersister::save_image_on_thread(slamState->get_input_rgb_image_copy(), m_sequencePathGenerator->make_path("rgbm%06i.ppm"));
 
-  // Save the inverse pose (i.e. the camera -> world transformation).
-  PosePersister::save_pose_on_thread(slamState->get_pose().GetInvM(), m_sequencePathGenerator->make_path("posem%06i.txt"));
+  // Save the inverse pose (i.e. the camera -> world transformation). If desired, we append it to a single pose log
+  // for the sequence rather than writing a separate file for each frame, since this is much cheaper for long recordings.
+  const Settings_CPtr& settings = m_pipeline->get_model()->get_settings();
+  if(settings->get_first_value<bool>("Application.logSequencePoses", false))
+  {
+    const std::string poseLogPath = (m_sequencePathGenerator->get_base_dir() / "poses.txt").string();
+    if(!m_poseLogWriter || m_poseLogWriter->get_path() != poseLogPath) m_poseLogWriter.reset(new PoseLogWriter(poseLogPath));
+    m_poseLogWriter->append_pose(m_sequencePathGenerator->get_index(), slamState->get_pose().GetInvM());
+  }
+  else PosePersister::save_pose_on_thread(slamState->get_pose().GetInvM(), m_sequencePathGenerator->make_path("posem%06i.txt"));
 
   m_sequencePathGenerator->increment_index();
 }
@@ -968,7 +985,8 @@ void Application::toggle_recording(const std::string& type, boost::optional<tvgu
   if(pathGenerator)
   {
     pathGenerator.reset();
-    std::cout << "[spaint] Stopped saving " << type << ".\n";
+    if(type == "sequence") m_poseLogWriter.reset();
+    std::cout << "[spaint] Stopped saving " << type << " (persistence tasks: " << PersistenceExecutor::instance().get_statistics() << ").\n";
   }
   else
   {
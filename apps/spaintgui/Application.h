@@ -16,6 +16,8 @@
 
 #include <ITMLib/Engines/Meshing/Interface/ITMMeshingEngine.h>
 
+#include <itmx/persistence/PoseLogWriter.h>
+
 #include <tvginput/InputState.h>
 
 #include <tvgutil/commands/CommandManager.h>
@@ -72,6 +74,9 @@ private:
   /** Whether or not the application is currently paused. */
   bool m_paused;
 
+  /** The writer used to log the poses for the current sequence recording (if we're logging the poses rather than saving them to individual files). */
+  boost::shared_ptr<itmx::PoseLogWriter> m_poseLogWriter;
+
   /** The multi-scene pipeline that the application should use. */
   MultiScenePipeline_Ptr m_pipeline;
 
@@ -11,6 +11,7 @@ using namespace rigging;
 #include <itmx/util/CameraPoseConverter.h>
 using namespace itmx;
 
+#include <spaint/imageprocessing/NativeMedianFilterer.h>
 #include <spaint/ogl/CameraRenderer.h>
 #include <spaint/ogl/QuadricRenderer.h>
 #include <spaint/selectiontransformers/interface/VoxelToCubeSelectionTransformer.h>
@@ -328,7 +329,10 @@ void Renderer::render_scene(const Vector2f& fracWindowPos, bool renderFiducials,
   glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-  // Render all the sub-windows.
+  // Render all the sub-windows. Sub-windows that show the same scene from the same viewpoint (e.g. with different
+  // visualisation types) share a single raycast of the scene, so that only the shading needs to be done per sub-window.
+  VisualisationGenerator_CPtr visualisationGenerator = m_model->get_visualisation_generator();
+  visualisationGenerator->begin_raycast_sharing();
   for(size_t subwindowIndex = 0, count = m_subwindowConfiguration->subwindow_count(); subwindowIndex < count; ++subwindowIndex)
   {
     Subwindow& subwindow = m_subwindowConfiguration->subwindow(subwindowIndex);
@@ -365,6 +369,7 @@ void Renderer::render_scene(const Vector2f& fracWindowPos, bool renderFiducials,
     render_pixel_value(fracWindowPos, subwindow);
 #endif
   }
+  visualisationGenerator->end_raycast_sharing();
 }
 
 void Renderer::set_window(const SDL_Window_Ptr& window)
@@ -460,18 +465,25 @@ void Renderer::render_pixel_value(const Vector2f& fracWindowPos, const Subwindow
 
 void Renderer::render_reconstructed_scene(const std::string& sceneID, const SE3Pose& pose, Subwindow& subwindow, int viewIndex) const
 {
-  // Set up any post-processing that needs to be applied to the rendering result.
-  // FIXME: At present, median filtering breaks in CPU mode, so we prevent it from running, but we should investigate why.
+  // Set up any post-processing that needs to be applied to the rendering result. In CUDA mode, we use ArrayFire
+  // to filter the image on the GPU if it's available. Otherwise, we use the native median filterer, which filters
+  // the image on the CPU and can be fused with the copy of the rendering result into the subwindow image.
   static boost::optional<VisualisationGenerator::Postprocessor> postprocessor = boost::none;
   if(!m_medianFilteringEnabled && postprocessor)
   {
     postprocessor.reset();
   }
-  else if(m_medianFilteringEnabled && !postprocessor && m_model->get_settings()->deviceType == DEVICE_CUDA)
+  else if(m_medianFilteringEnabled && !postprocessor)
   {
-#if defined(WITH_ARRAYFIRE) && !defined(USE_LOW_POWER_MODE)
+#ifndef USE_LOW_POWER_MODE
     const unsigned int kernelWidth = 3;
-    postprocessor = MedianFilterer(kernelWidth, m_model->get_settings()->deviceType);
+    const DeviceType deviceType = m_model->get_settings()->deviceType;
+#ifdef WITH_ARRAYFIRE
+    if(deviceType == DEVICE_CUDA) postprocessor = MedianFilterer(kernelWidth, deviceType);
+    else postprocessor = NativeMedianFilterer(kernelWidth, deviceType);
+#else
+    postprocessor = NativeMedianFilterer(kernelWidth, deviceType);
+#endif
 #endif
   }
 
@@ -12,6 +12,7 @@ using boost::assign::list_of;
 #include <evaluation/util/CartesianProductParameterSetGenerator.h>
 using namespace evaluation;
 
+#include <rafl/core/FlatRandomForest.h>
 #include <rafl/decisionfunctions/DecisionFunctionGeneratorFactory.h>
 using namespace rafl;
 
@@ -34,6 +35,7 @@ using namespace tvgutil;
 typedef int Label;
 typedef DecisionTree<Label> DT;
 typedef boost::shared_ptr<const Example<Label> > Example_CPtr;
+typedef FlatRandomForest<Label> FRF;
 typedef RandomForest<Label> RF;
 typedef boost::shared_ptr<RF> RF_Ptr;
 
@@ -154,5 +156,10 @@ int main(int argc, char *argv[])
   std::cout << "[touchtrain] Saving the forest to: " << forestPath << "\n";
   SerializationUtil::save_text(forestPath, *randomForest);
 
+  // Also output a flat version of the forest, which is much faster to load for touch detection.
+  std::string flatForestPath = dataset.get_models_directory() + "/randomForest-" + timestamp + ".rff";
+  std::cout << "[touchtrain] Saving the flat forest to: " << flatForestPath << "\n";
+  FRF(*randomForest).save(flatForestPath);
+
   return 0;
 }
@@ -66,6 +66,17 @@ protected:
 
   //#################### PUBLIC MEMBER FUNCTIONS ####################
 public:
+  /**
+   * \brief Combines the results of evaluating the learner on the individual splits of an example set into an overall result.
+   *
+   * \param results The results from the various splits.
+   * \return        The average of the results.
+   */
+  Result combine_split_results(const std::vector<Result>& results) const
+  {
+    return average_results(results);
+  }
+
   /**
    * \brief Evaluates the learner on the specified set of examples.
    *
@@ -75,7 +86,7 @@ public:
   Result evaluate(const std::vector<Example_CPtr>& examples) const
   {
     std::vector<Result> results;
-    std::vector<SplitGenerator::Split> splits = m_splitGenerator->generate_splits(examples.size());
+    std::vector<SplitGenerator::Split> splits = generate_splits(examples.size());
     int size = static_cast<int>(splits.size());
 
 #ifdef WITH_OPENMP
@@ -93,6 +104,31 @@ public:
 
     return average_results(results);
   }
+
+  /**
+   * \brief Evaluates the learner on a single split of the specified set of examples.
+   *
+   * This makes it possible for a caller to schedule the splits for several learners itself (see ParallelParamSetEvaluator).
+   *
+   * \param examples  The examples on which to evaluate the learner.
+   * \param split     The way in which the examples should be split into training and validation sets.
+   * \return          The results of evaluating the learner on the specified split.
+   */
+  Result evaluate_split(const std::vector<Example_CPtr>& examples, const SplitGenerator::Split& split) const
+  {
+    return evaluate_on_split(examples, split);
+  }
+
+  /**
+   * \brief Generates the splits of an example set on which the learner should be evaluated.
+   *
+   * \param exampleCount  The overall number of examples.
+   * \return              The splits on which the learner should be evaluated.
+   */
+  std::vector<SplitGenerator::Split> generate_splits(size_t exampleCount) const
+  {
+    return m_splitGenerator->generate_splits(exampleCount);
+  }
 };
 
 }
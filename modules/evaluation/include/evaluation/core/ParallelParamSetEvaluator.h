@@ -0,0 +1,330 @@
+/**
+ * evaluation: ParallelParamSetEvaluator.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2017. All rights reserved.
+ */
+
+#ifndef H_EVALUATION_PARALLELPARAMSETEVALUATOR
+#define H_EVALUATION_PARALLELPARAMSETEVALUATOR
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/exception_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/optional.hpp>
+#include <boost/thread.hpp>
+
+#ifdef WITH_OPENMP
+#include <omp.h>
+#endif
+
+#include "LearnerEvaluator.h"
+#include "PerformanceTable.h"
+
+namespace evaluation {
+
+/**
+ * \brief An instance of an instantiation of this class template can be used to evaluate a learner on many parameter sets at once.
+ *
+ * Rather than evaluating the parameter sets one after the other (and relying on nested parallelism to evaluate the splits
+ * for each parameter set concurrently), the evaluator flattens all of the (parameter set, split) pairs into a single list
+ * of tasks, which are then executed by a fixed number of worker threads. Each worker is limited to its share of the
+ * available OpenMP threads, so that the learner's own parallel loops do not oversubscribe the machine.
+ *
+ * The result for a parameter set is recorded in the performance table as soon as all of its splits have been evaluated.
+ * If a checkpoint file is specified, each such result is also appended to the file, and any parameter sets whose results
+ * are already in the file are not re-evaluated, which makes it possible to resume an interrupted sweep.
+ */
+template <typename Example>
+class ParallelParamSetEvaluator
+{
+  //#################### TYPEDEFS ####################
+public:
+  typedef boost::shared_ptr<const Example> Example_CPtr;
+  typedef LearnerEvaluator<Example,PerformanceResult> Evaluator;
+  typedef boost::shared_ptr<const Evaluator> Evaluator_CPtr;
+  typedef boost::function<Evaluator_CPtr(const ParamSet&)> EvaluatorMaker;
+
+  //#################### NESTED TYPES ####################
+private:
+  /**
+   * \brief An instance of this struct holds the state associated with the evaluation of a single parameter set.
+   */
+  struct ParamSetJob
+  {
+    /** The evaluator to use for the parameter set. */
+    Evaluator_CPtr evaluator;
+
+    /** The parameter set. */
+    ParamSet params;
+
+    /** The number of splits for the parameter set that have not yet been evaluated. */
+    size_t remainingSplitCount;
+
+    /** The results of evaluating the learner on the individual splits. */
+    std::vector<PerformanceResult> results;
+
+    /** The splits on which to evaluate the learner. */
+    std::vector<SplitGenerator::Split> splits;
+  };
+
+  /**
+   * \brief An instance of this struct represents a single (parameter set, split) task.
+   */
+  struct Task
+  {
+    /** The index of the parameter set job to which the task belongs. */
+    size_t jobIndex;
+
+    /** The index of the split to evaluate. */
+    size_t splitIndex;
+
+    Task(size_t jobIndex_, size_t splitIndex_)
+    : jobIndex(jobIndex_), splitIndex(splitIndex_)
+    {}
+  };
+
+  /**
+   * \brief An instance of this struct holds the state that is shared between the worker threads.
+   */
+  struct SharedState
+  {
+    /** The examples on which to evaluate the learner. */
+    const std::vector<Example_CPtr>& examples;
+
+    /** The first exception (if any) that was thrown by a task. */
+    boost::exception_ptr exception;
+
+    /** The parameter set jobs. */
+    std::vector<ParamSetJob>& jobs;
+
+    /** The synchronisation mutex. */
+    boost::mutex mutex;
+
+    /** The index of the next task to execute. */
+    size_t nextTaskIndex;
+
+    /** The performance table into which to record the results. */
+    PerformanceTable& table;
+
+    /** The (parameter set, split) tasks. */
+    const std::vector<Task>& tasks;
+
+    /** The number of worker threads. */
+    size_t workerCount;
+
+    SharedState(std::vector<ParamSetJob>& jobs_, const std::vector<Task>& tasks_, const std::vector<Example_CPtr>& examples_, PerformanceTable& table_, size_t workerCount_)
+    : examples(examples_), jobs(jobs_), nextTaskIndex(0), table(table_), tasks(tasks_), workerCount(workerCount_)
+    {}
+  };
+
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The name of the file (if any) to which to checkpoint the results for each parameter set as they become available. */
+  boost::optional<std::string> m_checkpointFilename;
+
+  /** The function to use to make an evaluator for each parameter set. */
+  EvaluatorMaker m_evaluatorMaker;
+
+  /** The maximum number of tasks to execute at once. */
+  size_t m_maxConcurrency;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs a parallel parameter set evaluator.
+   *
+   * \param evaluatorMaker      The function to use to make an evaluator for each parameter set.
+   * \param maxConcurrency      The maximum number of tasks to execute at once (0 means one per hardware thread).
+   * \param checkpointFilename  The name of the file (if any) to which to checkpoint the results for each parameter set.
+   */
+  explicit ParallelParamSetEvaluator(const EvaluatorMaker& evaluatorMaker, size_t maxConcurrency = 0,
+                                     const boost::optional<std::string>& checkpointFilename = boost::none)
+  : m_checkpointFilename(checkpointFilename), m_evaluatorMaker(evaluatorMaker), m_maxConcurrency(maxConcurrency)
+  {
+    if(m_maxConcurrency == 0) m_maxConcurrency = std::max<size_t>(boost::thread::hardware_concurrency(), 1);
+  }
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Evaluates the learner on the specified set of examples for each of the specified parameter sets.
+   *
+   * Note that the splits for the parameter sets are generated serially (in parameter set order) before any evaluation
+   * takes place, so the splits used are the same as if the parameter sets had been evaluated one after the other.
+   * The order in which the rows are added to the table is the order in which the parameter sets finish, however.
+   *
+   * \param params    The parameter sets.
+   * \param examples  The examples on which to evaluate the learner.
+   * \param table     The performance table into which to record the results.
+   * \throws std::runtime_error If the checkpoint file cannot be written.
+   */
+  void evaluate(const std::vector<ParamSet>& params, const std::vector<Example_CPtr>& examples, PerformanceTable& table) const
+  {
+    // Load the results (if any) from the checkpoint file.
+    std::map<std::string,PerformanceResult> checkpointedResults;
+    if(m_checkpointFilename) checkpointedResults = load_checkpoint(*m_checkpointFilename);
+
+    // Set up a job for each parameter set that has not already been evaluated, and flatten the jobs into a list of tasks.
+    std::vector<ParamSetJob> jobs;
+    std::vector<Task> tasks;
+    for(size_t i = 0, size = params.size(); i < size; ++i)
+    {
+      ParamSetJob job;
+      job.evaluator = m_evaluatorMaker(params[i]);
+      job.params = params[i];
+      job.splits = job.evaluator->generate_splits(examples.size());
+
+      std::map<std::string,PerformanceResult>::const_iterator it = checkpointedResults.find(ParamSetUtil::param_set_to_string(params[i]));
+      if(it != checkpointedResults.end())
+      {
+        table.record_performance(params[i], it->second);
+        continue;
+      }
+
+      job.remainingSplitCount = job.splits.size();
+      job.results.resize(job.splits.size());
+      for(size_t j = 0, splitCount = job.splits.size(); j < splitCount; ++j)
+      {
+        tasks.push_back(Task(jobs.size(), j));
+      }
+      jobs.push_back(job);
+    }
+
+    // Execute the tasks using a fixed number of worker threads.
+    SharedState state(jobs, tasks, examples, table, std::min(m_maxConcurrency, tasks.size()));
+    boost::thread_group workers;
+    for(size_t i = 0; i < state.workerCount; ++i)
+    {
+      workers.create_thread(boost::bind(&ParallelParamSetEvaluator::run_worker, this, boost::ref(state)));
+    }
+    workers.join_all();
+
+    if(state.exception) boost::rethrow_exception(state.exception);
+  }
+
+  //#################### PRIVATE MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Appends the result for a parameter set to the checkpoint file.
+   *
+   * \param params  The parameter set.
+   * \param result  The result for the parameter set.
+   * \throws std::runtime_error If the checkpoint file cannot be written.
+   */
+  void append_to_checkpoint(const ParamSet& params, const PerformanceResult& result) const
+  {
+    std::ofstream fs(m_checkpointFilename->c_str(), std::ios::app);
+    if(!fs) throw std::runtime_error("Error: Could not open the checkpoint file '" + *m_checkpointFilename + "' for writing");
+
+    const std::string paramString = ParamSetUtil::param_set_to_string(params);
+    fs << std::setprecision(9);
+    for(PerformanceResult::const_iterator it = result.begin(), iend = result.end(); it != iend; ++it)
+    {
+      const PerformanceMeasure& measure = it->second;
+      fs << paramString << '\t' << it->first << '\t' << measure.get_sample_count() << '\t' << measure.get_mean() << '\t' << measure.get_std_dev() << '\n';
+    }
+  }
+
+  /**
+   * \brief Loads the results that have been checkpointed to the specified file.
+   *
+   * Each line of the file contains a parameter string, a measure name, and the sample count, mean and standard deviation
+   * of the measure, all separated by tabs. Malformed lines (e.g. a partially-written last line) are ignored.
+   *
+   * \param filename  The name of the checkpoint file.
+   * \return          The checkpointed results, indexed by parameter string.
+   */
+  static std::map<std::string,PerformanceResult> load_checkpoint(const std::string& filename)
+  {
+    std::map<std::string,PerformanceResult> results;
+
+    std::ifstream fs(filename.c_str());
+    std::string line;
+    while(std::getline(fs, line))
+    {
+      std::vector<std::string> fields;
+      std::istringstream ls(line);
+      std::string field;
+      while(std::getline(ls, field, '\t')) fields.push_back(field);
+      if(fields.size() != 5) continue;
+
+      try
+      {
+        PerformanceMeasure measure(
+          boost::lexical_cast<size_t>(fields[2]),
+          boost::lexical_cast<float>(fields[3]),
+          boost::lexical_cast<float>(fields[4])
+        );
+        results[fields[0]].insert(std::make_pair(fields[1], measure));
+      }
+      catch(boost::bad_lexical_cast&) {}
+    }
+
+    return results;
+  }
+
+  /**
+   * \brief Repeatedly takes the next task from the shared list and executes it, until there are no tasks left.
+   *
+   * \param state The state that is shared between the worker threads.
+   */
+  void run_worker(SharedState& state) const
+  {
+#ifdef WITH_OPENMP
+    // Give each worker its share of the OpenMP threads, so that any parallel loops within the learner do not oversubscribe the machine.
+    omp_set_num_threads(std::max(omp_get_num_procs() / static_cast<int>(state.workerCount), 1));
+#endif
+
+    for(;;)
+    {
+      size_t taskIndex;
+      {
+        boost::lock_guard<boost::mutex> lock(state.mutex);
+        if(state.exception || state.nextTaskIndex == state.tasks.size()) return;
+        taskIndex = state.nextTaskIndex++;
+      }
+
+      const Task& task = state.tasks[taskIndex];
+      ParamSetJob& job = state.jobs[task.jobIndex];
+
+      try
+      {
+        PerformanceResult result = job.evaluator->evaluate_split(state.examples, job.splits[task.splitIndex]);
+
+        boost::lock_guard<boost::mutex> lock(state.mutex);
+        job.results[task.splitIndex] = result;
+
+        // If this was the last split for the parameter set, record the overall result for the parameter set.
+        if(--job.remainingSplitCount == 0)
+        {
+          PerformanceResult overallResult = job.evaluator->combine_split_results(job.results);
+          state.table.record_performance(job.params, overallResult);
+          if(m_checkpointFilename) append_to_checkpoint(job.params, overallResult);
+
+          // Release the memory used by the job, since it is no longer needed.
+          job.evaluator.reset();
+          std::vector<SplitGenerator::Split>().swap(job.splits);
+        }
+      }
+      catch(...)
+      {
+        boost::lock_guard<boost::mutex> lock(state.mutex);
+        if(!state.exception) state.exception = boost::current_exception();
+        return;
+      }
+    }
+  }
+};
+
+}
+
+#endif
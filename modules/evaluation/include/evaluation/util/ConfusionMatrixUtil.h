@@ -6,8 +6,8 @@
 #ifndef H_EVALUATION_CONFUSIONMATRIXUTIL
 #define H_EVALUATION_CONFUSIONMATRIXUTIL
 
+#include <algorithm>
 #include <cassert>
-#include <map>
 #include <set>
 #include <vector>
 
@@ -35,7 +35,10 @@ struct ConfusionMatrixUtil
   /**
    * \brief Makes a confusion matrix from a set of ground truth and predicted label vectors.
    *
-   * \param classLabels    The entire set of currently-known class labels.
+   * The labels are mapped to consecutive indices by binary search in a sorted array, and the examples are
+   * accumulated into per-thread confusion matrices (if OpenMP is available) that are summed at the end.
+   *
+   * \param classLabels    The entire set of currently-known class labels (this must contain all of the ground truth and predicted labels).
    * \param groundTruth    A vector of labels which are assumed to be correct.
    * \param predicted      A vector of labels predicted by a machine.
    * \return               The generated confusion matrix.
@@ -45,22 +48,36 @@ struct ConfusionMatrixUtil
   {
     assert(groundTruth.size() == predicted.size());
 
-    size_t sizeLabels = classLabels.size();
+    const int sizeLabels = static_cast<int>(classLabels.size());
     Eigen::MatrixXf confusionMatrix = Eigen::MatrixXf::Zero(sizeLabels, sizeLabels);
 
-    // Generate consecutive numeric indices for the various labels (these will be used to index into the confusion matrix).
-    std::map<Label,int> labelToIndex;
-    int i = 0;
-    for(typename std::set<Label>::const_iterator it = classLabels.begin(), iend = classLabels.end(); it != iend; ++it)
-    {
-      labelToIndex.insert(std::make_pair(*it, i));
-      ++i;
-    }
+    // Store the labels in a sorted array, so that the index of each label in the array can be used to index into the confusion matrix.
+    const std::vector<Label> sortedLabels(classLabels.begin(), classLabels.end());
 
     // Fill in the confusion matrix.
-    for(size_t i = 0, iend = groundTruth.size(); i < iend; ++i)
+    const int exampleCount = static_cast<int>(groundTruth.size());
+
+#ifdef WITH_OPENMP
+    #pragma omp parallel if(exampleCount >= 1024)
+#endif
     {
-      ++confusionMatrix(labelToIndex[groundTruth[i]], labelToIndex[predicted[i]]);
+      Eigen::MatrixXf localConfusionMatrix = Eigen::MatrixXf::Zero(sizeLabels, sizeLabels);
+
+#ifdef WITH_OPENMP
+      #pragma omp for nowait
+#endif
+      for(int i = 0; i < exampleCount; ++i)
+      {
+        const int groundTruthIndex = static_cast<int>(std::lower_bound(sortedLabels.begin(), sortedLabels.end(), groundTruth[i]) - sortedLabels.begin());
+        const int predictedIndex = static_cast<int>(std::lower_bound(sortedLabels.begin(), sortedLabels.end(), predicted[i]) - sortedLabels.begin());
+        assert(groundTruthIndex < sizeLabels && predictedIndex < sizeLabels);
+        ++localConfusionMatrix(groundTruthIndex, predictedIndex);
+      }
+
+#ifdef WITH_OPENMP
+      #pragma omp critical
+#endif
+      confusionMatrix += localConfusionMatrix;
     }
 
     return confusionMatrix;
@@ -6,7 +6,12 @@
 #ifndef H_EVALUATION_COORDINATEDESCENTPARAMETEROPTIMISER
 #define H_EVALUATION_COORDINATEDESCENTPARAMETEROPTIMISER
 
+#include <map>
+#include <string>
+#include <vector>
+
 #include <boost/function.hpp>
+#include <boost/optional.hpp>
 #include <boost/spirit/home/support/detail/hold_any.hpp>
 
 #include <tvgutil/numbers/RandomNumberGenerator.h>
@@ -17,6 +22,10 @@ namespace evaluation {
 
 /**
  * \brief An instance of this class uses coordinate descent with random restarts to find a parameter set with as low a cost as possible.
+ *
+ * The costs of the candidate values for each parameter are computed concurrently (if OpenMP is available), so the cost function
+ * must be safe to call from multiple threads at once. The cost of each parameter set is only ever computed once: the costs are
+ * cached across restarts (and across runs, if a cost cache file is specified).
  */
 class CoordinateDescentParameterOptimiser
 {
@@ -26,6 +35,12 @@ private:
 
   //#################### PRIVATE VARIABLES ####################
 private:
+  /** The costs of the parameter sets that have been evaluated so far (indexed by the string representations of the parameter sets). */
+  mutable std::map<std::string,float> m_costCache;
+
+  /** The name of the file (if any) to which the costs of newly-evaluated parameter sets should be appended. */
+  boost::optional<std::string> m_costCacheFilename;
+
   /** The cost function to use to evaluate the different parameter sets. */
   CostFunction m_costFunction;
 
@@ -82,6 +97,17 @@ public:
    */
   ParamSet optimise_for_parameters(float *bestCost = NULL) const;
 
+  /**
+   * \brief Specifies a file in which to persist the costs of the parameter sets that are evaluated.
+   *
+   * Any costs already in the file (e.g. from an earlier, interrupted run with the same cost function) are loaded into the cache
+   * and will not be recomputed. The costs of newly-evaluated parameter sets are appended to the file as soon as they are known.
+   *
+   * \param filename  The name of the cost cache file (it will be created if it does not already exist).
+   * \return          The optimiser itself (so that calls may be chained).
+   */
+  CoordinateDescentParameterOptimiser& use_cost_cache_file(const std::string& filename);
+
   //#################### PRIVATE MEMBER FUNCTIONS ####################
 private:
   /**
@@ -93,6 +119,16 @@ private:
    */
   float compute_cost(const std::vector<size_t>& valueIndices) const;
 
+  /**
+   * \brief Computes the costs associated with several sets of parameter value indices.
+   *
+   * Costs that are already in the cache are simply looked up. The remaining costs are computed in parallel and added to the cache.
+   *
+   * \param valueIndicesList  The sets of parameter value indices.
+   * \return                  The costs associated with the sets of parameter value indices (in the same order).
+   */
+  std::vector<float> compute_costs(const std::vector<std::vector<size_t> >& valueIndicesList) const;
+
   /**
    * \brief Generates a random set of parameter value indices, denoting particular settings for the parameters.
    *
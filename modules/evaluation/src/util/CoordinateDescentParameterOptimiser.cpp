@@ -5,7 +5,9 @@
 
 #include "util/CoordinateDescentParameterOptimiser.h"
 
+#include <fstream>
 #include <limits>
+#include <set>
 
 #include <boost/assign/list_of.hpp>
 #include <boost/lexical_cast.hpp>
@@ -57,11 +59,88 @@ ParamSet CoordinateDescentParameterOptimiser::optimise_for_parameters(float *bes
   return make_param_set(bestValueIndicesAllTime);
 }
 
+CoordinateDescentParameterOptimiser& CoordinateDescentParameterOptimiser::use_cost_cache_file(const std::string& filename)
+{
+  m_costCacheFilename = filename;
+
+  // Load any costs that were saved by an earlier run. Each line of the file is of the form "<param set string>\t<cost>".
+  std::ifstream fs(filename.c_str());
+  std::string line;
+  while(std::getline(fs, line))
+  {
+    size_t tabPos = line.find_last_of('\t');
+    if(tabPos == std::string::npos) continue;
+
+    try
+    {
+      m_costCache[line.substr(0, tabPos)] = boost::lexical_cast<float>(line.substr(tabPos + 1));
+    }
+    catch(boost::bad_lexical_cast&)
+    {
+      // If the line is malformed (e.g. because an earlier run was interrupted part-way through writing it), skip it.
+    }
+  }
+
+  return *this;
+}
+
 //#################### PRIVATE MEMBER FUNCTIONS ####################
 
 float CoordinateDescentParameterOptimiser::compute_cost(const std::vector<size_t>& valueIndices) const
 {
-  return m_costFunction(make_param_set(valueIndices));
+  return compute_costs(std::vector<std::vector<size_t> >(1, valueIndices))[0];
+}
+
+std::vector<float> CoordinateDescentParameterOptimiser::compute_costs(const std::vector<std::vector<size_t> >& valueIndicesList) const
+{
+  const size_t count = valueIndicesList.size();
+
+  // Make the parameter sets, and find the distinct ones whose costs are not yet in the cache.
+  std::vector<ParamSet> paramSets(count);
+  std::vector<std::string> keys(count);
+  std::vector<size_t> uncachedIndices;
+  std::set<std::string> uncachedKeys;
+  for(size_t i = 0; i < count; ++i)
+  {
+    paramSets[i] = make_param_set(valueIndicesList[i]);
+    keys[i] = ParamSetUtil::param_set_to_string(paramSets[i]);
+    if(m_costCache.find(keys[i]) == m_costCache.end() && uncachedKeys.insert(keys[i]).second)
+    {
+      uncachedIndices.push_back(i);
+    }
+  }
+
+  // Compute the costs of the uncached parameter sets in parallel.
+  const int uncachedCount = static_cast<int>(uncachedIndices.size());
+  std::vector<float> newCosts(uncachedCount);
+
+#ifdef WITH_OPENMP
+  #pragma omp parallel for schedule(dynamic)
+#endif
+  for(int j = 0; j < uncachedCount; ++j)
+  {
+    newCosts[j] = m_costFunction(paramSets[uncachedIndices[j]]);
+  }
+
+  // Add the new costs to the cache (and append them to the cost cache file, if any, so that they survive an interrupted run).
+  std::ofstream fs;
+  if(m_costCacheFilename && uncachedCount > 0) fs.open(m_costCacheFilename->c_str(), std::ios::app);
+
+  for(int j = 0; j < uncachedCount; ++j)
+  {
+    const std::string& key = keys[uncachedIndices[j]];
+    m_costCache[key] = newCosts[j];
+    if(fs) fs << key << '\t' << boost::lexical_cast<std::string>(newCosts[j]) << '\n';
+  }
+
+  // Look up the costs of all of the parameter sets in the cache.
+  std::vector<float> costs(count);
+  for(size_t i = 0; i < count; ++i)
+  {
+    costs[i] = m_costCache.find(keys[i])->second;
+  }
+
+  return costs;
 }
 
 std::vector<size_t> CoordinateDescentParameterOptimiser::generate_random_value_indices() const
@@ -112,20 +191,28 @@ std::pair<std::vector<size_t>,float> CoordinateDescentParameterOptimiser::perfor
     // Record the parameter value for which we already have the corresponding cost so that we can avoid re-evaluating it.
     size_t originalValueIndex = currentValueIndices[paramIndex];
 
-    // For each possible new value that the parameter can take:
-    std::vector<size_t> newValueIndices = currentValueIndices;
+    // Make the parameter value indices for each possible new value that the parameter can take. If we already know that the
+    // cost for a new value is no better than the cost for the current value (i.e. it's the current value), skip it.
+    std::vector<size_t> candidateValueIndices;
+    std::vector<std::vector<size_t> > candidates;
     for(size_t valueIndex = 0; valueIndex < valueCount; ++valueIndex)
     {
-      // If we already know that the cost for the new value is no better than the cost for the current value, skip it.
       if(valueIndex == originalValueIndex) continue;
+      candidateValueIndices.push_back(valueIndex);
+      candidates.push_back(currentValueIndices);
+      candidates.back()[paramIndex] = valueIndex;
+    }
 
-      // Compute the cost for the new value. If it's better than the cost for the current value, update the current value.
-      newValueIndices[paramIndex] = valueIndex;
-      float newCost = compute_cost(newValueIndices);
-      if(newCost < currentCost)
+    // Compute the costs for all of the new values at once (so that they can be computed concurrently).
+    std::vector<float> candidateCosts = compute_costs(candidates);
+
+    // For each new value, in order: if its cost is better than the cost for the current value, update the current value.
+    for(size_t i = 0, size = candidates.size(); i < size; ++i)
+    {
+      if(candidateCosts[i] < currentCost)
       {
-        currentValueIndices[paramIndex] = valueIndex;
-        currentCost = newCost;
+        currentValueIndices[paramIndex] = candidateValueIndices[i];
+        currentCost = candidateCosts[i];
       }
     }
 
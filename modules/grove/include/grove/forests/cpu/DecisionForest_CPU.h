@@ -64,6 +64,9 @@ public:
 public:
   /** Override */
   virtual void find_leaves(const DescriptorImage_CPtr& descriptors, LeafIndicesImage_Ptr& leafIndices) const;
+
+  /** Override */
+  virtual void find_leaves(const std::vector<DescriptorImage_CPtr>& descriptors, std::vector<LeafIndicesImage_Ptr>& leafIndices) const;
 };
 
 }
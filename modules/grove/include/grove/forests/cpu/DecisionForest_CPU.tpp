@@ -5,6 +5,10 @@
 
 #include "DecisionForest_CPU.h"
 
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
 #include "../shared/DecisionForest_Shared.h"
 
 namespace grove {
@@ -49,4 +53,57 @@ void DecisionForest_CPU<DescriptorType,TreeCount>::find_leaves(const DescriptorI
   }
 }
 
+template <typename DescriptorType, int TreeCount>
+void DecisionForest_CPU<DescriptorType,TreeCount>::find_leaves(const std::vector<DescriptorImage_CPtr>& descriptors, std::vector<LeafIndicesImage_Ptr>& leafIndices) const
+{
+  if(leafIndices.size() != descriptors.size())
+  {
+    throw std::invalid_argument("Error: The numbers of descriptors images and leaf indices images must be the same");
+  }
+
+  // Ensure that each leaf indices image is the same size as the corresponding descriptors image, and split
+  // each image into tiles of consecutive rows, each represented by an (image index, first row) pair.
+  const int rowsPerTile = 8;
+  std::vector<std::pair<int,int> > tiles;
+  for(int i = 0, imageCount = static_cast<int>(descriptors.size()); i < imageCount; ++i)
+  {
+    const Vector2i imgSize = descriptors[i]->noDims;
+    leafIndices[i]->ChangeDims(imgSize);
+
+    for(int y = 0; y < imgSize.y; y += rowsPerTile)
+    {
+      tiles.push_back(std::make_pair(i, y));
+    }
+  }
+
+  // Compute the leaf indices associated with each descriptor in the descriptors images. All of the tiles from all of the
+  // images are processed in a single parallel loop, rather than starting a separate loop for each image.
+  const NodeEntry *nodeImage = this->m_nodeImage->GetData(MEMORYDEVICE_CPU);
+  const int tileCount = static_cast<int>(tiles.size());
+
+#ifdef WITH_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for(int tileIdx = 0; tileIdx < tileCount; ++tileIdx)
+  {
+    const int imageIdx = tiles[tileIdx].first, firstRow = tiles[tileIdx].second;
+    const Vector2i imgSize = descriptors[imageIdx]->noDims;
+    const DescriptorType *descriptorsPtr = descriptors[imageIdx]->GetData(MEMORYDEVICE_CPU);
+    LeafIndices *leafIndicesPtr = leafIndices[imageIdx]->GetData(MEMORYDEVICE_CPU);
+
+    const int beginIdx = firstRow * imgSize.x;
+    const int endIdx = std::min(firstRow + rowsPerTile, imgSize.y) * imgSize.x;
+
+    // Route all of the descriptors in the tile down one tree before moving on to the next, so that the upper levels
+    // of each tree (which every descriptor visits) stay in the cache whilst the tile is being processed.
+    for(int treeIdx = 0; treeIdx < TreeCount; ++treeIdx)
+    {
+      for(int rasterIdx = beginIdx; rasterIdx < endIdx; ++rasterIdx)
+      {
+        leafIndicesPtr[rasterIdx][treeIdx] = compute_leaf_index<NodeEntry,DescriptorType,TreeCount>(descriptorsPtr[rasterIdx], nodeImage, treeIdx);
+      }
+    }
+  }
+}
+
 }
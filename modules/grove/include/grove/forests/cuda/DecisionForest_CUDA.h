@@ -37,6 +37,7 @@ public:
   using typename Base::LeafIndicesImage_Ptr;
   using typename Base::LeafIndicesImage_CPtr;
   using typename Base::NodeEntry;
+  using Base::find_leaves;
 
   //#################### CONSTRUCTORS ####################
 public:
@@ -145,6 +145,20 @@ public:
 
   //#################### PUBLIC MEMBER FUNCTIONS ####################
 public:
+  /**
+   * \brief Given several images filled with descriptors, evaluates the forest and returns the leaf indices associated with each descriptor (one per tree).
+   *
+   * By default, this simply calls the single-image version of find_leaves on each image in turn, but derived classes may
+   * override it to evaluate all of the images together (e.g. when relocalising a batch of frames during evaluation).
+   *
+   * \param descriptors A set of images in which each pixel contains a descriptor. All descriptors are assumed valid and are fed to every tree in the forest.
+   * \param leafIndices A set of images (one per descriptors image) in which to store the leaf indices computed for each descriptor. Each image will be
+   *                    resized to match the corresponding descriptors image.
+   *
+   * \throws std::invalid_argument If the numbers of descriptors images and leaf indices images differ.
+   */
+  virtual void find_leaves(const std::vector<DescriptorImage_CPtr>& descriptors, std::vector<LeafIndicesImage_Ptr>& leafIndices) const;
+
   /**
    * \brief Gets the total number of leaves in the forest.
    *
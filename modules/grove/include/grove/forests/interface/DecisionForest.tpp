@@ -6,6 +6,7 @@
 #include "DecisionForest.h"
 
 #include <fstream>
+#include <stdexcept>
 
 #include <boost/lexical_cast.hpp>
 
@@ -94,6 +95,20 @@ DecisionForest<DescriptorType,TreeCount>::~DecisionForest()
 
 //#################### PUBLIC MEMBER FUNCTIONS ####################
 
+template <typename DescriptorType, int TreeCount>
+void DecisionForest<DescriptorType,TreeCount>::find_leaves(const std::vector<DescriptorImage_CPtr>& descriptors, std::vector<LeafIndicesImage_Ptr>& leafIndices) const
+{
+  if(leafIndices.size() != descriptors.size())
+  {
+    throw std::invalid_argument("Error: The numbers of descriptors images and leaf indices images must be the same");
+  }
+
+  for(size_t i = 0, size = descriptors.size(); i < size; ++i)
+  {
+    find_leaves(descriptors[i], leafIndices[i]);
+  }
+}
+
 template <typename DescriptorType, int TreeCount>
 uint32_t DecisionForest<DescriptorType, TreeCount>::get_nb_leaves() const
 {
@@ -10,6 +10,36 @@
 
 namespace grove {
 
+/**
+ * \brief Finds the index of the leaf reached by a descriptor in the specified tree.
+ *
+ * \param descriptor  The descriptor to evaluate.
+ * \param nodeImage   The forest indexing structure.
+ * \param treeIdx     The index of the tree.
+ * \return            The index of the leaf reached by the descriptor in the tree.
+ */
+template <typename NodeType, typename DescriptorType, int TreeCount>
+_CPU_AND_GPU_CODE_TEMPLATE_
+inline int compute_leaf_index(const DescriptorType& descriptor, const NodeType *nodeImage, int treeIdx)
+{
+  // Start from the root node and iteratively walk down the tree until a leaf is reached.
+  uint32_t currentNodeIdx = 0;
+  NodeType node = nodeImage[currentNodeIdx * TreeCount + treeIdx];
+
+  // Note: This is for clarity: we could (if desired) test node.leafIdx directly in the while condition.
+  bool isLeaf = node.leafIdx >= 0;
+
+  while(!isLeaf)
+  {
+    // Descend to either the left or right subtree.
+    currentNodeIdx = node.leftChildIdx + static_cast<int>(descriptor.data[node.featureIdx] > node.featureThreshold);
+    node = nodeImage[currentNodeIdx * TreeCount + treeIdx];
+    isLeaf = node.leafIdx >= 0;
+  }
+
+  return node.leafIdx;
+}
+
 /**
  * \brief Finds the leaf indices associated with a descriptor and writes them into the leaf indices image.
  *
@@ -29,26 +59,10 @@ inline void compute_leaf_indices(int x, int y, const DescriptorType *descriptors
   const int rasterIdx = y * imgSize.width + x;
   const DescriptorType& currentDescriptor = descriptors[rasterIdx];
 
-  // For each tree in the forest:
+  // For each tree in the forest, write the index of the leaf reached by the descriptor into the leaf indices image.
   for(int treeIdx = 0; treeIdx < TreeCount; ++treeIdx)
   {
-    // Start from the root node and iteratively walk down the tree until a leaf is reached.
-    uint32_t currentNodeIdx = 0;
-    NodeType node = nodeImage[currentNodeIdx * TreeCount + treeIdx];
-
-    // Note: This is for clarity: we could (if desired) test node.leafIdx directly in the while condition.
-    bool isLeaf = node.leafIdx >= 0;
-
-    while(!isLeaf)
-    {
-      // Descend to either the left or right subtree.
-      currentNodeIdx = node.leftChildIdx + static_cast<int>(currentDescriptor.data[node.featureIdx] > node.featureThreshold);
-      node = nodeImage[currentNodeIdx * TreeCount + treeIdx];
-      isLeaf = node.leafIdx >= 0;
-    }
-
-    // Write the index of the leaf that has been reached into the leaf indices image.
-    leafIndices[rasterIdx][treeIdx] = node.leafIdx;
+    leafIndices[rasterIdx][treeIdx] = compute_leaf_index<NodeType,DescriptorType,TreeCount>(currentDescriptor, nodeImage, treeIdx);
   }
 }
 
@@ -80,12 +80,12 @@ struct CRFUtil
   template <typename Label>
   static Grid<Label> predict_labels(const ProbabilitiesGrid<Label>& probabilities)
   {
-    Grid<Label> result(probabilities.cols(), probabilities.rows());
+    Grid<Label> result(probabilities.rows(), probabilities.cols());
     for(size_t y = 0, height = probabilities.rows(); y < height; ++y)
     {
       for(size_t x = 0, width = probabilities.cols(); x < width; ++x)
       {
-        result(x, y) = tvgutil::ArgUtil::argmax(probabilities(x, y));
+        result(y, x) = tvgutil::ArgUtil::argmax(probabilities(y, x));
       }
     }
     return result;
@@ -0,0 +1,357 @@
+/**
+ * infermous: PermutohedralLattice.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2017. All rights reserved.
+ */
+
+#ifndef H_INFERMOUS_PERMUTOHEDRALLATTICE
+#define H_INFERMOUS_PERMUTOHEDRALLATTICE
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+namespace infermous {
+
+/**
+ * \brief An instance of this class can be used to perform fast high-dimensional Gaussian filtering of a set of points.
+ *
+ * The points are embedded in a d-dimensional feature space (e.g. position and colour) and the filter convolves their values with
+ * a Gaussian of unit standard deviation in that space (features should be divided by the desired standard deviations beforehand).
+ * Following Adams et al. ("Fast High-Dimensional Filtering Using the Permutohedral Lattice", Eurographics 2010), the values are
+ * splatted onto the vertices of the enclosing simplices of a permutohedral lattice, blurred along each lattice direction and then
+ * sliced back out at the original points. The cost of filtering is linear in the number of points, whatever the extent of the
+ * kernel. Note that the result is an approximation, and that (as in the original method) each point contributes to its own output.
+ *
+ * The lattice itself only depends on the features, so it can be built once and then used to filter many sets of values.
+ */
+class PermutohedralLattice
+{
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** For each point, the barycentric weights of the d+1 lattice vertices of its enclosing simplex. */
+  std::vector<float> m_barycentricWeights;
+
+  /** For each lattice direction and vertex, the indices of the vertex's two neighbours along that direction (offset by 1, so that 0 means "no neighbour"). */
+  std::vector<int> m_blurNeighbours;
+
+  /** The dimension of the feature space. */
+  int m_featureDim;
+
+  /** The hash table used to look up lattice vertices by key during construction (-1 denotes an empty slot). */
+  std::vector<int> m_hashTable;
+
+  /** The (d-dimensional) keys of the lattice vertices. */
+  std::vector<short> m_keys;
+
+  /** The number of points being filtered. */
+  int m_pointCount;
+
+  /** The number of lattice vertices that are in use. */
+  int m_vertexCount;
+
+  /** For each point, the indices of the d+1 lattice vertices of its enclosing simplex. */
+  std::vector<int> m_vertexIndices;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs a permutohedral lattice for the specified set of points.
+   *
+   * \param features            The (scaled) features of the points, stored contiguously (featureDim values per point).
+   * \param featureDim          The dimension of the feature space.
+   * \throws std::runtime_error If the size of the feature array is not a multiple of the feature dimension.
+   */
+  PermutohedralLattice(const std::vector<float>& features, int featureDim)
+  : m_featureDim(featureDim), m_pointCount(featureDim > 0 ? static_cast<int>(features.size() / featureDim) : 0), m_vertexCount(0)
+  {
+    if(featureDim <= 0 || features.size() != static_cast<size_t>(m_pointCount) * featureDim)
+    {
+      throw std::runtime_error("Error: The features must consist of a whole number of feature vectors");
+    }
+
+    const int d = featureDim, dp1 = d + 1;
+
+    // Calculate the factors used to scale the features so that the blur has unit standard deviation in feature space.
+    std::vector<float> scaleFactors(d);
+    const float invStdDev = dp1 * sqrtf(2.0f / 3.0f);
+    for(int i = 0; i < d; ++i)
+    {
+      scaleFactors[i] = invStdDev / sqrtf((i + 1.0f) * (i + 2.0f));
+    }
+
+    m_barycentricWeights.resize(static_cast<size_t>(m_pointCount) * dp1);
+    m_vertexIndices.resize(static_cast<size_t>(m_pointCount) * dp1);
+
+    size_t hashTableSize = 1024;
+    while(hashTableSize < static_cast<size_t>(m_pointCount)) hashTableSize *= 2;
+    m_hashTable.assign(hashTableSize, -1);
+
+    std::vector<float> barycentric(d + 2), elevated(dp1), scaledFeatures(d);
+    std::vector<short> key(d);
+    std::vector<int> rank(dp1), rem0(dp1);
+
+    for(int k = 0; k < m_pointCount; ++k)
+    {
+      const float *f = &features[static_cast<size_t>(k) * d];
+      for(int i = 0; i < d; ++i) scaledFeatures[i] = f[i] * scaleFactors[i];
+
+      // Elevate the point onto the hyperplane in which the lattice lives.
+      elevated[d] = -d * scaledFeatures[d - 1];
+      for(int i = d - 1; i > 0; --i)
+      {
+        elevated[i] = elevated[i + 1] - i * scaledFeatures[i - 1] + (i + 2) * scaledFeatures[i];
+      }
+      elevated[0] = elevated[1] + 2 * scaledFeatures[0];
+
+      // Find the closest remainder-0 lattice point.
+      int sum = 0;
+      for(int i = 0; i <= d; ++i)
+      {
+        const float v = elevated[i] / dp1;
+        const int up = static_cast<int>(ceilf(v)) * dp1, down = static_cast<int>(floorf(v)) * dp1;
+        rem0[i] = up - elevated[i] < elevated[i] - down ? up : down;
+        sum += rem0[i];
+      }
+      sum /= dp1;
+
+      // Rank the differential between the elevated point and the remainder-0 point along each axis.
+      std::fill(rank.begin(), rank.end(), 0);
+      for(int i = 0; i < d; ++i)
+      {
+        const float di = elevated[i] - rem0[i];
+        for(int j = i + 1; j <= d; ++j)
+        {
+          if(di < elevated[j] - rem0[j]) ++rank[i];
+          else ++rank[j];
+        }
+      }
+
+      // If the remainder-0 point does not lie on the hyperplane, fix it (and the ranks) up.
+      for(int i = 0; i <= d; ++i)
+      {
+        if(sum > 0 && rank[i] >= dp1 - sum)
+        {
+          rem0[i] -= dp1;
+          rank[i] += sum - dp1;
+        }
+        else if(sum < 0 && rank[i] < -sum)
+        {
+          rem0[i] += dp1;
+          rank[i] += dp1 + sum;
+        }
+        else rank[i] += sum;
+      }
+
+      // Compute the barycentric coordinates of the point within its enclosing simplex.
+      std::fill(barycentric.begin(), barycentric.end(), 0.0f);
+      for(int i = 0; i <= d; ++i)
+      {
+        const float v = (elevated[i] - rem0[i]) / dp1;
+        barycentric[d - rank[i]] += v;
+        barycentric[dp1 - rank[i]] -= v;
+      }
+      barycentric[0] += 1.0f + barycentric[dp1];
+
+      // Look up (or create) the vertices of the enclosing simplex, and record the point's weight for each of them.
+      for(int remainder = 0; remainder <= d; ++remainder)
+      {
+        for(int i = 0; i < d; ++i)
+        {
+          key[i] = static_cast<short>(rem0[i] + (rank[i] <= d - remainder ? remainder : remainder - dp1));
+        }
+
+        const size_t offset = static_cast<size_t>(k) * dp1 + remainder;
+        m_vertexIndices[offset] = find_vertex(&key[0], true);
+        m_barycentricWeights[offset] = barycentric[remainder];
+      }
+    }
+
+    // Find the neighbours of each vertex along each lattice direction.
+    std::vector<short> n1(d), n2(d);
+    m_blurNeighbours.resize(static_cast<size_t>(dp1) * m_vertexCount * 2);
+    for(int j = 0; j <= d; ++j)
+    {
+      for(int i = 0; i < m_vertexCount; ++i)
+      {
+        const short *vertexKey = &m_keys[static_cast<size_t>(i) * d];
+        for(int k = 0; k < d; ++k)
+        {
+          n1[k] = vertexKey[k] - 1;
+          n2[k] = vertexKey[k] + 1;
+        }
+
+        if(j < d)
+        {
+          n1[j] = vertexKey[j] + d;
+          n2[j] = vertexKey[j] - d;
+        }
+
+        const size_t offset = (static_cast<size_t>(j) * m_vertexCount + i) * 2;
+        m_blurNeighbours[offset] = find_vertex(&n1[0], false) + 1;
+        m_blurNeighbours[offset + 1] = find_vertex(&n2[0], false) + 1;
+      }
+    }
+
+    // The hash table is no longer needed once the lattice has been built.
+    std::vector<int>().swap(m_hashTable);
+  }
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Filters a set of values associated with the points.
+   *
+   * \param input     The values to filter, stored contiguously (valueDim values per point).
+   * \param output    A location into which to write the filtered values (this must not overlap the input).
+   * \param valueDim  The number of values associated with each point.
+   */
+  void filter(const float *input, float *output, int valueDim) const
+  {
+    const int d = m_featureDim, dp1 = d + 1;
+
+    // Note: The values for vertex i are stored at index i + 1, so that the values at index 0 (which are always zero) can be
+    //       used for neighbours that are not in the lattice.
+    std::vector<float> values(static_cast<size_t>(m_vertexCount + 1) * valueDim, 0.0f), newValues(values.size(), 0.0f);
+
+    // Splat the values onto the lattice.
+    for(int k = 0; k < m_pointCount; ++k)
+    {
+      const float *in = input + static_cast<size_t>(k) * valueDim;
+      for(int remainder = 0; remainder <= d; ++remainder)
+      {
+        const size_t offset = static_cast<size_t>(k) * dp1 + remainder;
+        float *v = &values[static_cast<size_t>(m_vertexIndices[offset] + 1) * valueDim];
+        const float w = m_barycentricWeights[offset];
+        for(int c = 0; c < valueDim; ++c) v[c] += w * in[c];
+      }
+    }
+
+    // Blur the values along each lattice direction in turn.
+    for(int j = 0; j <= d; ++j)
+    {
+#ifdef WITH_OPENMP
+      #pragma omp parallel for
+#endif
+      for(int i = 0; i < m_vertexCount; ++i)
+      {
+        const size_t offset = (static_cast<size_t>(j) * m_vertexCount + i) * 2;
+        const float *oldV = &values[static_cast<size_t>(i + 1) * valueDim];
+        const float *n1V = &values[static_cast<size_t>(m_blurNeighbours[offset]) * valueDim];
+        const float *n2V = &values[static_cast<size_t>(m_blurNeighbours[offset + 1]) * valueDim];
+        float *newV = &newValues[static_cast<size_t>(i + 1) * valueDim];
+        for(int c = 0; c < valueDim; ++c) newV[c] = oldV[c] + 0.5f * (n1V[c] + n2V[c]);
+      }
+
+      values.swap(newValues);
+    }
+
+    // Slice the blurred values back out at the points.
+    const float alpha = 1.0f / (1.0f + powf(2.0f, -static_cast<float>(d)));
+
+#ifdef WITH_OPENMP
+    #pragma omp parallel for
+#endif
+    for(int k = 0; k < m_pointCount; ++k)
+    {
+      float *out = output + static_cast<size_t>(k) * valueDim;
+      std::fill(out, out + valueDim, 0.0f);
+      for(int remainder = 0; remainder <= d; ++remainder)
+      {
+        const size_t offset = static_cast<size_t>(k) * dp1 + remainder;
+        const float *v = &values[static_cast<size_t>(m_vertexIndices[offset] + 1) * valueDim];
+        const float w = m_barycentricWeights[offset] * alpha;
+        for(int c = 0; c < valueDim; ++c) out[c] += w * v[c];
+      }
+    }
+  }
+
+  /**
+   * \brief Gets the number of points being filtered.
+   *
+   * \return  The number of points being filtered.
+   */
+  int get_point_count() const
+  {
+    return m_pointCount;
+  }
+
+  /**
+   * \brief Gets the number of lattice vertices that are in use.
+   *
+   * \return  The number of lattice vertices that are in use.
+   */
+  int get_vertex_count() const
+  {
+    return m_vertexCount;
+  }
+
+  //#################### PRIVATE MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Looks up the lattice vertex with the specified key, optionally creating it if it does not yet exist.
+   *
+   * \param key     The key of the vertex.
+   * \param create  Whether or not to create the vertex if it does not yet exist.
+   * \return        The index of the vertex, or -1 if it does not exist (and was not created).
+   */
+  int find_vertex(const short *key, bool create)
+  {
+    const int d = m_featureDim;
+
+    if(create && 2 * static_cast<size_t>(m_vertexCount) >= m_hashTable.size()) grow_hash_table();
+
+    const size_t mask = m_hashTable.size() - 1;
+    for(size_t h = hash_key(key) & mask;; h = (h + 1) & mask)
+    {
+      const int vertexIndex = m_hashTable[h];
+      if(vertexIndex == -1)
+      {
+        if(!create) return -1;
+
+        m_keys.insert(m_keys.end(), key, key + d);
+        m_hashTable[h] = m_vertexCount;
+        return m_vertexCount++;
+      }
+
+      if(std::equal(key, key + d, &m_keys[static_cast<size_t>(vertexIndex) * d])) return vertexIndex;
+    }
+  }
+
+  /**
+   * \brief Doubles the size of the hash table and reinserts the existing vertices.
+   */
+  void grow_hash_table()
+  {
+    std::vector<int> hashTable(m_hashTable.size() * 2, -1);
+    const size_t mask = hashTable.size() - 1;
+    for(int i = 0; i < m_vertexCount; ++i)
+    {
+      size_t h = hash_key(&m_keys[static_cast<size_t>(i) * m_featureDim]) & mask;
+      while(hashTable[h] != -1) h = (h + 1) & mask;
+      hashTable[h] = i;
+    }
+    m_hashTable.swap(hashTable);
+  }
+
+  /**
+   * \brief Calculates the hash of a vertex key.
+   *
+   * \param key The key.
+   * \return    The hash of the key.
+   */
+  size_t hash_key(const short *key) const
+  {
+    size_t h = 0;
+    for(int i = 0; i < m_featureDim; ++i)
+    {
+      h += key[i];
+      h *= 2531011;
+    }
+    return h;
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,309 @@
+/**
+ * infermous: DenseMeanFieldInferenceEngine.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2017. All rights reserved.
+ */
+
+#ifndef H_INFERMOUS_DENSEMEANFIELDINFERENCEENGINE
+#define H_INFERMOUS_DENSEMEANFIELDINFERENCEENGINE
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <set>
+#include <vector>
+
+#include "../base/CRF2D.h"
+
+namespace infermous {
+
+/**
+ * \brief An instance of an instantiation of this class template can be used to run mean-field inference on a 2D CRF,
+ *        using dense per-pixel probability tensors rather than grids of label -> probability maps.
+ *
+ * The engine computes the same update as MeanFieldInferenceEngine, but stores the unary potentials and the (double-buffered)
+ * marginals as dense height x width x labels float tensors, and caches the pairwise potentials as a labels x labels matrix.
+ * Since the pairwise potentials only depend on the labels of the pixels concerned, the message to a pixel can be computed by
+ * first summing the marginals of its neighbours and then multiplying the sum by the pairwise matrix, which reduces the cost
+ * of an update from O(neighbours * labels^2) to O(neighbours * labels + labels^2) per pixel. The label loops are vectorised
+ * by Eigen, and the rows of the CRF are updated in parallel (if OpenMP is available).
+ *
+ * The marginals are only copied back into the CRF at the end of each call to update_crf.
+ */
+template <typename Label>
+class DenseMeanFieldInferenceEngine
+{
+  //#################### TYPEDEFS ####################
+public:
+  typedef infermous::CRF2D_Ptr<Label> CRF2D_Ptr;
+  typedef infermous::CRF2D_CPtr<Label> CRF2D_CPtr;
+  typedef infermous::ProbabilitiesGrid<Label> ProbabilitiesGrid;
+  typedef infermous::ProbabilitiesGrid_Ptr<Label> ProbabilitiesGrid_Ptr;
+
+private:
+  typedef Eigen::Map<Eigen::VectorXf> VectorMap;
+  typedef Eigen::Map<const Eigen::VectorXf> ConstVectorMap;
+
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The CRF on which the mean-field inference engine works. */
+  CRF2D_Ptr m_crf;
+
+  /** The labels that appear in the CRF (the k'th label corresponds to the k'th element of each pixel in the tensors). */
+  std::vector<Label> m_labels;
+
+  /** The marginal probabilities for the pixels in the CRF, stored as a dense height x width x labels tensor. */
+  std::vector<float> m_marginals;
+
+  /** A list of offsets used to specify the neighbours of each pixel. */
+  std::vector<Eigen::Vector2i> m_neighbourOffsets;
+
+  /** A tensor into which the updated marginal probabilities are written, and which is swapped with m_marginals at the end of each time step. */
+  std::vector<float> m_newMarginals;
+
+  /** The pairwise potentials for each pair of labels, stored as a labels x labels matrix. */
+  Eigen::MatrixXf m_pairwisePotentials;
+
+  /** The unary potentials, phi_i(L) = -log(psi_i(L)), for the pixels in the CRF, stored as a dense height x width x labels tensor. */
+  std::vector<float> m_unaryPotentials;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs a dense mean-field inference engine.
+   *
+   * \param crf               The CRF on which the mean-field inference engine works.
+   * \param neighbourOffsets  A list of offsets used to specify the neighbours of each pixel.
+   */
+  DenseMeanFieldInferenceEngine(const CRF2D_Ptr& crf, const std::vector<Eigen::Vector2i>& neighbourOffsets)
+  : m_crf(crf), m_neighbourOffsets(neighbourOffsets)
+  {
+    const int height = crf->get_height(), width = crf->get_width();
+
+    // Determine the labels that appear in the CRF.
+    std::set<Label> labels;
+    for(int y = 0; y < height; ++y)
+    {
+      for(int x = 0; x < width; ++x)
+      {
+        const std::map<Label,float>& psi_i = crf->get_unaries_at(Eigen::Vector2i(x, y));
+        for(typename std::map<Label,float>::const_iterator kt = psi_i.begin(), kend = psi_i.end(); kt != kend; ++kt)
+        {
+          labels.insert(kt->first);
+        }
+      }
+    }
+    m_labels.assign(labels.begin(), labels.end());
+
+    // Cache the pairwise potentials for each pair of labels.
+    const int labelCount = static_cast<int>(m_labels.size());
+    PairwisePotentialCalculator_CPtr<Label> pairwisePotentialCalculator = crf->get_pairwise_potential_calculator();
+    m_pairwisePotentials.resize(labelCount, labelCount);
+    for(int k = 0; k < labelCount; ++k)
+    {
+      for(int kDash = 0; kDash < labelCount; ++kDash)
+      {
+        m_pairwisePotentials(k, kDash) = pairwisePotentialCalculator->calculate_potential(m_labels[k], m_labels[kDash]);
+      }
+    }
+
+    // Fill in the unary potentials and the initial marginals. Labels that are missing from a pixel's unaries are given a probability of zero,
+    // unless none of the pixel's labels has a non-zero probability, in which case the pixel is given a uniform unary potential (otherwise,
+    // all of its potentials would be infinite, and normalising its marginals would produce NaNs).
+    const size_t tensorSize = static_cast<size_t>(height) * width * labelCount;
+    m_unaryPotentials.assign(tensorSize, std::numeric_limits<float>::infinity());
+    m_marginals.assign(tensorSize, 0.0f);
+    m_newMarginals.assign(tensorSize, 0.0f);
+
+    for(int y = 0; y < height; ++y)
+    {
+      for(int x = 0; x < width; ++x)
+      {
+        const Eigen::Vector2i loc(x, y);
+        const size_t offset = pixel_offset(loc);
+
+        const std::map<Label,float>& psi_i = crf->get_unaries_at(loc);
+        const std::map<Label,float>& Q_i = crf->get_marginals_at(loc);
+        bool hasNonZeroUnary = false;
+        for(int k = 0; k < labelCount; ++k)
+        {
+          typename std::map<Label,float>::const_iterator it = psi_i.find(m_labels[k]);
+          if(it != psi_i.end() && it->second > 0.0f)
+          {
+            m_unaryPotentials[offset + k] = -logf(it->second);
+            hasNonZeroUnary = true;
+          }
+
+          typename std::map<Label,float>::const_iterator jt = Q_i.find(m_labels[k]);
+          if(jt != Q_i.end()) m_marginals[offset + k] = jt->second;
+        }
+
+        if(!hasNonZeroUnary) std::fill(&m_unaryPotentials[offset], &m_unaryPotentials[offset] + labelCount, 0.0f);
+      }
+    }
+  }
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Gets the CRF on which the mean-field inference engine works.
+   *
+   * \return  The CRF on which the mean-field inference engine works.
+   */
+  CRF2D_CPtr get_crf() const
+  {
+    return m_crf;
+  }
+
+  /**
+   * \brief Gets the labels that appear in the CRF, in the order in which they are stored in the tensors.
+   *
+   * \return  The labels that appear in the CRF.
+   */
+  const std::vector<Label>& get_labels() const
+  {
+    return m_labels;
+  }
+
+  /**
+   * \brief Gets the marginal probabilities for the pixels in the CRF, as a dense height x width x labels tensor.
+   *
+   * \return  The marginal probabilities for the pixels in the CRF.
+   */
+  const std::vector<float>& get_marginals() const
+  {
+    return m_marginals;
+  }
+
+  /**
+   * \brief Predicts the labels for each pixel in the CRF directly from the dense marginals.
+   *
+   * \return  The grid of predicted labels (indexed in the same way as the grids in the CRF).
+   */
+  Grid<Label> predict_labels() const
+  {
+    const int height = m_crf->get_height(), width = m_crf->get_width();
+    const int labelCount = static_cast<int>(m_labels.size());
+
+    Grid<Label> result(height, width);
+    for(int y = 0; y < height; ++y)
+    {
+      for(int x = 0; x < width; ++x)
+      {
+        const float *Q_i = &m_marginals[pixel_offset(Eigen::Vector2i(x, y))];
+        result(y, x) = m_labels[std::max_element(Q_i, Q_i + labelCount) - Q_i];
+      }
+    }
+
+    return result;
+  }
+
+  /**
+   * \brief Updates the CRF on which the mean-field inference engine works.
+   *
+   * \param iterations  The number of update iterations to run.
+   */
+  void update_crf(size_t iterations)
+  {
+    if(m_labels.empty()) return;
+
+    for(size_t i = 0; i < iterations; ++i)
+    {
+      update_marginals();
+
+      // Swap the new marginals into place.
+      m_marginals.swap(m_newMarginals);
+    }
+
+    // Copy the marginals back into the CRF.
+    write_marginals_to_crf();
+  }
+
+  //#################### PRIVATE MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Gets the offset of the specified pixel's elements within the tensors.
+   *
+   * \param loc The location of the pixel.
+   * \return    The offset of the pixel's elements within the tensors.
+   */
+  size_t pixel_offset(const Eigen::Vector2i& loc) const
+  {
+    return (static_cast<size_t>(loc.y()) * m_crf->get_width() + loc.x()) * m_labels.size();
+  }
+
+  /**
+   * \brief Computes the updated marginals for every pixel in the CRF and writes them into m_newMarginals.
+   */
+  void update_marginals()
+  {
+    const int height = m_crf->get_height(), width = m_crf->get_width();
+    const int labelCount = static_cast<int>(m_labels.size());
+
+#ifdef WITH_OPENMP
+    #pragma omp parallel
+#endif
+    {
+      // Allocate the per-thread storage needed to update the pixels.
+      Eigen::VectorXf neighbourSum(labelCount), M_i(labelCount);
+
+#ifdef WITH_OPENMP
+      #pragma omp for
+#endif
+      for(int y = 0; y < height; ++y)
+      {
+        for(int x = 0; x < width; ++x)
+        {
+          const Eigen::Vector2i i(x, y);
+          const size_t offset = pixel_offset(i);
+
+          // Calculate \sum_j Q_j^{t-1}(L') over the neighbours j of the pixel, for every label L'.
+          neighbourSum.setZero();
+          for(std::vector<Eigen::Vector2i>::const_iterator nt = m_neighbourOffsets.begin(), nend = m_neighbourOffsets.end(); nt != nend; ++nt)
+          {
+            Eigen::Vector2i j = i + *nt;
+            if(m_crf->within_bounds(j)) neighbourSum += ConstVectorMap(&m_marginals[pixel_offset(j)], labelCount);
+          }
+
+          // Calculate M_i(L) = phi_i(L) + \sum_j \sum_{L'} (Q_j^{t-1}(L') * phi_ij(L,L')) for every label L.
+          M_i.noalias() = m_pairwisePotentials * neighbourSum;
+          M_i += ConstVectorMap(&m_unaryPotentials[offset], labelCount);
+
+          // Calculate Q_i^t(L) = 1/Z_i * e^-M_i(L). Note that we subtract the smallest M_i(L) before exponentiating, which
+          // doesn't change the result after normalisation, but prevents all of the exponentials underflowing to zero.
+          VectorMap Q_i(&m_newMarginals[offset], labelCount);
+          Q_i = (-(M_i.array() - M_i.minCoeff())).exp();
+          Q_i /= Q_i.sum();
+        }
+      }
+    }
+  }
+
+  /**
+   * \brief Copies the dense marginals back into the CRF.
+   */
+  void write_marginals_to_crf()
+  {
+    const int height = m_crf->get_height(), width = m_crf->get_width();
+    const int labelCount = static_cast<int>(m_labels.size());
+
+    ProbabilitiesGrid_Ptr marginals(new ProbabilitiesGrid(height, width));
+    for(int y = 0; y < height; ++y)
+    {
+      for(int x = 0; x < width; ++x)
+      {
+        const float *Q_i = &m_marginals[pixel_offset(Eigen::Vector2i(x, y))];
+        std::map<Label,float>& target = (*marginals)(y, x);
+        for(int k = 0; k < labelCount; ++k)
+        {
+          target.insert(target.end(), std::make_pair(m_labels[k], Q_i[k]));
+        }
+      }
+    }
+
+    m_crf->swap_marginals(marginals);
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,379 @@
+/**
+ * infermous: FullyConnectedMeanFieldInferenceEngine.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2017. All rights reserved.
+ */
+
+#ifndef H_INFERMOUS_FULLYCONNECTEDMEANFIELDINFERENCEENGINE
+#define H_INFERMOUS_FULLYCONNECTEDMEANFIELDINFERENCEENGINE
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+#include "../base/CRF2D.h"
+#include "../base/PermutohedralLattice.h"
+
+namespace infermous {
+
+/**
+ * \brief An instance of an instantiation of this class template can be used to run mean-field inference on a fully-connected 2D CRF.
+ *
+ * Rather than connecting each pixel to a fixed local neighbourhood, every pair of pixels (i,j) is connected by the pairwise potential
+ *
+ *   phi_ij(L,L') = mu(L,L') * (w_a * exp(-|p_i-p_j|^2 / 2theta_a^2 - |c_i-c_j|^2 / 2theta_c^2) + w_s * exp(-|p_i-p_j|^2 / 2theta_s^2)),
+ *
+ * in which p and c denote pixel positions and colours, and mu is given by the CRF's pairwise potential calculator (Kraehenbuehl and
+ * Koltun, "Efficient Inference in Fully Connected CRFs with Gaussian Edge Potentials", NIPS 2011). The messages for all of the pixels
+ * are computed by filtering the marginals with a permutohedral lattice for each kernel, so the cost of an iteration is linear in the
+ * number of pixels, however large the kernels are. As in DenseMeanFieldInferenceEngine, the unaries and marginals are stored as dense
+ * height x width x labels tensors, and the marginals are only copied back into the CRF at the end of each call to update_crf.
+ */
+template <typename Label>
+class FullyConnectedMeanFieldInferenceEngine
+{
+  //#################### NESTED TYPES ####################
+public:
+  /**
+   * \brief An instance of this struct specifies the weights and standard deviations of the kernels in the pairwise potentials.
+   */
+  struct KernelParameters
+  {
+    /** The standard deviation (in colour units) of the appearance kernel. */
+    float appearanceColourStdDev;
+
+    /** The standard deviation (in pixels) of the appearance kernel. */
+    float appearanceSpatialStdDev;
+
+    /** The weight of the appearance kernel. */
+    float appearanceWeight;
+
+    /** The standard deviation (in pixels) of the smoothness kernel. */
+    float smoothnessSpatialStdDev;
+
+    /** The weight of the smoothness kernel. */
+    float smoothnessWeight;
+
+    /**
+     * \brief Constructs a set of kernel parameters (by default, those suggested by Kraehenbuehl and Koltun for colours in [0,255]).
+     */
+    KernelParameters(float appearanceWeight_ = 10.0f, float appearanceSpatialStdDev_ = 80.0f, float appearanceColourStdDev_ = 13.0f,
+                     float smoothnessWeight_ = 3.0f, float smoothnessSpatialStdDev_ = 3.0f)
+    : appearanceColourStdDev(appearanceColourStdDev_),
+      appearanceSpatialStdDev(appearanceSpatialStdDev_),
+      appearanceWeight(appearanceWeight_),
+      smoothnessSpatialStdDev(smoothnessSpatialStdDev_),
+      smoothnessWeight(smoothnessWeight_)
+    {}
+  };
+
+  //#################### TYPEDEFS ####################
+public:
+  typedef infermous::CRF2D_Ptr<Label> CRF2D_Ptr;
+  typedef infermous::CRF2D_CPtr<Label> CRF2D_CPtr;
+  typedef infermous::ProbabilitiesGrid<Label> ProbabilitiesGrid;
+  typedef infermous::ProbabilitiesGrid_Ptr<Label> ProbabilitiesGrid_Ptr;
+
+private:
+  typedef Eigen::Map<Eigen::VectorXf> VectorMap;
+  typedef Eigen::Map<const Eigen::VectorXf> ConstVectorMap;
+  typedef boost::shared_ptr<PermutohedralLattice> PermutohedralLattice_Ptr;
+
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The lattice used to filter the marginals with the appearance kernel. */
+  PermutohedralLattice_Ptr m_appearanceLattice;
+
+  /** A tensor into which the marginals filtered with the appearance kernel are written. */
+  std::vector<float> m_appearanceMessages;
+
+  /** The CRF on which the mean-field inference engine works. */
+  CRF2D_Ptr m_crf;
+
+  /** The weights and standard deviations of the kernels in the pairwise potentials. */
+  KernelParameters m_kernelParameters;
+
+  /** The labels that appear in the CRF (the k'th label corresponds to the k'th element of each pixel in the tensors). */
+  std::vector<Label> m_labels;
+
+  /** The marginal probabilities for the pixels in the CRF, stored as a dense height x width x labels tensor. */
+  std::vector<float> m_marginals;
+
+  /** The label compatibilities mu(L,L') for each pair of labels, stored as a labels x labels matrix. */
+  Eigen::MatrixXf m_pairwisePotentials;
+
+  /** The lattice used to filter the marginals with the smoothness kernel. */
+  PermutohedralLattice_Ptr m_smoothnessLattice;
+
+  /** A tensor into which the marginals filtered with the smoothness kernel are written. */
+  std::vector<float> m_smoothnessMessages;
+
+  /** The unary potentials, phi_i(L) = -log(psi_i(L)), for the pixels in the CRF, stored as a dense height x width x labels tensor. */
+  std::vector<float> m_unaryPotentials;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs a fully-connected mean-field inference engine.
+   *
+   * \param crf                 The CRF on which the mean-field inference engine works.
+   * \param colours             The colours of the pixels in the CRF (a height x width grid, indexed in the same way as the grids in the CRF).
+   * \param kernelParameters    The weights and standard deviations of the kernels in the pairwise potentials.
+   * \throws std::runtime_error If the size of the colour grid does not match that of the CRF.
+   */
+  FullyConnectedMeanFieldInferenceEngine(const CRF2D_Ptr& crf, const Grid<Eigen::Vector3f>& colours, const KernelParameters& kernelParameters = KernelParameters())
+  : m_crf(crf), m_kernelParameters(kernelParameters)
+  {
+    const int height = crf->get_height(), width = crf->get_width();
+    if(colours.rows() != height || colours.cols() != width)
+    {
+      throw std::runtime_error("Error: The colour grid must be the same size as the CRF");
+    }
+
+    // Determine the labels that appear in the CRF.
+    std::set<Label> labels;
+    for(int y = 0; y < height; ++y)
+    {
+      for(int x = 0; x < width; ++x)
+      {
+        const std::map<Label,float>& psi_i = crf->get_unaries_at(Eigen::Vector2i(x, y));
+        for(typename std::map<Label,float>::const_iterator kt = psi_i.begin(), kend = psi_i.end(); kt != kend; ++kt)
+        {
+          labels.insert(kt->first);
+        }
+      }
+    }
+    m_labels.assign(labels.begin(), labels.end());
+
+    // Cache the label compatibilities for each pair of labels.
+    const int labelCount = static_cast<int>(m_labels.size());
+    PairwisePotentialCalculator_CPtr<Label> pairwisePotentialCalculator = crf->get_pairwise_potential_calculator();
+    m_pairwisePotentials.resize(labelCount, labelCount);
+    for(int k = 0; k < labelCount; ++k)
+    {
+      for(int kDash = 0; kDash < labelCount; ++kDash)
+      {
+        m_pairwisePotentials(k, kDash) = pairwisePotentialCalculator->calculate_potential(m_labels[k], m_labels[kDash]);
+      }
+    }
+
+    // Fill in the unary potentials and the initial marginals. Labels that are missing from a pixel's unaries are given a probability of zero,
+    // unless none of the pixel's labels has a non-zero probability, in which case the pixel is given a uniform unary potential (otherwise,
+    // all of its potentials would be infinite, and normalising its marginals would produce NaNs).
+    const size_t pixelCount = static_cast<size_t>(height) * width;
+    const size_t tensorSize = pixelCount * labelCount;
+    m_unaryPotentials.assign(tensorSize, std::numeric_limits<float>::infinity());
+    m_marginals.assign(tensorSize, 0.0f);
+    m_appearanceMessages.assign(tensorSize, 0.0f);
+    m_smoothnessMessages.assign(tensorSize, 0.0f);
+
+    std::vector<float> appearanceFeatures(pixelCount * 5), smoothnessFeatures(pixelCount * 2);
+    for(int y = 0; y < height; ++y)
+    {
+      for(int x = 0; x < width; ++x)
+      {
+        const Eigen::Vector2i loc(x, y);
+        const size_t i = pixel_index(loc), offset = i * labelCount;
+
+        const std::map<Label,float>& psi_i = crf->get_unaries_at(loc);
+        const std::map<Label,float>& Q_i = crf->get_marginals_at(loc);
+        bool hasNonZeroUnary = false;
+        for(int k = 0; k < labelCount; ++k)
+        {
+          typename std::map<Label,float>::const_iterator it = psi_i.find(m_labels[k]);
+          if(it != psi_i.end() && it->second > 0.0f)
+          {
+            m_unaryPotentials[offset + k] = -logf(it->second);
+            hasNonZeroUnary = true;
+          }
+
+          typename std::map<Label,float>::const_iterator jt = Q_i.find(m_labels[k]);
+          if(jt != Q_i.end()) m_marginals[offset + k] = jt->second;
+        }
+
+        if(!hasNonZeroUnary) std::fill(&m_unaryPotentials[offset], &m_unaryPotentials[offset] + labelCount, 0.0f);
+
+        // Compute the features of the pixel in the spaces used by the two kernels (scaled so that the kernels have unit standard deviation).
+        const Eigen::Vector3f& colour = colours(y, x);
+        float *af = &appearanceFeatures[i * 5];
+        af[0] = x / kernelParameters.appearanceSpatialStdDev;
+        af[1] = y / kernelParameters.appearanceSpatialStdDev;
+        af[2] = colour.x() / kernelParameters.appearanceColourStdDev;
+        af[3] = colour.y() / kernelParameters.appearanceColourStdDev;
+        af[4] = colour.z() / kernelParameters.appearanceColourStdDev;
+
+        float *sf = &smoothnessFeatures[i * 2];
+        sf[0] = x / kernelParameters.smoothnessSpatialStdDev;
+        sf[1] = y / kernelParameters.smoothnessSpatialStdDev;
+      }
+    }
+
+    // Build the lattices (this only needs to be done once, since the features do not change during inference).
+    m_appearanceLattice.reset(new PermutohedralLattice(appearanceFeatures, 5));
+    m_smoothnessLattice.reset(new PermutohedralLattice(smoothnessFeatures, 2));
+  }
+
+  //#################### COPY CONSTRUCTOR & ASSIGNMENT OPERATOR ####################
+private:
+  // Deliberately private and unimplemented.
+  FullyConnectedMeanFieldInferenceEngine(const FullyConnectedMeanFieldInferenceEngine&);
+  FullyConnectedMeanFieldInferenceEngine& operator=(const FullyConnectedMeanFieldInferenceEngine&);
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Gets the CRF on which the mean-field inference engine works.
+   *
+   * \return  The CRF on which the mean-field inference engine works.
+   */
+  CRF2D_CPtr get_crf() const
+  {
+    return m_crf;
+  }
+
+  /**
+   * \brief Gets the labels that appear in the CRF, in the order in which they are stored in the tensors.
+   *
+   * \return  The labels that appear in the CRF.
+   */
+  const std::vector<Label>& get_labels() const
+  {
+    return m_labels;
+  }
+
+  /**
+   * \brief Gets the marginal probabilities for the pixels in the CRF, as a dense height x width x labels tensor.
+   *
+   * \return  The marginal probabilities for the pixels in the CRF.
+   */
+  const std::vector<float>& get_marginals() const
+  {
+    return m_marginals;
+  }
+
+  /**
+   * \brief Predicts the labels for each pixel in the CRF directly from the dense marginals.
+   *
+   * \return  The grid of predicted labels (indexed in the same way as the grids in the CRF).
+   */
+  Grid<Label> predict_labels() const
+  {
+    const int height = m_crf->get_height(), width = m_crf->get_width();
+    const int labelCount = static_cast<int>(m_labels.size());
+
+    Grid<Label> result(height, width);
+    for(int y = 0; y < height; ++y)
+    {
+      for(int x = 0; x < width; ++x)
+      {
+        const float *Q_i = &m_marginals[pixel_index(Eigen::Vector2i(x, y)) * labelCount];
+        result(y, x) = m_labels[std::max_element(Q_i, Q_i + labelCount) - Q_i];
+      }
+    }
+
+    return result;
+  }
+
+  /**
+   * \brief Updates the CRF on which the mean-field inference engine works.
+   *
+   * \param iterations  The number of update iterations to run.
+   */
+  void update_crf(size_t iterations)
+  {
+    if(m_labels.empty()) return;
+
+    for(size_t i = 0; i < iterations; ++i)
+    {
+      update_marginals();
+    }
+
+    // Copy the marginals back into the CRF.
+    write_marginals_to_crf();
+  }
+
+  //#################### PRIVATE MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Gets the index of the specified pixel within the (row-major) pixel ordering used by the tensors and lattices.
+   *
+   * \param loc The location of the pixel.
+   * \return    The index of the pixel.
+   */
+  size_t pixel_index(const Eigen::Vector2i& loc) const
+  {
+    return static_cast<size_t>(loc.y()) * m_crf->get_width() + loc.x();
+  }
+
+  /**
+   * \brief Computes the updated marginals for every pixel in the CRF.
+   */
+  void update_marginals()
+  {
+    const int pixelCount = m_crf->get_height() * m_crf->get_width();
+    const int labelCount = static_cast<int>(m_labels.size());
+
+    // Compute \sum_j k(f_i,f_j) Q_j^{t-1}(L') for each kernel, for every pixel i and label L'.
+    m_appearanceLattice->filter(&m_marginals[0], &m_appearanceMessages[0], labelCount);
+    m_smoothnessLattice->filter(&m_marginals[0], &m_smoothnessMessages[0], labelCount);
+
+    // Note: Since the messages have already been computed, the marginals can safely be updated in place.
+#ifdef WITH_OPENMP
+    #pragma omp parallel
+#endif
+    {
+      // Allocate the per-thread storage needed to update the pixels.
+      Eigen::VectorXf M_i(labelCount), S_i(labelCount);
+
+#ifdef WITH_OPENMP
+      #pragma omp for
+#endif
+      for(int i = 0; i < pixelCount; ++i)
+      {
+        const size_t offset = static_cast<size_t>(i) * labelCount;
+
+        // Calculate M_i(L) = phi_i(L) + \sum_{L'} mu(L,L') * (w_a * appearance message + w_s * smoothness message)(L').
+        S_i = m_kernelParameters.appearanceWeight * ConstVectorMap(&m_appearanceMessages[offset], labelCount)
+            + m_kernelParameters.smoothnessWeight * ConstVectorMap(&m_smoothnessMessages[offset], labelCount);
+        M_i.noalias() = m_pairwisePotentials * S_i;
+        M_i += ConstVectorMap(&m_unaryPotentials[offset], labelCount);
+
+        // Calculate Q_i^t(L) = 1/Z_i * e^-M_i(L) (subtracting the smallest M_i(L) first to prevent underflow).
+        VectorMap Q_i(&m_marginals[offset], labelCount);
+        Q_i = (-(M_i.array() - M_i.minCoeff())).exp();
+        Q_i /= Q_i.sum();
+      }
+    }
+  }
+
+  /**
+   * \brief Copies the dense marginals back into the CRF.
+   */
+  void write_marginals_to_crf()
+  {
+    const int height = m_crf->get_height(), width = m_crf->get_width();
+    const int labelCount = static_cast<int>(m_labels.size());
+
+    ProbabilitiesGrid_Ptr marginals(new ProbabilitiesGrid(height, width));
+    for(int y = 0; y < height; ++y)
+    {
+      for(int x = 0; x < width; ++x)
+      {
+        const float *Q_i = &m_marginals[pixel_index(Eigen::Vector2i(x, y)) * labelCount];
+        std::map<Label,float>& target = (*marginals)(y, x);
+        for(int k = 0; k < labelCount; ++k)
+        {
+          target.insert(target.end(), std::make_pair(m_labels[k], Q_i[k]));
+        }
+      }
+    }
+
+    m_crf->swap_marginals(marginals);
+  }
+};
+
+}
+
+#endif
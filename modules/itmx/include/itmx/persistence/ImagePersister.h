@@ -11,8 +11,7 @@
 #include <boost/bind.hpp>
 #include <boost/filesystem.hpp>
 
-#include <tvgutil/misc/ThreadPool.h>
-
+#include "PersistenceExecutor.h"
 #include "../base/ITMImagePtrTypes.h"
 
 namespace itmx {
@@ -86,6 +85,9 @@ public:
   /**
    * \brief Attempts to save an image to a file on a separate thread.
    *
+   * The image is saved using the persistence executor. If the executor's queue is full, its queue full
+   * strategy determines whether the caller blocks or a pending save is discarded.
+   *
    * \param image               The image to save.
    * \param path                The path to the file to which to save it.
    * \param fileType            The image file type.
@@ -95,7 +97,7 @@ public:
   static void save_image_on_thread(const boost::shared_ptr<const ORUtils::Image<T> >& image, const std::string& path, ImageFileType fileType = IFT_UNKNOWN)
   {
     void (*p)(const boost::shared_ptr<const ORUtils::Image<T> >&, const std::string&, ImageFileType) = &save_image;
-    tvgutil::ThreadPool::instance().post_task(boost::bind(p, image, path, fileType));
+    PersistenceExecutor::instance().post_task(boost::bind(p, image, path, fileType));
   }
 
   /**
@@ -0,0 +1,47 @@
+/**
+ * itmx: PersistenceExecutor.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2017. All rights reserved.
+ */
+
+#ifndef H_ITMX_PERSISTENCEEXECUTOR
+#define H_ITMX_PERSISTENCEEXECUTOR
+
+#include <tvgutil/misc/BoundedThreadPool.h>
+
+namespace itmx {
+
+/**
+ * \brief This class provides access to the bounded thread pool that is used to save images and poses to disk asynchronously.
+ *
+ * Persistence tasks are executed on a dedicated thread pool (with one thread for each task that may execute at once), so
+ * that they never compete with the tasks on the global thread pool. They are posted via a bounded queue: each task holds
+ * a copy of an image until it has been written, so the number of tasks that may be waiting at once must be bounded to keep
+ * memory usage under control.
+ */
+class PersistenceExecutor
+{
+  //#################### PUBLIC STATIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Configures the persistence executor.
+   *
+   * \note  This must be called (if at all) before the executor is first used.
+   *
+   * \param maxConcurrency      The maximum number of persistence tasks that can be executing at once.
+   * \param capacity            The maximum number of persistence tasks that can be waiting at once.
+   * \param queueFullStrategy   A strategy specifying what should happen when a task is posted while the queue is full.
+   * \throws std::runtime_error If the executor has already been used.
+   */
+  static void configure(size_t maxConcurrency, size_t capacity, tvgutil::bounded_thread_pool::QueueFullStrategy queueFullStrategy);
+
+  /**
+   * \brief Gets the bounded thread pool that is used to execute persistence tasks, constructing it if necessary.
+   *
+   * \return  The bounded thread pool that is used to execute persistence tasks.
+   */
+  static tvgutil::BoundedThreadPool& instance();
+};
+
+}
+
+#endif
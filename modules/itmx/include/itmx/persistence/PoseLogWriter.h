@@ -0,0 +1,127 @@
+/**
+ * itmx: PoseLogWriter.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2017. All rights reserved.
+ */
+
+#ifndef H_ITMX_POSELOGWRITER
+#define H_ITMX_POSELOGWRITER
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include <ITMLib/Utils/ITMMath.h>
+
+namespace itmx {
+
+/**
+ * \brief An instance of this class can be used to write a sequence of camera poses to a single append-only log file.
+ *
+ * Each line of the log contains a frame index, followed by the 16 entries of the corresponding pose matrix (in the
+ * same order in which PosePersister::save_pose writes them). Poses are accumulated into batches, and each batch is
+ * appended to the log asynchronously using the persistence executor. This avoids creating a separate small file for
+ * every frame of a long recording.
+ */
+class PoseLogWriter
+{
+  //#################### NESTED TYPES ####################
+private:
+  /**
+   * \brief An instance of this struct contains the state that is shared between a pose log writer and its pending write tasks.
+   */
+  struct SharedState
+  {
+    /** A mutex used to serialise writes to the log file. */
+    boost::mutex fileMutex;
+
+    /** The log file stream. */
+    std::ofstream fs;
+
+    /** A mutex used to synchronise access to the pending text. */
+    boost::mutex pendingMutex;
+
+    /** Text that has been flushed by the writer but not yet appended to the log file. */
+    std::string pendingText;
+  };
+
+  typedef boost::shared_ptr<SharedState> SharedState_Ptr;
+
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The poses in the current batch, formatted as log lines. */
+  std::ostringstream m_batch;
+
+  /** The number of poses in the current batch. */
+  size_t m_batchPoseCount;
+
+  /** The number of poses to accumulate before appending them to the log. */
+  size_t m_batchSize;
+
+  /** The path to the log file. */
+  std::string m_path;
+
+  /** The state that is shared between the writer and its pending write tasks. */
+  SharedState_Ptr m_sharedState;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs a pose log writer.
+   *
+   * \param path                The path to the log file (any existing poses in the file will be preserved).
+   * \param batchSize           The number of poses to accumulate before appending them to the log.
+   * \throws std::runtime_error If the log file could not be opened.
+   */
+  explicit PoseLogWriter(const std::string& path, size_t batchSize = 30);
+
+  //#################### DESTRUCTOR ####################
+public:
+  /**
+   * \brief Destroys the pose log writer, flushing any poses that have not yet been appended to the log.
+   */
+  ~PoseLogWriter();
+
+  //#################### COPY CONSTRUCTOR & ASSIGNMENT OPERATOR ####################
+private:
+  // Deliberately private and unimplemented.
+  PoseLogWriter(const PoseLogWriter&);
+  PoseLogWriter& operator=(const PoseLogWriter&);
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Adds a pose to the log.
+   *
+   * \param frameIndex  The index of the frame with which the pose is associated.
+   * \param pose        The pose matrix.
+   */
+  void append_pose(int frameIndex, const Matrix4f& pose);
+
+  /**
+   * \brief Asynchronously appends any poses in the current batch to the log.
+   */
+  void flush();
+
+  /**
+   * \brief Gets the path to the log file.
+   *
+   * \return  The path to the log file.
+   */
+  const std::string& get_path() const;
+
+  //#################### PRIVATE STATIC MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Appends any pending text to the log file.
+   *
+   * \param sharedState The state that is shared between the writer and its pending write tasks.
+   */
+  static void write_pending_text(const SharedState_Ptr& sharedState);
+};
+
+}
+
+#endif
@@ -7,7 +7,7 @@
 #define H_ITMX_MAPPINGCLIENT
 
 #include <tvgutil/boost/WrappedAsio.h>
-#include <tvgutil/containers/PooledQueue.h>
+#include <tvgutil/containers/SPSCPooledQueue.h>
 
 #include "RGBDCalibrationMessage.h"
 #include "RGBDFrameCompressor.h"
@@ -22,14 +22,14 @@ class MappingClient
 {
   //#################### TYPEDEFS ####################
 public:
-  typedef tvgutil::PooledQueue<RGBDFrameMessage_Ptr> RGBDFrameMessageQueue;
+  typedef tvgutil::SPSCPooledQueue<RGBDFrameMessage_Ptr> RGBDFrameMessageQueue;
 
   //#################### PRIVATE VARIABLES ####################
 private:
   /** A frame compressor, used to compress frame messages to reduce the network bandwidth they consume. */
   RGBDFrameCompressor_Ptr m_frameCompressor;
 
-  /** A queue containing the RGB-D frame messages to be sent to the server. */
+  /** A queue containing the RGB-D frame messages to be sent to the server (pushed by the caller's thread and popped by the message sender thread). */
   RGBDFrameMessageQueue m_frameMessageQueue;
 
   /** The TCP stream used as a wrapper around the connection to the server. */
@@ -40,9 +40,10 @@ public:
   /**
    * \brief Constructs a mapping client.
    *
-   * \param host              The mapping host to which to connect.
-   * \param port              The port on the mapping host to which to connect.
-   * \param poolEmptyStrategy A strategy specifying what should happen when a push is attempted while the frame message queue's pool is empty.
+   * \param host                The mapping host to which to connect.
+   * \param port                The port on the mapping host to which to connect.
+   * \param poolEmptyStrategy   A strategy specifying what should happen when a push is attempted while the frame message queue's pool is empty.
+   * \throws std::runtime_error If the pool empty strategy is not supported by the frame message queue (i.e. is not 'discard' or 'wait').
    */
   explicit MappingClient(const std::string& host = "localhost", const std::string& port = "7851", tvgutil::pooled_queue::PoolEmptyStrategy poolEmptyStrategy = tvgutil::pooled_queue::PES_DISCARD);
 
@@ -17,7 +17,7 @@
 #include <ITMLib/Objects/Camera/ITMRGBDCalib.h>
 
 #include <tvgutil/boost/WrappedAsio.h>
-#include <tvgutil/containers/PooledQueue.h>
+#include <tvgutil/containers/SPSCPooledQueue.h>
 
 #include "RGBDFrameMessage.h"
 
@@ -30,7 +30,7 @@ class MappingServer
 {
   //#################### TYPEDEFS ####################
 private:
-  typedef tvgutil::PooledQueue<RGBDFrameMessage_Ptr> RGBDFrameMessageQueue;
+  typedef tvgutil::SPSCPooledQueue<RGBDFrameMessage_Ptr> RGBDFrameMessageQueue;
   typedef boost::shared_ptr<RGBDFrameMessageQueue> RGBDFrameMessageQueue_Ptr;
 
   //#################### ENUMERATIONS ####################
@@ -57,7 +57,7 @@ private:
     /** The calibration parameters of the camera associated with the client. */
     ITMLib::ITMRGBDCalib m_calib;
 
-    /** A queue containing the RGB-D frame messages received from the client. */
+    /** A queue containing the RGB-D frame messages received from the client (pushed by the client's thread and popped by the thread that reads the images and poses). */
     RGBDFrameMessageQueue_Ptr m_frameMessageQueue;
 
     /** A flag indicating whether or not the images associated with the first message in the queue have already been read. */
@@ -33,9 +33,57 @@ inline float rgb_to_lab_f(float t)
   return t > 0.008856f ? pow(t, 1.0f / 3.0f) : 7.787f * t + 16.0f / 116.0f;
 }
 
+/**
+ * \brief A helper function for the RGB to CIELab conversion that performs its first stage, namely converting an RGB colour
+ *        to CIEXYZ and normalising the result by the reference white point.
+ *
+ * \param r The red component of the colour (in the range [0,1]).
+ * \param g The green component of the colour (in the range [0,1]).
+ * \param b The blue component of the colour (in the range [0,1]).
+ * \param x Used to return the normalised X component of the colour.
+ * \param y Used to return the normalised Y component of the colour.
+ * \param z Used to return the normalised Z component of the colour.
+ */
+_CPU_AND_GPU_CODE_
+inline void rgb_to_lab_xyz(float r, float g, float b, float& x, float& y, float& z)
+{
+  x = (0.412453f * r + 0.357580f * g + 0.180423f * b) / 0.950456f;
+  y = 0.212671f * r + 0.715160f * g + 0.072169f * b;
+  z = (0.019334f * r + 0.119193f * g + 0.950227f * b) / 1.088754f;
+}
+
+/**
+ * \brief A helper function for the RGB to CIELab conversion that performs its final stage, namely computing the (normalised)
+ *        CIELab colour from the normalised Y component of the colour and the results of applying rgb_to_lab_f to X, Y and Z.
+ *
+ * \param y   The normalised Y component of the colour.
+ * \param fx  The result of applying rgb_to_lab_f to the normalised X component of the colour.
+ * \param fy  The result of applying rgb_to_lab_f to the normalised Y component of the colour.
+ * \param fz  The result of applying rgb_to_lab_f to the normalised Z component of the colour.
+ * \param L   Used to return the L component of the CIELab colour.
+ * \param A   Used to return the (normalised) A component of the CIELab colour.
+ * \param B   Used to return the (normalised) B component of the CIELab colour.
+ */
+_CPU_AND_GPU_CODE_
+inline void rgb_to_lab_from_f(float y, float fx, float fy, float fz, float& L, float& A, float& B)
+{
+  const float EPSILON = 0.000001f;
+
+  L = y > 0.008856f ? (116.0f * fy - 16.0f) : (903.3f * y);
+  A = 500.0f * (fx - fy);
+  B = 200.0f * (fy - fz);
+
+  const float AplusB = fabs(A + B) + EPSILON;
+  A /= AplusB;
+  B /= AplusB;
+}
+
 /**
  * \brief Converts an RGB colour to CIELab.
  *
+ * The conversion is split into stages (rgb_to_lab_xyz, rgb_to_lab_f and rgb_to_lab_from_f) so that code that converts
+ * many colours at once can apply each stage to all of the colours in turn without duplicating the conversion itself.
+ *
  * \param rgb The RGB colour.
  * \return    The result of converting the colour to CIELab.
  */
@@ -44,26 +92,11 @@ inline Vector3f convert_rgb_to_lab(const Vector3f& rgb)
 {
   // Equivalent Matlab code can be found at: https://www.eecs.berkeley.edu/Research/Projects/CS/vision/bsds/code/Util/RGB2Lab.m
   // See also: http://docs.opencv.org/modules/imgproc/doc/miscellaneous_transformations.html
-  const float EPSILON = 0.000001f;
+  float x, y, z;
+  rgb_to_lab_xyz(rgb.r, rgb.g, rgb.b, x, y, z);
 
-  float x = 0.412453f * rgb.r + 0.357580f * rgb.g + 0.180423f * rgb.b;
-  float y = 0.212671f * rgb.r + 0.715160f * rgb.g + 0.072169f * rgb.b;
-  float z = 0.019334f * rgb.r + 0.119193f * rgb.g + 0.950227f * rgb.b;
-
-  x /= 0.950456f;
-  z /= 1.088754f;
-
-  float fx = rgb_to_lab_f(x);
-  float fy = rgb_to_lab_f(y);
-  float fz = rgb_to_lab_f(z);
-
-  float L = y > 0.008856f ? (116.0f * fy - 16.0f) : (903.3f * y);
-  float A = 500.0f * (fx - fy);
-  float B = 200.0f * (fy - fz);
-
-  float AplusB = fabs(A + B) + EPSILON;
-  A /= AplusB;
-  B /= AplusB;
+  float L, A, B;
+  rgb_to_lab_from_f(y, rgb_to_lab_f(x), rgb_to_lab_f(y), rgb_to_lab_f(z), L, A, B);
 
   return Vector3f(L, A, B);
 }
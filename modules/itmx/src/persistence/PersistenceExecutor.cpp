@@ -0,0 +1,63 @@
+/**
+ * itmx: PersistenceExecutor.cpp
+ * Copyright (c) Torr Vision Group, University of Oxford, 2017. All rights reserved.
+ */
+
+#include "persistence/PersistenceExecutor.h"
+
+#include <stdexcept>
+using namespace tvgutil;
+using namespace tvgutil::bounded_thread_pool;
+
+namespace itmx {
+
+//#################### LOCAL VARIABLES ####################
+
+namespace {
+
+/** The maximum number of persistence tasks that can be waiting at once. */
+size_t s_capacity = 64;
+
+/** The maximum number of persistence tasks that can be executing at once. */
+size_t s_maxConcurrency = 4;
+
+/** The synchronisation mutex. */
+boost::mutex s_mutex;
+
+/** The strategy specifying what should happen when a task is posted while the queue is full. */
+QueueFullStrategy s_queueFullStrategy = QFS_WAIT;
+
+/** Whether or not the executor has been used yet. */
+bool s_used = false;
+
+}
+
+//#################### PUBLIC STATIC MEMBER FUNCTIONS ####################
+
+void PersistenceExecutor::configure(size_t maxConcurrency, size_t capacity, QueueFullStrategy queueFullStrategy)
+{
+  boost::lock_guard<boost::mutex> lock(s_mutex);
+  if(s_used) throw std::runtime_error("Error: Cannot configure the persistence executor after it has been used");
+
+  s_maxConcurrency = maxConcurrency;
+  s_capacity = capacity;
+  s_queueFullStrategy = queueFullStrategy;
+}
+
+BoundedThreadPool& PersistenceExecutor::instance()
+{
+  boost::lock_guard<boost::mutex> lock(s_mutex);
+  s_used = true;
+
+  // Note: The persistence tasks are executed on a thread pool of their own rather than on the global thread pool, so that they
+  //       cannot be held up by (or hold up) long-running tasks such as background forest training. This matters because when
+  //       the queue is full, posting a task can block the calling thread until a persistence task finishes. The bounded thread
+  //       pool must be destroyed before the thread pool on whose threads it executes its tasks, since it waits for any remaining
+  //       tasks to finish when it is destroyed. Since function-local statics are destroyed in the reverse order of their
+  //       construction, constructing the underlying thread pool first ensures this.
+  static ThreadPool s_threadPool(s_maxConcurrency);
+  static BoundedThreadPool s_pool(s_maxConcurrency, s_capacity, s_queueFullStrategy, s_threadPool);
+  return s_pool;
+}
+
+}
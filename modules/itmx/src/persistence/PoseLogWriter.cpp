@@ -0,0 +1,92 @@
+/**
+ * itmx: PoseLogWriter.cpp
+ * Copyright (c) Torr Vision Group, University of Oxford, 2017. All rights reserved.
+ */
+
+#include "persistence/PoseLogWriter.h"
+
+#include <stdexcept>
+
+#include <boost/bind.hpp>
+
+#include "persistence/PersistenceExecutor.h"
+
+namespace itmx {
+
+//#################### CONSTRUCTORS ####################
+
+PoseLogWriter::PoseLogWriter(const std::string& path, size_t batchSize)
+: m_batchPoseCount(0), m_batchSize(batchSize), m_path(path), m_sharedState(new SharedState)
+{
+  m_sharedState->fs.open(path.c_str(), std::ios::out | std::ios::app);
+  if(!m_sharedState->fs) throw std::runtime_error("Could not open pose log file: " + path);
+}
+
+//#################### DESTRUCTOR ####################
+
+PoseLogWriter::~PoseLogWriter()
+{
+  flush();
+}
+
+//#################### PUBLIC MEMBER FUNCTIONS ####################
+
+void PoseLogWriter::append_pose(int frameIndex, const Matrix4f& pose)
+{
+  // Write the pose into the current batch, using the same entry order as PosePersister::save_pose.
+  m_batch << frameIndex;
+  for(int y = 0; y < 4; ++y)
+  {
+    m_batch << ' ' << pose(0, y) << ' ' << pose(1, y) << ' ' << pose(2, y) << ' ' << pose(3, y);
+  }
+  m_batch << '\n';
+
+  // If the batch is now full, append it to the log.
+  if(++m_batchPoseCount >= m_batchSize) flush();
+}
+
+void PoseLogWriter::flush()
+{
+  if(m_batchPoseCount == 0) return;
+
+  // Hand the current batch over to the shared state, and then start a new batch.
+  {
+    boost::lock_guard<boost::mutex> lock(m_sharedState->pendingMutex);
+    m_sharedState->pendingText += m_batch.str();
+  }
+
+  m_batch.str("");
+  m_batchPoseCount = 0;
+
+  // Post a task to append the pending text to the log. We give it priority over any queued images, since these are
+  // much more expensive to write. Note that if the executor discards the task, the text stays pending and will be
+  // written by the next task that does run, so no poses are lost.
+  PersistenceExecutor::instance().post_task(
+    boost::bind(&PoseLogWriter::write_pending_text, m_sharedState),
+    tvgutil::bounded_thread_pool::TP_HIGH
+  );
+}
+
+const std::string& PoseLogWriter::get_path() const
+{
+  return m_path;
+}
+
+//#################### PRIVATE STATIC MEMBER FUNCTIONS ####################
+
+void PoseLogWriter::write_pending_text(const SharedState_Ptr& sharedState)
+{
+  // Note: We take the pending text whilst holding the file mutex, to ensure that batches are written in the order in which they were flushed.
+  boost::lock_guard<boost::mutex> fileLock(sharedState->fileMutex);
+
+  std::string text;
+  {
+    boost::lock_guard<boost::mutex> pendingLock(sharedState->pendingMutex);
+    text.swap(sharedState->pendingText);
+  }
+
+  sharedState->fs << text;
+  sharedState->fs.flush();
+}
+
+}
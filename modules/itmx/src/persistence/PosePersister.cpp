@@ -8,8 +8,9 @@
 #include <fstream>
 #include <stdexcept>
 
-#include <tvgutil/misc/ThreadPool.h>
-using tvgutil::ThreadPool;
+#include <boost/bind.hpp>
+
+#include "persistence/PersistenceExecutor.h"
 
 namespace bf = boost::filesystem;
 
@@ -41,8 +42,8 @@ void PosePersister::save_pose_on_thread(const Matrix4f& pose, const std::string&
   // Select the save_pose overload that takes a string.
   void (*f)(const Matrix4f&, const std::string&) = &save_pose;
 
-  // Call it on a separate thread.
-  ThreadPool::instance().post_task(boost::bind(f, pose, path));
+  // Call it on a separate thread. Poses are tiny but cannot be regenerated, so we give them priority over images.
+  PersistenceExecutor::instance().post_task(boost::bind(f, pose, path), tvgutil::bounded_thread_pool::TP_HIGH);
 }
 
 void PosePersister::save_pose_on_thread(const Matrix4f& pose, const bf::path& path)
@@ -6,9 +6,13 @@
 #ifndef H_RAFL_DECISIONTREE
 #define H_RAFL_DECISIONTREE
 
+#include <limits>
 #include <set>
 #include <stdexcept>
 
+#include <boost/chrono/chrono.hpp>
+#include <boost/optional.hpp>
+
 #include <tvgutil/containers/PriorityQueue.h>
 #include <tvgutil/persistence/PropertyUtil.h>
 
@@ -16,6 +20,10 @@
 
 namespace rafl {
 
+//#################### FORWARD DECLARATIONS ####################
+
+template <typename Label> class FlatRandomForest;
+
 /**
  * \brief An instance of an instantiation of this class template represents a tree suitable for use within a random forest.
  */
@@ -37,6 +45,12 @@ private:
     /** The index of the node's left child in the tree's node array. */
     int m_leftChildIndex;
 
+    /**
+     * The cached PMF for the node (leaves only), stored as a dense vector of masses indexed by the tree's label indices.
+     * Any labels beyond the end of the vector have a mass of zero. This is empty if the node's reservoir is empty.
+     */
+    std::vector<float> m_pmf;
+
     /** The reservoir of examples currently stored in the node. */
     ExampleReservoir<Label> m_reservoir;
 
@@ -260,6 +274,7 @@ public:
 
   //#################### PRIVATE TYPEDEFS ####################
 private:
+  typedef boost::chrono::steady_clock Clock;
   typedef boost::shared_ptr<const Example<Label> > Example_CPtr;
   typedef boost::shared_ptr<Node> Node_Ptr;
   typedef tvgutil::PriorityQueue<int,float,signed char,std::greater<float> > SplittabilityQueue;
@@ -278,6 +293,12 @@ private:
   /** A flag indicating whether or not the tree is valid (trees are invalid until we have started to train them). */
   bool m_isValid;
 
+  /** A map from the labels seen by the tree to their indices in the cached leaf PMFs. */
+  std::map<Label,size_t> m_labelIndices;
+
+  /** The labels seen by the tree, in the order in which they are indexed in the cached leaf PMFs. */
+  std::vector<Label> m_labels;
+
   /** The nodes in the tree. */
   std::vector<Node_Ptr> m_nodes;
 
@@ -356,6 +377,17 @@ public:
     // since the splittability calculations for the dirty nodes depend on the new weights).
     update_inverse_class_weights();
 
+    // Update the cached PMFs of the leaves. If the class weights have changed, all of the PMFs need updating;
+    // if not, only those of the leaves to which examples have been added do.
+    if(m_inverseClassWeights && !indices.empty()) update_all_leaf_pmfs();
+    else
+    {
+      for(std::set<int>::const_iterator it = m_dirtyNodes.begin(), iend = m_dirtyNodes.end(); it != iend; ++it)
+      {
+        update_leaf_pmf(*it);
+      }
+    }
+
     // Recalculate the splittabilities of nodes to which examples have been added.
     update_dirty_nodes();
   }
@@ -390,6 +422,18 @@ public:
     return m_classFrequencies;
   }
 
+  /**
+   * \brief Gets the labels seen by the tree, in the order in which they are indexed in the dense PMFs returned by lookup_dense_pmf.
+   *
+   * New labels are only ever appended, so the index of a label never changes once the tree has seen it.
+   *
+   * \return  The labels seen by the tree.
+   */
+  const std::vector<Label>& get_labels() const
+  {
+    return m_labels;
+  }
+
   /**
    * \brief Gets the number of nodes in the tree.
    *
@@ -410,6 +454,16 @@ public:
     return m_treeDepth;
   }
 
+  /**
+   * \brief Gets whether or not the tree contains any nodes that are currently splittable enough to be worth trying to split.
+   *
+   * \return  true, if the tree contains any such nodes, or false otherwise.
+   */
+  bool has_splittable_nodes() const
+  {
+    return !m_splittabilityQueue.empty() && m_splittabilityQueue.top().key() >= m_settings.splittabilityThreshold;
+  }
+
   /**
    * \brief Gets whether or not the tree is valid.
    *
@@ -422,7 +476,21 @@ public:
     return m_isValid;
   }
 
- /**
+  /**
+   * \brief Looks up the cached, dense PMF for the leaf to which an example with the specified descriptor would be added.
+   *
+   * The PMF is a vector of masses indexed in the same way as the labels returned by get_labels. Any labels beyond the
+   * end of the vector have a mass of zero, and the vector will be empty if the leaf's reservoir is empty.
+   *
+   * \param descriptor  The descriptor.
+   * \return            The dense PMF for the leaf to which an example with that descriptor would be added.
+   */
+  const std::vector<float>& lookup_dense_pmf(const Descriptor_CPtr& descriptor) const
+  {
+    return m_nodes[find_leaf(*descriptor)]->m_pmf;
+  }
+
+  /**
    * \brief Looks up the probability mass function for the leaf to which an example with the specified descriptor would be added.
    *
    * \param descriptor  The descriptor.
@@ -434,6 +502,26 @@ public:
     return make_pmf(leafIndex);
   }
 
+  /**
+   * \brief Makes a deep copy of the decision tree that can be trained independently of the original.
+   *
+   * The nodes of the copy (including their example reservoirs) are separate from those of the original, so the copy
+   * can safely be trained on another thread whilst the original continues to be used. The examples themselves, the
+   * decision functions of the nodes that have already been split and the random number generator are shared, since
+   * they are either immutable or thread-safe.
+   *
+   * \return  The copy of the tree.
+   */
+  boost::shared_ptr<DecisionTree> make_snapshot() const
+  {
+    boost::shared_ptr<DecisionTree> snapshot(new DecisionTree(*this));
+    for(size_t i = 0, size = m_nodes.size(); i < size; ++i)
+    {
+      snapshot->m_nodes[i].reset(new Node(*m_nodes[i]));
+    }
+    return snapshot;
+  }
+
   /**
    * \brief Outputs the decision tree to a stream.
    *
@@ -465,32 +553,23 @@ public:
    */
   size_t train(size_t splitBudget)
   {
-    size_t nodesSplit = 0;
-
-    // Keep splitting nodes until we either run out of nodes to split or exceed the split budget. In practice,
-    // we will also stop splitting if the best node's splittability falls below a threshold. If the best node
-    // cannot be split at present, we remove it from the queue to give the other nodes a chance and re-add it
-    // at the end of the training step.
-    std::vector<typename SplittabilityQueue::Element> elementsToReAdd;
-    while(!m_splittabilityQueue.empty() && nodesSplit < splitBudget)
-    {
-      typename SplittabilityQueue::Element e = m_splittabilityQueue.top();
-      if(e.key() >= m_settings.splittabilityThreshold)
-      {
-        m_splittabilityQueue.pop();
-        if(split_node(e.id())) ++nodesSplit;
-        else elementsToReAdd.push_back(e);
-      }
-      else break;
-    }
-
-    // Re-add any elements corresponding to nodes that could not be successfully split in this training step.
-    for(typename std::vector<typename SplittabilityQueue::Element>::iterator it = elementsToReAdd.begin(), iend = elementsToReAdd.end(); it != iend; ++it)
-    {
-      m_splittabilityQueue.insert(it->id(), it->key(), it->data());
-    }
+    return train_sub(splitBudget, boost::none);
+  }
 
-    return nodesSplit;
+  /**
+   * \brief Trains the tree by splitting suitable nodes until the specified amount of time has elapsed.
+   *
+   * Unlike train, which bounds the number of nodes split, this bounds the time taken by the training step, which makes it
+   * more suitable for interactive use (the time taken to split a node varies greatly with the size of its reservoir). A new
+   * split is only attempted if the longest split attempt made so far in the step would still finish within the budget, so
+   * the budget can only be overrun by the first split attempt, or by an attempt that takes much longer than its predecessors.
+   *
+   * \param timeBudget  The amount of time that may be spent on this training step.
+   * \return            The number of nodes that have been split.
+   */
+  size_t train_for(const boost::chrono::microseconds& timeBudget)
+  {
+    return train_sub(std::numeric_limits<size_t>::max(), Clock::now() + timeBudget);
   }
 
   //#################### PRIVATE MEMBER FUNCTIONS ####################
@@ -513,6 +592,9 @@ private:
 
     // Update the class frequency histogram.
     m_classFrequencies.add(example->get_label());
+
+    // If the example's label has not been seen before, give it the next available index in the cached leaf PMFs.
+    if(m_labelIndices.insert(std::make_pair(example->get_label(), m_labels.size())).second) m_labels.push_back(example->get_label());
   }
 
   /**
@@ -603,14 +685,24 @@ private:
   }
 
   /**
-   * \brief Makes a probability mass function for the specified leaf.
+   * \brief Makes a probability mass function for the specified leaf from its cached, dense PMF.
    *
-   * \param leafIndex The leaf for which to make the probability mass function.
-   * \return          The probability mass function.
+   * \param leafIndex           The leaf for which to make the probability mass function.
+   * \return                    The probability mass function.
+   * \throws std::runtime_error If the leaf's reservoir is empty.
    */
   tvgutil::ProbabilityMassFunction<Label> make_pmf(int leafIndex) const
   {
-    return tvgutil::ProbabilityMassFunction<Label>(*m_nodes[leafIndex]->m_reservoir.get_histogram(), m_inverseClassWeights);
+    const std::vector<float>& pmf = m_nodes[leafIndex]->m_pmf;
+    if(pmf.empty()) throw std::runtime_error("Cannot make a probability mass function for a leaf with an empty reservoir");
+
+    std::map<Label,float> masses;
+    for(size_t k = 0, size = pmf.size(); k < size; ++k)
+    {
+      if(pmf[k] > 0.0f) masses.insert(std::make_pair(m_labels[k], pmf[k]));
+    }
+
+    return tvgutil::ProbabilityMassFunction<Label>(masses);
   }
 
   /**
@@ -684,16 +776,79 @@ private:
     fill_reservoir(split->m_leftExamples, multipliers, m_nodes[n.m_leftChildIndex]->m_reservoir);
     fill_reservoir(split->m_rightExamples, multipliers, m_nodes[n.m_rightChildIndex]->m_reservoir);
 
-    // Update the splittability for the child nodes.
+    // Update the splittability and cached PMF for the child nodes.
     update_splittability(n.m_leftChildIndex);
     update_splittability(n.m_rightChildIndex);
+    update_leaf_pmf(n.m_leftChildIndex);
+    update_leaf_pmf(n.m_rightChildIndex);
 
-    // Clear the example reservoir in the node that was split.
+    // Clear the example reservoir and cached PMF in the node that was split.
     n.m_reservoir.clear();
+    std::vector<float>().swap(n.m_pmf);
 
     return true;
   }
 
+  /**
+   * \brief Trains the tree by splitting a number of suitable nodes, optionally stopping early if a deadline is reached.
+   *
+   * \param splitBudget The maximum number of nodes that may be split in this training step.
+   * \param deadline    An optional time by which the training step should have finished.
+   * \return            The number of nodes that have been split.
+   */
+  size_t train_sub(size_t splitBudget, const boost::optional<Clock::time_point>& deadline)
+  {
+    size_t nodesSplit = 0;
+    Clock::duration longestSplitAttempt = Clock::duration::zero();
+
+    // Keep splitting nodes until we either run out of nodes to split or exceed the split budget. In practice,
+    // we will also stop splitting if the best node's splittability falls below a threshold, or if we are training
+    // to a deadline and the next split attempt might not finish in time. If the best node cannot be split at
+    // present, we remove it from the queue to give the other nodes a chance and re-add it at the end of the
+    // training step.
+    std::vector<typename SplittabilityQueue::Element> elementsToReAdd;
+    while(!m_splittabilityQueue.empty() && nodesSplit < splitBudget)
+    {
+      Clock::time_point startTime;
+      if(deadline)
+      {
+        startTime = Clock::now();
+        if(startTime + longestSplitAttempt >= *deadline) break;
+      }
+
+      typename SplittabilityQueue::Element e = m_splittabilityQueue.top();
+      if(e.key() >= m_settings.splittabilityThreshold)
+      {
+        m_splittabilityQueue.pop();
+        if(split_node(e.id())) ++nodesSplit;
+        else elementsToReAdd.push_back(e);
+
+        // Note that failed split attempts are timed as well, since they can be just as costly as successful ones.
+        if(deadline) longestSplitAttempt = std::max(longestSplitAttempt, Clock::now() - startTime);
+      }
+      else break;
+    }
+
+    // Re-add any elements corresponding to nodes that could not be successfully split in this training step.
+    for(typename std::vector<typename SplittabilityQueue::Element>::iterator it = elementsToReAdd.begin(), iend = elementsToReAdd.end(); it != iend; ++it)
+    {
+      m_splittabilityQueue.insert(it->id(), it->key(), it->data());
+    }
+
+    return nodesSplit;
+  }
+
+  /**
+   * \brief Updates the cached PMFs of all of the leaves in the tree.
+   */
+  void update_all_leaf_pmfs()
+  {
+    for(int nodeIndex = 0, nodeCount = static_cast<int>(m_nodes.size()); nodeIndex < nodeCount; ++nodeIndex)
+    {
+      if(is_leaf(nodeIndex)) update_leaf_pmf(nodeIndex);
+    }
+  }
+
   /**
    * \brief Updates the splittability values for any nodes whose reservoirs were changed whilst adding exmaples.
    */
@@ -708,6 +863,47 @@ private:
     m_dirtyNodes.clear();
   }
 
+  /**
+   * \brief Updates the cached PMF of the specified leaf to reflect the current contents of its reservoir and the current class weights.
+   *
+   * \param leafIndex The index of the leaf.
+   */
+  void update_leaf_pmf(int leafIndex)
+  {
+    std::vector<float>& pmf = m_nodes[leafIndex]->m_pmf;
+    const tvgutil::Histogram<Label>& histogram = *m_nodes[leafIndex]->m_reservoir.get_histogram();
+    if(histogram.empty())
+    {
+      pmf.clear();
+      return;
+    }
+
+    // Determine the masses for the labels in the histogram by dividing the number of instances in each bin by the histogram count,
+    // scaling them by the relevant class weights (if any).
+    pmf.assign(m_labels.size(), 0.0f);
+    const size_t count = histogram.get_count();
+    float sum = 0.0f;
+    const std::map<Label,size_t>& bins = histogram.get_bins();
+    for(typename std::map<Label,size_t>::const_iterator it = bins.begin(), iend = bins.end(); it != iend; ++it)
+    {
+      float mass = static_cast<float>(it->second) / count;
+      if(m_inverseClassWeights)
+      {
+        typename std::map<Label,float>::const_iterator jt = m_inverseClassWeights->find(it->first);
+        if(jt != m_inverseClassWeights->end()) mass *= jt->second;
+      }
+
+      pmf[m_labelIndices.find(it->first)->second] = mass;
+      sum += mass;
+    }
+
+    // If the masses were scaled, renormalise them.
+    if(m_inverseClassWeights)
+    {
+      for(size_t k = 0, size = pmf.size(); k < size; ++k) pmf[k] /= sum;
+    }
+  }
+
   /**
    * \brief Updates the splittability of the specified node.
    *
@@ -750,13 +946,49 @@ private:
   //#################### SERIALIZATION ####################
 private:
   /**
-   * \brief Serializes the decision tree to/from an archive.
+   * \brief Loads the decision tree from an archive.
+   *
+   * The label indices and cached leaf PMFs are not saved, so they are rebuilt once the rest of the tree has been loaded.
    *
    * \param ar      The archive.
    * \param version The file format version number.
    */
   template <typename Archive>
-  void serialize(Archive& ar, const unsigned int version)
+  void load(Archive& ar, const unsigned int version)
+  {
+    serialize_common(ar);
+
+    m_labelIndices.clear();
+    m_labels.clear();
+    const std::map<Label,size_t>& bins = m_classFrequencies.get_bins();
+    for(typename std::map<Label,size_t>::const_iterator it = bins.begin(), iend = bins.end(); it != iend; ++it)
+    {
+      m_labelIndices.insert(std::make_pair(it->first, m_labels.size()));
+      m_labels.push_back(it->first);
+    }
+
+    update_all_leaf_pmfs();
+  }
+
+  /**
+   * \brief Saves the decision tree to an archive.
+   *
+   * \param ar      The archive.
+   * \param version The file format version number.
+   */
+  template <typename Archive>
+  void save(Archive& ar, const unsigned int version) const
+  {
+    const_cast<DecisionTree*>(this)->serialize_common(ar);
+  }
+
+  /**
+   * \brief Serializes the saved parts of the decision tree to/from an archive.
+   *
+   * \param ar  The archive.
+   */
+  template <typename Archive>
+  void serialize_common(Archive& ar)
   {
     ar & m_classFrequencies;
     ar & m_dirtyNodes;
@@ -769,7 +1001,13 @@ private:
     ar & m_treeDepth;
   }
 
+  BOOST_SERIALIZATION_SPLIT_MEMBER()
+
   friend class boost::serialization::access;
+
+  //#################### FRIENDS ####################
+
+  friend class FlatRandomForest<Label>;
 };
 
 }
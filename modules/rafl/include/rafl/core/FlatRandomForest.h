@@ -0,0 +1,601 @@
+/**
+ * rafl: FlatRandomForest.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2017. All rights reserved.
+ */
+
+#ifndef H_RAFL_FLATRANDOMFOREST
+#define H_RAFL_FLATRANDOMFOREST
+
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/is_pod.hpp>
+
+#include "../decisionfunctions/FeatureThresholdingDecisionFunction.h"
+#include "../decisionfunctions/PairwiseOpAndThresholdDecisionFunction.h"
+#include "RandomForest.h"
+
+namespace rafl {
+
+/**
+ * \brief This struct describes the layout of a flat random forest file.
+ *
+ * A flat random forest file consists of a fixed-size header, followed by contiguous arrays containing (in order) the labels
+ * known to the forest, the indices of the root nodes of the trees, the nodes themselves, the dense leaf PMFs (one row of
+ * masses per leaf, with one column per label) and, optionally, the dense leaf histograms (laid out in the same way). All
+ * values are stored in the native byte order of the machine that wrote the file.
+ */
+struct FlatRandomForestFormat
+{
+  //#################### CONSTANTS ####################
+
+  /** The flag that is set in the header iff the file contains leaf histograms. */
+  static const boost::uint32_t HAS_LEAF_HISTOGRAMS = 1;
+
+  /** The version of the format that is written (and the only version that can currently be read). */
+  static const boost::uint32_t VERSION = 1;
+
+  //#################### ENUMERATIONS ####################
+
+  /**
+   * \brief The different kinds of node that can appear in a flat forest.
+   */
+  enum NodeKind
+  {
+    /** A leaf node. */
+    NK_LEAF,
+
+    /** A branch node that tests an individual feature against a threshold. */
+    NK_FEATURE_THRESHOLD,
+
+    /** A branch node that tests the sum of two features against a threshold. */
+    NK_PAIRWISE_ADD,
+
+    /** A branch node that tests the difference of two features against a threshold. */
+    NK_PAIRWISE_SUBTRACT
+  };
+
+  //#################### NESTED TYPES ####################
+
+  /**
+   * \brief An instance of this struct represents the header of a flat random forest file.
+   */
+  struct Header
+  {
+    /** The magic number that identifies the file as a flat random forest file. */
+    char magic[8];
+
+    /** The version of the format in which the file was written. */
+    boost::uint32_t version;
+
+    /** The size (in bytes) of each label (used to check that the file is read with the same label type with which it was written). */
+    boost::uint32_t labelSize;
+
+    /** The number of trees in the forest. */
+    boost::uint32_t treeCount;
+
+    /** The number of labels known to the forest. */
+    boost::uint32_t labelCount;
+
+    /** The total number of nodes in the forest. */
+    boost::uint32_t nodeCount;
+
+    /** The total number of leaves in the forest. */
+    boost::uint32_t leafCount;
+
+    /** A set of flags describing the optional contents of the file. */
+    boost::uint32_t flags;
+  };
+
+  /**
+   * \brief An instance of this struct represents a node in a flat forest.
+   */
+  struct Node
+  {
+    /** The kind of node (see NodeKind). */
+    boost::uint32_t kind;
+
+    /** The index of the node's left child in the node array (branch nodes only). */
+    boost::int32_t leftChildIndex;
+
+    /** The index of the node's right child in the node array (branch nodes only). */
+    boost::int32_t rightChildIndex;
+
+    /** The index of the first (or only) feature tested by the node (branch nodes only). */
+    boost::uint32_t firstFeatureIndex;
+
+    /** The index of the second feature tested by the node (pairwise branch nodes only). */
+    boost::uint32_t secondFeatureIndex;
+
+    /** The threshold against which the node compares its feature value (branch nodes only). */
+    float threshold;
+
+    /** The index of the node's row in the leaf arrays (leaf nodes only). */
+    boost::int32_t leafIndex;
+  };
+
+  //#################### PUBLIC STATIC MEMBER FUNCTIONS ####################
+
+  /**
+   * \brief Determines whether or not the specified file is a flat random forest file.
+   *
+   * \param filename  The name of the file.
+   * \return          true, if the file exists and starts with the flat random forest file magic number, or false otherwise.
+   */
+  static bool is_flat_forest_file(const std::string& filename)
+  {
+    std::ifstream fs(filename.c_str(), std::ios::binary);
+    char magicBuffer[8];
+    return fs.read(magicBuffer, sizeof(magicBuffer)) && memcmp(magicBuffer, magic(), sizeof(magicBuffer)) == 0;
+  }
+
+  /**
+   * \brief Gets the magic number that identifies a flat random forest file.
+   *
+   * \return  The magic number that identifies a flat random forest file.
+   */
+  static const char *magic()
+  {
+    return "RAFLFF01";
+  }
+};
+
+/**
+ * \brief An instance of an instantiation of this class template represents a trained random forest in a flat form that is suitable for inference only.
+ *
+ * The nodes of all the trees are stored in a single array (each tree's nodes in depth-first order), and the PMF of each leaf
+ * is stored as a dense row of masses, so that a PMF can be calculated without walking any pointers or building any maps
+ * other than the one for the result. A flat forest can be made from an ordinary random forest, and saved to and loaded
+ * from a compact binary file. The example reservoirs of the original forest are not retained, but the histograms of
+ * their contents can optionally be kept.
+ */
+template <typename Label>
+class FlatRandomForest
+{
+  BOOST_STATIC_ASSERT(boost::is_pod<Label>::value);
+
+  //#################### TYPEDEFS ####################
+private:
+  typedef DecisionTree<Label> DT;
+  typedef FlatRandomForestFormat::Node Node;
+
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The labels known to the forest (in ascending order). */
+  std::vector<Label> m_labels;
+
+  /** The total number of leaves in the forest. */
+  size_t m_leafCount;
+
+  /** The dense leaf histograms (one row per leaf, one column per label), if available. */
+  std::vector<boost::uint32_t> m_leafHistograms;
+
+  /** The dense leaf PMFs (one row per leaf, one column per label). */
+  std::vector<float> m_leafMasses;
+
+  /** The nodes of all the trees in the forest. */
+  std::vector<Node> m_nodes;
+
+  /** The indices of the root nodes of the trees in the node array. */
+  std::vector<boost::int32_t> m_treeRoots;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs a flat random forest from an ordinary random forest.
+   *
+   * \param forest              The ordinary random forest.
+   * \throws std::runtime_error If the forest contains a decision function of a type that cannot be flattened.
+   */
+  explicit FlatRandomForest(const RandomForest<Label>& forest)
+  : m_leafCount(0)
+  {
+    // Determine the labels known to the forest, i.e. those that appear in any of its leaf histograms.
+    std::set<Label> labels;
+    for(size_t i = 0, treeCount = forest.get_tree_count(); i < treeCount; ++i)
+    {
+      const DT& tree = *forest.get_tree(i);
+      for(size_t j = 0, nodeCount = tree.m_nodes.size(); j < nodeCount; ++j)
+      {
+        if(!tree.is_leaf(static_cast<int>(j))) continue;
+        const std::map<Label,size_t>& bins = tree.m_nodes[j]->m_reservoir.get_histogram()->get_bins();
+        for(typename std::map<Label,size_t>::const_iterator it = bins.begin(), iend = bins.end(); it != iend; ++it)
+        {
+          labels.insert(it->first);
+        }
+      }
+    }
+    m_labels.assign(labels.begin(), labels.end());
+
+    // Flatten the trees.
+    for(size_t i = 0, treeCount = forest.get_tree_count(); i < treeCount; ++i)
+    {
+      const DT& tree = *forest.get_tree(i);
+      m_treeRoots.push_back(flatten_subtree(tree, tree.m_rootIndex));
+    }
+  }
+
+  /**
+   * \brief Loads a flat random forest from the specified flat random forest file.
+   *
+   * \param filename            The name of the file.
+   * \throws std::runtime_error If the file cannot be opened, is not a flat random forest file, was written with a different
+   *                            label type or an unsupported version of the format, or is truncated.
+   */
+  explicit FlatRandomForest(const std::string& filename)
+  {
+    std::ifstream fs(filename.c_str(), std::ios::binary);
+    if(!fs) throw std::runtime_error("Error: '" + filename + "' could not be opened");
+
+    FlatRandomForestFormat::Header header;
+    if(!fs.read(reinterpret_cast<char*>(&header), sizeof(header)) || memcmp(header.magic, FlatRandomForestFormat::magic(), sizeof(header.magic)) != 0)
+    {
+      throw std::runtime_error("Error: '" + filename + "' is not a flat random forest file");
+    }
+
+    if(header.version != FlatRandomForestFormat::VERSION)
+    {
+      throw std::runtime_error("Error: '" + filename + "' was written with an unsupported version of the flat random forest format");
+    }
+
+    if(header.labelSize != sizeof(Label))
+    {
+      throw std::runtime_error("Error: The forest in '" + filename + "' was written with a different label type");
+    }
+
+    m_leafCount = header.leafCount;
+    const size_t leafCellCount = m_leafCount * header.labelCount;
+    read_array(fs, m_labels, header.labelCount, filename);
+    read_array(fs, m_treeRoots, header.treeCount, filename);
+    read_array(fs, m_nodes, header.nodeCount, filename);
+    read_array(fs, m_leafMasses, leafCellCount, filename);
+    if(header.flags & FlatRandomForestFormat::HAS_LEAF_HISTOGRAMS) read_array(fs, m_leafHistograms, leafCellCount, filename);
+  }
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Calculates an overall forest PMF for the specified descriptor.
+   *
+   * This is simply the average of the PMFs for the specified descriptor in the various decision trees. Every label known
+   * to the forest appears in the result, with a mass of zero if none of the relevant leaves contain it.
+   *
+   * \param descriptor          The descriptor.
+   * \return                    The PMF.
+   * \throws std::runtime_error If the forest does not know any labels.
+   */
+  tvgutil::ProbabilityMassFunction<Label> calculate_pmf(const Descriptor_CPtr& descriptor) const
+  {
+    if(m_labels.empty()) throw std::runtime_error("Error: Cannot calculate a PMF using a flat forest that does not know any labels");
+
+    // Sum the masses from the leaves reached by the descriptor in the individual trees.
+    const size_t labelCount = m_labels.size();
+    std::vector<float> summedMasses(labelCount, 0.0f);
+    for(size_t i = 0, treeCount = m_treeRoots.size(); i < treeCount; ++i)
+    {
+      const float *leafMasses = &m_leafMasses[find_leaf(i, *descriptor) * labelCount];
+      for(size_t k = 0; k < labelCount; ++k)
+      {
+        summedMasses[k] += leafMasses[k];
+      }
+    }
+
+    // Create a normalised probability mass function from the summed masses.
+    std::map<Label,float> masses;
+    for(size_t k = 0; k < labelCount; ++k)
+    {
+      masses.insert(masses.end(), std::make_pair(m_labels[k], summedMasses[k]));
+    }
+
+    return tvgutil::ProbabilityMassFunction<Label>(masses);
+  }
+
+  /**
+   * \brief Finds the leaf reached by the specified descriptor in the specified tree.
+   *
+   * \param treeIndex   The index of the tree.
+   * \param descriptor  The descriptor.
+   * \return            The index of the leaf (which can be passed to get_leaf_histogram).
+   */
+  size_t find_leaf(size_t treeIndex, const Descriptor& descriptor) const
+  {
+    const Node *node = &m_nodes[m_treeRoots[treeIndex]];
+    while(node->kind != FlatRandomForestFormat::NK_LEAF)
+    {
+      float value = descriptor[node->firstFeatureIndex];
+      if(node->kind == FlatRandomForestFormat::NK_PAIRWISE_ADD) value = value + descriptor[node->secondFeatureIndex];
+      else if(node->kind == FlatRandomForestFormat::NK_PAIRWISE_SUBTRACT) value = value - descriptor[node->secondFeatureIndex];
+
+      node = &m_nodes[value < node->threshold ? node->leftChildIndex : node->rightChildIndex];
+    }
+    return static_cast<size_t>(node->leafIndex);
+  }
+
+  /**
+   * \brief Gets the histogram of the examples that were in the reservoir of the specified leaf when the forest was flattened.
+   *
+   * \param leafIndex           The index of the leaf.
+   * \return                    The histogram.
+   * \throws std::runtime_error If the forest does not have leaf histograms.
+   */
+  tvgutil::Histogram<Label> get_leaf_histogram(size_t leafIndex) const
+  {
+    if(!has_leaf_histograms()) throw std::runtime_error("Error: The flat forest does not have leaf histograms");
+
+    tvgutil::Histogram<Label> histogram;
+    const size_t labelCount = m_labels.size();
+    for(size_t k = 0; k < labelCount; ++k)
+    {
+      for(boost::uint32_t n = 0, count = m_leafHistograms[leafIndex * labelCount + k]; n < count; ++n)
+      {
+        histogram.add(m_labels[k]);
+      }
+    }
+    return histogram;
+  }
+
+  /**
+   * \brief Gets the total number of leaves in the forest.
+   *
+   * \return  The total number of leaves in the forest.
+   */
+  size_t get_leaf_count() const
+  {
+    return m_leafCount;
+  }
+
+  /**
+   * \brief Gets the total number of nodes in the forest.
+   *
+   * \return  The total number of nodes in the forest.
+   */
+  size_t get_node_count() const
+  {
+    return m_nodes.size();
+  }
+
+  /**
+   * \brief Gets the number of trees in the forest.
+   *
+   * \return  The number of trees in the forest.
+   */
+  size_t get_tree_count() const
+  {
+    return m_treeRoots.size();
+  }
+
+  /**
+   * \brief Gets whether or not the forest has leaf histograms.
+   *
+   * \return  true, if the forest has leaf histograms, or false otherwise.
+   */
+  bool has_leaf_histograms() const
+  {
+    return !m_leafHistograms.empty();
+  }
+
+  /**
+   * \brief Outputs statistics about the flat forest to a stream.
+   *
+   * \param os  The stream to which to output the statistics.
+   */
+  void output_statistics(std::ostream& os) const
+  {
+    os << std::setprecision(5);
+    for(size_t i = 0, treeCount = m_treeRoots.size(); i < treeCount; ++i)
+    {
+      size_t nodeCount = 0, leafCount = 0, depth = 0;
+      float totalLeafEntropy = 0.0f;
+
+      std::vector<std::pair<boost::int32_t,size_t> > nodesToVisit(1, std::make_pair(m_treeRoots[i], 0));
+      while(!nodesToVisit.empty())
+      {
+        const Node& node = m_nodes[nodesToVisit.back().first];
+        const size_t nodeDepth = nodesToVisit.back().second;
+        nodesToVisit.pop_back();
+
+        ++nodeCount;
+        depth = std::max(depth, nodeDepth);
+
+        if(node.kind == FlatRandomForestFormat::NK_LEAF)
+        {
+          ++leafCount;
+          totalLeafEntropy += calculate_leaf_entropy(node.leafIndex);
+        }
+        else
+        {
+          nodesToVisit.push_back(std::make_pair(node.leftChildIndex, nodeDepth + 1));
+          nodesToVisit.push_back(std::make_pair(node.rightChildIndex, nodeDepth + 1));
+        }
+      }
+
+      os << "Tree: " << i << ", ";
+      os << "Node Count: " << nodeCount << ", ";
+      os << "Depth: " << depth << ", ";
+      os << "Avg. Leaf Entropy: " << totalLeafEntropy / leafCount << '\n';
+    }
+    os << '\n';
+  }
+
+  /**
+   * \brief Predicts a label for the specified descriptor.
+   *
+   * \param descriptor  The descriptor.
+   * \return            The predicted label.
+   */
+  Label predict(const Descriptor_CPtr& descriptor) const
+  {
+    return calculate_pmf(descriptor).calculate_best_label();
+  }
+
+  /**
+   * \brief Saves the flat forest to a flat random forest file.
+   *
+   * \param filename              The name of the file.
+   * \param saveLeafHistograms    Whether or not to save the leaf histograms (if the forest has them).
+   * \throws std::runtime_error   If the file cannot be written.
+   */
+  void save(const std::string& filename, bool saveLeafHistograms = false) const
+  {
+    std::ofstream fs(filename.c_str(), std::ios::binary);
+    if(!fs) throw std::runtime_error("Error: '" + filename + "' could not be opened for writing");
+
+    saveLeafHistograms = saveLeafHistograms && has_leaf_histograms();
+
+    FlatRandomForestFormat::Header header;
+    memcpy(header.magic, FlatRandomForestFormat::magic(), sizeof(header.magic));
+    header.version = FlatRandomForestFormat::VERSION;
+    header.labelSize = sizeof(Label);
+    header.treeCount = static_cast<boost::uint32_t>(m_treeRoots.size());
+    header.labelCount = static_cast<boost::uint32_t>(m_labels.size());
+    header.nodeCount = static_cast<boost::uint32_t>(m_nodes.size());
+    header.leafCount = static_cast<boost::uint32_t>(get_leaf_count());
+    header.flags = saveLeafHistograms ? FlatRandomForestFormat::HAS_LEAF_HISTOGRAMS : 0;
+
+    fs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    write_array(fs, m_labels);
+    write_array(fs, m_treeRoots);
+    write_array(fs, m_nodes);
+    write_array(fs, m_leafMasses);
+    if(saveLeafHistograms) write_array(fs, m_leafHistograms);
+
+    if(!fs) throw std::runtime_error("Error: The flat forest could not be written to '" + filename + "'");
+  }
+
+  //#################### PRIVATE MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Calculates the entropy of the PMF of the specified leaf.
+   *
+   * \param leafIndex The index of the leaf.
+   * \return          The entropy of the leaf's PMF.
+   */
+  float calculate_leaf_entropy(size_t leafIndex) const
+  {
+    const size_t labelCount = m_labels.size();
+    std::map<Label,float> masses;
+    for(size_t k = 0; k < labelCount; ++k)
+    {
+      float mass = m_leafMasses[leafIndex * labelCount + k];
+      if(mass > 0.0f) masses.insert(masses.end(), std::make_pair(m_labels[k], mass));
+    }
+    return masses.empty() ? 0.0f : tvgutil::ProbabilityMassFunction<Label>(masses).calculate_entropy();
+  }
+
+  /**
+   * \brief Appends the flattened form of a subtree of an ordinary decision tree to the node array.
+   *
+   * The nodes of the subtree are appended in depth-first order, so that the left child of each branch node immediately
+   * follows it in the array.
+   *
+   * \param tree                The ordinary decision tree.
+   * \param subtreeRootIndex    The index of the root of the subtree in the ordinary tree's node array.
+   * \return                    The index of the root of the flattened subtree in the node array.
+   * \throws std::runtime_error If the subtree contains a decision function of a type that cannot be flattened.
+   */
+  boost::int32_t flatten_subtree(const DT& tree, int subtreeRootIndex)
+  {
+    const typename DT::Node& treeNode = *tree.m_nodes[subtreeRootIndex];
+    const boost::int32_t flatIndex = static_cast<boost::int32_t>(m_nodes.size());
+
+    Node node;
+    memset(&node, 0, sizeof(Node));
+    node.leafIndex = -1;
+
+    if(tree.is_leaf(subtreeRootIndex))
+    {
+      node.kind = FlatRandomForestFormat::NK_LEAF;
+      node.leafIndex = static_cast<boost::int32_t>(m_leafCount++);
+      m_nodes.push_back(node);
+
+      // Append the leaf's PMF and histogram to the leaf arrays. Leaves with empty reservoirs get a PMF of all zeros.
+      const tvgutil::Histogram<Label>& histogram = *treeNode.m_reservoir.get_histogram();
+      const std::map<Label,size_t>& bins = histogram.get_bins();
+      std::map<Label,float> masses;
+      if(!histogram.empty()) masses = tree.make_pmf(subtreeRootIndex).get_masses();
+
+      for(typename std::vector<Label>::const_iterator it = m_labels.begin(), iend = m_labels.end(); it != iend; ++it)
+      {
+        typename std::map<Label,float>::const_iterator jt = masses.find(*it);
+        m_leafMasses.push_back(jt != masses.end() ? jt->second : 0.0f);
+
+        typename std::map<Label,size_t>::const_iterator kt = bins.find(*it);
+        m_leafHistograms.push_back(kt != bins.end() ? static_cast<boost::uint32_t>(kt->second) : 0);
+      }
+
+      return flatIndex;
+    }
+
+    // Record the node's decision function.
+    const DecisionFunction *splitter = treeNode.m_splitter.get();
+    if(const FeatureThresholdingDecisionFunction *df = dynamic_cast<const FeatureThresholdingDecisionFunction*>(splitter))
+    {
+      node.kind = FlatRandomForestFormat::NK_FEATURE_THRESHOLD;
+      node.firstFeatureIndex = static_cast<boost::uint32_t>(df->get_feature_index());
+      node.threshold = df->get_threshold();
+    }
+    else if(const PairwiseOpAndThresholdDecisionFunction *df = dynamic_cast<const PairwiseOpAndThresholdDecisionFunction*>(splitter))
+    {
+      node.kind = df->get_op() == PairwiseOpAndThresholdDecisionFunction::PO_ADD ? FlatRandomForestFormat::NK_PAIRWISE_ADD : FlatRandomForestFormat::NK_PAIRWISE_SUBTRACT;
+      node.firstFeatureIndex = static_cast<boost::uint32_t>(df->get_first_feature_index());
+      node.secondFeatureIndex = static_cast<boost::uint32_t>(df->get_second_feature_index());
+      node.threshold = df->get_threshold();
+    }
+    else throw std::runtime_error("Error: Cannot flatten a decision tree containing an unsupported type of decision function");
+
+    m_nodes.push_back(node);
+
+    // Flatten the node's children, and link them to the node.
+    const boost::int32_t leftChildIndex = flatten_subtree(tree, treeNode.m_leftChildIndex);
+    const boost::int32_t rightChildIndex = flatten_subtree(tree, treeNode.m_rightChildIndex);
+    m_nodes[flatIndex].leftChildIndex = leftChildIndex;
+    m_nodes[flatIndex].rightChildIndex = rightChildIndex;
+
+    return flatIndex;
+  }
+
+  //#################### PRIVATE STATIC MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Reads an array of values from a flat random forest file.
+   *
+   * \param fs                  The stream from which to read the array.
+   * \param arr                 The vector into which to read the array.
+   * \param size                The number of values in the array.
+   * \param filename            The name of the file (for error reporting purposes).
+   * \throws std::runtime_error If the file is truncated.
+   */
+  template <typename T>
+  static void read_array(std::istream& fs, std::vector<T>& arr, size_t size, const std::string& filename)
+  {
+    arr.resize(size);
+    if(size > 0 && !fs.read(reinterpret_cast<char*>(&arr[0]), size * sizeof(T)))
+    {
+      throw std::runtime_error("Error: The flat random forest file '" + filename + "' is truncated");
+    }
+  }
+
+  /**
+   * \brief Writes an array of values to a flat random forest file.
+   *
+   * \param fs  The stream to which to write the array.
+   * \param arr The array.
+   */
+  template <typename T>
+  static void write_array(std::ostream& fs, const std::vector<T>& arr)
+  {
+    if(!arr.empty()) fs.write(reinterpret_cast<const char*>(&arr[0]), arr.size() * sizeof(T));
+  }
+};
+
+}
+
+#endif
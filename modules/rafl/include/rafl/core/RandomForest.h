@@ -6,6 +6,11 @@
 #ifndef H_RAFL_RANDOMFOREST
 #define H_RAFL_RANDOMFOREST
 
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+#include <tvgutil/misc/ThreadPool.h>
+
 #include "DecisionTree.h"
 
 namespace rafl {
@@ -18,16 +23,70 @@ class RandomForest
 {
   //#################### TYPEDEFS ####################
 private:
+  typedef boost::chrono::steady_clock Clock;
   typedef boost::shared_ptr<const Example<Label> > Example_CPtr;
   typedef DecisionTree<Label> DT;
   typedef boost::shared_ptr<DT> DT_Ptr;
   typedef boost::shared_ptr<const DT> DT_CPtr;
 
+  //#################### NESTED TYPES ####################
+private:
+  /**
+   * \brief An instance of this struct represents a job that trains a snapshot of one of the trees in the forest on a thread in the global thread pool.
+   *
+   * The job is shared between the forest and the thread that runs it, so the forest can abandon it without waiting for it.
+   */
+  struct BackgroundTrainingJob
+  {
+    /** Whether or not the job has been abandoned by the forest (in which case any queued examples need not be added to the snapshot). */
+    bool abandoned;
+
+    /** Whether or not the job has finished (i.e. the snapshot has been trained and has had all of the queued examples added to it). */
+    bool finished;
+
+    /** The mutex used to synchronise access to the flags and the queued examples. */
+    boost::mutex mutex;
+
+    /** The number of nodes that were split during the training of the snapshot. */
+    size_t nodesSplit;
+
+    /** The examples that have been added to the live tree since the snapshot was made, and which still need to be added to the snapshot. */
+    std::vector<Example_CPtr> queuedExamples;
+
+    /** The snapshot being trained. */
+    DT_Ptr snapshot;
+
+    /** A condition variable used to wait for the job to finish. */
+    boost::condition_variable trainingFinished;
+
+    BackgroundTrainingJob() : abandoned(false), finished(false), nodesSplit(0) {}
+  };
+
+  typedef boost::shared_ptr<BackgroundTrainingJob> BackgroundTrainingJob_Ptr;
+
   //#################### PRIVATE VARIABLES ####################
 private:
+  /** The background training jobs for the trees (if any), indexed by tree. */
+  std::vector<BackgroundTrainingJob_Ptr> m_backgroundTrainingJobs;
+
+  /** A map from the labels seen by the forest to their indices in the dense PMFs calculated by the forest. */
+  std::map<Label,size_t> m_labelIndices;
+
+  /** The labels seen by the forest, in the order in which they are indexed in the dense PMFs calculated by the forest. */
+  std::vector<Label> m_labels;
+
+  /** The times at which snapshots of the trees were last made for background training, indexed by tree. */
+  std::vector<Clock::time_point> m_lastSnapshotTimes;
+
+  /** The index of the tree from which the next time-budgeted training step should start. */
+  size_t m_nextTreeToTrain;
+
   /** The settings needed to configure the decision trees. */
   typename DT::Settings m_settings;
 
+  /** For each tree, a map from the indices of the labels in the tree's dense PMFs to their indices in the forest's dense PMFs. */
+  std::vector<std::vector<size_t> > m_treeLabelIndices;
+
   /** The decision trees that collectively make up the random forest. */
   std::vector<DT_Ptr> m_trees;
 
@@ -40,7 +99,7 @@ public:
    * \param settings  The settings needed to configure the decision trees.
    */
   RandomForest(size_t treeCount, const typename DT::Settings& settings)
-  : m_settings(settings)
+  : m_backgroundTrainingJobs(treeCount), m_lastSnapshotTimes(treeCount), m_nextTreeToTrain(0), m_settings(settings), m_treeLabelIndices(treeCount)
   {
     for(size_t i = 0; i < treeCount; ++i)
     {
@@ -54,7 +113,30 @@ private:
    *
    * Note: This constructor is needed for serialization and should not be used otherwise.
    */
-  RandomForest() {}
+  RandomForest()
+  : m_nextTreeToTrain(0)
+  {}
+
+  //#################### DESTRUCTOR ####################
+public:
+  /**
+   * \brief Destroys the random forest.
+   *
+   * Any background training jobs are abandoned rather than waited for (they hold everything they need, so they can safely finish on their own).
+   */
+  ~RandomForest()
+  {
+    for(size_t i = 0, treeCount = m_backgroundTrainingJobs.size(); i < treeCount; ++i)
+    {
+      abandon_background_training_job(i);
+    }
+  }
+
+  //#################### COPY CONSTRUCTOR & ASSIGNMENT OPERATOR ####################
+private:
+  // Deliberately private and unimplemented.
+  RandomForest(const RandomForest&);
+  RandomForest& operator=(const RandomForest&);
 
   //#################### PUBLIC MEMBER FUNCTIONS ####################
 public:
@@ -65,11 +147,12 @@ public:
    */
   void add_examples(const std::vector<Example_CPtr>& examples)
   {
-    // Add the new examples to the different trees.
-    for(typename std::vector<DT_Ptr>::const_iterator it = m_trees.begin(), iend = m_trees.end(); it != iend; ++it)
-    {
-      (*it)->add_examples(examples);
-    }
+    // Create a vector of indices indicating that all the examples should be added to the forest.
+    size_t size = examples.size();
+    std::vector<size_t> indices(size);
+    for(size_t i = 0; i < size; ++i) indices[i] = i;
+
+    add_examples(examples, indices);
   }
 
   /**
@@ -81,37 +164,111 @@ public:
    */
   void add_examples(const std::vector<Example_CPtr>& examples, const std::vector<size_t>& indices)
   {
-    // Add the new examples to the different trees.
-    for(typename std::vector<DT_Ptr>::const_iterator it = m_trees.begin(), iend = m_trees.end(); it != iend; ++it)
+    for(size_t i = 0, treeCount = m_trees.size(); i < treeCount; ++i)
     {
-      (*it)->add_examples(examples, indices);
+      add_examples_to_tree(i, examples, indices);
     }
+
+    update_label_indices();
   }
 
   /**
    * \brief Calculates an overall forest PMF for the specified descriptor.
    *
-   * This is simply the average of the PMFs for the specified descriptor in the various decision trees.
+   * This is simply the average of the PMFs for the specified descriptor in the various decision trees. Trees whose leaf
+   * for the descriptor has an empty reservoir are skipped, rather than causing an exception to be thrown as they would
+   * if their PMFs were looked up individually (see DecisionTree::lookup_pmf).
    *
-   * \param descriptor  The descriptor.
-   * \return            The PMF.
+   * \param descriptor          The descriptor.
+   * \return                    The PMF.
+   * \throws std::runtime_error If none of the trees has any examples in the leaf reached by the descriptor.
    */
   tvgutil::ProbabilityMassFunction<Label> calculate_pmf(const Descriptor_CPtr& descriptor) const
   {
-    // Sum the masses from the individual tree PMFs for the descriptor.
+    // Calculate the dense PMF for the descriptor.
+    std::vector<float> denseMasses;
+    calculate_pmf(descriptor, denseMasses);
+
+    // Convert it into a probability mass function (omitting any labels whose masses are zero).
     std::map<Label,float> masses;
-    for(typename std::vector<DT_Ptr>::const_iterator it = m_trees.begin(), iend = m_trees.end(); it != iend; ++it)
+    for(size_t k = 0, size = denseMasses.size(); k < size; ++k)
     {
-      tvgutil::ProbabilityMassFunction<Label> individualPMF = (*it)->lookup_pmf(descriptor);
-      const std::map<Label,float>& individualMasses = individualPMF.get_masses();
-      for(typename std::map<Label,float>::const_iterator jt = individualMasses.begin(), jend = individualMasses.end(); jt != jend; ++jt)
+      if(denseMasses[k] > 0.0f) masses.insert(std::make_pair(m_labels[k], denseMasses[k]));
+    }
+
+    return tvgutil::ProbabilityMassFunction<Label>(masses);
+  }
+
+  /**
+   * \brief Calculates an overall forest PMF for the specified descriptor, and writes it into a caller-supplied dense buffer.
+   *
+   * This is simply the average of the cached leaf PMFs for the specified descriptor in the various decision trees. As with
+   * the map-based version, trees whose leaf for the descriptor has an empty reservoir are skipped. On output, the buffer
+   * contains one mass for each label returned by get_labels (in the same order). Since the buffer is only resized if the
+   * number of labels has changed, reusing the same buffer for many descriptors avoids any per-descriptor allocations.
+   *
+   * \param descriptor          The descriptor.
+   * \param masses              The buffer into which to write the masses.
+   * \throws std::runtime_error If none of the trees has any examples in the leaf reached by the descriptor.
+   */
+  void calculate_pmf(const Descriptor_CPtr& descriptor, std::vector<float>& masses) const
+  {
+    // Sum the masses from the individual tree PMFs for the descriptor.
+    masses.assign(m_labels.size(), 0.0f);
+    for(size_t i = 0, treeCount = m_trees.size(); i < treeCount; ++i)
+    {
+      const std::vector<float>& treeMasses = m_trees[i]->lookup_dense_pmf(descriptor);
+      const std::vector<size_t>& treeLabelIndices = m_treeLabelIndices[i];
+      for(size_t k = 0, size = treeMasses.size(); k < size; ++k)
       {
-        masses[jt->first] += jt->second;
+        masses[treeLabelIndices[k]] += treeMasses[k];
       }
     }
 
-    // Create a normalised probability mass function from the summed masses.
-    return tvgutil::ProbabilityMassFunction<Label>(masses);
+    // Normalise the summed masses.
+    float sum = 0.0f;
+    for(size_t k = 0, size = masses.size(); k < size; ++k) sum += masses[k];
+    if(sum <= 0.0f) throw std::runtime_error("Cannot calculate a probability mass function using leaves with empty reservoirs");
+    for(size_t k = 0, size = masses.size(); k < size; ++k) masses[k] /= sum;
+  }
+
+  /**
+   * \brief Swaps any snapshots whose background training has finished into the forest in place of the corresponding trees.
+   *
+   * \param wait  Whether or not to wait for any background training jobs that are still running to finish.
+   * \return      The total number of nodes that were split in the snapshots that have been swapped in.
+   */
+  size_t complete_background_training(bool wait = false)
+  {
+    size_t nodesSplit = 0;
+    for(size_t i = 0, treeCount = m_trees.size(); i < treeCount; ++i)
+    {
+      BackgroundTrainingJob_Ptr job = m_backgroundTrainingJobs[i];
+      if(!job) continue;
+
+      if(!wait)
+      {
+        boost::lock_guard<boost::mutex> lock(job->mutex);
+        if(!job->finished) continue;
+      }
+
+      nodesSplit += swap_in_snapshot(i);
+    }
+
+    update_label_indices();
+    return nodesSplit;
+  }
+
+  /**
+   * \brief Gets the labels seen by the forest, in the order in which they are indexed in the dense PMFs calculated by the forest.
+   *
+   * New labels are only ever appended, so the index of a label never changes once the forest has seen it.
+   *
+   * \return  The labels seen by the forest.
+   */
+  const std::vector<Label>& get_labels() const
+  {
+    return m_labels;
   }
 
   /**
@@ -136,6 +293,20 @@ public:
     return m_trees.size();
   }
   
+  /**
+   * \brief Gets whether or not any of the trees in the forest are currently being trained in the background.
+   *
+   * \return  true, if any of the trees are being trained in the background, or false otherwise.
+   */
+  bool is_training_in_background() const
+  {
+    for(typename std::vector<BackgroundTrainingJob_Ptr>::const_iterator it = m_backgroundTrainingJobs.begin(), iend = m_backgroundTrainingJobs.end(); it != iend; ++it)
+    {
+      if(*it) return true;
+    }
+    return false;
+  }
+
   /**
    * \brief Gets whether or not the forest is valid.
    *
@@ -195,7 +366,61 @@ public:
    */
   Label predict(const Descriptor_CPtr& descriptor) const
   {
-    return calculate_pmf(descriptor).calculate_best_label();
+    std::vector<float> masses;
+    return predict(descriptor, masses);
+  }
+
+  /**
+   * \brief Predicts a label for the specified descriptor, using a caller-supplied buffer to hold the forest PMF.
+   *
+   * If there are several labels with the highest mass, the smallest of them is returned.
+   *
+   * \param descriptor  The descriptor.
+   * \param masses      A buffer in which to store the masses of the forest PMF for the descriptor (see calculate_pmf).
+   * \return            The predicted label.
+   */
+  Label predict(const Descriptor_CPtr& descriptor, std::vector<float>& masses) const
+  {
+    calculate_pmf(descriptor, masses);
+
+    size_t bestIndex = 0;
+    for(size_t k = 1, size = masses.size(); k < size; ++k)
+    {
+      if(masses[k] > masses[bestIndex] || (masses[k] == masses[bestIndex] && m_labels[k] < m_labels[bestIndex])) bestIndex = k;
+    }
+
+    return m_labels[bestIndex];
+  }
+
+  /**
+   * \brief Predicts labels for a batch of examples, in parallel (if OpenMP is available).
+   *
+   * \param examples  A pool of examples.
+   * \param indices   The indices of the examples in the pool for which to predict labels.
+   * \return          The predicted labels (in the same order as the indices).
+   */
+  std::vector<Label> predict(const std::vector<Example_CPtr>& examples, const std::vector<size_t>& indices) const
+  {
+    const int indicesSize = static_cast<int>(indices.size());
+    std::vector<Label> predictedLabels(indicesSize);
+
+#ifdef WITH_OPENMP
+    #pragma omp parallel
+#endif
+    {
+      // Use a separate PMF buffer for each thread, so that it can be reused for all of the examples the thread processes.
+      std::vector<float> masses;
+
+#ifdef WITH_OPENMP
+      #pragma omp for schedule(dynamic, 16)
+#endif
+      for(int i = 0; i < indicesSize; ++i)
+      {
+        predictedLabels[i] = predict(examples[indices[i]]->get_descriptor(), masses);
+      }
+    }
+
+    return predictedLabels;
   }
 
   /**
@@ -206,7 +431,15 @@ public:
    */
   void reset_tree(size_t treeIndex)
   {
-    if(treeIndex < m_trees.size()) m_trees[treeIndex].reset(new DT(m_settings));
+    if(treeIndex < m_trees.size())
+    {
+      // If a snapshot of the tree is being trained in the background, abandon it without waiting for its training to finish.
+      abandon_background_training_job(treeIndex);
+
+      m_trees[treeIndex].reset(new DT(m_settings));
+      m_lastSnapshotTimes[treeIndex] = Clock::time_point();
+      m_treeLabelIndices[treeIndex].clear();
+    }
     else throw std::runtime_error("Bad tree index whilst trying to reset tree");
   }
 
@@ -221,28 +454,266 @@ public:
   size_t train(size_t splitBudget)
   {
     size_t nodesSplit = 0;
-    for(typename std::vector<DT_Ptr>::const_iterator it = m_trees.begin(), iend = m_trees.end(); it != iend; ++it)
+    for(size_t i = 0, treeCount = m_trees.size(); i < treeCount; ++i)
     {
-      nodesSplit += (*it)->train(splitBudget);
+      // Trees whose snapshots are being trained in the background will be replaced, so there is no point training them.
+      if(!m_backgroundTrainingJobs[i]) nodesSplit += m_trees[i]->train(splitBudget);
     }
     return nodesSplit;
   }
 
+  /**
+   * \brief Trains the forest by splitting suitable nodes in its trees until the specified amount of time has elapsed.
+   *
+   * Each tree is given an equal share of the time that remains when its turn comes, so any time left unused by one tree
+   * is passed on to the others. The tree from which training starts is rotated between calls, so that if the budget is
+   * too small for all the trees to be trained in a single call, none of the trees will be starved of training.
+   *
+   * \param timeBudget  The amount of time that may be spent on this training step.
+   * \return            The total number of nodes that have been split across all the trees.
+   */
+  size_t train_for(const boost::chrono::microseconds& timeBudget)
+  {
+    const Clock::time_point deadline = Clock::now() + timeBudget;
+    const size_t treeCount = m_trees.size();
+    if(treeCount == 0) return 0;
+
+    size_t nodesSplit = 0;
+    for(size_t j = 0; j < treeCount; ++j)
+    {
+      // Trees whose snapshots are being trained in the background will be replaced, so there is no point training them.
+      const size_t i = (m_nextTreeToTrain + j) % treeCount;
+      if(m_backgroundTrainingJobs[i]) continue;
+
+      const Clock::duration remainingTime = deadline - Clock::now();
+      if(remainingTime <= Clock::duration::zero()) break;
+
+      nodesSplit += m_trees[i]->train_for(boost::chrono::duration_cast<boost::chrono::microseconds>(remainingTime / (treeCount - j)));
+    }
+
+    m_nextTreeToTrain = (m_nextTreeToTrain + 1) % treeCount;
+    return nodesSplit;
+  }
+
+  /**
+   * \brief Starts training snapshots of the trees in the forest in the background.
+   *
+   * Each tree that is not already being trained in the background, has nodes that are worth trying to split, and has not
+   * been snapshotted within the specified interval is copied, and the copy is then trained on a thread in the global thread
+   * pool, whilst the original tree remains available for prediction. Any examples added to the forest in
+   * the meantime are added both to the original tree and (once its training has finished) to the copy. Trained copies are
+   * swapped into the forest in place of the original trees by complete_background_training (or add_examples), so that
+   * callers never see a partially-trained tree.
+   *
+   * \note  The copies are made on the calling thread (see DecisionTree::make_snapshot), since the original trees may be
+   *        modified as soon as this function returns. The cost is linear in the number of examples held in the trees'
+   *        leaf reservoirs, and is typically a few milliseconds per tree for the reservoir sizes that spaint uses, which
+   *        is why trees with nothing to split are skipped and the rate at which each tree is snapshotted can be limited.
+   *
+   * \param splitBudget         The maximum number of nodes per tree that may be split by each background training job.
+   * \param minSnapshotInterval The minimum amount of time that must elapse between successive snapshots of the same tree.
+   */
+  void train_in_background(size_t splitBudget, const boost::chrono::microseconds& minSnapshotInterval = boost::chrono::microseconds(0))
+  {
+    const Clock::time_point now = Clock::now();
+    for(size_t i = 0, treeCount = m_trees.size(); i < treeCount; ++i)
+    {
+      if(m_backgroundTrainingJobs[i] || !m_trees[i]->has_splittable_nodes() || now - m_lastSnapshotTimes[i] < minSnapshotInterval) continue;
+
+      m_lastSnapshotTimes[i] = now;
+      BackgroundTrainingJob_Ptr job(new BackgroundTrainingJob);
+      job->snapshot = m_trees[i]->make_snapshot();
+      tvgutil::ThreadPool::instance().post_task(boost::bind(&RandomForest::run_background_training_job, job, splitBudget));
+      m_backgroundTrainingJobs[i] = job;
+    }
+  }
+
+  //#################### PRIVATE STATIC MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Runs a background training job.
+   *
+   * This trains the job's snapshot, and then adds any examples that were queued for it in the meantime (unless the job has been abandoned).
+   *
+   * \param job         The job.
+   * \param splitBudget The maximum number of nodes that may be split when training the snapshot.
+   */
+  static void run_background_training_job(const BackgroundTrainingJob_Ptr& job, size_t splitBudget)
+  {
+    job->nodesSplit = job->snapshot->train(splitBudget);
+
+    for(;;)
+    {
+      std::vector<Example_CPtr> examples;
+
+      {
+        boost::lock_guard<boost::mutex> lock(job->mutex);
+        if(job->abandoned || job->queuedExamples.empty())
+        {
+          job->queuedExamples.clear();
+          job->finished = true;
+          job->trainingFinished.notify_all();
+          return;
+        }
+        examples.swap(job->queuedExamples);
+      }
+
+      job->snapshot->add_examples(examples);
+    }
+  }
+
+  //#################### PRIVATE MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Abandons the background training job (if any) for the specified tree, without waiting for it to finish.
+   *
+   * \param treeIndex The index of the tree.
+   */
+  void abandon_background_training_job(size_t treeIndex)
+  {
+    BackgroundTrainingJob_Ptr& job = m_backgroundTrainingJobs[treeIndex];
+    if(!job) return;
+
+    {
+      boost::lock_guard<boost::mutex> lock(job->mutex);
+      job->abandoned = true;
+    }
+
+    job.reset();
+  }
+
+  /**
+   * \brief Adds new training examples to the specified tree.
+   *
+   * This only touches state belonging to the specified tree, so it can safely be called for several different trees at
+   * once. The caller is responsible for calling update_label_indices afterwards.
+   *
+   * \param treeIndex                     The index of the tree.
+   * \param examples                      A pool of examples that could potentially be added.
+   * \param indices                       The indices of the examples in the pool that should be added to the tree.
+   * \throws std::out_of_range_exception  If any of the indices are invalid.
+   */
+  void add_examples_to_tree(size_t treeIndex, const std::vector<Example_CPtr>& examples, const std::vector<size_t>& indices)
+  {
+    // If a snapshot of the tree is being trained in the background, queue the new examples so that they can be added to
+    // the snapshot once its training has finished. If the job has already finished, swap in the snapshot straight away,
+    // since it will no longer pick up any queued examples.
+    BackgroundTrainingJob_Ptr job = m_backgroundTrainingJobs[treeIndex];
+    if(job)
+    {
+      bool finished;
+
+      {
+        boost::lock_guard<boost::mutex> lock(job->mutex);
+        finished = job->finished;
+        if(!finished)
+        {
+          for(size_t j = 0, size = indices.size(); j < size; ++j)
+          {
+            job->queuedExamples.push_back(examples.at(indices[j]));
+          }
+        }
+      }
+
+      if(finished) swap_in_snapshot(treeIndex);
+    }
+
+    // Add the new examples to the tree itself, so that they can be used for prediction straight away.
+    m_trees[treeIndex]->add_examples(examples, indices);
+  }
+
+  /**
+   * \brief Swaps the snapshot trained by the specified tree's background training job into the forest in place of the tree.
+   *
+   * This waits for the job to finish if necessary. The caller is responsible for calling update_label_indices afterwards.
+   *
+   * \param treeIndex The index of the tree.
+   * \return          The number of nodes that were split in the snapshot.
+   */
+  size_t swap_in_snapshot(size_t treeIndex)
+  {
+    BackgroundTrainingJob_Ptr job = m_backgroundTrainingJobs[treeIndex];
+    m_backgroundTrainingJobs[treeIndex].reset();
+
+    {
+      boost::unique_lock<boost::mutex> lock(job->mutex);
+      while(!job->finished) job->trainingFinished.wait(lock);
+    }
+
+    // Note that the snapshot may have indexed its labels differently from the tree it replaces, so the map from the
+    // snapshot's label indices to the forest's label indices must be rebuilt from scratch.
+    m_trees[treeIndex] = job->snapshot;
+    m_treeLabelIndices[treeIndex].clear();
+
+    return job->nodesSplit;
+  }
+
+  /**
+   * \brief Makes sure that the forest has an index for every label seen by its trees, and that the maps from the trees'
+   *        label indices to the forest's label indices are up to date.
+   */
+  void update_label_indices()
+  {
+    for(size_t i = 0, treeCount = m_trees.size(); i < treeCount; ++i)
+    {
+      const std::vector<Label>& treeLabels = m_trees[i]->get_labels();
+      std::vector<size_t>& treeLabelIndices = m_treeLabelIndices[i];
+
+      // Since trees only ever append new labels, we only need to consider the labels the tree has seen since the last update.
+      for(size_t k = treeLabelIndices.size(), size = treeLabels.size(); k < size; ++k)
+      {
+        std::pair<typename std::map<Label,size_t>::iterator,bool> result = m_labelIndices.insert(std::make_pair(treeLabels[k], m_labels.size()));
+        if(result.second) m_labels.push_back(treeLabels[k]);
+        treeLabelIndices.push_back(result.first->second);
+      }
+    }
+  }
+
   //#################### SERIALIZATION ####################
 private:
   /**
-   * \brief Serializes the random forest to/from an archive.
+   * \brief Loads the random forest from an archive.
+   *
+   * The label indices are not saved, so they are rebuilt once the trees have been loaded.
+   *
+   * \param ar      The archive.
+   * \param version The file format version number.
+   */
+  template <typename Archive>
+  void load(Archive& ar, const unsigned int version)
+  {
+    for(size_t i = 0, treeCount = m_backgroundTrainingJobs.size(); i < treeCount; ++i)
+    {
+      abandon_background_training_job(i);
+    }
+
+    ar & m_settings;
+    ar & m_trees;
+
+    m_backgroundTrainingJobs.assign(m_trees.size(), BackgroundTrainingJob_Ptr());
+    m_lastSnapshotTimes.assign(m_trees.size(), Clock::time_point());
+    m_nextTreeToTrain = 0;
+    m_labelIndices.clear();
+    m_labels.clear();
+    m_treeLabelIndices.assign(m_trees.size(), std::vector<size_t>());
+    update_label_indices();
+  }
+
+  /**
+   * \brief Saves the random forest to an archive.
    *
    * \param ar      The archive.
    * \param version The file format version number.
    */
   template <typename Archive>
-  void serialize(Archive& ar, const unsigned int version)
+  void save(Archive& ar, const unsigned int version) const
   {
     ar & m_settings;
     ar & m_trees;
   }
 
+  BOOST_SERIALIZATION_SPLIT_MEMBER()
+
   friend class boost::serialization::access;
 };
 
@@ -8,9 +8,9 @@
 
 #include <utility>
 
-#ifdef WITH_OPENMP
-#include <omp.h>
-#endif
+#include <boost/bind.hpp>
+
+#include <tvgutil/misc/ThreadPool.h>
 
 #include "../examples/ExampleReservoir.h"
 #include "../examples/ExampleUtil.h"
@@ -52,11 +52,6 @@ public:
   typedef boost::shared_ptr<Split> Split_Ptr;
   typedef boost::shared_ptr<const Split> Split_CPtr;
 
-  //#################### PRIVATE VARIABLES ####################
-private:
-  /* The split candidates. */
-  mutable std::vector<Split> m_splitCandidates;
-
   //#################### DESTRUCTOR ####################
 public:
   /**
@@ -111,67 +106,38 @@ public:
     std::cout << "\nP: " << *reservoir.get_histogram() << ' ' << initialEntropy << '\n';
 #endif
 
-    // Generate the split candidates.
-    if(static_cast<int>(m_splitCandidates.size()) != candidateCount) m_splitCandidates.resize(candidateCount);
+    // Generate the split candidates. Note that these are deliberately local rather than stored in the generator, since
+    // the same generator may be used to split nodes in several trees at once (e.g. when training trees in the background).
+    std::vector<Split> splitCandidates(candidateCount);
     for(int i = 0; i < candidateCount; ++i)
     {
-      m_splitCandidates[i].m_decisionFunction = generate_candidate_decision_function(examples, randomNumberGenerator);
+      splitCandidates[i].m_decisionFunction = generate_candidate_decision_function(examples, randomNumberGenerator);
     }
 
-    // Pick the best split candidate and return it.
+    // Evaluate the split candidates in parallel on the shared thread pool.
+    std::vector<float> gains(candidateCount);
+    tvgutil::ThreadPool::instance().parallel_for(0, candidateCount, boost::bind(
+      &DecisionFunctionGenerator::evaluate_split_candidate, _1, boost::cref(reservoir), boost::cref(examples),
+      initialEntropy, boost::cref(inverseClassWeights), boost::ref(splitCandidates), boost::ref(gains)
+    ), 1);
+
+    // Pick the best split candidate. Note that this is done serially, so that ties are always broken in the same way.
     float bestGain = static_cast<float>(INT_MIN);
     int bestIndex = -1;
-
-#ifdef WITH_OPENMP
-    #pragma omp parallel for
-#endif
     for(int i = 0; i < candidateCount; ++i)
     {
-#if 0 && WITH_OPENMP
-      int threadID = omp_get_thread_num();
-      int threadCount = omp_get_num_threads();
-      std::cout << "threadID=" << threadID << " threadCount=" << threadCount << '\n';
-#endif
-
-#if 0
-      std::cout << *splitCandidate->m_decisionFunction << '\n';
-#endif
-
-      // Partition the examples using the split candidate's decision function.
-      m_splitCandidates[i].m_leftExamples.clear();
-      m_splitCandidates[i].m_rightExamples.clear();
-      for(size_t j = 0, size = examples.size(); j < size; ++j)
+      if(gains[i] > bestGain)
       {
-        if(m_splitCandidates[i].m_decisionFunction->classify_descriptor(*examples[j]->get_descriptor()) == DecisionFunction::DC_LEFT)
+        if(gains[i] > gainThreshold && !splitCandidates[i].m_leftExamples.empty() && !splitCandidates[i].m_rightExamples.empty())
         {
-          m_splitCandidates[i].m_leftExamples.push_back(examples[j]);
-        }
-        else
-        {
-          m_splitCandidates[i].m_rightExamples.push_back(examples[j]);
-        }
-      }
-
-      // Calculate the information gain we would obtain from this split.
-      float gain = calculate_information_gain(reservoir, initialEntropy, m_splitCandidates[i].m_leftExamples, m_splitCandidates[i].m_rightExamples, inverseClassWeights);
-
-#ifdef WITH_OPENMP
-      #pragma omp critical
-#endif
-      {
-        if(gain > bestGain)
-        {
-          if(gain > gainThreshold && !m_splitCandidates[i].m_leftExamples.empty() && !m_splitCandidates[i].m_rightExamples.empty())
-          {
-            bestGain = gain;
-            bestIndex = i;
-          }
+          bestGain = gains[i];
+          bestIndex = i;
         }
       }
     }
 
     Split_Ptr bestSplitCandidate;
-    if(bestIndex != -1) bestSplitCandidate.reset(new Split(m_splitCandidates[bestIndex]));
+    if(bestIndex != -1) bestSplitCandidate.reset(new Split(splitCandidates[bestIndex]));
 
     // Return a split candidate that had maximum gain (note that this may be NULL if no split had a high enough gain).
     return bestSplitCandidate;
@@ -242,6 +208,42 @@ private:
 
     return result;
   }
+
+  /**
+   * \brief Partitions a set of examples using the decision function of the specified split candidate, and calculates the resulting information gain.
+   *
+   * \param i                   The index of the split candidate.
+   * \param reservoir           The reservoir from which the examples were taken.
+   * \param examples            The examples to partition.
+   * \param initialEntropy      The entropy of the example set before the split.
+   * \param inverseClassWeights The (optional) inverses of the L1-normalised class frequencies observed in the training data.
+   * \param splitCandidates     The split candidates (the examples are partitioned into the i'th one).
+   * \param gains               The information gains of the split candidates (the i'th one is written).
+   */
+  static void evaluate_split_candidate(int i, const ExampleReservoir<Label>& reservoir, const std::vector<Example_CPtr>& examples, float initialEntropy,
+                                       const boost::optional<std::map<Label,float> >& inverseClassWeights, std::vector<Split>& splitCandidates, std::vector<float>& gains)
+  {
+#if 0
+    std::cout << *splitCandidates[i].m_decisionFunction << '\n';
+#endif
+
+    Split& splitCandidate = splitCandidates[i];
+    splitCandidate.m_leftExamples.clear();
+    splitCandidate.m_rightExamples.clear();
+    for(size_t j = 0, size = examples.size(); j < size; ++j)
+    {
+      if(splitCandidate.m_decisionFunction->classify_descriptor(*examples[j]->get_descriptor()) == DecisionFunction::DC_LEFT)
+      {
+        splitCandidate.m_leftExamples.push_back(examples[j]);
+      }
+      else
+      {
+        splitCandidate.m_rightExamples.push_back(examples[j]);
+      }
+    }
+
+    gains[i] = calculate_information_gain(reservoir, initialEntropy, splitCandidate.m_leftExamples, splitCandidate.m_rightExamples, inverseClassWeights);
+  }
 };
 
 }
@@ -48,6 +48,20 @@ public:
   /** Override */
   virtual DescriptorClassification classify_descriptor(const Descriptor& descriptor) const;
 
+  /**
+   * \brief Gets the index of the feature in a feature descriptor that should be compared to the threshold.
+   *
+   * \return  The index of the feature in a feature descriptor that should be compared to the threshold.
+   */
+  size_t get_feature_index() const;
+
+  /**
+   * \brief Gets the threshold against which to compare the feature.
+   *
+   * \return  The threshold against which to compare the feature.
+   */
+  float get_threshold() const;
+
   /** Override */
   virtual void output(std::ostream& os) const;
 
@@ -0,0 +1,228 @@
+/**
+ * rafl: BinaryExampleReader.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2017. All rights reserved.
+ */
+
+#ifndef H_RAFL_BINARYEXAMPLEREADER
+#define H_RAFL_BINARYEXAMPLEREADER
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/is_pod.hpp>
+
+#include "Example.h"
+
+namespace rafl {
+
+/**
+ * \brief This struct describes the layout of a binary example file.
+ *
+ * A binary example file consists of a fixed-size header, followed by a contiguous row-major matrix of floats containing
+ * the descriptors of the examples (one row per example), followed by a contiguous array containing their labels. All
+ * values are stored in the native byte order of the machine that wrote the file.
+ */
+struct BinaryExampleFormat
+{
+  //#################### NESTED TYPES ####################
+
+  /**
+   * \brief An instance of this struct represents the header of a binary example file.
+   */
+  struct Header
+  {
+    /** The magic number that identifies the file as a binary example file. */
+    char magic[8];
+
+    /** The number of examples in the file. */
+    boost::uint64_t exampleCount;
+
+    /** The number of features in each example's descriptor. */
+    boost::uint32_t featureCount;
+
+    /** The size (in bytes) of each label (used to check that the file is read with the same label type with which it was written). */
+    boost::uint32_t labelSize;
+  };
+
+  //#################### PUBLIC STATIC MEMBER FUNCTIONS ####################
+
+  /**
+   * \brief Determines whether or not the specified file is a binary example file.
+   *
+   * \param filename  The name of the file.
+   * \return          true, if the file exists and starts with the binary example file magic number, or false otherwise.
+   */
+  static bool is_binary_example_file(const std::string& filename)
+  {
+    std::ifstream fs(filename.c_str(), std::ios::binary);
+    char magicBuffer[8];
+    return fs.read(magicBuffer, sizeof(magicBuffer)) && memcmp(magicBuffer, magic(), sizeof(magicBuffer)) == 0;
+  }
+
+  /**
+   * \brief Gets the magic number that identifies a binary example file.
+   *
+   * \return  The magic number that identifies a binary example file.
+   */
+  static const char *magic()
+  {
+    return "RAFLEX01";
+  }
+
+  /**
+   * \brief Makes the header for a binary example file.
+   *
+   * \param exampleCount  The number of examples in the file.
+   * \param featureCount  The number of features in each example's descriptor.
+   * \param labelSize     The size (in bytes) of each label.
+   * \return              The header.
+   */
+  static Header make_header(boost::uint64_t exampleCount, boost::uint32_t featureCount, boost::uint32_t labelSize)
+  {
+    Header header;
+    memcpy(header.magic, magic(), sizeof(header.magic));
+    header.exampleCount = exampleCount;
+    header.featureCount = featureCount;
+    header.labelSize = labelSize;
+    return header;
+  }
+};
+
+/**
+ * \brief An instance of an instantiation of this class template can be used to stream examples from a binary example file in chunks.
+ *
+ * This makes it possible to train on example sets that would not fit comfortably in memory as vectors of individually-allocated
+ * examples, e.g. by repeatedly calling read_chunk and passing the resulting examples to RandomForest::add_examples.
+ */
+template <typename Label>
+class BinaryExampleReader
+{
+  BOOST_STATIC_ASSERT(boost::is_pod<Label>::value);
+
+  //#################### TYPEDEFS ####################
+public:
+  typedef boost::shared_ptr<const Example<Label> > Example_CPtr;
+
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The stream from which to read the descriptors. */
+  std::ifstream m_descriptorStream;
+
+  /** The header of the file. */
+  BinaryExampleFormat::Header m_header;
+
+  /** The stream from which to read the labels. */
+  std::ifstream m_labelStream;
+
+  /** The number of examples that have been read so far. */
+  size_t m_readCount;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs a reader for the specified binary example file.
+   *
+   * \param filename            The name of the file.
+   * \throws std::runtime_error If the file cannot be opened, is not a binary example file, or was written with a different label type.
+   */
+  explicit BinaryExampleReader(const std::string& filename)
+  : m_descriptorStream(filename.c_str(), std::ios::binary), m_labelStream(filename.c_str(), std::ios::binary), m_readCount(0)
+  {
+    if(!m_descriptorStream || !m_labelStream) throw std::runtime_error("Error: '" + filename + "' could not be opened");
+
+    if(!m_descriptorStream.read(reinterpret_cast<char*>(&m_header), sizeof(BinaryExampleFormat::Header)) ||
+       memcmp(m_header.magic, BinaryExampleFormat::magic(), sizeof(m_header.magic)) != 0)
+    {
+      throw std::runtime_error("Error: '" + filename + "' is not a binary example file");
+    }
+
+    if(m_header.labelSize != sizeof(Label))
+    {
+      throw std::runtime_error("Error: The examples in '" + filename + "' were written with a different label type");
+    }
+
+    // Position the label stream at the start of the label array (which follows the descriptor matrix).
+    m_labelStream.seekg(sizeof(BinaryExampleFormat::Header) + m_header.exampleCount * m_header.featureCount * sizeof(float));
+  }
+
+  //#################### COPY CONSTRUCTOR & ASSIGNMENT OPERATOR ####################
+private:
+  // Deliberately private and unimplemented.
+  BinaryExampleReader(const BinaryExampleReader&);
+  BinaryExampleReader& operator=(const BinaryExampleReader&);
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Gets the number of examples in the file.
+   *
+   * \return  The number of examples in the file.
+   */
+  size_t get_example_count() const
+  {
+    return static_cast<size_t>(m_header.exampleCount);
+  }
+
+  /**
+   * \brief Gets the number of features in each example's descriptor.
+   *
+   * \return  The number of features in each example's descriptor.
+   */
+  size_t get_feature_count() const
+  {
+    return m_header.featureCount;
+  }
+
+  /**
+   * \brief Gets whether or not there are any examples left to read.
+   *
+   * \return  true, if there are any examples left to read, or false otherwise.
+   */
+  bool has_more_examples() const
+  {
+    return m_readCount < get_example_count();
+  }
+
+  /**
+   * \brief Reads the next chunk of examples from the file.
+   *
+   * \param maxExampleCount     The maximum number of examples to read.
+   * \return                    The examples that were read (this will be empty if there are no examples left to read).
+   * \throws std::runtime_error If the file is truncated.
+   */
+  std::vector<Example_CPtr> read_chunk(size_t maxExampleCount)
+  {
+    const size_t exampleCount = std::min(maxExampleCount, get_example_count() - m_readCount);
+    const size_t featureCount = get_feature_count();
+
+    std::vector<float> features(exampleCount * featureCount);
+    std::vector<Label> labels(exampleCount);
+    if((!features.empty() && !m_descriptorStream.read(reinterpret_cast<char*>(&features[0]), features.size() * sizeof(float))) ||
+       (!labels.empty() && !m_labelStream.read(reinterpret_cast<char*>(&labels[0]), labels.size() * sizeof(Label))))
+    {
+      throw std::runtime_error("Error: The binary example file is truncated");
+    }
+
+    std::vector<Example_CPtr> result;
+    result.reserve(exampleCount);
+    for(size_t i = 0; i < exampleCount; ++i)
+    {
+      std::vector<float>::const_iterator descriptorBegin = features.begin() + i * featureCount;
+      Descriptor_Ptr descriptor(new Descriptor(descriptorBegin, descriptorBegin + featureCount));
+      result.push_back(Example_CPtr(new Example<Label>(descriptor, labels[i])));
+    }
+
+    m_readCount += exampleCount;
+    return result;
+  }
+};
+
+}
+
+#endif
@@ -74,6 +74,45 @@ public:
    */
   ExampleReservoir() {}
 
+  //#################### COPY CONSTRUCTOR & ASSIGNMENT OPERATOR ####################
+public:
+  /**
+   * \brief Constructs a copy of an example reservoir.
+   *
+   * The copy gets its own histogram, so that adding examples to it does not affect the original. The examples themselves
+   * (which are immutable) and the random number generator (which is thread-safe) are shared.
+   *
+   * \param rhs The reservoir to copy.
+   */
+  ExampleReservoir(const ExampleReservoir& rhs)
+  : m_curSize(rhs.m_curSize),
+    m_examples(rhs.m_examples),
+    m_histogram(rhs.m_histogram ? new tvgutil::Histogram<Label>(*rhs.m_histogram) : NULL),
+    m_maxClassSize(rhs.m_maxClassSize),
+    m_randomNumberGenerator(rhs.m_randomNumberGenerator),
+    m_seenExamples(rhs.m_seenExamples)
+  {}
+
+  /**
+   * \brief Assigns a copy of another example reservoir to this one (see the copy constructor).
+   *
+   * \param rhs The reservoir to copy.
+   * \return    This reservoir.
+   */
+  ExampleReservoir& operator=(const ExampleReservoir& rhs)
+  {
+    if(this != &rhs)
+    {
+      m_curSize = rhs.m_curSize;
+      m_examples = rhs.m_examples;
+      m_histogram.reset(rhs.m_histogram ? new tvgutil::Histogram<Label>(*rhs.m_histogram) : NULL);
+      m_maxClassSize = rhs.m_maxClassSize;
+      m_randomNumberGenerator = rhs.m_randomNumberGenerator;
+      m_seenExamples = rhs.m_seenExamples;
+    }
+    return *this;
+  }
+
   //#################### PUBLIC MEMBER FUNCTIONS ####################
 public:
   /**
@@ -11,7 +11,7 @@
 #include <tvgutil/persistence/LineUtil.h>
 #include <tvgutil/statistics/ProbabilityMassFunction.h>
 
-#include "Example.h"
+#include "BinaryExampleReader.h"
 
 namespace rafl {
 
@@ -50,9 +50,81 @@ public:
     return histogram.empty() ? 0.0f : tvgutil::ProbabilityMassFunction<Label>(histogram, multipliers).calculate_entropy();
   }
 
+  /**
+   * \brief Converts a text file of examples (as read by load_examples) into a binary example file.
+   *
+   * The text file is processed a line at a time, so only the labels (rather than the examples themselves) are held in memory.
+   *
+   * \param textFilename        The name of the text file.
+   * \param binaryFilename      The name of the binary file to write.
+   * \throws std::runtime_error If either file cannot be opened, or if the examples in the text file do not all have the same number of features.
+   */
+  template <typename Label>
+  static void convert_examples_to_binary(const std::string& textFilename, const std::string& binaryFilename)
+  {
+    std::ifstream is(textFilename.c_str());
+    if(!is) throw std::runtime_error("Error: '" + textFilename + "' could not be opened");
+
+    std::ofstream os(binaryFilename.c_str(), std::ios::binary);
+    if(!os) throw std::runtime_error("Error: '" + binaryFilename + "' could not be opened for writing");
+
+    // Write a placeholder header (the counts are filled in once all of the examples have been converted).
+    BinaryExampleFormat::Header header = BinaryExampleFormat::make_header(0, 0, sizeof(Label));
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // Write the descriptors to the file as we go, and keep the labels until the end.
+    const std::string delimiters(", ");
+    std::vector<float> descriptor;
+    std::vector<Label> labels;
+    std::string line;
+    while(std::getline(is, line))
+    {
+      std::vector<std::string> words = tvgutil::LineUtil::extract_words(line, delimiters);
+      if(words.empty()) continue;
+
+      const size_t featureCount = words.size() - 1;
+      if(labels.empty()) header.featureCount = static_cast<boost::uint32_t>(featureCount);
+      else if(featureCount != header.featureCount) throw std::runtime_error("Error: The examples in '" + textFilename + "' have different numbers of features");
+
+      descriptor.resize(featureCount);
+      for(size_t j = 0; j < featureCount; ++j)
+      {
+        descriptor[j] = boost::lexical_cast<float>(words[j]);
+      }
+
+      if(featureCount > 0) os.write(reinterpret_cast<const char*>(&descriptor[0]), featureCount * sizeof(float));
+      labels.push_back(boost::lexical_cast<Label>(words.back()));
+    }
+
+    // Write the labels, and then go back and fill in the header.
+    if(!labels.empty()) os.write(reinterpret_cast<const char*>(&labels[0]), labels.size() * sizeof(Label));
+
+    header.exampleCount = labels.size();
+    os.seekp(0);
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if(!os) throw std::runtime_error("Error: Could not write to '" + binaryFilename + "'");
+  }
+
+  /**
+   * \brief Loads all of the examples in the specified binary example file.
+   *
+   * To avoid holding all of the examples in memory at once, use a BinaryExampleReader instead.
+   *
+   * \param filename  The name of the binary example file.
+   * \return          The loaded examples.
+   */
+  template <typename Label>
+  static std::vector<boost::shared_ptr<const Example<Label> > > load_binary_examples(const std::string& filename)
+  {
+    BinaryExampleReader<Label> reader(filename);
+    return reader.read_chunk(reader.get_example_count());
+  }
+
   /**
    * \brief Loads a set of examples from the specified file.
    *
+   * The file may either be a binary example file (which is detected automatically) or a text file containing one example per line.
+   *
    * \param filename  The name of the file from which to load the examples.
    * \return          The loaded examples.
    */
@@ -62,6 +134,8 @@ public:
     // FIXME: Make this robust to bad data.
 
     typedef boost::shared_ptr<const Example<Label> > Example_CPtr;
+    if(BinaryExampleFormat::is_binary_example_file(filename)) return load_binary_examples<Label>(filename);
+
     std::vector<Example_CPtr> result;
 
     std::ifstream fs(filename.c_str());
@@ -73,6 +147,7 @@ public:
     for(size_t i = 0, lineCount = wordLines.size(); i < lineCount; ++i)
     {
       const std::vector<std::string>& words = wordLines[i];
+      if(words.empty()) continue;
 
       Descriptor_Ptr descriptor(new Descriptor);
       for(size_t j = 0; j < words.size() - 1; ++j)
@@ -120,6 +195,37 @@ public:
   {
     return tvgutil::ProbabilityMassFunction<Label>(make_histogram(examples), multipliers);
   }
+
+  /**
+   * \brief Saves a set of examples to a binary example file.
+   *
+   * \param examples            The examples to save (their descriptors must all have the same size).
+   * \param filename            The name of the binary example file.
+   * \throws std::runtime_error If the file cannot be written, or if the descriptors of the examples have different sizes.
+   */
+  template <typename Label>
+  static void save_binary_examples(const std::vector<boost::shared_ptr<const Example<Label> > >& examples, const std::string& filename)
+  {
+    std::ofstream os(filename.c_str(), std::ios::binary);
+    if(!os) throw std::runtime_error("Error: '" + filename + "' could not be opened for writing");
+
+    const size_t featureCount = examples.empty() ? 0 : examples[0]->get_descriptor()->size();
+    BinaryExampleFormat::Header header = BinaryExampleFormat::make_header(examples.size(), static_cast<boost::uint32_t>(featureCount), sizeof(Label));
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    std::vector<Label> labels;
+    labels.reserve(examples.size());
+    for(size_t i = 0, size = examples.size(); i < size; ++i)
+    {
+      const Descriptor& descriptor = *examples[i]->get_descriptor();
+      if(descriptor.size() != featureCount) throw std::runtime_error("Error: The examples to save have different numbers of features");
+      if(featureCount > 0) os.write(reinterpret_cast<const char*>(&descriptor[0]), featureCount * sizeof(float));
+      labels.push_back(examples[i]->get_label());
+    }
+
+    if(!labels.empty()) os.write(reinterpret_cast<const char*>(&labels[0]), labels.size() * sizeof(Label));
+    if(!os) throw std::runtime_error("Error: Could not write to '" + filename + "'");
+  }
 };
 
 }
@@ -22,6 +22,16 @@ DecisionFunction::DescriptorClassification FeatureThresholdingDecisionFunction::
   return descriptor[m_featureIndex] < m_threshold ? DC_LEFT : DC_RIGHT;
 }
 
+size_t FeatureThresholdingDecisionFunction::get_feature_index() const
+{
+  return m_featureIndex;
+}
+
+float FeatureThresholdingDecisionFunction::get_threshold() const
+{
+  return m_threshold;
+}
+
 void FeatureThresholdingDecisionFunction::output(std::ostream& os) const
 {
   os << "Feature " << m_featureIndex << " < " << m_threshold;
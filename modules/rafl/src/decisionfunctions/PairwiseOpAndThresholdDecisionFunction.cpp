@@ -29,6 +29,26 @@ DecisionFunction::DescriptorClassification PairwiseOpAndThresholdDecisionFunctio
   return result < m_threshold ? DC_LEFT : DC_RIGHT;
 }
 
+size_t PairwiseOpAndThresholdDecisionFunction::get_first_feature_index() const
+{
+  return m_firstFeatureIndex;
+}
+
+PairwiseOpAndThresholdDecisionFunction::Op PairwiseOpAndThresholdDecisionFunction::get_op() const
+{
+  return m_op;
+}
+
+size_t PairwiseOpAndThresholdDecisionFunction::get_second_feature_index() const
+{
+  return m_secondFeatureIndex;
+}
+
+float PairwiseOpAndThresholdDecisionFunction::get_threshold() const
+{
+  return m_threshold;
+}
+
 void PairwiseOpAndThresholdDecisionFunction::output(std::ostream& os) const
 {
   os << "First Feature " << m_firstFeatureIndex << ' '
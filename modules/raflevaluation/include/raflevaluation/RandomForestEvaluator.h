@@ -96,25 +96,20 @@ private:
    */
   static ResultType do_evaluation(const RandomForest_Ptr& randomForest, const std::vector<Example_CPtr>& examples, const std::vector<size_t>& indices)
   {
-    std::set<Label> classLabels;
-    int indicesSize = static_cast<int>(indices.size());
-    std::vector<Label> expectedLabels(indicesSize), predictedLabels(indicesSize);
+    // Predict labels for all of the evaluation examples at once.
+    std::vector<Label> predictedLabels = randomForest->predict(examples, indices);
 
-#ifdef WITH_OPENMP
-    #pragma omp parallel for
-#endif
-    for(int i = 0; i < indicesSize; ++i)
+    // Gather the expected labels, and make the set of labels that occur in either the expected or the predicted labels.
+    const size_t indicesSize = indices.size();
+    std::vector<Label> expectedLabels(indicesSize);
+    for(size_t i = 0; i < indicesSize; ++i)
     {
-      const Example_CPtr& example = examples[indices[i]];
-      predictedLabels[i] = randomForest->predict(example->get_descriptor());
-      expectedLabels[i] = example->get_label();
-
-#ifdef WITH_OPENMP
-      #pragma omp critical
-#endif
-      classLabels.insert(expectedLabels[i]);
+      expectedLabels[i] = examples[indices[i]]->get_label();
     }
 
+    std::set<Label> classLabels(expectedLabels.begin(), expectedLabels.end());
+    classLabels.insert(predictedLabels.begin(), predictedLabels.end());
+
     Eigen::MatrixXf confusionMatrix = ConfusionMatrixUtil::make_confusion_matrix(classLabels, expectedLabels, predictedLabels);
     return boost::assign::map_list_of("Accuracy", ConfusionMatrixUtil::calculate_accuracy(ConfusionMatrixUtil::normalise_rows_L1(confusionMatrix)));
   }
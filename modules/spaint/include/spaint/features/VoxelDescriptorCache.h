@@ -0,0 +1,123 @@
+/**
+ * spaint: VoxelDescriptorCache.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2017. All rights reserved.
+ */
+
+#ifndef H_SPAINT_VOXELDESCRIPTORCACHE
+#define H_SPAINT_VOXELDESCRIPTORCACHE
+
+#include <list>
+
+#include <boost/cstdint.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <ITMLib/Utils/ITMMath.h>
+
+#include <rafl/base/Descriptor.h>
+
+namespace spaint {
+
+/**
+ * \brief An instance of this class can be used to cache the feature descriptors computed for voxels in a scene.
+ *
+ * Each descriptor is stored together with the values of the scene change counter (see SLAMState::get_scene_change_count) and
+ * the fusion count of the voxel's block (see SLAMState::get_block_fusion_count) at the time it was computed. It is treated as
+ * stale once the scene has changed as a whole, or once the voxel's block has been fused into more than a specified number of times.
+ * The cache has a fixed capacity: when it is full, the least recently used descriptor is evicted to make room for a new one.
+ */
+class VoxelDescriptorCache
+{
+  //#################### NESTED TYPES ####################
+private:
+  /**
+   * \brief An instance of this struct represents an entry in the cache.
+   */
+  struct Entry
+  {
+    /** The fusion count of the voxel's block when the descriptor was computed. */
+    size_t blockFusionCount;
+
+    /** The descriptor for the voxel. */
+    rafl::Descriptor_CPtr descriptor;
+
+    /** The position of the entry's key in the recency list. */
+    std::list<boost::uint64_t>::iterator recencyIt;
+
+    /** The value of the scene change counter when the descriptor was computed. */
+    size_t sceneChangeCount;
+  };
+
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The maximum number of descriptors that the cache can hold. */
+  size_t m_capacity;
+
+  /** The entries in the cache, indexed by the keys of their voxels. */
+  boost::unordered_map<boost::uint64_t,Entry> m_entries;
+
+  /** The number of times a voxel's block can be fused into before its cached descriptor is treated as stale (0 means that descriptors are only reused until the block is next fused into). */
+  size_t m_maxAge;
+
+  /** The keys of the voxels whose descriptors are in the cache, ordered from most to least recently used. */
+  std::list<boost::uint64_t> m_recencyList;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs a voxel descriptor cache.
+   *
+   * \param capacity  The maximum number of descriptors that the cache can hold.
+   * \param maxAge    The number of times a voxel's block can be fused into before its cached descriptor is treated as stale.
+   */
+  VoxelDescriptorCache(size_t capacity, size_t maxAge);
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Removes all of the descriptors from the cache.
+   */
+  void clear();
+
+  /**
+   * \brief Inserts the descriptor for a voxel into the cache, replacing any existing descriptor for the voxel.
+   *
+   * \param voxelLocation     The location of the voxel.
+   * \param descriptor        The descriptor for the voxel.
+   * \param sceneChangeCount  The value of the scene change counter when the descriptor was computed.
+   * \param blockFusionCount  The fusion count of the voxel's block when the descriptor was computed.
+   */
+  void insert(const Vector3s& voxelLocation, const rafl::Descriptor_CPtr& descriptor, size_t sceneChangeCount, size_t blockFusionCount);
+
+  /**
+   * \brief Looks up the descriptor for a voxel in the cache.
+   *
+   * Stale descriptors are removed from the cache when they are looked up.
+   *
+   * \param voxelLocation     The location of the voxel.
+   * \param sceneChangeCount  The current value of the scene change counter.
+   * \param blockFusionCount  The current fusion count of the voxel's block.
+   * \return                  The descriptor for the voxel, if it is in the cache and not stale, or NULL otherwise.
+   */
+  rafl::Descriptor_CPtr lookup(const Vector3s& voxelLocation, size_t sceneChangeCount, size_t blockFusionCount);
+
+  /**
+   * \brief Gets the number of descriptors in the cache.
+   *
+   * \return  The number of descriptors in the cache.
+   */
+  size_t size() const;
+
+  //#################### PRIVATE STATIC MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Makes the key used to index the cache entry for a voxel.
+   *
+   * \param voxelLocation The location of the voxel.
+   * \return              The key.
+   */
+  static boost::uint64_t make_key(const Vector3s& voxelLocation);
+};
+
+}
+
+#endif
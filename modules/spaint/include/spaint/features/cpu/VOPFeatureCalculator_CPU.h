@@ -48,6 +48,32 @@ private:
 
   /** Override */
   virtual void update_coordinate_systems(int voxelLocationCount, const ORUtils::MemoryBlock<float>& featuresMB) const;
+
+  //#################### PRIVATE STATIC MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Computes a histogram of oriented gradients from the RGB patch for a voxel in a single pass over the patch.
+   *
+   * \param rgbPatch      The voxel's RGB patch (i.e. the patch segment of its feature descriptor).
+   * \param patchSize     The side length of a VOP patch.
+   * \param binCount      The number of bins into which to quantize the gradient orientations.
+   * \param intensities   Scratch storage for the intensity values of the patch (patchSize * patchSize elements).
+   * \param rowGradients  Scratch storage for the gradients of a patch row (3 * patchSize elements).
+   * \param histogram     The location into which to write the histogram for the patch.
+   */
+  static void compute_histogram_for_voxel(const float *rgbPatch, int patchSize, size_t binCount, float *intensities, float *rowGradients, float *histogram);
+
+  /**
+   * \brief Converts the RGB patch for a voxel to the CIELab colour space, processing each stage of the conversion for the whole patch at once.
+   *
+   * This produces the same results as convert_patch_to_lab, but splits the patch into separate channels so that the
+   * linear stages of the conversion can be vectorised.
+   *
+   * \param rgbPatch  The voxel's RGB patch (i.e. the patch segment of its feature descriptor).
+   * \param patchArea The number of pixels in the patch.
+   * \param channels  Scratch storage for the separate channels of the patch (6 * patchArea elements).
+   */
+  static void convert_patch_to_lab_vectorised(float *rgbPatch, int patchArea, float *channels);
 };
 
 }
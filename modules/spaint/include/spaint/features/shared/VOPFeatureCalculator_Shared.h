@@ -12,6 +12,59 @@
 
 namespace spaint {
 
+/**
+ * \brief Rotates the coordinate system for a voxel to align it with the dominant orientation in a histogram of oriented gradients.
+ *
+ * \param histogram The histogram of oriented intensity gradients for the voxel's patch.
+ * \param binCount  The number of quantized orientation bins in the histogram.
+ * \param xAxis     The x axis for the voxel.
+ * \param yAxis     The y axis for the voxel.
+ */
+_CPU_AND_GPU_CODE_
+inline void align_coordinate_system_with_histogram(const float *histogram, size_t binCount, Vector3f *xAxis, Vector3f *yAxis)
+{
+  // Calculate the dominant orientation for the voxel.
+  size_t dominantBin = 0;
+  double highestBinValue = 0;
+  for(size_t binIndex = 0; binIndex < binCount; ++binIndex)
+  {
+    double binValue = histogram[binIndex];
+    if(binValue >= highestBinValue)
+    {
+      highestBinValue = binValue;
+      dominantBin = binIndex;
+    }
+  }
+
+  float binAngle = static_cast<float>(2 * M_PI) / binCount;
+  float dominantOrientation = dominantBin * binAngle;
+
+  // Rotate the existing axes to be aligned with the dominant orientation.
+  float c = cos(dominantOrientation);
+  float s = sin(dominantOrientation);
+
+  Vector3f xAxisCopy = *xAxis;
+  Vector3f yAxisCopy = *yAxis;
+
+  *xAxis = c * xAxisCopy + s * yAxisCopy;
+  *yAxis = c * yAxisCopy - s * xAxisCopy;
+}
+
+/**
+ * \brief Quantizes the orientation of an intensity gradient into one of the bins of a histogram of oriented gradients.
+ *
+ * \param xDeriv    The x derivative of the intensity.
+ * \param yDeriv    The y derivative of the intensity.
+ * \param binCount  The number of bins into which to quantize the gradient orientations.
+ * \return          The bin into which the orientation of the gradient falls.
+ */
+_CPU_AND_GPU_CODE_
+inline int quantize_orientation(float xDeriv, float yDeriv, size_t binCount)
+{
+  double ori = atan2(yDeriv, xDeriv) + 2 * M_PI;
+  return static_cast<int>(binCount * ori / (2 * M_PI)) % binCount;
+}
+
 /**
  * \brief Converts the RGB patch for the specified voxel to the CIELab colour space.
  *
@@ -66,11 +119,8 @@ inline void compute_histogram_for_patch(int tid, size_t patchSize, const float *
     // Compute the magnitude.
     float mag = static_cast<float>(sqrt(xDeriv * xDeriv + yDeriv * yDeriv));
 
-    // Compute the orientation.
-    double ori = atan2(yDeriv, xDeriv) + 2 * M_PI;
-
-    // Quantize the orientation and update the histogram.
-    int bin = static_cast<int>(binCount * ori / (2 * M_PI)) % binCount;
+    // Compute and quantize the orientation, and update the histogram.
+    int bin = quantize_orientation(xDeriv, yDeriv, binCount);
 
 #if defined(__CUDACC__) && defined(__CUDA_ARCH__)
     atomicAdd(&histogram[bin], mag);
@@ -246,31 +296,7 @@ inline void update_coordinate_system(int tid, int patchArea, const float *histog
 {
   if(tid % patchArea == 0)
   {
-    // Calculate the dominant orientation for the voxel.
-    size_t dominantBin = 0;
-    double highestBinValue = 0;
-    for(size_t binIndex = 0; binIndex < binCount; ++binIndex)
-    {
-      double binValue = histogram[binIndex];
-      if(binValue >= highestBinValue)
-      {
-        highestBinValue = binValue;
-        dominantBin = binIndex;
-      }
-    }
-
-    float binAngle = static_cast<float>(2 * M_PI) / binCount;
-    float dominantOrientation = dominantBin * binAngle;
-
-    // Rotate the existing axes to be aligned with the dominant orientation.
-    float c = cos(dominantOrientation);
-    float s = sin(dominantOrientation);
-
-    Vector3f xAxisCopy = *xAxis;
-    Vector3f yAxisCopy = *yAxis;
-
-    *xAxis = c * xAxisCopy + s * yAxisCopy;
-    *yAxis = c * yAxisCopy - s * xAxisCopy;
+    align_coordinate_system_with_histogram(histogram, binCount, xAxis, yAxis);
   }
 }
 
@@ -6,6 +6,9 @@
 #ifndef H_SPAINT_ARUCOFIDUCIALDETECTOR
 #define H_SPAINT_ARUCOFIDUCIALDETECTOR
 
+#include <map>
+#include <vector>
+
 #include <boost/optional.hpp>
 
 #include <opencv2/opencv.hpp>
@@ -18,17 +21,55 @@ namespace spaint {
 
 /**
  * \brief An instance of this class can be used to detect ArUco fiducials in a 3D scene.
+ *
+ * By default, the detector tracks the fiducials it has detected from one frame to the next: rather than scanning the
+ * whole colour image for fiducials every frame, it predicts where in the image each known fiducial will be (based on
+ * the camera pose and the positions of the fiducial's corners in world space), and only scans a padded region of
+ * interest around each prediction. A full-frame scan is performed every so often (to find any new fiducials), and
+ * whenever a known fiducial cannot be found in its region of interest.
  */
 class ArUcoFiducialDetector : public FiducialDetector
 {
+  //#################### NESTED TYPES ####################
+private:
+  /**
+   * \brief An instance of this struct records the information needed to predict where a fiducial will be in the next frame.
+   */
+  struct TrackedFiducial
+  {
+    /** The corners of the fiducial in the colour image in which it was most recently detected. */
+    std::vector<cv::Point2f> corners;
+
+    /** The positions of the fiducial's corners in world space (where known). */
+    std::vector<boost::optional<Vector3f> > worldCorners;
+  };
+
   //#################### PRIVATE VARIABLES ####################
 private:
+  /** The number of frames since the last full-frame scan for fiducials. */
+  mutable int m_framesSinceFullScan;
+
+  /** The maximum number of frames between full-frame scans for fiducials when the known fiducials are being tracked. */
+  int m_fullScanInterval;
+
+  /** The minimum amount of padding (in pixels) to add around the predicted location of a known fiducial when scanning for it. */
+  int m_minRoiPadding;
+
   /** The picker used when estimating poses from the scene raycast. */
   mutable itmx::Picker_CPtr m_picker;
 
+  /** The amount of padding (as a fraction of the size of its predicted bounding box) to add around the predicted location of a known fiducial when scanning for it. */
+  float m_roiPaddingFactor;
+
+  /** Whether or not to track the known fiducials between frames, rather than scanning the whole colour image for fiducials every frame. */
+  bool m_roiTrackingEnabled;
+
   /** The settings to use for InfiniTAM. */
   Settings_CPtr m_settings;
 
+  /** The fiducials that were detected in the previous frame, indexed by ID. */
+  mutable std::map<int,TrackedFiducial> m_trackedFiducials;
+
   //#################### CONSTRUCTORS ####################
 public:
   /**
@@ -90,6 +131,19 @@ private:
   std::vector<boost::optional<FiducialMeasurement> > construct_measurements_from_raycast(const std::vector<int>& ids, const std::vector<std::vector<cv::Point2f> >& corners,
                                                                                          const VoxelRenderState_CPtr& renderState, const ORUtils::SE3Pose& pose) const;
 
+  /**
+   * \brief Scans padded regions of interest around the predicted locations of the known fiducials in the live colour image.
+   *
+   * \param rgbImage  The live colour image.
+   * \param view      The view of the scene containing the live images.
+   * \param pose      The current estimate of the camera pose.
+   * \param ids       A vector into which to write the IDs of the fiducials that are detected.
+   * \param corners   A vector into which to write the corners of the fiducials that are detected.
+   * \return          true, if all of the known fiducials were detected, or false otherwise.
+   */
+  bool detect_known_fiducials(const cv::Mat3b& rgbImage, const View_CPtr& view, const ORUtils::SE3Pose& pose,
+                              std::vector<int>& ids, std::vector<std::vector<cv::Point2f> >& corners) const;
+
   /**
    * \brief Tries to determine the 3D point in eye space that corresponds to a fiducial corner in the live colour image
    *        by back-projecting into 3D using the depth value from the live depth image.
@@ -110,6 +164,17 @@ private:
    */
   boost::optional<Vector3f> pick_corner_from_raycast(const cv::Point2f& corner, const VoxelRenderState_CPtr& renderState) const;
 
+  /**
+   * \brief Replaces the set of known fiducials with the set of fiducials that have just been detected.
+   *
+   * \param ids     The IDs of the fiducials that have been detected in the live colour image.
+   * \param corners The corners of the fiducials that have been detected in the live colour image.
+   * \param view    The view of the scene containing the live images.
+   * \param pose    The current estimate of the camera pose (used to map the fiducial corners from eye space to world space).
+   */
+  void update_tracked_fiducials(const std::vector<int>& ids, const std::vector<std::vector<cv::Point2f> >& corners,
+                                const View_CPtr& view, const ORUtils::SE3Pose& pose) const;
+
   //#################### PRIVATE STATIC MEMBER FUNCTIONS ####################
 private:
   /**
@@ -0,0 +1,86 @@
+/**
+ * spaint: NativeMedianFilterer.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2017. All rights reserved.
+ */
+
+#ifndef H_SPAINT_NATIVEMEDIANFILTERER
+#define H_SPAINT_NATIVEMEDIANFILTERER
+
+#include <vector>
+
+#include <ORUtils/DeviceType.h>
+
+#include <itmx/base/ITMImagePtrTypes.h>
+
+namespace spaint {
+
+/**
+ * \brief An instance of this class can be used to perform median filtering on RGBA images without needing ArrayFire.
+ *
+ * The filtering is performed on the CPU, one channel at a time, using a fixed sorting network to find the median of
+ * each pixel's neighbourhood. The networks only use byte-wise min/max operations and are applied to whole rows at
+ * a time, which allows the compiler to vectorise them. Pixels beyond the borders of the image are treated as copies
+ * of the nearest pixel inside it. Only kernel widths of 3 and 5 are supported.
+ */
+class NativeMedianFilterer
+{
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The device on which the images to be filtered reside. */
+  DeviceType m_deviceType;
+
+  /** The kernel width to use for median filtering. */
+  unsigned int m_kernelWidth;
+
+  /** A padded copy of the most recent input image, with its border pixels replicated to fill the padding. */
+  mutable std::vector<Vector4u> m_padded;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs a native median filterer.
+   *
+   * \param kernelWidth           The kernel width to use for median filtering (must be 3 or 5).
+   * \param deviceType            The device on which the images to be filtered reside.
+   * \throws std::invalid_argument If the kernel width is not supported.
+   */
+  NativeMedianFilterer(unsigned int kernelWidth, DeviceType deviceType);
+
+  //#################### PUBLIC OPERATORS ####################
+public:
+  /**
+   * \brief Performs median filtering on an RGBA input image to produce an RGBA output image.
+   *
+   * If the filterer is operating in CUDA mode, the input image is transferred to the CPU for filtering, and the result
+   * is transferred back to the GPU afterwards. The input and output images may be the same.
+   *
+   * \param input   The input image.
+   * \param output  The output image.
+   */
+  void operator()(const ITMUChar4Image_CPtr& input, const ITMUChar4Image_Ptr& output) const;
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Performs median filtering on the CPU copy of an RGBA input image, writing the result into the CPU copy of an RGBA output image.
+   *
+   * This makes it possible to fuse the filtering with a device-to-host copy of the input image, since the output image
+   * can be written directly rather than first being made into a copy of the input. The output image must already be
+   * the same size as the input image, but the two images may be the same.
+   *
+   * \param input   The input image (whose CPU copy must be up to date).
+   * \param output  The output image.
+   */
+  void filter_on_cpu(const ITMUChar4Image *input, ITMUChar4Image *output) const;
+
+  /**
+   * \brief Gets the kernel width used for median filtering.
+   *
+   * \return  The kernel width used for median filtering.
+   */
+  unsigned int get_kernel_width() const;
+};
+
+}
+
+#endif
@@ -6,15 +6,34 @@
 #ifndef H_SPAINT_VOXELMARKER_CPU
 #define H_SPAINT_VOXELMARKER_CPU
 
+#include <utility>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
 #include "../interface/VoxelMarker.h"
 
 namespace spaint {
 
 /**
  * \brief An instance of this class can be used to mark a set of voxels with a semantic label using the CPU.
+ *
+ * Rather than looking up each voxel in the scene's hash table independently, the marker first sorts the voxels
+ * to be marked by voxel block, and then looks up each block only once. This also allows duplicate voxels to be
+ * handled deterministically: each duplicate receives the label that the voxel had before the marking operation
+ * as its old label, and the voxel ends up with the label it would have had if the voxels had been marked one by
+ * one in input order.
  */
 class VoxelMarker_CPU : public VoxelMarker
 {
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The indices in the sorted entry array at which the entries for each voxel block start (plus a final sentinel). */
+  mutable std::vector<int> m_blockStarts;
+
+  /** The voxels to be marked, each represented by a (block/voxel key, input index) pair and sorted by block, voxel and input index. */
+  mutable std::vector<std::pair<boost::uint64_t,int> > m_sortedEntries;
+
   //#################### PUBLIC MEMBER FUNCTIONS ####################
 public:
   /** Override */
@@ -27,6 +46,22 @@ public:
   /** Override */
   virtual void mark_voxels(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB, const ORUtils::MemoryBlock<SpaintVoxel::PackedLabel>& voxelLabelsMB,
                            SpaintVoxelScene *scene, MarkingMode mode, ORUtils::MemoryBlock<SpaintVoxel::PackedLabel> *oldVoxelLabelsMB) const;
+
+  //#################### PRIVATE MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Marks a set of voxels in the scene with semantic labels, looking up each voxel block only once.
+   *
+   * \param voxelLocations  The locations of the voxels in the scene.
+   * \param voxelLabels     The semantic labels with which to mark the voxels (one per voxel), or NULL to mark them all with label.
+   * \param label           The semantic label with which to mark the voxels (used iff voxelLabels is NULL).
+   * \param voxelCount      The number of voxels to mark.
+   * \param scene           The scene.
+   * \param mode            The marking mode.
+   * \param oldVoxelLabels  An optional array into which to store the old semantic labels of the voxels being marked.
+   */
+  void mark_voxels_by_block(const Vector3s *voxelLocations, const SpaintVoxel::PackedLabel *voxelLabels, SpaintVoxel::PackedLabel label,
+                            int voxelCount, SpaintVoxelScene *scene, MarkingMode mode, SpaintVoxel::PackedLabel *oldVoxelLabels) const;
 };
 
 }
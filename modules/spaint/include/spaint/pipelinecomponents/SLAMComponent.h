@@ -14,6 +14,7 @@
 
 #include "SLAMContext.h"
 #include "../fiducials/FiducialDetector.h"
+#include "../slamstate/interface/VisibleBlockFinder.h"
 
 namespace spaint {
 
@@ -135,6 +136,12 @@ private:
   /** The view builder. */
   ViewBuilder_Ptr m_viewBuilder;
 
+  /** The visible block finder used to determine which voxel blocks each frame has been fused into. */
+  VisibleBlockFinder_CPtr m_visibleBlockFinder;
+
+  /** A memory block in which to store the positions of the voxel blocks into which the most recent frame was fused. */
+  boost::shared_ptr<ORUtils::MemoryBlock<Vector3s> > m_visibleBlockPositionsMB;
+
   //#################### CONSTRUCTORS ####################
 public:
   /**
@@ -9,6 +9,7 @@
 #include <rafl/core/RandomForest.h>
 
 #include "SemanticSegmentationContext.h"
+#include "../features/VoxelDescriptorCache.h"
 #include "../features/interface/FeatureCalculator.h"
 #include "../sampling/interface/PerLabelVoxelSampler.h"
 #include "../sampling/interface/UniformVoxelSampler.h"
@@ -26,6 +27,12 @@ private:
 
   //#################### PRIVATE VARIABLES ####################
 private:
+  /** Whether or not to split the nodes of the random forest on background threads rather than during run_training itself. */
+  bool m_backgroundTrainingEnabled;
+
+  /** The minimum amount of time (in microseconds) between successive snapshots of each tree for background training. */
+  int m_backgroundTrainingInterval;
+
   /** The shared context needed for semantic segmentation. */
   SemanticSegmentationContext_Ptr m_context;
 
@@ -47,9 +54,15 @@ private:
   /** A memory block in which to store the feature vectors computed for the various voxels during prediction. */
   boost::shared_ptr<ORUtils::MemoryBlock<float> > m_predictionFeaturesMB;
 
+  /** A cache of the feature descriptors computed for voxels during prediction, used to avoid recomputing the descriptors for voxels in parts of the scene that have not changed. */
+  boost::shared_ptr<VoxelDescriptorCache> m_predictionDescriptorCache;
+
   /** A memory block in which to store the labels predicted for the various voxels. */
   boost::shared_ptr<ORUtils::MemoryBlock<SpaintVoxel::PackedLabel> > m_predictionLabelsMB;
 
+  /** A memory block in which to store the locations of the voxels sampled for prediction purposes whose descriptors were not in the cache. */
+  Selector::Selection_Ptr m_predictionMissLocationsMB;
+
   /** The voxel sampler used in prediction mode. */
   UniformVoxelSampler_CPtr m_predictionSampler;
 
@@ -71,6 +84,12 @@ private:
   /** The voxel sampler used in training mode. */
   PerLabelVoxelSampler_CPtr m_trainingSampler;
 
+  /** The maximum number of nodes per tree that may be split in each training step (when training is not time-budgeted). */
+  size_t m_trainingSplitBudget;
+
+  /** The amount of time (in microseconds) that may be spent splitting nodes in each training step (0 means use the split budget instead). */
+  int m_trainingTimeBudget;
+
   /** A memory block in which to store the number of voxels sampled for each label for training purposes. */
   boost::shared_ptr<ORUtils::MemoryBlock<unsigned int> > m_trainingVoxelCountsMB;
 
@@ -29,12 +29,14 @@ struct LabelPropagatorFactory
    * \param maxAngleBetweenNormals            The largest angle allowed between the normals of neighbouring voxels if propagation is to occur.
    * \param maxSquaredDistanceBetweenColours  The maximum squared distance allowed between the colours of neighbouring voxels if propagation is to occur.
    * \param maxSquaredDistanceBetweenVoxels   The maximum squared distance allowed between the positions of neighbouring voxels if propagation is to occur.
+   * \param iterationCount                    The number of propagation steps to perform each time a label is propagated (only used by the CPU propagator).
    * \return                                  The label propagator.
    */
   static LabelPropagator_CPtr make_label_propagator(size_t raycastResultSize, DeviceType deviceType,
                                                     float maxAngleBetweenNormals = static_cast<float>(2.0f * M_PI / 180.0f),
                                                     float maxSquaredDistanceBetweenColours = 50.0f * 50.0f,
-                                                    float maxSquaredDistanceBetweenVoxels = 10.0f * 10.0f);
+                                                    float maxSquaredDistanceBetweenVoxels = 10.0f * 10.0f,
+                                                    size_t iterationCount = 4);
 };
 
 }
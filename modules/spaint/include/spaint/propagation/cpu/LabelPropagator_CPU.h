@@ -6,15 +6,43 @@
 #ifndef H_SPAINT_LABELPROPAGATOR_CPU
 #define H_SPAINT_LABELPROPAGATOR_CPU
 
+#include <vector>
+
 #include "../interface/LabelPropagator.h"
 
 namespace spaint {
 
 /**
  * \brief An instance of this class can be used to propagate a specified label across surfaces in the scene using the CPU.
+ *
+ * Rather than looking up the neighbours of each voxel in the scene's hash table during propagation, the CPU propagator first gathers
+ * the positions, normals, CIELab colours and labels of the voxels in the raycast result into a compact, per-frame surface point cloud
+ * (stored as one array per property). Propagation is then performed on this point cloud, using the image grid of the raycast result
+ * as its neighbourhood structure, which makes it cheap to perform several propagation steps per frame. Finally, the labels of those
+ * voxels whose labels have changed are written back to the scene.
  */
 class LabelPropagator_CPU : public LabelPropagator
 {
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The number of propagation steps to perform on the surface point cloud each time a label is propagated. */
+  size_t m_iterationCount;
+
+  /** The CIELab colours of the surface points. */
+  mutable std::vector<Vector3f> m_labColours;
+
+  /** The labels of the surface points (double-buffered, so that each propagation step can read one buffer and write the other). */
+  mutable std::vector<SpaintVoxel::PackedLabel> m_labels[2];
+
+  /** The labels that the surface points had in the scene when they were gathered. */
+  mutable std::vector<SpaintVoxel::PackedLabel> m_originalLabels;
+
+  /** The positions of the surface points. */
+  mutable std::vector<Vector3f> m_positions;
+
+  /** Flags indicating which of the surface points correspond to voxels in the scene. */
+  mutable std::vector<unsigned char> m_valid;
+
   //#################### CONSTRUCTORS ####################
 public:
   /**
@@ -24,8 +52,10 @@ public:
    * \param maxAngleBetweenNormals            The largest angle allowed between the normals of neighbouring voxels if propagation is to occur.
    * \param maxSquaredDistanceBetweenColours  The maximum squared distance allowed between the colours of neighbouring voxels if propagation is to occur.
    * \param maxSquaredDistanceBetweenVoxels   The maximum squared distance allowed between the positions of neighbouring voxels if propagation is to occur.
+   * \param iterationCount                    The number of propagation steps to perform each time a label is propagated.
    */
-  LabelPropagator_CPU(size_t raycastResultSize, float maxAngleBetweenNormals, float maxSquaredDistanceBetweenColours, float maxSquaredDistanceBetweenVoxels);
+  LabelPropagator_CPU(size_t raycastResultSize, float maxAngleBetweenNormals, float maxSquaredDistanceBetweenColours, float maxSquaredDistanceBetweenVoxels,
+                      size_t iterationCount);
 
   //#################### PRIVATE MEMBER FUNCTIONS ####################
 private:
@@ -127,6 +127,119 @@ inline void propagate_from_neighbours(int voxelIndex, int width, int height, Spa
 #undef SPFN
 }
 
+/**
+ * \brief Determines whether or not the specified label should be propagated from a specified neighbouring surface point to the point of interest.
+ *
+ * This is equivalent to should_propagate_from_neighbour, but operates on a per-frame surface point cloud (see write_surface_point)
+ * rather than looking up the neighbour's properties in the scene.
+ *
+ * \param neighbourX                        The x coordinate of the neighbour in the raycast result.
+ * \param neighbourY                        The y coordinate of the neighbour in the raycast result.
+ * \param width                             The width of the raycast result.
+ * \param height                            The height of the raycast result.
+ * \param label                             The label being propagated.
+ * \param loc                               The position of the point of interest in the scene.
+ * \param normal                            The surface normal of the point of interest.
+ * \param labColour                         The CIELab colour of the point of interest.
+ * \param positions                         The positions of the surface points.
+ * \param normals                           The surface normals of the surface points.
+ * \param labColours                        The CIELab colours of the surface points.
+ * \param labels                            The current labels of the surface points.
+ * \param valid                             Flags indicating which of the surface points correspond to voxels in the scene.
+ * \param maxAngleBetweenNormals            The largest angle allowed between the normals of the neighbour and the point of interest if propagation is to occur.
+ * \param maxSquaredDistanceBetweenColours  The maximum squared distance allowed between the colours of the neighbour and the point of interest if propagation is to occur.
+ * \param maxSquaredDistanceBetweenVoxels   The maximum squared distance allowed between the positions of the neighbour and the point of interest if propagation is to occur.
+ * \return                                  true, if the label should be propagated from the neighbour, or false otherwise.
+ */
+_CPU_AND_GPU_CODE_
+inline bool should_propagate_from_surface_point(int neighbourX, int neighbourY, int width, int height, SpaintVoxel::Label label,
+                                                const Vector3f& loc, const Vector3f& normal, const Vector3f& labColour,
+                                                const Vector3f *positions, const Vector3f *normals, const Vector3f *labColours,
+                                                const SpaintVoxel::PackedLabel *labels, const unsigned char *valid,
+                                                float maxAngleBetweenNormals, float maxSquaredDistanceBetweenColours,
+                                                float maxSquaredDistanceBetweenVoxels)
+{
+  // If the neighbour is outside the raycast result, or does not correspond to a voxel in the scene, early out.
+  if(neighbourX < 0 || neighbourX >= width || neighbourY < 0 || neighbourY >= height) return false;
+
+  int neighbourIndex = neighbourY * width + neighbourX;
+  if(!valid[neighbourIndex] || labels[neighbourIndex].label != label) return false;
+
+  // Compute the squared distance between the neighbour's position and the position of the point of interest.
+  Vector3f posOffset = positions[neighbourIndex] - loc;
+  float squaredDistanceBetweenVoxels = dot(posOffset, posOffset);
+  if(squaredDistanceBetweenVoxels > maxSquaredDistanceBetweenVoxels) return false;
+  float distanceBetweenVoxels = sqrt(squaredDistanceBetweenVoxels);
+
+  // Compute the distance between the neighbour's colour and the colour of the point of interest.
+  Vector3f colourOffset = labColours[neighbourIndex] - labColour;
+  float squaredDistanceBetweenColours = dot(colourOffset, colourOffset);
+  if(squaredDistanceBetweenColours > maxSquaredDistanceBetweenColours * distanceBetweenVoxels) return false;
+
+  // Compute the angle between the neighbour's normal and the normal of the point of interest.
+  const Vector3f& neighbourNormal = normals[neighbourIndex];
+  float angleBetweenNormals = acosf(dot(normal, neighbourNormal) / (length(normal) * length(neighbourNormal)));
+  return angleBetweenNormals <= maxAngleBetweenNormals * distanceBetweenVoxels;
+}
+
+/**
+ * \brief Performs a single propagation step for the specified surface point, based on its own properties and those of its neighbours.
+ *
+ * The labels of the surface points are double-buffered: the neighbours' labels are read from the input labels, and the new label
+ * of the point of interest is written into the output labels. This makes the step independent of the order in which points are processed.
+ *
+ * \param pointIndex                        The index of the surface point (i.e. of the corresponding pixel in the raycast result).
+ * \param width                             The width of the raycast result.
+ * \param height                            The height of the raycast result.
+ * \param label                             The label being propagated.
+ * \param positions                         The positions of the surface points.
+ * \param normals                           The surface normals of the surface points.
+ * \param labColours                        The CIELab colours of the surface points.
+ * \param inputLabels                       The labels of the surface points before the step.
+ * \param valid                             Flags indicating which of the surface points correspond to voxels in the scene.
+ * \param maxAngleBetweenNormals            The largest angle allowed between the normals of neighbouring points if propagation is to occur.
+ * \param maxSquaredDistanceBetweenColours  The maximum squared distance allowed between the colours of neighbouring points if propagation is to occur.
+ * \param maxSquaredDistanceBetweenVoxels   The maximum squared distance allowed between the positions of neighbouring points if propagation is to occur.
+ * \param outputLabels                      The labels of the surface points after the step.
+ */
+_CPU_AND_GPU_CODE_
+inline void propagate_between_surface_points(int pointIndex, int width, int height, SpaintVoxel::Label label,
+                                             const Vector3f *positions, const Vector3f *normals, const Vector3f *labColours,
+                                             const SpaintVoxel::PackedLabel *inputLabels, const unsigned char *valid,
+                                             float maxAngleBetweenNormals, float maxSquaredDistanceBetweenColours,
+                                             float maxSquaredDistanceBetweenVoxels, SpaintVoxel::PackedLabel *outputLabels)
+{
+  const SpaintVoxel::PackedLabel oldLabel = inputLabels[pointIndex];
+  outputLabels[pointIndex] = oldLabel;
+
+  // If the point does not correspond to a voxel, already has the label being propagated, or has a label that propagation is not
+  // allowed to overwrite, early out.
+  const SpaintVoxel::PackedLabel newLabel(label, SpaintVoxel::LG_PROPAGATED);
+  if(!valid[pointIndex] || oldLabel.label == label || !can_overwrite_label(oldLabel, newLabel)) return;
+
+  const Vector3f& loc = positions[pointIndex];
+  const Vector3f& normal = normals[pointIndex];
+  const Vector3f& labColour = labColours[pointIndex];
+  int x = pointIndex % width;
+  int y = pointIndex / width;
+
+#define SPFSP(nx,ny) should_propagate_from_surface_point( \
+  nx, ny, width, height, label, loc, normal, labColour, \
+  positions, normals, labColours, inputLabels, valid, \
+  maxAngleBetweenNormals, maxSquaredDistanceBetweenColours, \
+  maxSquaredDistanceBetweenVoxels)
+
+  if((SPFSP(x - 2, y) && SPFSP(x - 5, y)) ||
+     (SPFSP(x + 2, y) && SPFSP(x + 5, y)) ||
+     (SPFSP(x, y - 2) && SPFSP(x, y - 5)) ||
+     (SPFSP(x, y + 2) && SPFSP(x, y + 5)))
+  {
+    outputLabels[pointIndex] = newLabel;
+  }
+
+#undef SPFSP
+}
+
 /**
  * \brief Calculates the normal of the specified voxel in the raycast result and writes it into the surface normals array.
  *
@@ -152,6 +265,47 @@ inline void write_surface_normal(int voxelIndex, const Vector4f *raycastResult,
   surfaceNormals[voxelIndex] = n;
 }
 
+/**
+ * \brief Gathers the properties of the voxel corresponding to the specified pixel in the raycast result into a per-frame surface point cloud.
+ *
+ * Gathering the properties once per frame means that the propagation steps do not need to look up voxels in the scene.
+ *
+ * \param pointIndex    The index of the pixel in the raycast result.
+ * \param raycastResult The raycast result.
+ * \param voxelData     The scene's voxel data.
+ * \param indexData     The scene's index data.
+ * \param positions     The array into which to write the position of the surface point.
+ * \param normals       The array into which to write the surface normal of the surface point.
+ * \param labColours    The array into which to write the CIELab colour of the surface point.
+ * \param labels        The array into which to write the label of the surface point.
+ * \param valid         The array into which to write whether or not the surface point corresponds to a voxel in the scene.
+ */
+_CPU_AND_GPU_CODE_
+inline void write_surface_point(int pointIndex, const Vector4f *raycastResult, const SpaintVoxel *voxelData, const ITMVoxelIndex::IndexData *indexData,
+                                Vector3f *positions, Vector3f *normals, Vector3f *labColours, SpaintVoxel::PackedLabel *labels, unsigned char *valid)
+{
+  Vector4f loc = raycastResult[pointIndex];
+  positions[pointIndex] = loc.toVector3();
+
+  bool foundPoint = false;
+  SpaintVoxel voxel;
+  if(loc.w > 0) voxel = readVoxel(voxelData, indexData, loc.toVector3().toIntRound(), foundPoint);
+
+  if(foundPoint)
+  {
+    normals[pointIndex] = computeSingleNormalFromSDF(voxelData, indexData, loc.toVector3());
+    labColours[pointIndex] = itmx::convert_rgb_to_lab(VoxelColourReader<SpaintVoxel::hasColorInformation>::read(voxel).toFloat());
+    labels[pointIndex] = voxel.packedLabel;
+    valid[pointIndex] = 1;
+  }
+  else
+  {
+    normals[pointIndex] = labColours[pointIndex] = Vector3f(0.0f, 0.0f, 0.0f);
+    labels[pointIndex] = SpaintVoxel::PackedLabel();
+    valid[pointIndex] = 0;
+  }
+}
+
 }
 
 #endif
@@ -6,15 +6,51 @@
 #ifndef H_SPAINT_PERLABELVOXELSAMPLER_CPU
 #define H_SPAINT_PERLABELVOXELSAMPLER_CPU
 
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
 #include "../interface/PerLabelVoxelSampler.h"
 
 namespace spaint {
 
 /**
  * \brief An instance of this class can be used to sample voxels for each currently-used label from a scene using the CPU.
+ *
+ * Unlike the CUDA implementation, which stores one byte per pixel per label in its voxel masks, the CPU implementation packs
+ * the voxel masks into 64-bit words (one bit per pixel) and computes the prefix sums of the masks at word granularity (using
+ * bit counts), in parallel over blocks of words. The position of a candidate voxel within its word is resolved when its
+ * location is written into the candidate voxel locations array.
  */
 class PerLabelVoxelSampler_CPU : public PerLabelVoxelSampler
 {
+  //#################### TYPEDEFS ####################
+private:
+  typedef boost::uint64_t MaskWord;
+
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The number of mask words in each block when computing the prefix sums of the voxel masks. */
+  static const int BLOCK_SIZE = 256;
+
+  /** The number of blocks into which the mask words for each label are divided when computing the prefix sums of the voxel masks. */
+  int m_blockCount;
+
+  /** The offsets of the blocks within the prefix sums of the voxel masks for the various labels. */
+  mutable std::vector<unsigned int> m_blockOffsets;
+
+  /** The number of mask words needed to store the voxel mask for each label. */
+  int m_maskWordCount;
+
+  /**
+   * The prefix sums of the voxel masks (at word granularity) for the various labels. The prefix sum for each label has an additional
+   * element at the end that contains the total number of candidate voxels for the label.
+   */
+  mutable std::vector<unsigned int> m_voxelMaskPrefixSums;
+
+  /** The bit-packed voxel masks indicating which voxels may be used as examples of which semantic labels (concatenated into a single 1D array). */
+  mutable std::vector<MaskWord> m_voxelMasks;
+
   //#################### CONSTRUCTORS ####################
 public:
   /**
@@ -43,6 +79,16 @@ private:
 
   /** Override */
   virtual void write_sampled_voxel_locations(const ORUtils::MemoryBlock<bool>& labelMaskMB, ORUtils::MemoryBlock<Vector3s>& sampledVoxelLocationsMB) const;
+
+  //#################### PRIVATE STATIC MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Counts the number of bits that are set in the specified mask word.
+   *
+   * \param word  The mask word.
+   * \return      The number of bits that are set in the mask word.
+   */
+  static unsigned int count_bits(MaskWord word);
 };
 
 }
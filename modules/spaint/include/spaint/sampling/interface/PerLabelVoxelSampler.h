@@ -45,18 +45,6 @@ protected:
   /** A random number generator. */
   boost::shared_ptr<tvgutil::RandomNumberGenerator> m_rng;
 
-  /**
-   * A memory block in which to store the prefix sums for the voxel masks. These are used to determine the locations in the
-   * candidate voxel locations array into which to write candidate voxels.
-   */
-  boost::shared_ptr<ORUtils::MemoryBlock<unsigned int> > m_voxelMaskPrefixSumsMB;
-
-  /**
-   * A memory block in which to store voxel masks indicating which voxels may be used as examples of which semantic labels.
-   * The masks for the different labels are concatenated into a single 1D array.
-   */
-  boost::shared_ptr<ORUtils::MemoryBlock<unsigned char> > m_voxelMasksMB;
-
   //#################### CONSTRUCTORS ####################
 protected:
   /**
@@ -43,6 +43,28 @@ inline void copy_sampled_voxel_locations(int voxelIndex, const bool *labelMask,
   }
 }
 
+/**
+ * \brief Determines the label (if any) for which the specified voxel in the raycast result can serve as a candidate sample.
+ *
+ * \param voxelIndex    The index of the voxel in the raycast result.
+ * \param raycastResult The current raycast result.
+ * \param voxelData     The scene's voxel data.
+ * \param indexData     The scene's index data.
+ * \return              The label for which the voxel can serve as a candidate sample, or -1 if there is no such label.
+ */
+_CPU_AND_GPU_CODE_
+inline int get_candidate_label(int voxelIndex, const Vector4f *raycastResult, const SpaintVoxel *voxelData, const ITMVoxelIndex::IndexData *indexData)
+{
+  Vector3i loc = raycastResult[voxelIndex].toVector3().toIntRound();
+  bool isFound;
+  int voxelAddress = findVoxel(indexData, loc, isFound);
+  if(!isFound) return -1;
+
+  // FIXME: We shouldn't hard-code which labels we're training from here.
+  const SpaintVoxel::PackedLabel& packedLabel = voxelData[voxelAddress].packedLabel;
+  return packedLabel.group != SpaintVoxel::LG_FOREST ? static_cast<int>(packedLabel.label) : -1;
+}
+
 /**
  * \brief Updates the voxel masks for the various labels based on the contents of the specified voxel (if it exists).
  *
@@ -60,17 +82,12 @@ inline void update_masks_for_voxel(int voxelIndex, const Vector4f *raycastResult
                                    size_t maxLabelCount, unsigned char *voxelMasks)
 {
   // Note: We do not need to explicitly use the label mask in this function, since no voxel will ever be marked with an unused label.
-
-  Vector3i loc = raycastResult[voxelIndex].toVector3().toIntRound();
-  bool isFound;
-  int voxelAddress = findVoxel(indexData, loc, isFound);
-  const SpaintVoxel *voxel = isFound ? &voxelData[voxelAddress] : NULL;
+  const int candidateLabel = get_candidate_label(voxelIndex, raycastResult, voxelData, indexData);
 
   // Update the voxel masks for the various labels (even the ones that are not currently active).
   for(size_t k = 0; k < maxLabelCount; ++k)
   {
-    // FIXME: We shouldn't hard-code which labels we're training from here.
-    voxelMasks[k * (raycastResultSize + 1) + voxelIndex] = voxel && voxel->packedLabel.label == k && voxel->packedLabel.group != SpaintVoxel::LG_FOREST ? 1 : 0;
+    voxelMasks[k * (raycastResultSize + 1) + voxelIndex] = candidateLabel == static_cast<int>(k) ? 1 : 0;
   }
 }
 
@@ -6,6 +6,9 @@
 #ifndef H_SPAINT_BACKGROUNDSUBTRACTINGOBJECTSEGMENTER
 #define H_SPAINT_BACKGROUNDSUBTRACTINGOBJECTSEGMENTER
 
+#include <utility>
+#include <vector>
+
 #include <opencv2/core/core.hpp>
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
@@ -19,17 +22,125 @@ namespace spaint {
 /**
  * \brief An instance of this class can be used to segment an object that is placed in front of a static scene
  *        using background subtraction.
+ *
+ * All of the state used during segmentation (including the intermediate images) is owned by the segmenter itself
+ * and allocated up-front, so separate segmenters can safely be used in parallel (e.g. one per tracked object), provided
+ * that the debugging windows (which are shared between segmenters and not thread-safe) are disabled.
  */
 class BackgroundSubtractingObjectSegmenter : public Segmenter
 {
+  //#################### NESTED TYPES ####################
+private:
+  /**
+   * \brief An instance of this struct holds the buffers that are reused each time the segmenter is run.
+   */
+  struct Workspace
+  {
+    /** A mask containing the contours in the change mask that should be removed from it. */
+    cv::Mat1b badContourMask;
+
+    /** The camera from whose pose the scene is being viewed. */
+    boost::shared_ptr<rigging::SimpleCamera> camera;
+
+    /** A mask containing any changes in the scene with respect to the reconstructed model. */
+    ITMUCharImage_Ptr changeMask;
+
+    /** The centroids of the connected components of the mask currently being processed. */
+    cv::Mat1d componentCentroids;
+
+    /** The connected component to which each pixel in the mask currently being processed belongs. */
+    cv::Mat1i components;
+
+    /** The statistics of the connected components of the mask currently being processed. */
+    cv::Mat1i componentStats;
+
+    /** A copy of the change mask that can be modified during contour finding. */
+    cv::Mat1b contourImage;
+
+    /** The contours in the change mask. */
+    std::vector<std::vector<cv::Point> > contours;
+
+    /** An OpenCV view of the change mask (this shares its data with the InfiniTAM image). */
+    cv::Mat1b cvChangeMask;
+
+    /** A greyscale version of the depth raycast of the scene. */
+    cv::Mat1b depthRaycast;
+
+    /** The pixels in the change mask, together with their live depth values, sorted by depth. */
+    std::vector<std::pair<float,int> > depthSortedPixels;
+
+    /** A dilated version of the edges in the depth raycast. */
+    cv::Mat dilatedDepthEdges;
+
+    /** The kernel with which to dilate the edges in the depth raycast. */
+    cv::Mat dilationKernel;
+
+    /** The intermediate images used when finding edges in the depth raycast. */
+    cv::Mat gradX, gradY, absGradX, absGradY, grad, depthEdges;
+
+    /** A mask denoting the location of the user's hand. */
+    cv::Mat1b handMask;
+
+    /** An OpenCV view of the object mask (this shares its data with the target mask). */
+    cv::Mat1b objectMask;
+  };
+
   //#################### PRIVATE VARIABLES ####################
 private:
+  /** Pixels greater than this percentage distance from the centre of the image will be ignored by the change mask. */
+  int m_centreDistThreshold;
+
+  /** Pixels with values above this will be treated as edges in the gradient magnitude image of the depth raycast. */
+  int m_depthEdgeThreshold;
+
+  /** Hand components below this size will be removed from the hand mask (if small hand components are being removed). */
+  int m_handComponentSizeThreshold;
+
   /** The colour appearance model to use to separate the user's hand from any object it's holding. */
   ColourAppearanceModel_Ptr m_handAppearanceModel;
 
+  /** Small components in the change mask whose compactness is less than this percentage will be ignored. */
+  int m_lowerCompactnessThreshold;
+
+  /** Pixels whose depth difference (in mm) is less than this will be ignored by the change mask. */
+  int m_lowerDiffThresholdMm;
+
+  /** Pixels near depth edges whose depth difference (in mm) is less than this will be ignored by the change mask. */
+  int m_lowerDiffThresholdNearEdgesMm;
+
+  /** Contours in the change mask that are at most this size will be subjected to a box test. */
+  int m_maxContourSizeForBox;
+
+  /** Contours in the change mask that are at most this size will be subjected to a compactness test. */
+  int m_maxContourSizeForCompactness;
+
+  /** The maximum difference in depth to allow between pixels within the same cluster. */
+  int m_maxIntraClusterDepthDiffMm;
+
+  /** Clusters of pixels (by depth) that are less than this size will be removed from the change mask. */
+  int m_minClusterSize;
+
+  /** Components in the change mask below this size will be ignored. */
+  int m_minComponentSize;
+
+  /** Object components below this size will be removed from the object mask. */
+  int m_objectComponentSizeThreshold;
+
+  /** The minimum percentage probability of a changed pixel being part of the object (rather than the hand) for it to be added to the object mask. */
+  int m_objectProbThreshold;
+
+  /** Whether or not to remove small components from the hand mask (0 = no, 1 = yes). */
+  int m_removeSmallHandComponents;
+
   /** The touch detector to use to make the change and hand masks. */
   mutable TouchDetector_Ptr m_touchDetector;
 
+  /** Pixels whose live depth value (in mm) is greater than this will be ignored by the change mask. */
+  int m_upperDepthThresholdMm;
+
+  /** The buffers that are reused each time the segmenter is run. */
+  mutable Workspace m_workspace;
+
   //#################### CONSTRUCTORS ####################
 public:
   /**
@@ -72,15 +183,23 @@ private:
    */
   ITMUCharImage_CPtr make_hand_mask(const ITMFloatImage_CPtr& depthInput, const ORUtils::SE3Pose& pose, const RenderState_CPtr& renderState) const;
 
-  //#################### PRIVATE STATIC MEMBER FUNCTIONS ####################
-private:
   /**
    * \brief Updates a mask to retain only connected components over a certain size.
    *
    * \param mask                  The mask to update.
    * \param minimumComponentSize  The minimum size of component to retain.
+   * \param complementMask        An optional mask to which any pixels removed from the first mask should be added.
+   */
+  void remove_small_components(cv::Mat1b& mask, int minimumComponentSize, cv::Mat1b *complementMask = NULL) const;
+
+  /**
+   * \brief Runs the touch detector on the live depth input.
+   *
+   * \param depthInput  The live depth input from the camera.
+   * \param pose        The camera pose from which the scene is being viewed.
+   * \param renderState The render state corresponding to the camera.
    */
-  static void remove_small_components(cv::Mat1b& mask, int minimumComponentSize);
+  void run_touch_detector(const ITMFloatImage_CPtr& depthInput, const ORUtils::SE3Pose& pose, const RenderState_CPtr& renderState) const;
 };
 
 }
@@ -6,23 +6,22 @@
 #ifndef H_SPAINT_COLOURAPPEARANCEMODEL
 #define H_SPAINT_COLOURAPPEARANCEMODEL
 
-#include <itmx/base/ITMImagePtrTypes.h>
+#include <vector>
 
-#include <tvgutil/statistics/ProbabilityMassFunction.h>
+#include <itmx/base/ITMImagePtrTypes.h>
 
 namespace spaint {
 
 /**
  * \brief An instance of this class can be used to represent a pixel-wise colour appearance model for an object.
  *
- * We base our model on a chroma-based 2D histogram over colours in the YCbCr colour space.
+ * We base our model on a chroma-based 2D histogram over colours in the YCbCr colour space. The histograms are stored as dense
+ * arrays of bins, and the posterior probability for each bin is precomputed whenever the model is trained, so that evaluating
+ * the model for a pixel just requires a table lookup. Since the RGB -> YCbCr conversion is linear, the bin coordinates are
+ * computed by summing per-channel contributions that are looked up in small tables.
  */
 class ColourAppearanceModel
 {
-  //#################### TYPEDEFS ####################
-private:
-  typedef boost::shared_ptr<tvgutil::ProbabilityMassFunction<int> > PMF_Ptr;
-
   //#################### PRIVATE VARIABLES ####################
 private:
   /** The number of Cb bins in the histogram. */
@@ -31,17 +30,26 @@ private:
   /** The number of Cr bins in the histogram. */
   int m_binsCr;
 
+  /** The contributions of the R, G and B channels (in that order, 256 values each) to the (fractional) Cb coordinate of a colour's bin. */
+  std::vector<float> m_cbLookup;
+
+  /** The number of pixels that have been added to the P(Colour | object) histogram. */
+  size_t m_countColourGivenObject;
+
+  /** The number of pixels that have been added to the P(Colour | !object) histogram. */
+  size_t m_countColourGivenNotObject;
+
+  /** The contributions of the R, G and B channels (in that order, 256 values each) to the (fractional) Cr coordinate of a colour's bin. */
+  std::vector<float> m_crLookup;
+
   // A (linearised) 2D histogram representing P(Colour | object).
-  tvgutil::Histogram<int> m_histColourGivenObject;
+  std::vector<size_t> m_histColourGivenObject;
 
   // A (linearised) 2D histogram representing P(Colour | !object).
-  tvgutil::Histogram<int> m_histColourGivenNotObject;
-
-  // A (linearised) 2D probability mass function representing P(Colour | object).
-  PMF_Ptr m_pmfColourGivenObject;
+  std::vector<size_t> m_histColourGivenNotObject;
 
-  // A (linearised) 2D probability mass function representing P(Colour | !object).
-  PMF_Ptr m_pmfColourGivenNotObject;
+  // A (linearised) 2D table containing P(object | Colour) for each bin (empty until there is enough training data to compute it).
+  std::vector<float> m_posteriors;
 
   //#################### CONSTRUCTORS ####################
 public:
@@ -80,6 +88,11 @@ private:
    * \return          The 2D histogram bin index for the colour.
    */
   int compute_bin(const Vector3u& rgbColour) const;
+
+  /**
+   * \brief Recomputes the posterior probability table from the histograms.
+   */
+  void update_posteriors();
 };
 
 //#################### TYPEDEFS ####################
@@ -6,15 +6,49 @@
 #ifndef H_SPAINT_VOXELTOCUBESELECTIONTRANSFORMER_CPU
 #define H_SPAINT_VOXELTOCUBESELECTIONTRANSFORMER_CPU
 
+#include <vector>
+
 #include "../interface/VoxelToCubeSelectionTransformer.h"
 
 namespace spaint {
 
 /**
  * \brief An instance of this class can be used to expand a selection of individual voxels into a selection of voxel cubes around the initial voxels using the CPU.
+ *
+ * Rather than writing out a full cube for each initial voxel (which produces a huge number of duplicate voxels when the
+ * cubes overlap), the transformer first accumulates the union of the cubes into a sparse set of voxel blocks, each of
+ * which has a bitmask indicating which of its voxels are selected. It then writes out each selected voxel exactly once,
+ * block by block. The bitmasks are built one row of voxels at a time, so the cost per initial voxel grows quadratically
+ * rather than cubically with the radius.
  */
 class VoxelToCubeSelectionTransformer_CPU : public VoxelToCubeSelectionTransformer
 {
+  //#################### NESTED TYPES ####################
+private:
+  /**
+   * \brief An instance of this struct records which voxels in a voxel block are selected.
+   */
+  struct BlockMask
+  {
+    /** The position of the voxel block (in blocks). */
+    Vector3i blockPos;
+
+    /** The voxel rows in the block (indexed by y + z * SDF_BLOCK_SIZE), each with one bit per voxel (indexed by x). */
+    unsigned char rows[SDF_BLOCK_SIZE * SDF_BLOCK_SIZE];
+  };
+
+  /**
+   * \brief An instance of this struct represents the union of the cubes around the voxels in an input selection.
+   */
+  struct BlockMasks
+  {
+    /** The masks for the voxel blocks that contain at least one selected voxel. */
+    std::vector<BlockMask> masks;
+
+    /** The number of selected voxels in each of the block masks. */
+    std::vector<int> voxelCounts;
+  };
+
   //#################### CONSTRUCTORS ####################
 public:
   /**
@@ -26,8 +60,58 @@ public:
 
   //#################### PUBLIC MEMBER FUNCTIONS ####################
 public:
+  /**
+   * \brief Computes the size of the output selection of voxels corresponding to the specified input selection.
+   *
+   * Since overlapping cubes are merged, this is the number of distinct voxels in the union of the cubes, and can be
+   * much smaller than the number of initial voxels multiplied by the cube size.
+   *
+   * \param inputSelectionMB  A memory block containing the input selection of voxels.
+   * \return                  The size of the output selection of voxels corresponding to the specified input selection.
+   */
+  virtual size_t compute_output_selection_size(const Selection& inputSelectionMB) const;
+
   /** Override */
   virtual void transform_selection(const Selection& inputSelectionMB, Selection& outputSelectionMB) const;
+
+  /**
+   * \brief Transforms one selection of voxels in the scene into another.
+   *
+   * This builds the block masks for the input selection only once, and uses them both to size the output selection
+   * and to fill it in (the base class implementation would build them twice).
+   *
+   * \param inputSelectionMB  A memory block containing the input selection of voxels.
+   * \return                  A pointer to a memory block containing the output selection of voxels.
+   */
+  virtual Selection *transform_selection(const Selection& inputSelectionMB) const;
+
+  //#################### PRIVATE MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Builds the block masks for the union of the cubes around the voxels in the specified input selection.
+   *
+   * \param inputSelectionMB  A memory block containing the input selection of voxels.
+   * \param blockMasks        The block masks into which to write the union of the cubes.
+   */
+  void build_block_masks(const Selection& inputSelectionMB, BlockMasks& blockMasks) const;
+
+  //#################### PRIVATE STATIC MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Counts the selected voxels in a set of block masks.
+   *
+   * \param blockMasks  The block masks.
+   * \return            The number of selected voxels in the block masks.
+   */
+  static size_t count_selected_voxels(const BlockMasks& blockMasks);
+
+  /**
+   * \brief Writes the selected voxels in a set of block masks to an output selection.
+   *
+   * \param blockMasks        The block masks.
+   * \param outputSelectionMB A memory block into which to store the output selection of voxels.
+   */
+  static void write_selected_voxels(const BlockMasks& blockMasks, Selection& outputSelectionMB);
 };
 
 }
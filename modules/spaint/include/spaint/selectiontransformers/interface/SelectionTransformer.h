@@ -93,7 +93,7 @@ public:
    * \param inputSelectionMB  A memory block containing the input selection of voxels.
    * \return                  A pointer to a memory block containing the output selection of voxels.
    */
-  Selection *transform_selection(const Selection& inputSelectionMB) const;
+  virtual Selection *transform_selection(const Selection& inputSelectionMB) const;
 };
 
 //#################### TYPEDEFS ####################
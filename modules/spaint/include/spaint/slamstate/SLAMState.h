@@ -8,6 +8,9 @@
 
 #include <map>
 
+#include <boost/cstdint.hpp>
+#include <boost/unordered_map.hpp>
+
 #include <itmx/base/ITMImagePtrTypes.h>
 #include <itmx/base/ITMObjectPtrTypes.h>
 
@@ -24,6 +27,9 @@ class SLAMState
 {
   //#################### PRIVATE VARIABLES ####################
 private:
+  /** The number of times each voxel block has been fused into since the scene last changed as a whole, indexed by block key. */
+  boost::unordered_map<boost::uint64_t,size_t> m_blockFusionCounts;
+
   /** The fiducials (if any) that have been detected in the 3D scene. */
   std::map<std::string,Fiducial_Ptr> m_fiducials;
 
@@ -42,6 +48,9 @@ private:
   /** The voxel render state corresponding to the live camera pose. */
   VoxelRenderState_Ptr m_liveVoxelRenderState;
 
+  /** A counter that is incremented whenever the reconstructed scene changes as a whole (e.g. when it is reset or loaded), and which can be used to invalidate data derived from the scene. */
+  size_t m_sceneChangeCount;
+
   /** The current reconstructed surfel scene. */
   SpaintSurfelScene_Ptr m_surfelScene;
 
@@ -54,8 +63,25 @@ private:
   /** The current reconstructed voxel scene. */
   SpaintVoxelScene_Ptr m_voxelScene;
 
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs a SLAM state.
+   */
+  SLAMState();
+
   //#################### PUBLIC MEMBER FUNCTIONS ####################
 public:
+  /**
+   * \brief Gets the number of times the voxel block containing the specified voxel has been fused into since the scene last changed as a whole.
+   *
+   * Data derived from the voxel (e.g. its feature descriptor) that were computed when the count had its current value are still up-to-date.
+   *
+   * \param voxelLocation  The location of the voxel.
+   * \return               The number of times the voxel block containing the voxel has been fused into since the scene last changed as a whole.
+   */
+  size_t get_block_fusion_count(const Vector3s& voxelLocation) const;
+
   /**
    * \brief Gets the dimensions of the depth images from which the scene is being reconstructed.
    *
@@ -140,6 +166,16 @@ public:
    */
   const Vector2i& get_rgb_image_size() const;
 
+  /**
+   * \brief Gets the current value of the scene change counter.
+   *
+   * Data derived from the scene (e.g. voxel feature descriptors) that were computed when the counter had its current value are still up-to-date,
+   * provided that the voxel blocks from which they were derived have not since been fused into (see get_block_fusion_count).
+   *
+   * \return  The current value of the scene change counter.
+   */
+  size_t get_scene_change_count() const;
+
   /**
    * \brief Gets the surfel scene.
    *
@@ -196,6 +232,19 @@ public:
    */
   SpaintVoxelScene_CPtr get_voxel_scene() const;
 
+  /**
+   * \brief Notes that a frame has been fused into the specified voxel blocks, by incrementing their fusion counts.
+   *
+   * \param blockPositionsMB  A memory block containing the positions (in blocks) of the voxel blocks (on the CPU).
+   */
+  void note_blocks_fused(const ORUtils::MemoryBlock<Vector3s>& blockPositionsMB);
+
+  /**
+   * \brief Notes that the reconstructed scene has changed as a whole (e.g. because it has been reset or loaded),
+   *        by incrementing the scene change counter and clearing the fusion counts of the voxel blocks.
+   */
+  void note_scene_changed();
+
   /**
    * \brief Sets the mask to apply to the input images during tracking.
    *
@@ -273,6 +322,16 @@ public:
    * \param measurements  The set of measurements with which to update the fiducials.
    */
   void update_fiducials(const std::map<std::string,FiducialMeasurement>& measurements);
+
+  //#################### PRIVATE STATIC MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Makes the key used to index the fusion count for a voxel block.
+   *
+   * \param blockPos The position of the voxel block (in blocks).
+   * \return         The key.
+   */
+  static boost::uint64_t make_block_key(const Vector3s& blockPos);
 };
 
 //#################### TYPEDEFS ####################
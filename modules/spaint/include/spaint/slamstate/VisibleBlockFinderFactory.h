@@ -0,0 +1,33 @@
+/**
+ * spaint: VisibleBlockFinderFactory.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2017. All rights reserved.
+ */
+
+#ifndef H_SPAINT_VISIBLEBLOCKFINDERFACTORY
+#define H_SPAINT_VISIBLEBLOCKFINDERFACTORY
+
+#include <ORUtils/DeviceType.h>
+
+#include "interface/VisibleBlockFinder.h"
+
+namespace spaint {
+
+/**
+ * \brief This struct can be used to construct visible block finders.
+ */
+struct VisibleBlockFinderFactory
+{
+  //#################### PUBLIC STATIC MEMBER FUNCTIONS ####################
+
+  /**
+   * \brief Makes a visible block finder.
+   *
+   * \param deviceType  The device on which the visible block finder should operate.
+   * \return            The visible block finder.
+   */
+  static VisibleBlockFinder_CPtr make_visible_block_finder(DeviceType deviceType);
+};
+
+}
+
+#endif
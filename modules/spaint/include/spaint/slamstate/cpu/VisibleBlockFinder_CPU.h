@@ -0,0 +1,26 @@
+/**
+ * spaint: VisibleBlockFinder_CPU.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2017. All rights reserved.
+ */
+
+#ifndef H_SPAINT_VISIBLEBLOCKFINDER_CPU
+#define H_SPAINT_VISIBLEBLOCKFINDER_CPU
+
+#include "../interface/VisibleBlockFinder.h"
+
+namespace spaint {
+
+/**
+ * \brief An instance of this class can be used to find the positions of the voxel blocks that are visible in a render state using the CPU.
+ */
+class VisibleBlockFinder_CPU : public VisibleBlockFinder
+{
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /** Override */
+  virtual void find_visible_blocks(const SpaintVoxelScene *scene, const ITMLib::ITMRenderState_VH *renderState, ORUtils::MemoryBlock<Vector3s>& blockPositionsMB) const;
+};
+
+}
+
+#endif
@@ -0,0 +1,26 @@
+/**
+ * spaint: VisibleBlockFinder_CUDA.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2017. All rights reserved.
+ */
+
+#ifndef H_SPAINT_VISIBLEBLOCKFINDER_CUDA
+#define H_SPAINT_VISIBLEBLOCKFINDER_CUDA
+
+#include "../interface/VisibleBlockFinder.h"
+
+namespace spaint {
+
+/**
+ * \brief An instance of this class can be used to find the positions of the voxel blocks that are visible in a render state using CUDA.
+ */
+class VisibleBlockFinder_CUDA : public VisibleBlockFinder
+{
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /** Override */
+  virtual void find_visible_blocks(const SpaintVoxelScene *scene, const ITMLib::ITMRenderState_VH *renderState, ORUtils::MemoryBlock<Vector3s>& blockPositionsMB) const;
+};
+
+}
+
+#endif
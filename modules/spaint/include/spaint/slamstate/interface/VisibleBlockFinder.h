@@ -0,0 +1,48 @@
+/**
+ * spaint: VisibleBlockFinder.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2017. All rights reserved.
+ */
+
+#ifndef H_SPAINT_VISIBLEBLOCKFINDER
+#define H_SPAINT_VISIBLEBLOCKFINDER
+
+#include <ITMLib/Objects/RenderStates/ITMRenderState_VH.h>
+
+#include "../../util/SpaintVoxelScene.h"
+
+namespace spaint {
+
+/**
+ * \brief An instance of a class deriving from this one can be used to find the positions of the voxel blocks that are visible in a render state.
+ *
+ * After a frame has been fused into the scene, the visible voxel blocks are the ones whose contents may have been changed by the fusion.
+ */
+class VisibleBlockFinder
+{
+  //#################### DESTRUCTOR ####################
+public:
+  /**
+   * \brief Destroys the visible block finder.
+   */
+  virtual ~VisibleBlockFinder() {}
+
+  //#################### PUBLIC ABSTRACT MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Finds the positions of the voxel blocks that are visible in the specified render state.
+   *
+   * \param scene             The scene.
+   * \param renderState       The render state.
+   * \param blockPositionsMB  A memory block into which to write the positions (in blocks) of the visible voxel blocks. This must be able to hold
+   *                          SDF_LOCAL_BLOCK_NUM positions, and its data size will be set to the number of visible voxel blocks.
+   */
+  virtual void find_visible_blocks(const SpaintVoxelScene *scene, const ITMLib::ITMRenderState_VH *renderState, ORUtils::MemoryBlock<Vector3s>& blockPositionsMB) const = 0;
+};
+
+//#################### TYPEDEFS ####################
+
+typedef boost::shared_ptr<const VisibleBlockFinder> VisibleBlockFinder_CPtr;
+
+}
+
+#endif
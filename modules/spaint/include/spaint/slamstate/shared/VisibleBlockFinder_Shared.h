@@ -0,0 +1,29 @@
+/**
+ * spaint: VisibleBlockFinder_Shared.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2017. All rights reserved.
+ */
+
+#ifndef H_SPAINT_VISIBLEBLOCKFINDER_SHARED
+#define H_SPAINT_VISIBLEBLOCKFINDER_SHARED
+
+#include "../../util/SpaintVoxelScene.h"
+
+namespace spaint {
+
+/**
+ * \brief Writes the position of a visible voxel block into an array of block positions.
+ *
+ * \param i               The index of the visible voxel block in the list of visible entries.
+ * \param visibleEntryIDs The IDs of the hash entries for the visible voxel blocks.
+ * \param hashTable       The hash table for the scene.
+ * \param blockPositions  The array of block positions.
+ */
+_CPU_AND_GPU_CODE_
+inline void write_visible_block_position(int i, const int *visibleEntryIDs, const ITMVoxelIndex::IndexData *hashTable, Vector3s *blockPositions)
+{
+  blockPositions[i] = hashTable[visibleEntryIDs[i]].pos;
+}
+
+}
+
+#endif
@@ -11,7 +11,7 @@
 #include <itmx/base/ITMObjectPtrTypes.h>
 #include <itmx/visualisation/interface/DepthVisualiser.h>
 
-#include <rafl/core/RandomForest.h>
+#include <rafl/core/FlatRandomForest.h>
 
 #include <rigging/SimpleCamera.h>
 
@@ -31,8 +31,8 @@ class TouchDetector
 private:
   typedef boost::shared_ptr<af::array> AFArray_Ptr;
   typedef int Label;
-  typedef rafl::RandomForest<Label> RF;
-  typedef boost::shared_ptr<RF> RF_Ptr;
+  typedef rafl::FlatRandomForest<Label> FRF;
+  typedef boost::shared_ptr<const FRF> FRF_CPtr;
 
   //#################### PRIVATE DEBUGGING VARIABLES ####################
 private:
@@ -60,7 +60,7 @@ private:
   AFArray_Ptr m_diffRawRaycast;
 
   /** The random forest used to score the candidate connected components. */
-  RF_Ptr m_forest;
+  FRF_CPtr m_forest;
 
   /** The height of the images on which the touch detector is running. */
   int m_imageHeight;
@@ -7,7 +7,7 @@
 
 #include <boost/filesystem.hpp>
 
-#include <rafl/core/RandomForest.h>
+#include <rafl/core/FlatRandomForest.h>
 
 namespace spaint {
 
@@ -19,6 +19,8 @@ class TouchSettings
   //#################### TYPEDEFS ####################
 private:
   typedef int Label;
+  typedef rafl::FlatRandomForest<Label> FRF;
+  typedef boost::shared_ptr<const FRF> FRF_CPtr;
   typedef rafl::RandomForest<Label> RF;
   typedef boost::shared_ptr<RF> RF_Ptr;
 
@@ -74,10 +76,12 @@ public:
    * \brief Loads a random forest from the file specified by the forest path.
    *
    * The loading is done in TouchSettings rather than TouchDetector to work around a weird compiler bug.
+   * The file can either contain a flat forest, which is loaded directly, or an ordinary forest saved as
+   * a text archive, which is loaded and then flattened.
    *
    * \return  The random forest that has been loaded.
    */
-  RF_Ptr load_forest() const;
+  FRF_CPtr load_forest() const;
 
   /**
    * \brief Gets whether or not to save images of the candidate connected components.
@@ -6,6 +6,8 @@
 #ifndef H_SPAINT_VISUALISATIONGENERATOR
 #define H_SPAINT_VISUALISATIONGENERATOR
 
+#include <vector>
+
 #include <boost/function.hpp>
 #include <boost/optional.hpp>
 
@@ -53,6 +55,29 @@ public:
     VT_SCENE_SEMANTICPHONG
   };
 
+  //#################### NESTED TYPES ####################
+private:
+  /**
+   * \brief An instance of this struct records a voxel raycast that can be shared between visualisations of a scene from the same viewpoint.
+   */
+  struct SharedRaycast
+  {
+    /** The size of the raycast image. */
+    Vector2i imageSize;
+
+    /** The camera pose matrix from which the scene was raycast. */
+    Matrix4f poseMatrix;
+
+    /** The projection parameters of the camera intrinsics with which the scene was raycast. */
+    Vector4f projectionParams;
+
+    /** The render state containing the raycast result. */
+    VoxelRenderState_Ptr renderState;
+
+    /** The scene that was raycast. */
+    const SpaintVoxelScene *scene;
+  };
+
   //#################### PRIVATE VARIABLES ####################
 private:
   /** The depth visualiser. */
@@ -67,6 +92,12 @@ private:
   /** The settings to use for InfiniTAM. */
   Settings_CPtr m_settings;
 
+  /** The voxel raycasts that have been performed since raycast sharing was last enabled. */
+  mutable std::vector<SharedRaycast> m_sharedRaycasts;
+
+  /** Whether or not voxel raycasts are currently being shared between visualisations. */
+  mutable bool m_sharingRaycasts;
+
   /** The InfiniTAM engine to use for rendering a surfel scene. */
   SurfelVisualisationEngine_CPtr m_surfelVisualisationEngine;
 
@@ -89,6 +120,21 @@ public:
 
   //#################### PUBLIC MEMBER FUNCTIONS ####################
 public:
+  /**
+   * \brief Starts sharing voxel raycasts between the visualisations that are generated (e.g. for the sub-windows of a single frame).
+   *
+   * Whilst raycast sharing is enabled, generate_voxel_visualisation only raycasts a scene once for each distinct combination
+   * of pose, intrinsics and image size: any further visualisations of the scene from the same viewpoint reuse the existing
+   * raycast, and only perform the shading pass. Since the shared raycasts become invalid as soon as the scene changes,
+   * sharing should only be enabled for the duration of a single frame (see end_raycast_sharing).
+   */
+  void begin_raycast_sharing() const;
+
+  /**
+   * \brief Stops sharing voxel raycasts between the visualisations that are generated, and discards any raycasts that have been recorded.
+   */
+  void end_raycast_sharing() const;
+
   /**
    * \brief Generates a synthetic depth image of a voxel scene from the specified pose.
    *
@@ -169,9 +215,26 @@ public:
 
   //#################### PRIVATE MEMBER FUNCTIONS ####################
 private:
+  /**
+   * \brief Makes sure that the specified render state contains a raycast of a voxel scene from the specified pose.
+   *
+   * If raycast sharing is enabled and the scene has already been raycast from the same viewpoint, the existing raycast
+   * result is copied into the render state; otherwise, a new raycast is performed (and recorded if sharing is enabled).
+   *
+   * \param scene       The scene to raycast.
+   * \param pose        The pose from which to raycast the scene.
+   * \param intrinsics  The camera intrinsics to use when raycasting the scene.
+   * \param renderState The render state into which to put the raycast result.
+   */
+  void ensure_voxel_raycast(const SpaintVoxelScene_CPtr& scene, const ORUtils::SE3Pose& pose, const ITMLib::ITMIntrinsics& intrinsics,
+                            const VoxelRenderState_Ptr& renderState) const;
+
   /**
    * \brief Makes a copy of an input raycast, optionally post-processes it and then ensures that it is accessible on the CPU.
    *
+   * If the post-processor is a NativeMedianFilterer, the copy and the filtering are fused into a single pass that
+   * filters the CPU copy of the input raycast directly into the output raycast.
+   *
    * \param inputRaycast  The input raycast.
    * \param postprocessor An optional function with which to postprocess the output raycast.
    * \param outputRaycast The output raycast (guaranteed to be accessible on the CPU).
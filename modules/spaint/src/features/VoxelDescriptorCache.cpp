@@ -0,0 +1,89 @@
+/**
+ * spaint: VoxelDescriptorCache.cpp
+ * Copyright (c) Torr Vision Group, University of Oxford, 2017. All rights reserved.
+ */
+
+#include "features/VoxelDescriptorCache.h"
+
+namespace spaint {
+
+//#################### CONSTRUCTORS ####################
+
+VoxelDescriptorCache::VoxelDescriptorCache(size_t capacity, size_t maxAge)
+: m_capacity(capacity), m_maxAge(maxAge)
+{}
+
+//#################### PUBLIC MEMBER FUNCTIONS ####################
+
+void VoxelDescriptorCache::clear()
+{
+  m_entries.clear();
+  m_recencyList.clear();
+}
+
+void VoxelDescriptorCache::insert(const Vector3s& voxelLocation, const rafl::Descriptor_CPtr& descriptor, size_t sceneChangeCount, size_t blockFusionCount)
+{
+  if(m_capacity == 0) return;
+
+  const boost::uint64_t key = make_key(voxelLocation);
+  boost::unordered_map<boost::uint64_t,Entry>::iterator it = m_entries.find(key);
+  if(it != m_entries.end())
+  {
+    // If there is already an entry for the voxel, update it and mark it as the most recently used entry.
+    it->second.blockFusionCount = blockFusionCount;
+    it->second.descriptor = descriptor;
+    it->second.sceneChangeCount = sceneChangeCount;
+    m_recencyList.splice(m_recencyList.begin(), m_recencyList, it->second.recencyIt);
+    return;
+  }
+
+  // If the cache is full, evict the least recently used entry.
+  if(m_entries.size() == m_capacity)
+  {
+    m_entries.erase(m_recencyList.back());
+    m_recencyList.pop_back();
+  }
+
+  // Add a new entry for the voxel.
+  m_recencyList.push_front(key);
+  Entry& entry = m_entries[key];
+  entry.blockFusionCount = blockFusionCount;
+  entry.descriptor = descriptor;
+  entry.recencyIt = m_recencyList.begin();
+  entry.sceneChangeCount = sceneChangeCount;
+}
+
+rafl::Descriptor_CPtr VoxelDescriptorCache::lookup(const Vector3s& voxelLocation, size_t sceneChangeCount, size_t blockFusionCount)
+{
+  boost::unordered_map<boost::uint64_t,Entry>::iterator it = m_entries.find(make_key(voxelLocation));
+  if(it == m_entries.end()) return rafl::Descriptor_CPtr();
+
+  // If the descriptor is stale (i.e. the scene has changed as a whole, or the voxel's block has been fused into too often since
+  // the descriptor was computed), remove it from the cache.
+  if(sceneChangeCount != it->second.sceneChangeCount || blockFusionCount - it->second.blockFusionCount > m_maxAge)
+  {
+    m_recencyList.erase(it->second.recencyIt);
+    m_entries.erase(it);
+    return rafl::Descriptor_CPtr();
+  }
+
+  // Otherwise, mark the entry as the most recently used entry and return the descriptor.
+  m_recencyList.splice(m_recencyList.begin(), m_recencyList, it->second.recencyIt);
+  return it->second.descriptor;
+}
+
+size_t VoxelDescriptorCache::size() const
+{
+  return m_entries.size();
+}
+
+//#################### PRIVATE STATIC MEMBER FUNCTIONS ####################
+
+boost::uint64_t VoxelDescriptorCache::make_key(const Vector3s& voxelLocation)
+{
+  return (static_cast<boost::uint64_t>(static_cast<unsigned short>(voxelLocation.x)) << 32) |
+         (static_cast<boost::uint64_t>(static_cast<unsigned short>(voxelLocation.y)) << 16) |
+         static_cast<boost::uint64_t>(static_cast<unsigned short>(voxelLocation.z));
+}
+
+}
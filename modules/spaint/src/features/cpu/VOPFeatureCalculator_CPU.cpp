@@ -5,6 +5,7 @@
 
 #include "features/cpu/VOPFeatureCalculator_CPU.h"
 
+#include <algorithm>
 #include <vector>
 
 #include <ITMLib/Objects/Scene/ITMRepresentationAccess.h>
@@ -43,14 +44,23 @@ void VOPFeatureCalculator_CPU::calculate_surface_normals(const ORUtils::MemoryBl
 void VOPFeatureCalculator_CPU::convert_patches_to_lab(int voxelLocationCount, ORUtils::MemoryBlock<float>& featuresMB) const
 {
   const size_t featureCount = get_feature_count();
+  const int patchArea = static_cast<int>(m_patchSize * m_patchSize);
   float *features = featuresMB.GetData(MEMORYDEVICE_CPU);
 
 #ifdef WITH_OPENMP
-  #pragma omp parallel for
+  #pragma omp parallel
 #endif
-  for(int voxelLocationIndex = 0; voxelLocationIndex < voxelLocationCount; ++voxelLocationIndex)
   {
-    convert_patch_to_lab(voxelLocationIndex, featureCount, features);
+    // Allocate the per-thread storage used to hold the XYZ and f(XYZ) channels of a patch in structure-of-arrays form.
+    std::vector<float> channels(6 * patchArea);
+
+#ifdef WITH_OPENMP
+    #pragma omp for
+#endif
+    for(int voxelLocationIndex = 0; voxelLocationIndex < voxelLocationCount; ++voxelLocationIndex)
+    {
+      convert_patch_to_lab_vectorised(features + voxelLocationIndex * featureCount, patchArea, &channels[0]);
+    }
   }
 }
 
@@ -107,46 +117,96 @@ void VOPFeatureCalculator_CPU::generate_rgb_patches(const ORUtils::MemoryBlock<V
 
 void VOPFeatureCalculator_CPU::update_coordinate_systems(int voxelLocationCount, const ORUtils::MemoryBlock<float>& featuresMB) const
 {
-  const int featureCount = static_cast<int>(get_feature_count());
+  const size_t featureCount = get_feature_count();
   const float *features = featuresMB.GetData(MEMORYDEVICE_CPU);
   const int patchSize = static_cast<int>(m_patchSize);
-  const int patchArea = patchSize * patchSize;
   Vector3f *xAxes = m_xAxesMB->GetData(MEMORYDEVICE_CPU);
   Vector3f *yAxes = m_yAxesMB->GetData(MEMORYDEVICE_CPU);
 
-  std::vector<std::vector<float> > histograms(voxelLocationCount, std::vector<float>(m_binCount));
-  std::vector<std::vector<float> > intensities(voxelLocationCount, std::vector<float>(patchArea));
-
-  int threadCount = voxelLocationCount * patchArea;
-
-  // Convert each voxel's RGB patch to an intensity patch.
+  // Unlike on the GPU, where there is a thread per patch pixel, we process each voxel's patch in a single pass on the CPU.
+  // This avoids the need for atomic updates to the histograms, and allows the inner loops over the patch rows to be vectorised.
 #ifdef WITH_OPENMP
-  #pragma omp parallel for
+  #pragma omp parallel
 #endif
-  for(int tid = 0; tid < threadCount; ++tid)
   {
-    int voxelLocationIndex = tid / patchArea;
-    compute_intensities_for_patch(tid, features, featureCount, patchSize, &intensities[voxelLocationIndex][0]);
-  }
+    // Allocate the per-thread storage needed to compute the histograms.
+    std::vector<float> histogram(m_binCount);
+    std::vector<float> intensities(patchSize * patchSize);
+    std::vector<float> rowGradients(3 * patchSize);
 
-  // Compute a histogram of oriented gradients from the intensity patch for each voxel.
 #ifdef WITH_OPENMP
-  #pragma omp parallel for
+    #pragma omp for
 #endif
-  for(int tid = 0; tid < threadCount; ++tid)
+    for(int voxelLocationIndex = 0; voxelLocationIndex < voxelLocationCount; ++voxelLocationIndex)
+    {
+      // Compute a histogram of oriented gradients from the voxel's RGB patch.
+      compute_histogram_for_voxel(features + voxelLocationIndex * featureCount, patchSize, m_binCount, &intensities[0], &rowGradients[0], &histogram[0]);
+
+      // Calculate the dominant orientation for the voxel and rotate its coordinate system to align with that as necessary.
+      align_coordinate_system_with_histogram(&histogram[0], m_binCount, &xAxes[voxelLocationIndex], &yAxes[voxelLocationIndex]);
+    }
+  }
+}
+
+//#################### PRIVATE STATIC MEMBER FUNCTIONS ####################
+
+void VOPFeatureCalculator_CPU::compute_histogram_for_voxel(const float *rgbPatch, int patchSize, size_t binCount, float *intensities, float *rowGradients, float *histogram)
+{
+  const int patchArea = patchSize * patchSize;
+
+  // Convert the RGB patch to an intensity patch.
+  for(int i = 0; i < patchArea; ++i)
   {
-    int voxelLocationIndex = tid / patchArea;
-    compute_histogram_for_patch(tid, m_patchSize, &intensities[voxelLocationIndex][0], m_binCount, &histograms[voxelLocationIndex][0]);
+    intensities[i] = itmx::convert_rgb_to_grey(rgbPatch[i * 3], rgbPatch[i * 3 + 1], rgbPatch[i * 3 + 2]);
   }
 
-  // Calculate the dominant orientation for each voxel and rotate its coordinate system to align with that as necessary.
-#ifdef WITH_OPENMP
-  #pragma omp parallel for
-#endif
-  for(int tid = 0; tid < threadCount; ++tid)
+  // Compute the histogram one row of the patch at a time, skipping the border pixels (for which we can't compute a gradient).
+  std::fill(histogram, histogram + binCount, 0.0f);
+  float *xDerivs = rowGradients, *yDerivs = rowGradients + patchSize, *mags = rowGradients + 2 * patchSize;
+  for(int y = 1; y < patchSize - 1; ++y)
+  {
+    const float *row = intensities + y * patchSize;
+    const float *rowAbove = row - patchSize, *rowBelow = row + patchSize;
+
+    // Compute the derivatives and gradient magnitudes for the whole row (this loop has no dependencies and can be vectorised).
+    for(int x = 1; x < patchSize - 1; ++x)
+    {
+      xDerivs[x] = row[x + 1] - row[x - 1];
+      yDerivs[x] = rowBelow[x] - rowAbove[x];
+      mags[x] = sqrt(xDerivs[x] * xDerivs[x] + yDerivs[x] * yDerivs[x]);
+    }
+
+    // Quantize the orientations and update the histogram.
+    for(int x = 1; x < patchSize - 1; ++x)
+    {
+      histogram[quantize_orientation(xDerivs[x], yDerivs[x], binCount)] += mags[x];
+    }
+  }
+}
+
+void VOPFeatureCalculator_CPU::convert_patch_to_lab_vectorised(float *rgbPatch, int patchArea, float *channels)
+{
+  float *x = channels, *y = x + patchArea, *z = y + patchArea;
+  float *fx = z + patchArea, *fy = fx + patchArea, *fz = fy + patchArea;
+
+  // Convert the patch to the CIEXYZ colour space, splitting it into separate channels as we go so as to allow vectorisation.
+  for(int i = 0; i < patchArea; ++i)
+  {
+    itmx::rgb_to_lab_xyz(rgbPatch[i * 3] / 255.0f, rgbPatch[i * 3 + 1] / 255.0f, rgbPatch[i * 3 + 2] / 255.0f, x[i], y[i], z[i]);
+  }
+
+  // Apply the non-linearity to each channel (this is the only part of the conversion that is not vectorised).
+  for(int i = 0; i < patchArea; ++i)
+  {
+    fx[i] = itmx::rgb_to_lab_f(x[i]);
+    fy[i] = itmx::rgb_to_lab_f(y[i]);
+    fz[i] = itmx::rgb_to_lab_f(z[i]);
+  }
+
+  // Compute the CIELab values and write them back into the patch.
+  for(int i = 0; i < patchArea; ++i)
   {
-    int voxelLocationIndex = tid / patchArea;
-    update_coordinate_system(tid, patchArea, &histograms[voxelLocationIndex][0], m_binCount, &xAxes[voxelLocationIndex], &yAxes[voxelLocationIndex]);
+    itmx::rgb_to_lab_from_f(y[i], fx[i], fy[i], fz[i], rgbPatch[i * 3], rgbPatch[i * 3 + 1], rgbPatch[i * 3 + 2]);
   }
 }
 
@@ -5,6 +5,7 @@
 
 #include "fiducials/ArUcoFiducialDetector.h"
 
+#include <algorithm>
 #include <cmath>
 
 #include <boost/lexical_cast.hpp>
@@ -29,8 +30,14 @@ namespace spaint {
 //#################### CONSTRUCTORS ####################
 
 ArUcoFiducialDetector::ArUcoFiducialDetector(const Settings_CPtr& settings)
-: m_settings(settings)
-{}
+: m_framesSinceFullScan(0), m_settings(settings)
+{
+  static const std::string settingsNamespace = "ArUcoFiducialDetector.";
+  m_fullScanInterval = settings->get_first_value<int>(settingsNamespace + "fullScanInterval", 10);
+  m_minRoiPadding = settings->get_first_value<int>(settingsNamespace + "minRoiPadding", 20);
+  m_roiPaddingFactor = settings->get_first_value<float>(settingsNamespace + "roiPaddingFactor", 0.5f);
+  m_roiTrackingEnabled = settings->get_first_value<bool>(settingsNamespace + "roiTrackingEnabled", true);
+}
 
 //#################### PUBLIC MEMBER FUNCTIONS ####################
 
@@ -44,11 +51,25 @@ std::map<std::string,FiducialMeasurement> ArUcoFiducialDetector::detect_fiducial
   rgb->UpdateHostFromDevice();
   cv::Mat3b rgbImage = OpenCVUtil::make_rgb_image(rgb->GetData(MEMORYDEVICE_CPU), rgb->noDims.x, rgb->noDims.y);
 
-  // Detect any ArUco fiducials that are visible.
-  cv::aruco::Dictionary dictionary = cv::aruco::getPredefinedDictionary(cv::aruco::DICT_6X6_250);
+  // Detect any ArUco fiducials that are visible. If we're tracking the known fiducials, we only scan the regions of the image
+  // in which we expect to find them, unless it's time for a periodic full-frame scan or one of them can no longer be found.
   std::vector<std::vector<cv::Point2f> > corners;
   std::vector<int> ids;
-  cv::aruco::detectMarkers(rgbImage, dictionary, corners, ids);
+
+  bool fullScanNeeded = !m_roiTrackingEnabled || m_trackedFiducials.empty() || m_framesSinceFullScan >= m_fullScanInterval;
+  if(!fullScanNeeded && !detect_known_fiducials(rgbImage, view, pose, ids, corners)) fullScanNeeded = true;
+
+  if(fullScanNeeded)
+  {
+    ids.clear();
+    corners.clear();
+    cv::aruco::Dictionary dictionary = cv::aruco::getPredefinedDictionary(cv::aruco::DICT_6X6_250);
+    cv::aruco::detectMarkers(rgbImage, dictionary, corners, ids);
+    m_framesSinceFullScan = 0;
+  }
+  else ++m_framesSinceFullScan;
+
+  if(m_roiTrackingEnabled) update_tracked_fiducials(ids, corners, view, pose);
 
 #if 0
   // Visualise the detected fiducials for debugging purposes.
@@ -183,6 +204,76 @@ ArUcoFiducialDetector::construct_measurements_from_raycast(const std::vector<int
   return measurements;
 }
 
+bool ArUcoFiducialDetector::detect_known_fiducials(const cv::Mat3b& rgbImage, const View_CPtr& view, const ORUtils::SE3Pose& pose,
+                                                   std::vector<int>& ids, std::vector<std::vector<cv::Point2f> >& corners) const
+{
+  cv::aruco::Dictionary dictionary = cv::aruco::getPredefinedDictionary(cv::aruco::DICT_6X6_250);
+  const cv::Rect imageRect(0, 0, rgbImage.cols, rgbImage.rows);
+
+  // FIXME: As in pick_corner_from_depth, I'm currently assuming that there is an identity mapping between the depth and colour cameras.
+  const Vector4f& projParams = view->calib.intrinsics_d.projectionParamsSimple.all;
+  const Matrix4f worldToEye = pose.GetM();
+
+  for(std::map<int,TrackedFiducial>::const_iterator it = m_trackedFiducials.begin(), iend = m_trackedFiducials.end(); it != iend; ++it)
+  {
+    // If the fiducial has already been detected in the region of interest of another fiducial, there's no need to look for it again.
+    if(std::find(ids.begin(), ids.end(), it->first) != ids.end()) continue;
+
+    // Predict the corners of the fiducial in the colour image by projecting their world-space positions (where known)
+    // into the image using the current camera pose. If a corner's world-space position is not known, we assume that
+    // it has not moved since the previous frame.
+    const TrackedFiducial& fiducial = it->second;
+    std::vector<cv::Point2f> predictedCorners = fiducial.corners;
+    for(size_t i = 0, size = predictedCorners.size(); i < size; ++i)
+    {
+      if(!fiducial.worldCorners[i]) continue;
+
+      const Vector3f& cornerWorld = *fiducial.worldCorners[i];
+      const Vector4f cornerEye = worldToEye * Vector4f(cornerWorld.x, cornerWorld.y, cornerWorld.z, 1.0f);
+      if(cornerEye.z <= 0.0f) continue;
+
+      predictedCorners[i] = cv::Point2f(
+        projParams.x * cornerEye.x / cornerEye.z + projParams.z,
+        projParams.y * cornerEye.y / cornerEye.z + projParams.w
+      );
+    }
+
+    // Pad the bounding box of the predicted corners to allow for prediction errors, and clip it to the image.
+    const cv::Rect bounds = cv::boundingRect(predictedCorners);
+    const int padding = std::max(m_minRoiPadding, static_cast<int>(m_roiPaddingFactor * std::max(bounds.width, bounds.height)));
+    const cv::Rect roi = cv::Rect(bounds.x - padding, bounds.y - padding, bounds.width + 2 * padding, bounds.height + 2 * padding) & imageRect;
+
+    // If the fiducial is predicted to be outside the image, it has been lost.
+    if(roi.area() == 0) return false;
+
+    // Scan the region of interest for fiducials, and add any that haven't already been detected to the results.
+    std::vector<std::vector<cv::Point2f> > roiCorners;
+    std::vector<int> roiIds;
+    cv::aruco::detectMarkers(rgbImage(roi), dictionary, roiCorners, roiIds);
+
+    for(size_t i = 0, size = roiIds.size(); i < size; ++i)
+    {
+      if(std::find(ids.begin(), ids.end(), roiIds[i]) != ids.end()) continue;
+
+      for(size_t j = 0, cornerCount = roiCorners[i].size(); j < cornerCount; ++j)
+      {
+        roiCorners[i][j] += cv::Point2f(static_cast<float>(roi.x), static_cast<float>(roi.y));
+      }
+
+      ids.push_back(roiIds[i]);
+      corners.push_back(roiCorners[i]);
+    }
+  }
+
+  // Check whether all of the known fiducials have been detected.
+  for(std::map<int,TrackedFiducial>::const_iterator it = m_trackedFiducials.begin(), iend = m_trackedFiducials.end(); it != iend; ++it)
+  {
+    if(std::find(ids.begin(), ids.end(), it->first) == ids.end()) return false;
+  }
+
+  return true;
+}
+
 boost::optional<Vector3f> ArUcoFiducialDetector::pick_corner_from_depth(const cv::Point2f& corner, const View_CPtr& view) const
 {
   // FIXME: I'm currently assuming that there is an identity mapping between the depth and colour cameras - in general, this won't be the case.
@@ -214,6 +305,33 @@ boost::optional<Vector3f> ArUcoFiducialDetector::pick_corner_from_raycast(const
   return Picker::get_positions<Vector3f>(*pickPointFloatMB, m_settings->sceneParams.voxelSize)[0];
 }
 
+void ArUcoFiducialDetector::update_tracked_fiducials(const std::vector<int>& ids, const std::vector<std::vector<cv::Point2f> >& corners,
+                                                     const View_CPtr& view, const ORUtils::SE3Pose& pose) const
+{
+  m_trackedFiducials.clear();
+
+  // Make sure that the live depth image is available on the CPU.
+  view->depth->UpdateHostFromDevice();
+
+  // For each detected fiducial, record its corners in the colour image, and try to determine their positions in world space.
+  const Matrix4f eyeToWorld = pose.GetInvM();
+  for(size_t i = 0, size = ids.size(); i < size; ++i)
+  {
+    TrackedFiducial& fiducial = m_trackedFiducials[ids[i]];
+    fiducial.corners = corners[i];
+    fiducial.worldCorners.resize(corners[i].size());
+
+    for(size_t j = 0, cornerCount = corners[i].size(); j < cornerCount; ++j)
+    {
+      boost::optional<Vector3f> cornerEye = pick_corner_from_depth(corners[i][j], view);
+      if(!cornerEye) continue;
+
+      const Vector4f cornerWorld = eyeToWorld * Vector4f(cornerEye->x, cornerEye->y, cornerEye->z, 1.0f);
+      fiducial.worldCorners[j] = Vector3f(cornerWorld.x, cornerWorld.y, cornerWorld.z);
+    }
+  }
+}
+
 //#################### PRIVATE STATIC MEMBER FUNCTIONS ####################
 
 boost::optional<ORUtils::SE3Pose> ArUcoFiducialDetector::make_pose_from_corners(const boost::optional<Vector3f>& v0,
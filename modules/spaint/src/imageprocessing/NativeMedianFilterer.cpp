@@ -0,0 +1,193 @@
+/**
+ * spaint: NativeMedianFilterer.cpp
+ * Copyright (c) Torr Vision Group, University of Oxford, 2017. All rights reserved.
+ */
+
+#include "imageprocessing/NativeMedianFilterer.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+//#################### LOCAL FUNCTIONS ####################
+
+/**
+ * \brief Sorts two bytes into ascending order.
+ *
+ * \param a The first byte (set to the smaller of the two values).
+ * \param b The second byte (set to the larger of the two values).
+ */
+inline void sort2(unsigned char& a, unsigned char& b)
+{
+  const unsigned char lo = std::min(a, b);
+  b = std::max(a, b);
+  a = lo;
+}
+
+/**
+ * \brief Computes the 3x3 median of each byte in a row of a padded RGBA image.
+ *
+ * The median of each byte is taken over the corresponding bytes of its 3x3 neighbourhood of pixels, which means
+ * that each of the four channels is filtered independently.
+ *
+ * \param rows      Pointers to the first byte of the first pixel to filter in each of the three rows of the neighbourhood.
+ * \param output    A pointer to the first byte of the output row.
+ * \param byteCount The number of bytes in the output row.
+ */
+void median3x3_row(const unsigned char *const *rows, unsigned char *output, int byteCount)
+{
+  const unsigned char *r0 = rows[0], *r1 = rows[1], *r2 = rows[2];
+  for(int i = 0; i < byteCount; ++i)
+  {
+    unsigned char p[9] = { r0[i-4], r0[i], r0[i+4], r1[i-4], r1[i], r1[i+4], r2[i-4], r2[i], r2[i+4] };
+
+    // See "Fast median search: an ANSI C implementation" (Devillard, 1998).
+    sort2(p[1], p[2]); sort2(p[4], p[5]); sort2(p[7], p[8]);
+    sort2(p[0], p[1]); sort2(p[3], p[4]); sort2(p[6], p[7]);
+    sort2(p[1], p[2]); sort2(p[4], p[5]); sort2(p[7], p[8]);
+    sort2(p[0], p[3]); sort2(p[5], p[8]); sort2(p[4], p[7]);
+    sort2(p[3], p[6]); sort2(p[1], p[4]); sort2(p[2], p[5]);
+    sort2(p[4], p[7]); sort2(p[4], p[2]); sort2(p[6], p[4]);
+    sort2(p[4], p[2]);
+
+    output[i] = p[4];
+  }
+}
+
+/**
+ * \brief Computes the 5x5 median of each byte in a row of a padded RGBA image.
+ *
+ * The median of each byte is taken over the corresponding bytes of its 5x5 neighbourhood of pixels, which means
+ * that each of the four channels is filtered independently.
+ *
+ * \param rows      Pointers to the first byte of the first pixel to filter in each of the five rows of the neighbourhood.
+ * \param output    A pointer to the first byte of the output row.
+ * \param byteCount The number of bytes in the output row.
+ */
+void median5x5_row(const unsigned char *const *rows, unsigned char *output, int byteCount)
+{
+  const unsigned char *r0 = rows[0], *r1 = rows[1], *r2 = rows[2], *r3 = rows[3], *r4 = rows[4];
+  for(int i = 0; i < byteCount; ++i)
+  {
+    unsigned char p[25] = {
+      r0[i-8], r0[i-4], r0[i], r0[i+4], r0[i+8],
+      r1[i-8], r1[i-4], r1[i], r1[i+4], r1[i+8],
+      r2[i-8], r2[i-4], r2[i], r2[i+4], r2[i+8],
+      r3[i-8], r3[i-4], r3[i], r3[i+4], r3[i+8],
+      r4[i-8], r4[i-4], r4[i], r4[i+4], r4[i+8]
+    };
+
+    // See "Fast median search: an ANSI C implementation" (Devillard, 1998).
+    sort2(p[0], p[1]);   sort2(p[3], p[4]);   sort2(p[2], p[4]);   sort2(p[2], p[3]);   sort2(p[6], p[7]);
+    sort2(p[5], p[7]);   sort2(p[5], p[6]);   sort2(p[9], p[10]);  sort2(p[8], p[10]);  sort2(p[8], p[9]);
+    sort2(p[12], p[13]); sort2(p[11], p[13]); sort2(p[11], p[12]); sort2(p[15], p[16]); sort2(p[14], p[16]);
+    sort2(p[14], p[15]); sort2(p[18], p[19]); sort2(p[17], p[19]); sort2(p[17], p[18]); sort2(p[21], p[22]);
+    sort2(p[20], p[22]); sort2(p[20], p[21]); sort2(p[23], p[24]); sort2(p[2], p[5]);   sort2(p[3], p[6]);
+    sort2(p[0], p[6]);   sort2(p[0], p[3]);   sort2(p[4], p[7]);   sort2(p[1], p[7]);   sort2(p[1], p[4]);
+    sort2(p[11], p[14]); sort2(p[8], p[14]);  sort2(p[8], p[11]);  sort2(p[12], p[15]); sort2(p[9], p[15]);
+    sort2(p[9], p[12]);  sort2(p[13], p[16]); sort2(p[10], p[16]); sort2(p[10], p[13]); sort2(p[20], p[23]);
+    sort2(p[17], p[23]); sort2(p[17], p[20]); sort2(p[21], p[24]); sort2(p[18], p[24]); sort2(p[18], p[21]);
+    sort2(p[19], p[22]); sort2(p[8], p[17]);  sort2(p[9], p[18]);  sort2(p[0], p[18]);  sort2(p[0], p[9]);
+    sort2(p[10], p[19]); sort2(p[1], p[19]);  sort2(p[1], p[10]);  sort2(p[11], p[20]); sort2(p[2], p[20]);
+    sort2(p[2], p[11]);  sort2(p[12], p[21]); sort2(p[3], p[21]);  sort2(p[3], p[12]);  sort2(p[13], p[22]);
+    sort2(p[4], p[22]);  sort2(p[4], p[13]);  sort2(p[14], p[23]); sort2(p[5], p[23]);  sort2(p[5], p[14]);
+    sort2(p[15], p[24]); sort2(p[6], p[24]);  sort2(p[6], p[15]);  sort2(p[7], p[16]);  sort2(p[7], p[19]);
+    sort2(p[13], p[21]); sort2(p[15], p[23]); sort2(p[7], p[13]);  sort2(p[7], p[15]);  sort2(p[1], p[9]);
+    sort2(p[3], p[11]);  sort2(p[5], p[17]);  sort2(p[11], p[17]); sort2(p[9], p[17]);  sort2(p[4], p[10]);
+    sort2(p[6], p[12]);  sort2(p[7], p[14]);  sort2(p[4], p[6]);   sort2(p[4], p[7]);   sort2(p[12], p[14]);
+    sort2(p[10], p[14]); sort2(p[6], p[7]);   sort2(p[10], p[12]); sort2(p[6], p[10]);  sort2(p[6], p[17]);
+    sort2(p[12], p[17]); sort2(p[7], p[17]);  sort2(p[7], p[10]);  sort2(p[12], p[18]); sort2(p[7], p[12]);
+    sort2(p[10], p[18]); sort2(p[12], p[20]); sort2(p[10], p[20]); sort2(p[10], p[12]);
+
+    output[i] = p[12];
+  }
+}
+
+}
+
+namespace spaint {
+
+//#################### CONSTRUCTORS ####################
+
+NativeMedianFilterer::NativeMedianFilterer(unsigned int kernelWidth, DeviceType deviceType)
+: m_deviceType(deviceType), m_kernelWidth(kernelWidth)
+{
+  if(kernelWidth != 3 && kernelWidth != 5)
+  {
+    throw std::invalid_argument("Error: Native median filtering only supports kernel widths of 3 and 5");
+  }
+}
+
+//#################### PUBLIC OPERATORS ####################
+
+void NativeMedianFilterer::operator()(const ITMUChar4Image_CPtr& input, const ITMUChar4Image_Ptr& output) const
+{
+  output->ChangeDims(input->noDims);
+
+  if(m_deviceType == DEVICE_CUDA)
+  {
+    input->UpdateHostFromDevice();
+    filter_on_cpu(input.get(), output.get());
+    output->UpdateDeviceFromHost();
+  }
+  else filter_on_cpu(input.get(), output.get());
+}
+
+//#################### PUBLIC MEMBER FUNCTIONS ####################
+
+void NativeMedianFilterer::filter_on_cpu(const ITMUChar4Image *input, ITMUChar4Image *output) const
+{
+  const int width = input->noDims.x, height = input->noDims.y;
+  if(width == 0 || height == 0) return;
+
+  const int radius = static_cast<int>(m_kernelWidth / 2);
+  const int paddedWidth = width + 2 * radius, paddedHeight = height + 2 * radius;
+
+  // Make a padded copy of the input image, replicating its border pixels to fill the padding. As well as
+  // removing the need to special-case the borders, this allows the input and output images to be the same.
+  m_padded.resize(paddedWidth * paddedHeight);
+  const Vector4u *inputPtr = input->GetData(MEMORYDEVICE_CPU);
+  Vector4u *paddedPtr = &m_padded[0];
+
+#ifdef WITH_OPENMP
+  #pragma omp parallel for
+#endif
+  for(int py = 0; py < paddedHeight; ++py)
+  {
+    const int y = std::min(std::max(py - radius, 0), height - 1);
+    const Vector4u *inputRow = inputPtr + y * width;
+    Vector4u *paddedRow = paddedPtr + py * paddedWidth;
+
+    std::fill(paddedRow, paddedRow + radius, inputRow[0]);
+    std::copy(inputRow, inputRow + width, paddedRow + radius);
+    std::fill(paddedRow + radius + width, paddedRow + paddedWidth, inputRow[width - 1]);
+  }
+
+  // Filter each row of the image.
+  Vector4u *outputPtr = output->GetData(MEMORYDEVICE_CPU);
+  const int byteCount = width * 4;
+
+#ifdef WITH_OPENMP
+  #pragma omp parallel for
+#endif
+  for(int y = 0; y < height; ++y)
+  {
+    const unsigned char *rows[5];
+    for(int k = 0; k < static_cast<int>(m_kernelWidth); ++k)
+    {
+      rows[k] = reinterpret_cast<const unsigned char*>(paddedPtr + (y + k) * paddedWidth + radius);
+    }
+
+    unsigned char *outputRow = reinterpret_cast<unsigned char*>(outputPtr + y * width);
+    if(m_kernelWidth == 3) median3x3_row(rows, outputRow, byteCount);
+    else median5x5_row(rows, outputRow, byteCount);
+  }
+}
+
+unsigned int NativeMedianFilterer::get_kernel_width() const
+{
+  return m_kernelWidth;
+}
+
+}
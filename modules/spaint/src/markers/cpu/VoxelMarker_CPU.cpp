@@ -5,8 +5,33 @@
 
 #include "markers/cpu/VoxelMarker_CPU.h"
 
+#include <algorithm>
+
+#include <boost/static_assert.hpp>
+
 #include "markers/shared/VoxelMarker_Shared.h"
 
+namespace {
+
+//#################### LOCAL TYPES ####################
+
+/**
+ * \brief Computes (at compile time) the number of bits needed to represent the non-negative integer N.
+ */
+template <int N>
+struct BitCount
+{
+  enum { value = 1 + BitCount<N / 2>::value };
+};
+
+template <>
+struct BitCount<0>
+{
+  enum { value = 0 };
+};
+
+}
+
 namespace spaint {
 
 //#################### PUBLIC MEMBER FUNCTIONS ####################
@@ -29,16 +54,7 @@ void VoxelMarker_CPU::mark_voxels(const ORUtils::MemoryBlock<Vector3s>& voxelLoc
   SpaintVoxel::PackedLabel *oldVoxelLabels = oldVoxelLabelsMB ? oldVoxelLabelsMB->GetData(MEMORYDEVICE_CPU) : NULL;
   int voxelCount = static_cast<int>(voxelLocationsMB.dataSize);
 
-  SpaintVoxel *voxelData = scene->localVBA.GetVoxelBlocks();
-  const ITMVoxelIndex::IndexData *voxelIndex = scene->index.getIndexData();
-
-#ifdef WITH_OPENMP
-  #pragma omp parallel for
-#endif
-  for(int i = 0; i < voxelCount; ++i)
-  {
-    mark_voxel(voxelLocations[i], label, oldVoxelLabels ? &oldVoxelLabels[i] : NULL, voxelData, voxelIndex, mode);
-  }
+  mark_voxels_by_block(voxelLocations, NULL, label, voxelCount, scene, mode, oldVoxelLabels);
 }
 
 void VoxelMarker_CPU::mark_voxels(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB, const ORUtils::MemoryBlock<SpaintVoxel::PackedLabel>& voxelLabelsMB,
@@ -49,15 +65,92 @@ void VoxelMarker_CPU::mark_voxels(const ORUtils::MemoryBlock<Vector3s>& voxelLoc
   SpaintVoxel::PackedLabel *oldVoxelLabels = oldVoxelLabelsMB ? oldVoxelLabelsMB->GetData(MEMORYDEVICE_CPU) : NULL;
   int voxelCount = static_cast<int>(voxelLocationsMB.dataSize);
 
+  mark_voxels_by_block(voxelLocations, voxelLabels, SpaintVoxel::PackedLabel(), voxelCount, scene, mode, oldVoxelLabels);
+}
+
+//#################### PRIVATE MEMBER FUNCTIONS ####################
+
+void VoxelMarker_CPU::mark_voxels_by_block(const Vector3s *voxelLocations, const SpaintVoxel::PackedLabel *voxelLabels, SpaintVoxel::PackedLabel label,
+                                           int voxelCount, SpaintVoxelScene *scene, MarkingMode mode, SpaintVoxel::PackedLabel *oldVoxelLabels) const
+{
+  // Since voxel locations are stored as shorts, voxel block coordinates lie in [-4096,4095] and can be packed into 13 bits each.
+  // The key for each voxel packs its block coordinates into the high bits and its linear index within the block into the low bits,
+  // so that sorting by key groups the voxels by block, and the duplicates of each voxel together.
+  const int blockCoordOffset = 4096;
+  const int linearIdxBits = BitCount<SDF_BLOCK_SIZE3 - 1>::value;
+  BOOST_STATIC_ASSERT(3 * 13 + linearIdxBits <= 64);
+  const boost::uint64_t linearIdxMask = (1 << linearIdxBits) - 1;
+
+  // Compute the key for each voxel.
+  m_sortedEntries.resize(voxelCount);
+
+#ifdef WITH_OPENMP
+  #pragma omp parallel for
+#endif
+  for(int i = 0; i < voxelCount; ++i)
+  {
+    Vector3i blockPos;
+    const int linearIdx = pointToVoxelBlockPos(voxelLocations[i].toInt(), blockPos);
+    const boost::uint64_t key =
+      (static_cast<boost::uint64_t>(blockPos.z + blockCoordOffset) << (linearIdxBits + 26)) |
+      (static_cast<boost::uint64_t>(blockPos.y + blockCoordOffset) << (linearIdxBits + 13)) |
+      (static_cast<boost::uint64_t>(blockPos.x + blockCoordOffset) << linearIdxBits) |
+      static_cast<boost::uint64_t>(linearIdx);
+    m_sortedEntries[i] = std::make_pair(key, i);
+  }
+
+  // Sort the voxels by key and then by input index, so that the duplicates of each voxel end up in input order.
+  std::sort(m_sortedEntries.begin(), m_sortedEntries.end());
+
+  // Find the start of the run of voxels for each voxel block.
+  m_blockStarts.clear();
+  for(int j = 0; j < voxelCount; ++j)
+  {
+    if(j == 0 || (m_sortedEntries[j].first >> linearIdxBits) != (m_sortedEntries[j-1].first >> linearIdxBits))
+    {
+      m_blockStarts.push_back(j);
+    }
+  }
+  const int blockCount = static_cast<int>(m_blockStarts.size());
+  m_blockStarts.push_back(voxelCount);
+
   SpaintVoxel *voxelData = scene->localVBA.GetVoxelBlocks();
   const ITMVoxelIndex::IndexData *voxelIndex = scene->index.getIndexData();
 
+  // Mark the voxels in each block. Since each block is processed by a single thread, no synchronisation is needed.
 #ifdef WITH_OPENMP
   #pragma omp parallel for
 #endif
-  for(int i = 0; i < voxelCount; ++i)
+  for(int b = 0; b < blockCount; ++b)
   {
-    mark_voxel(voxelLocations[i], voxelLabels[i], oldVoxelLabels ? &oldVoxelLabels[i] : NULL, voxelData, voxelIndex, mode);
+    const int blockBegin = m_blockStarts[b], blockEnd = m_blockStarts[b+1];
+
+    // Look up the voxel block in the scene's hash table. If it is not allocated, none of its voxels can be marked.
+    Vector3i blockPos;
+    pointToVoxelBlockPos(voxelLocations[m_sortedEntries[blockBegin].second].toInt(), blockPos);
+    bool isFound;
+    const int blockAddress = findVoxel(voxelIndex, blockPos * SDF_BLOCK_SIZE, isFound);
+    if(!isFound) continue;
+    SpaintVoxel *blockVoxels = voxelData + blockAddress;
+
+    for(int j = blockBegin; j < blockEnd;)
+    {
+      const boost::uint64_t key = m_sortedEntries[j].first;
+      SpaintVoxel::PackedLabel& packedLabel = blockVoxels[key & linearIdxMask].packedLabel;
+      const SpaintVoxel::PackedLabel originalLabel = packedLabel;
+
+      // Apply the labels for all the duplicates of the voxel in input order, recording the voxel's original label as the old label for each of them.
+      SpaintVoxel::PackedLabel newLabel = originalLabel;
+      for(; j < blockEnd && m_sortedEntries[j].first == key; ++j)
+      {
+        const int i = m_sortedEntries[j].second;
+        const SpaintVoxel::PackedLabel entryLabel = voxelLabels ? voxelLabels[i] : label;
+        if(oldVoxelLabels) oldVoxelLabels[i] = originalLabel;
+        if(mode == FORCED_MARKING || can_overwrite_label(newLabel, entryLabel)) newLabel = entryLabel;
+      }
+
+      packedLabel = newLabel;
+    }
   }
 }
 
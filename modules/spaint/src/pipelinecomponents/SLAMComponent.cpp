@@ -19,6 +19,7 @@ using namespace InputSource;
 using namespace ITMLib;
 using namespace ORUtils;
 
+#include <itmx/base/MemoryBlockFactory.h>
 #ifdef WITH_OPENCV
 #include <itmx/ocv/OpenCVUtil.h>
 #endif
@@ -33,6 +34,7 @@ using namespace itmx;
 using namespace tvgutil;
 
 #include "segmentation/SegmentationUtil.h"
+#include "slamstate/VisibleBlockFinderFactory.h"
 
 namespace spaint {
 
@@ -85,6 +87,10 @@ SLAMComponent::SLAMComponent(const SLAMContext_Ptr& context, const std::string&
     m_denseSurfelMapper.reset(new ITMDenseSurfelMapper<SpaintSurfel>(depthImageSize, settings->deviceType));
   }
 
+  // Set up the visible block finder and the memory block in which to store the positions of the voxel blocks into which each frame is fused.
+  m_visibleBlockFinder = VisibleBlockFinderFactory::make_visible_block_finder(settings->deviceType);
+  m_visibleBlockPositionsMB = MemoryBlockFactory::instance().make_block<Vector3s>(SDF_LOCAL_BLOCK_NUM);
+
   // Set up the tracker and the tracking controller.
   setup_tracker();
   m_trackingController.reset(new ITMTrackingController(m_tracker.get(), settings.get()));
@@ -127,6 +133,7 @@ void SLAMComponent::load_models(const std::string& inputDir)
   // InfiniTAM's loading function to load the files from *inside* the specified folder.
   const SLAMState_Ptr& slamState = m_context->get_slam_state(m_sceneID);
   slamState->get_voxel_scene()->LoadFromDirectory(inputDir + "/");
+  slamState->note_scene_changed();
 
   // TODO: If we support surfel model loading at some point in the future, the surfel model should be loaded here as well.
 
@@ -254,6 +261,11 @@ bool SLAMComponent::process_frame()
   {
     // Run the fusion process.
     m_denseVoxelMapper->ProcessFrame(view.get(), trackingState.get(), voxelScene.get(), liveVoxelRenderState.get(), resetVisibleList);
+
+    // Record which voxel blocks the frame has been fused into, so that any data derived from them can be invalidated.
+    m_visibleBlockFinder->find_visible_blocks(voxelScene.get(), static_cast<const ITMRenderState_VH*>(liveVoxelRenderState.get()), *m_visibleBlockPositionsMB);
+    m_visibleBlockPositionsMB->UpdateHostFromDevice();
+    slamState->note_blocks_fused(*m_visibleBlockPositionsMB);
     if(m_mappingMode != MAP_VOXELS_ONLY)
     {
       m_denseSurfelMapper->ProcessFrame(view.get(), trackingState.get(), surfelScene.get(), liveSurfelRenderState.get());
@@ -315,6 +327,7 @@ void SLAMComponent::reset_scene()
   // Reset the scene.
   const SLAMState_Ptr& slamState = m_context->get_slam_state(m_sceneID);
   m_denseVoxelMapper->ResetScene(slamState->get_voxel_scene().get());
+  slamState->note_scene_changed();
   if(m_mappingMode != MAP_VOXELS_ONLY)
   {
     slamState->get_surfel_scene()->Reset();
@@ -62,12 +62,31 @@ SemanticSegmentationComponent::SemanticSegmentationComponent(const SemanticSegme
   const size_t featureCount = m_featureCalculator->get_feature_count();
   m_predictionFeaturesMB = mbf.make_block<float>(m_maxPredictionVoxelCount * featureCount);
   m_predictionLabelsMB = mbf.make_block<SpaintVoxel::PackedLabel>(m_maxPredictionVoxelCount);
+  m_predictionMissLocationsMB = mbf.make_block<Vector3s>(m_maxPredictionVoxelCount);
   m_predictionVoxelLocationsMB = mbf.make_block<Vector3s>(m_maxPredictionVoxelCount);
   m_trainingFeaturesMB = mbf.make_block<float>(maxTrainingVoxelCount * featureCount);
   m_trainingLabelMaskMB = mbf.make_block<bool>(maxLabelCount);
   m_trainingVoxelCountsMB = mbf.make_block<unsigned int>(maxLabelCount);
   m_trainingVoxelLocationsMB = mbf.make_block<Vector3s>(maxTrainingVoxelCount);
 
+  // Set up the cache for the descriptors computed during prediction. Cached descriptors are keyed on the voxel blocks
+  // into which frames are fused, so they remain valid for parts of the scene that are out of view. The maximum age
+  // (the number of times a voxel's block can be fused into before its descriptor is recomputed) trades off descriptor
+  // freshness against speed in the parts of the scene that are still being reconstructed.
+  static const std::string settingsNamespace = "SemanticSegmentationComponent.";
+  const size_t descriptorCacheCapacity = settings->get_first_value<size_t>(settingsNamespace + "descriptorCacheCapacity", 4 * m_maxPredictionVoxelCount);
+  const size_t maxDescriptorAge = settings->get_first_value<size_t>(settingsNamespace + "maxDescriptorAge", 10);
+  m_predictionDescriptorCache.reset(new VoxelDescriptorCache(descriptorCacheCapacity, maxDescriptorAge));
+
+  // Set up the training schedule. By default, a fixed number of nodes per tree are split in each training step, but the
+  // time spent training can instead be bounded to keep frame times stable, or the splitting can be moved onto background
+  // threads altogether (in which case the split budget applies to each background training job, and the interval limits
+  // how often each tree is copied for a new job).
+  m_backgroundTrainingEnabled = settings->get_first_value<bool>(settingsNamespace + "backgroundTrainingEnabled", false);
+  m_backgroundTrainingInterval = settings->get_first_value<int>(settingsNamespace + "backgroundTrainingInterval", 100000);
+  m_trainingSplitBudget = settings->get_first_value<size_t>(settingsNamespace + "trainingSplitBudget", 20);
+  m_trainingTimeBudget = settings->get_first_value<int>(settingsNamespace + "trainingTimeBudget", 0);
+
   // Register the relevant decision function generators with the factory.
   DecisionFunctionGeneratorFactory<SpaintVoxel::Label>::instance().register_maker(
     SpaintDecisionFunctionGenerator::get_static_type(),
@@ -134,19 +153,59 @@ void SemanticSegmentationComponent::run_prediction(const VoxelRenderState_CPtr&
   // Sample some voxels for which to predict labels.
   m_predictionSampler->sample_voxels(renderState->raycastResult, m_maxPredictionVoxelCount, *m_predictionVoxelLocationsMB);
 
-  // Calculate feature descriptors for the sampled voxels.
-  m_featureCalculator->calculate_features(*m_predictionVoxelLocationsMB, m_context->get_slam_state(m_sceneID)->get_voxel_scene().get(), *m_predictionFeaturesMB);
-  std::vector<Descriptor_CPtr> descriptors = ForestUtil::make_descriptors(*m_predictionFeaturesMB, m_maxPredictionVoxelCount, m_featureCalculator->get_feature_count());
+  // Look up the descriptors for the sampled voxels in the cache, and make a list of the voxels whose descriptors are missing or stale.
+  SLAMState_CPtr slamState = m_context->get_slam_state(m_sceneID);
+  const size_t sceneChangeCount = slamState->get_scene_change_count();
+  m_predictionVoxelLocationsMB->UpdateHostFromDevice();
+  const Vector3s *voxelLocations = m_predictionVoxelLocationsMB->GetData(MEMORYDEVICE_CPU);
+  Vector3s *missLocations = m_predictionMissLocationsMB->GetData(MEMORYDEVICE_CPU);
+
+  std::vector<size_t> blockFusionCounts(m_maxPredictionVoxelCount);
+  std::vector<Descriptor_CPtr> descriptors(m_maxPredictionVoxelCount);
+  std::vector<size_t> missIndices;
+  for(size_t i = 0; i < m_maxPredictionVoxelCount; ++i)
+  {
+    blockFusionCounts[i] = slamState->get_block_fusion_count(voxelLocations[i]);
+    descriptors[i] = m_predictionDescriptorCache->lookup(voxelLocations[i], sceneChangeCount, blockFusionCounts[i]);
+    if(!descriptors[i])
+    {
+      missLocations[missIndices.size()] = voxelLocations[i];
+      missIndices.push_back(i);
+    }
+  }
+
+  // Calculate feature descriptors for the voxels whose descriptors were not in the cache, and add them to the cache.
+  if(!missIndices.empty())
+  {
+    m_predictionMissLocationsMB->dataSize = missIndices.size();
+    m_predictionMissLocationsMB->UpdateDeviceFromHost();
+    m_featureCalculator->calculate_features(*m_predictionMissLocationsMB, slamState->get_voxel_scene().get(), *m_predictionFeaturesMB);
+    std::vector<Descriptor_CPtr> missDescriptors = ForestUtil::make_descriptors(*m_predictionFeaturesMB, missIndices.size(), m_featureCalculator->get_feature_count());
+
+    for(size_t j = 0, missCount = missIndices.size(); j < missCount; ++j)
+    {
+      descriptors[missIndices[j]] = missDescriptors[j];
+      m_predictionDescriptorCache->insert(missLocations[j], missDescriptors[j], sceneChangeCount, blockFusionCounts[missIndices[j]]);
+    }
+  }
 
   // Predict labels for the voxels based on the feature descriptors.
   SpaintVoxel::PackedLabel *labels = m_predictionLabelsMB->GetData(MEMORYDEVICE_CPU);
 
 #ifdef WITH_OPENMP
-  #pragma omp parallel for
+  #pragma omp parallel
 #endif
-  for(int i = 0; i < static_cast<int>(m_maxPredictionVoxelCount); ++i)
   {
-    labels[i] = SpaintVoxel::PackedLabel(m_forest->predict(descriptors[i]), SpaintVoxel::LG_FOREST);
+    // Reuse the same PMF buffer for all of the voxels processed by each thread.
+    std::vector<float> masses;
+
+#ifdef WITH_OPENMP
+    #pragma omp for
+#endif
+    for(int i = 0; i < static_cast<int>(m_maxPredictionVoxelCount); ++i)
+    {
+      labels[i] = SpaintVoxel::PackedLabel(m_forest->predict(descriptors[i], masses), SpaintVoxel::LG_FOREST);
+    }
   }
 
   m_predictionLabelsMB->UpdateDeviceFromHost();
@@ -203,10 +262,23 @@ void SemanticSegmentationComponent::run_training(const VoxelRenderState_CPtr& re
     maxLabelCount
   );
 
-  // Train the forest.
-  const size_t splitBudget = 20;
+  // Add the examples to the forest. If any snapshots of the trees have finished training in the background, they will be swapped in.
   m_forest->add_examples(examples);
-  m_forest->train(splitBudget);
+
+  // Train the forest.
+  if(m_backgroundTrainingEnabled)
+  {
+    m_forest->complete_background_training();
+    m_forest->train_in_background(m_trainingSplitBudget, boost::chrono::microseconds(m_backgroundTrainingInterval));
+  }
+  else if(m_trainingTimeBudget > 0)
+  {
+    m_forest->train_for(boost::chrono::microseconds(m_trainingTimeBudget));
+  }
+  else
+  {
+    m_forest->train(m_trainingSplitBudget);
+  }
 }
 
 }
@@ -18,7 +18,7 @@ namespace spaint {
 
 LabelPropagator_CPtr LabelPropagatorFactory::make_label_propagator(size_t raycastResultSize, DeviceType deviceType,
                                                                    float maxAngleBetweenNormals, float maxSquaredDistanceBetweenColours,
-                                                                   float maxSquaredDistanceBetweenVoxels)
+                                                                   float maxSquaredDistanceBetweenVoxels, size_t iterationCount)
 {
   LabelPropagator_CPtr propagator;
 
@@ -33,7 +33,7 @@ LabelPropagator_CPtr LabelPropagatorFactory::make_label_propagator(size_t raycas
   }
   else
   {
-    propagator.reset(new LabelPropagator_CPU(raycastResultSize, maxAngleBetweenNormals, maxSquaredDistanceBetweenColours, maxSquaredDistanceBetweenVoxels));
+    propagator.reset(new LabelPropagator_CPU(raycastResultSize, maxAngleBetweenNormals, maxSquaredDistanceBetweenColours, maxSquaredDistanceBetweenVoxels, iterationCount));
   }
 
   return propagator;
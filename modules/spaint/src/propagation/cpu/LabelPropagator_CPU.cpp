@@ -5,15 +5,26 @@
 
 #include "propagation/cpu/LabelPropagator_CPU.h"
 
+#include <algorithm>
+
 #include "propagation/shared/LabelPropagator_Shared.h"
 
 namespace spaint {
 
 //#################### CONSTRUCTORS ####################
 
-LabelPropagator_CPU::LabelPropagator_CPU(size_t raycastResultSize, float maxAngleBetweenNormals, float maxSquaredDistanceBetweenColours, float maxSquaredDistanceBetweenVoxels)
-: LabelPropagator(raycastResultSize, maxAngleBetweenNormals, maxSquaredDistanceBetweenColours, maxSquaredDistanceBetweenVoxels)
-{}
+LabelPropagator_CPU::LabelPropagator_CPU(size_t raycastResultSize, float maxAngleBetweenNormals, float maxSquaredDistanceBetweenColours, float maxSquaredDistanceBetweenVoxels,
+                                         size_t iterationCount)
+: LabelPropagator(raycastResultSize, maxAngleBetweenNormals, maxSquaredDistanceBetweenColours, maxSquaredDistanceBetweenVoxels),
+  m_iterationCount(std::max<size_t>(iterationCount, 1)),
+  m_labColours(raycastResultSize),
+  m_originalLabels(raycastResultSize),
+  m_positions(raycastResultSize),
+  m_valid(raycastResultSize)
+{
+  m_labels[0].resize(raycastResultSize);
+  m_labels[1].resize(raycastResultSize);
+}
 
 //#################### PRIVATE MEMBER FUNCTIONS ####################
 
@@ -25,12 +36,19 @@ void LabelPropagator_CPU::calculate_normals(const ITMFloat4Image *raycastResult,
   Vector3f *surfaceNormals = m_surfaceNormalsMB->GetData(MEMORYDEVICE_CPU);
   const SpaintVoxel *voxelData = scene->localVBA.GetVoxelBlocks();
 
+  // Gather the properties of the voxels in the raycast result into the surface point cloud. This is the only point at which
+  // the voxels are looked up in the scene until the changed labels are written back at the end of the propagation process.
+  Vector3f *labColours = &m_labColours[0];
+  SpaintVoxel::PackedLabel *labels = &m_originalLabels[0];
+  Vector3f *positions = &m_positions[0];
+  unsigned char *valid = &m_valid[0];
+
 #ifdef WITH_OPENMP
   #pragma omp parallel for
 #endif
-  for(int voxelIndex = 0; voxelIndex < raycastResultSize; ++voxelIndex)
+  for(int pointIndex = 0; pointIndex < raycastResultSize; ++pointIndex)
   {
-    write_surface_normal(voxelIndex, raycastResultData, voxelData, indexData, surfaceNormals);
+    write_surface_point(pointIndex, raycastResultData, voxelData, indexData, positions, surfaceNormals, labColours, labels, valid);
   }
 }
 
@@ -38,21 +56,49 @@ void LabelPropagator_CPU::perform_propagation(SpaintVoxel::Label label, const IT
 {
   const int height = raycastResult->noDims.y;
   const ITMVoxelIndex::IndexData *indexData = scene->index.getIndexData();
-  const Vector4f *raycastResultData = raycastResult->GetData(MEMORYDEVICE_CPU);
   const int raycastResultSize = static_cast<int>(raycastResult->dataSize);
   const Vector3f *surfaceNormals = m_surfaceNormalsMB->GetData(MEMORYDEVICE_CPU);
   SpaintVoxel *voxelData = scene->localVBA.GetVoxelBlocks();
   const int width = raycastResult->noDims.x;
 
+  const Vector3f *labColours = &m_labColours[0];
+  const SpaintVoxel::PackedLabel *originalLabels = &m_originalLabels[0];
+  const Vector3f *positions = &m_positions[0];
+  const unsigned char *valid = &m_valid[0];
+
+  // Repeatedly propagate the label across the surface point cloud, alternating between the two label buffers.
+  std::copy(m_originalLabels.begin(), m_originalLabels.end(), m_labels[0].begin());
+
+  size_t current = 0;
+  for(size_t i = 0; i < m_iterationCount; ++i, current = 1 - current)
+  {
+    const SpaintVoxel::PackedLabel *inputLabels = &m_labels[current][0];
+    SpaintVoxel::PackedLabel *outputLabels = &m_labels[1 - current][0];
+
+#ifdef WITH_OPENMP
+    #pragma omp parallel for
+#endif
+    for(int pointIndex = 0; pointIndex < raycastResultSize; ++pointIndex)
+    {
+      propagate_between_surface_points(
+        pointIndex, width, height, label, positions, surfaceNormals, labColours, inputLabels, valid,
+        m_maxAngleBetweenNormals, m_maxSquaredDistanceBetweenColours, m_maxSquaredDistanceBetweenVoxels, outputLabels
+      );
+    }
+  }
+
+  // Write the labels of any surface points whose labels have changed back to the scene.
+  const SpaintVoxel::PackedLabel *finalLabels = &m_labels[current][0];
+
 #ifdef WITH_OPENMP
   #pragma omp parallel for
 #endif
-  for(int voxelIndex = 0; voxelIndex < raycastResultSize; ++voxelIndex)
+  for(int pointIndex = 0; pointIndex < raycastResultSize; ++pointIndex)
   {
-    propagate_from_neighbours(
-      voxelIndex, width, height, label, raycastResultData, surfaceNormals, voxelData, indexData,
-      m_maxAngleBetweenNormals, m_maxSquaredDistanceBetweenColours, m_maxSquaredDistanceBetweenVoxels
-    );
+    if(valid[pointIndex] && !(finalLabels[pointIndex] == originalLabels[pointIndex]))
+    {
+      mark_voxel(positions[pointIndex].toShortRound(), finalLabels[pointIndex], NULL, voxelData, indexData);
+    }
   }
 }
 
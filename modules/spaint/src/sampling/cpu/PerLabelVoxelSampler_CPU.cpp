@@ -5,6 +5,8 @@
 
 #include "sampling/cpu/PerLabelVoxelSampler_CPU.h"
 
+#include <algorithm>
+
 #include "sampling/shared/PerLabelVoxelSampler_Shared.h"
 
 namespace spaint {
@@ -12,30 +14,76 @@ namespace spaint {
 //#################### CONSTRUCTORS ####################
 
 PerLabelVoxelSampler_CPU::PerLabelVoxelSampler_CPU(size_t maxLabelCount, size_t maxVoxelsPerLabel, int raycastResultSize, unsigned int seed)
-: PerLabelVoxelSampler(maxLabelCount, maxVoxelsPerLabel, raycastResultSize, seed)
-{}
+: PerLabelVoxelSampler(maxLabelCount, maxVoxelsPerLabel, raycastResultSize, seed),
+  m_maskWordCount((raycastResultSize + 63) / 64)
+{
+  m_blockCount = (m_maskWordCount + BLOCK_SIZE - 1) / BLOCK_SIZE;
+  m_blockOffsets.resize(maxLabelCount * m_blockCount);
+  m_voxelMaskPrefixSums.resize(maxLabelCount * (m_maskWordCount + 1));
+  m_voxelMasks.resize(maxLabelCount * m_maskWordCount);
+}
 
 //#################### PRIVATE MEMBER FUNCTIONS ####################
 
 void PerLabelVoxelSampler_CPU::calculate_voxel_mask_prefix_sums(const ORUtils::MemoryBlock<bool>& labelMaskMB) const
 {
   const bool *labelMask = labelMaskMB.GetData(MEMORYDEVICE_CPU);
-  const unsigned char *voxelMasks = m_voxelMasksMB->GetData(MEMORYDEVICE_CPU);
-  unsigned int *voxelMaskPrefixSums = m_voxelMaskPrefixSumsMB->GetData(MEMORYDEVICE_CPU);
+  const int stride = m_maskWordCount + 1;
+  const int taskCount = static_cast<int>(m_maxLabelCount) * m_blockCount;
+
+  // Step 1: Compute the prefix sums of the mask words within each block of each used label, recording the total for each block.
+#ifdef WITH_OPENMP
+  #pragma omp parallel for
+#endif
+  for(int task = 0; task < taskCount; ++task)
+  {
+    const int k = task / m_blockCount, block = task % m_blockCount;
+    if(!labelMask[k]) continue;
+
+    const MaskWord *voxelMask = &m_voxelMasks[k * m_maskWordCount];
+    unsigned int *voxelMaskPrefixSum = &m_voxelMaskPrefixSums[k * stride];
+
+    unsigned int sum = 0;
+    for(int i = block * BLOCK_SIZE, end = std::min(i + BLOCK_SIZE, m_maskWordCount); i < end; ++i)
+    {
+      voxelMaskPrefixSum[i] = sum;
+      sum += count_bits(voxelMask[i]);
+    }
 
-  // For each possible label:
-  const int stride = m_raycastResultSize + 1;
+    m_blockOffsets[task] = sum;
+  }
+
+  // Step 2: Convert the block totals for each used label into block offsets, and write the total for the label at the end of its prefix sum.
   for(size_t k = 0; k < m_maxLabelCount; ++k)
   {
-    // If the label is not currently in use, continue.
     if(!labelMask[k]) continue;
 
-    // Calculate the prefix sum of the voxel mask.
-    const size_t offset = k * stride;
-    voxelMaskPrefixSums[offset] = 0;
-    for(int i = 1; i < stride; ++i)
+    unsigned int sum = 0;
+    for(int block = 0; block < m_blockCount; ++block)
+    {
+      unsigned int& blockOffset = m_blockOffsets[k * m_blockCount + block];
+      const unsigned int blockTotal = blockOffset;
+      blockOffset = sum;
+      sum += blockTotal;
+    }
+
+    m_voxelMaskPrefixSums[k * stride + m_maskWordCount] = sum;
+  }
+
+  // Step 3: Add the block offsets to the prefix sums within the blocks.
+#ifdef WITH_OPENMP
+  #pragma omp parallel for
+#endif
+  for(int task = 0; task < taskCount; ++task)
+  {
+    const int k = task / m_blockCount, block = task % m_blockCount;
+    const unsigned int blockOffset = m_blockOffsets[task];
+    if(!labelMask[k] || blockOffset == 0) continue;
+
+    unsigned int *voxelMaskPrefixSum = &m_voxelMaskPrefixSums[k * stride];
+    for(int i = block * BLOCK_SIZE, end = std::min(i + BLOCK_SIZE, m_maskWordCount); i < end; ++i)
     {
-      voxelMaskPrefixSums[offset + i] = voxelMaskPrefixSums[offset + (i - 1)] + voxelMasks[offset + (i - 1)];
+      voxelMaskPrefixSum[i] += blockOffset;
     }
   }
 }
@@ -45,23 +93,31 @@ void PerLabelVoxelSampler_CPU::calculate_voxel_masks(const ITMFloat4Image *rayca
                                                      const ITMVoxelIndex::IndexData *indexData) const
 {
   const Vector4f *raycastResultData = raycastResult->GetData(MEMORYDEVICE_CPU);
-  unsigned char *voxelMasks = m_voxelMasksMB->GetData(MEMORYDEVICE_CPU);
+  const int maxLabelCount = static_cast<int>(m_maxLabelCount);
 
+  // Each iteration builds a single mask word for all of the labels, so that no two threads ever write to the same word.
 #ifdef WITH_OPENMP
   #pragma omp parallel for
 #endif
-  for(int voxelIndex = 0; voxelIndex < m_raycastResultSize; ++voxelIndex)
+  for(int wordIndex = 0; wordIndex < m_maskWordCount; ++wordIndex)
   {
-    // Update the voxel masks based on the contents of the voxel.
-    update_masks_for_voxel(
-      voxelIndex,
-      raycastResultData,
-      m_raycastResultSize,
-      voxelData,
-      indexData,
-      m_maxLabelCount,
-      voxelMasks
-    );
+    // Clear the mask words for the various labels (even the ones that are not currently active).
+    for(int k = 0; k < maxLabelCount; ++k)
+    {
+      m_voxelMasks[k * m_maskWordCount + wordIndex] = 0;
+    }
+
+    // Set the bits corresponding to the voxels that can serve as candidates for each label.
+    const int voxelIndexBegin = wordIndex * 64;
+    const int voxelIndexEnd = std::min(voxelIndexBegin + 64, m_raycastResultSize);
+    for(int voxelIndex = voxelIndexBegin; voxelIndex < voxelIndexEnd; ++voxelIndex)
+    {
+      const int k = get_candidate_label(voxelIndex, raycastResultData, voxelData, indexData);
+      if(k >= 0 && k < maxLabelCount)
+      {
+        m_voxelMasks[k * m_maskWordCount + wordIndex] |= MaskWord(1) << (voxelIndex - voxelIndexBegin);
+      }
+    }
   }
 }
 
@@ -69,39 +125,44 @@ void PerLabelVoxelSampler_CPU::write_candidate_voxel_counts(const ORUtils::Memor
                                                             ORUtils::MemoryBlock<unsigned int>& voxelCountsForLabelsMB) const
 {
   const bool *labelMask = labelMaskMB.GetData(MEMORYDEVICE_CPU);
-  const unsigned int *voxelMaskPrefixSums = m_voxelMaskPrefixSumsMB->GetData(MEMORYDEVICE_CPU);
   unsigned int *voxelCountsForLabels = voxelCountsForLabelsMB.GetData(MEMORYDEVICE_CPU);
 
-#ifdef WITH_OPENMP
-  #pragma omp parallel for
-#endif
-  for(int k = 0; k < static_cast<int>(m_maxLabelCount); ++k)
+  for(size_t k = 0; k < m_maxLabelCount; ++k)
   {
-    write_candidate_voxel_count(k, m_raycastResultSize, labelMask, voxelMaskPrefixSums, voxelCountsForLabels);
+    voxelCountsForLabels[k] = labelMask[k] ? m_voxelMaskPrefixSums[k * (m_maskWordCount + 1) + m_maskWordCount] : 0;
   }
 }
 
 void PerLabelVoxelSampler_CPU::write_candidate_voxel_locations(const ITMFloat4Image *raycastResult) const
 {
   const Vector4f *raycastResultData = raycastResult->GetData(MEMORYDEVICE_CPU);
-  const unsigned char *voxelMasks = m_voxelMasksMB->GetData(MEMORYDEVICE_CPU);
-  const unsigned int *voxelMaskPrefixSums = m_voxelMaskPrefixSumsMB->GetData(MEMORYDEVICE_CPU);
   Vector3s *candidateVoxelLocations = m_candidateVoxelLocationsMB->GetData(MEMORYDEVICE_CPU);
+  const int maxLabelCount = static_cast<int>(m_maxLabelCount);
 
+  // Note: We do not need to explicitly use the label mask in this function, since there will never be any candidates for unused labels.
 #ifdef WITH_OPENMP
   #pragma omp parallel for
 #endif
-  for(int voxelIndex = 0; voxelIndex < m_raycastResultSize; ++voxelIndex)
+  for(int wordIndex = 0; wordIndex < m_maskWordCount; ++wordIndex)
   {
-    write_candidate_voxel_location(
-      voxelIndex,
-      raycastResultData,
-      m_raycastResultSize,
-      voxelMasks,
-      voxelMaskPrefixSums,
-      m_maxLabelCount,
-      candidateVoxelLocations
-    );
+    // For each possible label:
+    for(int k = 0; k < maxLabelCount; ++k)
+    {
+      // If none of the voxels covered by the mask word are candidates for this label, skip it.
+      MaskWord word = m_voxelMasks[k * m_maskWordCount + wordIndex];
+      if(word == 0) continue;
+
+      // Otherwise, write the locations of the candidate voxels into the segment of the candidate voxel locations array that
+      // corresponds to this label, starting from the index given by the prefix sum for the mask word.
+      unsigned int i = m_voxelMaskPrefixSums[k * (m_maskWordCount + 1) + wordIndex];
+      for(int voxelIndex = wordIndex * 64; word != 0; ++voxelIndex, word >>= 1)
+      {
+        if(word & 1)
+        {
+          candidateVoxelLocations[k * m_raycastResultSize + i++] = raycastResultData[voxelIndex].toVector3().toShortRound();
+        }
+      }
+    }
   }
 }
 
@@ -131,4 +192,19 @@ void PerLabelVoxelSampler_CPU::write_sampled_voxel_locations(const ORUtils::Memo
   }
 }
 
+//#################### PRIVATE STATIC MEMBER FUNCTIONS ####################
+
+unsigned int PerLabelVoxelSampler_CPU::count_bits(MaskWord word)
+{
+#if defined(__GNUC__)
+  return static_cast<unsigned int>(__builtin_popcountll(word));
+#else
+  // See "Counting bits set, in parallel" in Sean Eron Anderson's "Bit Twiddling Hacks".
+  word = word - ((word >> 1) & 0x5555555555555555ULL);
+  word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+  word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+  return static_cast<unsigned int>((word * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
 }
@@ -20,6 +20,9 @@
   #pragma warning(default:4267)
 #endif
 
+#include <itmx/base/MemoryBlockFactory.h>
+using itmx::MemoryBlockFactory;
+
 #include "sampling/shared/PerLabelVoxelSampler_Shared.h"
 
 #define DEBUGGING 0
@@ -72,8 +75,18 @@ __global__ void ck_write_candidate_voxel_locations(const Vector4f *raycastResult
 //#################### CONSTRUCTORS ####################
 
 PerLabelVoxelSampler_CUDA::PerLabelVoxelSampler_CUDA(size_t maxLabelCount, size_t maxVoxelsPerLabel, int raycastResultSize, unsigned int seed)
-: PerLabelVoxelSampler(maxLabelCount, maxVoxelsPerLabel, raycastResultSize, seed)
-{}
+: PerLabelVoxelSampler(maxLabelCount, maxVoxelsPerLabel, raycastResultSize, seed),
+  m_voxelMaskPrefixSumsMB(MemoryBlockFactory::instance().make_block<unsigned int>(maxLabelCount * (raycastResultSize + 1))),
+  m_voxelMasksMB(MemoryBlockFactory::instance().make_block<unsigned char>(maxLabelCount * (raycastResultSize + 1)))
+{
+  // Make sure that the dummy elements at the end of the voxel masks for the various labels are properly initialised.
+  unsigned char *voxelMasks = m_voxelMasksMB->GetData(MEMORYDEVICE_CPU);
+  for(size_t k = 1; k <= maxLabelCount; ++k)
+  {
+    voxelMasks[k * (raycastResultSize + 1) - 1] = 0;
+  }
+  m_voxelMasksMB->UpdateDeviceFromHost();
+}
 
 //#################### PRIVATE MEMBER FUNCTIONS ####################
 
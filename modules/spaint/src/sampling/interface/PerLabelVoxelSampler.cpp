@@ -20,18 +20,8 @@ PerLabelVoxelSampler::PerLabelVoxelSampler(size_t maxLabelCount, size_t maxVoxel
   m_maxLabelCount(maxLabelCount),
   m_maxVoxelsPerLabel(maxVoxelsPerLabel),
   m_raycastResultSize(raycastResultSize),
-  m_rng(new tvgutil::RandomNumberGenerator(seed)),
-  m_voxelMaskPrefixSumsMB(MemoryBlockFactory::instance().make_block<unsigned int>(maxLabelCount * (raycastResultSize + 1))),
-  m_voxelMasksMB(MemoryBlockFactory::instance().make_block<unsigned char>(maxLabelCount * (raycastResultSize + 1)))
-{
-  // Make sure that the dummy elements at the end of the voxel masks for the various labels are properly initialised.
-  unsigned char *voxelMasks = m_voxelMasksMB->GetData(MEMORYDEVICE_CPU);
-  for(size_t k = 1; k <= maxLabelCount; ++k)
-  {
-    voxelMasks[k * (raycastResultSize + 1) - 1] = 0;
-  }
-  m_voxelMasksMB->UpdateDeviceFromHost();
-}
+  m_rng(new tvgutil::RandomNumberGenerator(seed))
+{}
 
 //#################### DESTRUCTOR ####################
 
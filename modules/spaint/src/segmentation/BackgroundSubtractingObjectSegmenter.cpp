@@ -5,23 +5,81 @@
 
 #include "segmentation/BackgroundSubtractingObjectSegmenter.h"
 
+#include <algorithm>
 #include <cmath>
 
+#include <boost/optional.hpp>
 #include <boost/serialization/shared_ptr.hpp>
 
 #include <itmx/ocv/OpenCVUtil.h>
 #include <itmx/util/CameraPoseConverter.h>
 using namespace itmx;
 
-#define DEBUGGING 1
+// Note: The debugging windows are shared between all segmenters, their trackbars are bound to the parameters of the most recently
+//       constructed segmenter, and OpenCV's GUI functions are not thread-safe, so debugging should only be enabled when a single
+//       segmenter is in use.
+#define DEBUGGING 0
 
 namespace spaint {
 
 //#################### CONSTRUCTORS ####################
 
 BackgroundSubtractingObjectSegmenter::BackgroundSubtractingObjectSegmenter(const View_CPtr& view, const Settings_CPtr& itmSettings, const TouchSettings_Ptr& touchSettings)
-: Segmenter(view), m_touchDetector(new TouchDetector(view->depth->noDims, itmSettings, touchSettings))
-{}
+: Segmenter(view),
+  m_centreDistThreshold(70),
+  m_depthEdgeThreshold(3),
+  m_handComponentSizeThreshold(100),
+  m_lowerCompactnessThreshold(50),
+  m_lowerDiffThresholdMm(15),
+  m_lowerDiffThresholdNearEdgesMm(100),
+  m_maxContourSizeForBox(1000),
+  m_maxContourSizeForCompactness(800),
+  m_maxIntraClusterDepthDiffMm(5),
+  m_minClusterSize(250),
+  m_minComponentSize(150),
+  m_objectComponentSizeThreshold(1000),
+  m_objectProbThreshold(80),
+  m_removeSmallHandComponents(1),
+  m_touchDetector(new TouchDetector(view->depth->noDims, itmSettings, touchSettings)),
+  m_upperDepthThresholdMm(1000)
+{
+  // Allocate the buffers that will be reused each time the segmenter is run.
+  const Vector2i depthDims = view->depth->noDims, rgbDims = view->rgb->noDims;
+  m_workspace.badContourMask.create(depthDims.y, depthDims.x);
+  m_workspace.camera.reset(new rigging::SimpleCamera(Eigen::Vector3f(0,0,0), Eigen::Vector3f(0,0,1), Eigen::Vector3f(0,-1,0)));
+  m_workspace.changeMask.reset(new ITMUCharImage(depthDims, true, true));
+  m_workspace.contourImage.create(depthDims.y, depthDims.x);
+  m_workspace.cvChangeMask = cv::Mat1b(depthDims.y, depthDims.x, m_workspace.changeMask->GetData(MEMORYDEVICE_CPU));
+  m_workspace.depthRaycast.create(depthDims.y, depthDims.x);
+  m_workspace.depthSortedPixels.reserve(view->depth->dataSize);
+  m_workspace.dilationKernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(7, 7));
+  m_workspace.handMask.create(rgbDims.y, rgbDims.x);
+  m_workspace.objectMask = cv::Mat1b(rgbDims.y, rgbDims.x, m_targetMask->GetData(MEMORYDEVICE_CPU));
+
+#if DEBUGGING
+  // Set up the debugging windows for the change and object masks.
+  const std::string changeMaskWindowName = "Change Mask";
+  cv::namedWindow(changeMaskWindowName, cv::WINDOW_AUTOSIZE);
+  cv::createTrackbar("centreDistThreshold", changeMaskWindowName, &m_centreDistThreshold, 100);
+  cv::createTrackbar("depthEdgeThreshold", changeMaskWindowName, &m_depthEdgeThreshold, 255);
+  cv::createTrackbar("lowerCompactnessThreshold", changeMaskWindowName, &m_lowerCompactnessThreshold, 100);
+  cv::createTrackbar("lowerDiffThresholdMm", changeMaskWindowName, &m_lowerDiffThresholdMm, 100);
+  cv::createTrackbar("lowerDiffThresholdNearEdgesMm", changeMaskWindowName, &m_lowerDiffThresholdNearEdgesMm, 100);
+  cv::createTrackbar("maxContourSizeForBox", changeMaskWindowName, &m_maxContourSizeForBox, 2000);
+  cv::createTrackbar("maxContourSizeForCompactness", changeMaskWindowName, &m_maxContourSizeForCompactness, 2000);
+  cv::createTrackbar("maxIntraClusterDepthDiffMm", changeMaskWindowName, &m_maxIntraClusterDepthDiffMm, 20);
+  cv::createTrackbar("minClusterSize", changeMaskWindowName, &m_minClusterSize, 1000);
+  cv::createTrackbar("minComponentSize", changeMaskWindowName, &m_minComponentSize, 2000);
+  cv::createTrackbar("upperDepthThresholdMm", changeMaskWindowName, &m_upperDepthThresholdMm, 2000);
+
+  const std::string objectMaskWindowName = "Object Mask";
+  cv::namedWindow(objectMaskWindowName, cv::WINDOW_AUTOSIZE);
+  cv::createTrackbar("handComponentSizeThreshold", objectMaskWindowName, &m_handComponentSizeThreshold, 200);
+  cv::createTrackbar("objectComponentSizeThreshold", objectMaskWindowName, &m_objectComponentSizeThreshold, 2000);
+  cv::createTrackbar("objectProbThreshold", objectMaskWindowName, &m_objectProbThreshold, 100);
+  cv::createTrackbar("removeSmallHandComponents", objectMaskWindowName, &m_removeSmallHandComponents, 1);
+#endif
+}
 
 //#################### PUBLIC MEMBER FUNCTIONS ####################
 
@@ -32,27 +90,6 @@ void BackgroundSubtractingObjectSegmenter::reset()
 
 ITMUCharImage_CPtr BackgroundSubtractingObjectSegmenter::segment(const ORUtils::SE3Pose& pose, const RenderState_CPtr& renderState) const
 {
-  // Set up the segmentation parameters.
-  static int handComponentSizeThreshold = 100;
-  static int objectComponentSizeThreshold = 1000;
-  static int objectProbThreshold = 80;
-  static int removeSmallHandComponents = 1;
-
-#if DEBUGGING
-  // Set up the debugging window for the object mask.
-  const std::string debugWindowName = "Object Mask";
-  static bool initialised = false;
-  if(!initialised)
-  {
-    cv::namedWindow(debugWindowName, cv::WINDOW_AUTOSIZE);
-    cv::createTrackbar("handComponentSizeThreshold", debugWindowName, &handComponentSizeThreshold, 200);
-    cv::createTrackbar("objectComponentSizeThreshold", debugWindowName, &objectComponentSizeThreshold, 2000);
-    cv::createTrackbar("objectProbThreshold", debugWindowName, &objectProbThreshold, 100);
-    cv::createTrackbar("removeSmallHandComponents", debugWindowName, &removeSmallHandComponents, 1);
-    initialised = true;
-  }
-#endif
-
   // Copy the current colour and depth input images across to the CPU.
   ITMUChar4Image_CPtr rgbInput(m_view->rgb, boost::serialization::null_deleter());
   rgbInput->UpdateHostFromDevice();
@@ -60,68 +97,55 @@ ITMUCharImage_CPtr BackgroundSubtractingObjectSegmenter::segment(const ORUtils::
   ITMFloatImage_CPtr depthInput(m_view->depth, boost::serialization::null_deleter());
   depthInput->UpdateHostFromDevice();
 
-  // Make the change mask.
+  // Make the change mask. Note that this cannot be fused with the construction of the hand and object masks, since the
+  // later stages of its construction (the removal of small components, the contour analysis and the depth clustering)
+  // each need the whole of the mask produced by the previous stage. For the same reason, each of the three masks needs
+  // its own connected components pass: the change mask's components must be filtered before its contours are found,
+  // and the object mask's components can only be found once any small hand components have been merged back into it.
   ITMUCharImage_CPtr changeMask = make_change_mask(depthInput, pose, renderState);
 
-  // Make the hand mask.
-  static cv::Mat1b handMask = cv::Mat1b::zeros(m_view->rgb->noDims.y, m_view->rgb->noDims.x);
+  // Make the hand and object masks in a single pass over the image: each pixel in the change mask is added
+  // to the hand mask if it is sufficiently likely to be part of the hand, and to the object mask otherwise.
   const Vector4u *rgbPtr = rgbInput->GetData(MEMORYDEVICE_CPU);
   const uchar *changeMaskPtr = changeMask->GetData(MEMORYDEVICE_CPU);
+  uchar *handMaskPtr = m_workspace.handMask.data;
+  uchar *objectMaskPtr = m_workspace.objectMask.data;
+  const float handProbThreshold = (100 - m_objectProbThreshold) / 100.0f;
   const int pixelCount = static_cast<int>(rgbInput->dataSize);
 
-  // For each pixel in the current colour input image:
 #if WITH_OPENMP
   #pragma omp parallel for
 #endif
   for(int i = 0; i < pixelCount; ++i)
   {
-    // Update the hand mask based on whether the pixel is part of the hand.
-    unsigned char value = 0;
+    unsigned char handValue = 0, objectValue = 0;
     if(changeMaskPtr[i])
     {
       float handProb = m_handAppearanceModel ? m_handAppearanceModel->compute_posterior_probability(rgbPtr[i].toVector3()) : 0.0f;
-      int handProbThreshold = 100 - objectProbThreshold;
-
-#if 1
-      if(handProb >= handProbThreshold / 100.0f) value = 255;
-#else
-      // For debugging purposes
-      if(handProb >= handProbThreshold / 100.0f) value = (uchar)(handProb * 255);
-#endif
+      if(handProb >= handProbThreshold) handValue = 255;
+      else objectValue = 255;
     }
 
-    handMask.data[i] = value;
+    handMaskPtr[i] = handValue;
+    objectMaskPtr[i] = objectValue;
   }
 
-  // If desired, update the hand mask to only contain components over a certain size.
-  if(removeSmallHandComponents)
-  {
-    remove_small_components(handMask, handComponentSizeThreshold);
-  }
-
-  // Make the object mask.
-  static cv::Mat1b objectMask = cv::Mat1b::zeros(m_view->rgb->noDims.y, m_view->rgb->noDims.x);
-
-  // Set the object mask to the difference between the change mask and the hand mask.
-#if WITH_OPENMP
-  #pragma omp parallel for
-#endif
-  for(int i = 0; i < pixelCount; ++i)
+  // If desired, remove any small components from the hand mask, adding the pixels concerned back into the object mask.
+  if(m_removeSmallHandComponents)
   {
-    objectMask.data[i] = changeMaskPtr[i] && !handMask.data[i] ? 255 : 0;
+    remove_small_components(m_workspace.handMask, m_handComponentSizeThreshold, &m_workspace.objectMask);
   }
 
   // Update the object mask to only contain components over a certain size.
-  remove_small_components(objectMask, objectComponentSizeThreshold);
+  remove_small_components(m_workspace.objectMask, m_objectComponentSizeThreshold);
 
 #if DEBUGGING
   // Show the debugging window for the object mask.
-  cv::imshow(debugWindowName, objectMask);
+  cv::imshow("Object Mask", m_workspace.objectMask);
   cv::waitKey(10);
 #endif
 
-  // Convert the object mask to InfiniTAM format and return it.
-  std::copy(objectMask.data, objectMask.data + m_view->rgb->dataSize, m_targetMask->GetData(MEMORYDEVICE_CPU));
+  // Since the OpenCV object mask shares its data with the target mask, the target mask is now up-to-date.
   return m_targetMask;
 }
 
@@ -147,44 +171,8 @@ ITMUChar4Image_CPtr BackgroundSubtractingObjectSegmenter::train(const ORUtils::S
 
 ITMUCharImage_CPtr BackgroundSubtractingObjectSegmenter::make_change_mask(const ITMFloatImage_CPtr& depthInput, const ORUtils::SE3Pose& pose, const RenderState_CPtr& renderState) const
 {
-  // Set up the parameters for the change mask.
-  static int centreDistThreshold = 70;            // pixels greater than this percentage distance from the centre of the image will be ignored
-  static int depthEdgeThreshold = 3;              // pixels with values above this will be treated as edges in the gradient magnitude image of the depth raycast
-  static int lowerCompactnessThreshold = 50;      // small components whose compactness is less than this percentage will be ignored
-  static int lowerDiffThresholdMm = 15;           // pixels whose depth difference (in mm) is less than this will be ignored
-  static int lowerDiffThresholdNearEdgesMm = 100; // pixels near depth edges whose depth difference (in mm) is less than this will be ignored
-  static int maxContourSizeForBox = 1000;         // contours that are at most this size will be subjected to a box test
-  static int maxContourSizeForCompactness = 800;  // contours that are at most this size will be subjected to a compactness test
-  static int maxIntraClusterDepthDiffMm = 5;      // the maximum difference in depth to allow between pixels within the same cluster
-  static int minClusterSize = 250;                // clusters of pixels (by depth) that are less than this size will be ignored
-  static int minComponentSize = 150;              // components below this size will be ignored
-  static int upperDepthThresholdMm = 1000;        // pixels whose live depth value (in mm) is greater than this will be ignored
-
-#if DEBUGGING
-  // Set up the debugging window for the change mask.
-  const std::string debugWindowName = "Change Mask";
-  static bool initialised = false;
-  if(!initialised)
-  {
-    cv::namedWindow(debugWindowName, cv::WINDOW_AUTOSIZE);
-    cv::createTrackbar("centreDistThreshold", debugWindowName, &centreDistThreshold, 100);
-    cv::createTrackbar("depthEdgeThreshold", debugWindowName, &depthEdgeThreshold, 255);
-    cv::createTrackbar("lowerCompactnessThreshold", debugWindowName, &lowerCompactnessThreshold, 100);
-    cv::createTrackbar("lowerDiffThresholdMm", debugWindowName, &lowerDiffThresholdMm, 100);
-    cv::createTrackbar("lowerDiffThresholdNearEdgesMm", debugWindowName, &lowerDiffThresholdNearEdgesMm, 100);
-    cv::createTrackbar("maxContourSizeForBox", debugWindowName, &maxContourSizeForBox, 2000);
-    cv::createTrackbar("maxContourSizeForCompactness", debugWindowName, &maxContourSizeForCompactness, 2000);
-    cv::createTrackbar("maxIntraClusterDepthDiffMm", debugWindowName, &maxIntraClusterDepthDiffMm, 20);
-    cv::createTrackbar("minClusterSize", debugWindowName, &minClusterSize, 1000);
-    cv::createTrackbar("minComponentSize", debugWindowName, &minComponentSize, 2000);
-    cv::createTrackbar("upperDepthThresholdMm", debugWindowName, &upperDepthThresholdMm, 2000);
-    initialised = true;
-  }
-#endif
-
   // Run the touch detector.
-  rigging::MoveableCamera_CPtr camera(new rigging::SimpleCamera(CameraPoseConverter::pose_to_camera(pose)));
-  m_touchDetector->determine_touch_points(camera, depthInput, renderState);
+  run_touch_detector(depthInput, pose, renderState);
 
   // Get a thresholded version of the live depth image.
   ITMFloatImage_CPtr thresholdedRawDepth = m_touchDetector->get_thresholded_raw_depth();
@@ -198,26 +186,35 @@ ITMUCharImage_CPtr BackgroundSubtractingObjectSegmenter::make_change_mask(const
 
   // Compute a dilated, thresholded version of the gradient magnitude of the depth raycast.
   const int width = depthRaycast->noDims.x, height = depthRaycast->noDims.y;
-  cv::Mat1b cvDepthRaycast = OpenCVUtil::make_greyscale_image(depthRaycastPtr, width, height, OpenCVUtil::ROW_MAJOR, 100.0f);
-  cv::Mat gradX, gradY, absGradX, absGradY, grad, depthEdges, dilatedDepthEdges;
-  cv::Sobel(cvDepthRaycast, gradX, CV_16S, 1, 0, 3);
-  cv::convertScaleAbs(gradX, absGradX);
-  cv::Sobel(cvDepthRaycast, gradY, CV_16S, 0, 1, 3);
-  cv::convertScaleAbs(gradY, absGradY);
-  cv::addWeighted(absGradX, 0.5, absGradY, 0.5, 0, grad);
-  cv::threshold(grad, depthEdges, depthEdgeThreshold, 255.0, cv::THRESH_BINARY);
-  cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(7, 7));
-  cv::dilate(depthEdges, dilatedDepthEdges, kernel);
+  const int pixelCount = static_cast<int>(depthRaycast->dataSize);
+  Workspace& ws = m_workspace;
+
+#if WITH_OPENMP
+  #pragma omp parallel for
+#endif
+  for(int i = 0; i < pixelCount; ++i)
+  {
+    ws.depthRaycast.data[i] = static_cast<uchar>(CLAMP(depthRaycastPtr[i] * 100.0f, 0.0f, 255.0f));
+  }
+
+  cv::Sobel(ws.depthRaycast, ws.gradX, CV_16S, 1, 0, 3);
+  cv::convertScaleAbs(ws.gradX, ws.absGradX);
+  cv::Sobel(ws.depthRaycast, ws.gradY, CV_16S, 0, 1, 3);
+  cv::convertScaleAbs(ws.gradY, ws.absGradY);
+  cv::addWeighted(ws.absGradX, 0.5, ws.absGradY, 0.5, 0, ws.grad);
+  cv::threshold(ws.grad, ws.depthEdges, m_depthEdgeThreshold, 255.0, cv::THRESH_BINARY);
+  cv::dilate(ws.depthEdges, ws.dilatedDepthEdges, ws.dilationKernel);
+  const uchar *dilatedDepthEdgesPtr = ws.dilatedDepthEdges.data;
 
   // Get the difference between the live depth image and the depth raycast of the scene.
   ITMFloatImage_CPtr diffRawRaycast = m_touchDetector->get_diff_raw_raycast();
   const float *diffRawRaycastPtr = diffRawRaycast->GetData(MEMORYDEVICE_CPU);
 
   // Make an initial change mask, starting from the whole image and filtering out pixels based on some simple criteria.
-  static ITMUCharImage_Ptr changeMask(new ITMUCharImage(Vector2i(width, height), true, true));
-  uchar *changeMaskPtr = changeMask->GetData(MEMORYDEVICE_CPU);
+  // Note that the OpenCV version of the change mask shares its data with the InfiniTAM one, so there is no need to copy it.
+  uchar *changeMaskPtr = ws.changeMask->GetData(MEMORYDEVICE_CPU);
   const double halfWidth = width / 2.0, halfHeight = height / 2.0;
-  const int pixelCount = static_cast<int>(changeMask->dataSize);
+  const float invalidDepthValue = m_touchDetector->invalid_depth_value();
 
 #if WITH_OPENMP
   #pragma omp parallel for
@@ -237,7 +234,7 @@ ITMUCharImage_CPtr BackgroundSubtractingObjectSegmenter::make_change_mask(const
 
     // If the depth raycast value for the pixel is invalid, remove it from the change mask (without a depth raycast value,
     // we can't do background subtraction).
-    if(fabs(depthRaycastPtr[i] - m_touchDetector->invalid_depth_value()) < 1e-3f)
+    if(fabs(depthRaycastPtr[i] - invalidDepthValue) < 1e-3f)
     {
       changeMaskPtr[i] = 0;
       continue;
@@ -245,7 +242,7 @@ ITMUCharImage_CPtr BackgroundSubtractingObjectSegmenter::make_change_mask(const
 
     // If the live depth value for the pixel is too large, remove it from the change mask (the depth gets increasingly
     // unreliable as we get further away from the sensor, so this helps us avoid corrupting our mask with noise).
-    if(thresholdedRawDepthPtr[i] * 1000.0f > upperDepthThresholdMm)
+    if(thresholdedRawDepthPtr[i] * 1000.0f > m_upperDepthThresholdMm)
     {
       changeMaskPtr[i] = 0;
       continue;
@@ -256,7 +253,7 @@ ITMUCharImage_CPtr BackgroundSubtractingObjectSegmenter::make_change_mask(const
     const int x = i % width, y = i / width;
     const double xDist = fabs(x - halfWidth), yDist = fabs(y - halfHeight);
     const double centreDist = sqrt((xDist * xDist + yDist * yDist) / (halfWidth * halfWidth + halfHeight * halfHeight));
-    if(static_cast<int>(centreDist * 100) > centreDistThreshold)
+    if(static_cast<int>(centreDist * 100) > m_centreDistThreshold)
     {
       changeMaskPtr[i] = 0;
       continue;
@@ -265,7 +262,7 @@ ITMUCharImage_CPtr BackgroundSubtractingObjectSegmenter::make_change_mask(const
     // If the difference between the pixel's values in the live depth image and the depth raycast is quite small,
     // remove it from the change mask (this helps exclude minor differences that are caused by sensor noise).
     const float diffRawRaycastMm = diffRawRaycastPtr[i] * 1000.0f;
-    if(diffRawRaycastMm < lowerDiffThresholdMm)
+    if(diffRawRaycastMm < m_lowerDiffThresholdMm)
     {
       changeMaskPtr[i] = 0;
       continue;
@@ -274,48 +271,20 @@ ITMUCharImage_CPtr BackgroundSubtractingObjectSegmenter::make_change_mask(const
     // If the pixel is close to an edge in the depth raycast and there isn't a fairly significant difference between
     // its values in the live depth image and the depth raycast, remove it from the change mask (we insist on a larger
     // difference than normal near depth raycast edges because depth values tend to be unreliable along such boundaries).
-    if(dilatedDepthEdges.data[i] && diffRawRaycastMm < lowerDiffThresholdNearEdgesMm)
+    if(dilatedDepthEdgesPtr[i] && diffRawRaycastMm < m_lowerDiffThresholdNearEdgesMm)
     {
       changeMaskPtr[i] = 0;
       continue;
     }
   }
 
-  // Copy the change mask across to an OpenCV image.
-  static cv::Mat1b cvChangeMask = cv::Mat1b::zeros(height, width);
-
-#if WITH_OPENMP
-  #pragma omp parallel for
-#endif
-  for(int i = 0; i < pixelCount; ++i)
-  {
-    cvChangeMask.data[i] = changeMaskPtr[i];
-  }
-
-  // Find the connected components of the change mask.
-  cv::Mat1i ccsImage, stats;
-  cv::Mat1d centroids;
-  cv::connectedComponentsWithStats(cvChangeMask, ccsImage, stats, centroids);
-
   // Update the change mask to only contain components over a certain size.
-  const int *ccsData = reinterpret_cast<int*>(ccsImage.data);
-
-#if WITH_OPENMP
-  #pragma omp parallel for
-#endif
-  for(int i = 0; i < pixelCount; ++i)
-  {
-    int componentSize = stats(ccsData[i], cv::CC_STAT_AREA);
-    if(componentSize < minComponentSize)
-    {
-      cvChangeMask.data[i] = 0;
-      changeMaskPtr[i] = 0;
-    }
-  }
+  remove_small_components(ws.cvChangeMask, m_minComponentSize);
 
   // Find the contours in the change mask.
-  std::vector<std::vector<cv::Point> > contours;
-  cv::findContours(cvChangeMask.clone(), contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_NONE);
+  const std::vector<std::vector<cv::Point> >& contours = ws.contours;
+  ws.cvChangeMask.copyTo(ws.contourImage);
+  cv::findContours(ws.contourImage, ws.contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_NONE);
 
   // Divide the contours into three sets:
   // - bad contours (small and not compact)
@@ -333,7 +302,7 @@ ITMUCharImage_CPtr BackgroundSubtractingObjectSegmenter::make_change_mask(const
     size_t perimeter = contours[i].size();
     double compactness = 4 * M_PI * area / (perimeter * perimeter);
 
-    if(static_cast<int>(area) <= maxContourSizeForCompactness && static_cast<int>(CLAMP(ROUND(compactness * 100), 0, 100)) < lowerCompactnessThreshold)
+    if(static_cast<int>(area) <= m_maxContourSizeForCompactness && static_cast<int>(CLAMP(ROUND(compactness * 100), 0, 100)) < m_lowerCompactnessThreshold)
     {
       // If the contour is small and not sufficiently compact, add it to the bad contours set.
       badContours.insert(i);
@@ -342,7 +311,7 @@ ITMUCharImage_CPtr BackgroundSubtractingObjectSegmenter::make_change_mask(const
     {
       // Otherwise, add the contour to the large or small contours set based on its size,
       // and update the largest contour and its area as necessary.
-      (area >= maxContourSizeForBox ? largeContours : smallContours).insert(i);
+      (area >= m_maxContourSizeForBox ? largeContours : smallContours).insert(i);
 
       if(area > largestContourArea)
       {
@@ -387,90 +356,73 @@ ITMUCharImage_CPtr BackgroundSubtractingObjectSegmenter::make_change_mask(const
   std::copy(smallContours.begin(), smallContours.end(), std::inserter(badContours, badContours.begin()));
 
   // Make a mask containing all of the bad contours.
-  cv::Mat1b badContourMask = cv::Mat1b::zeros(cvChangeMask.size());
+  ws.badContourMask.setTo(0);
   for(std::set<int>::const_iterator it = badContours.begin(), iend = badContours.end(); it != iend; ++it)
   {
-    cv::drawContours(badContourMask, contours, *it, cv::Scalar(255), cv::FILLED);
+    cv::drawContours(ws.badContourMask, contours, *it, cv::Scalar(255), cv::FILLED);
   }
 
-  // Remove any bad contours from the change mask.
-#if WITH_OPENMP
-  #pragma omp parallel for
-#endif
+  // Cluster the pixels in the change mask by depth, and discard clusters that are below a certain size. To do this, we sort
+  // the pixels by depth, and then split the sorted sequence wherever there is a sufficiently large jump in depth. Note that
+  // the removal of the bad contours from the change mask is fused into the pass that gathers the pixels to be sorted.
+  std::vector<std::pair<float,int> >& depthSortedPixels = ws.depthSortedPixels;
+  depthSortedPixels.clear();
   for(int i = 0; i < pixelCount; ++i)
   {
-    if(badContourMask.data[i])
+    if(ws.badContourMask.data[i])
     {
-      cvChangeMask.data[i] = 0;
       changeMaskPtr[i] = 0;
     }
-  }
-
-  // Cluster the pixels in the change mask by depth, and discard clusters that are below a certain size.
-  std::multimap<float,int> depthToPixels;
-  for(int i = 0; i < pixelCount; ++i)
-  {
-    if(changeMaskPtr[i])
+    else if(changeMaskPtr[i])
     {
-      depthToPixels.insert(std::make_pair(thresholdedRawDepthPtr[i], i));
+      depthSortedPixels.push_back(std::make_pair(thresholdedRawDepthPtr[i], i));
     }
   }
 
-  std::vector<std::vector<int> > clusters;
-  boost::optional<float> lastDepth;
-  for(std::multimap<float,int>::const_iterator it = depthToPixels.begin(), iend = depthToPixels.end(); it != iend; ++it)
+  std::sort(depthSortedPixels.begin(), depthSortedPixels.end());
+
+  for(size_t clusterBegin = 0, size = depthSortedPixels.size(); clusterBegin < size; /* no-op */)
   {
-    float depth = it->first;
-    if(!lastDepth || static_cast<int>(ROUND((depth - *lastDepth) * 1000)) > maxIntraClusterDepthDiffMm)
+    size_t clusterEnd = clusterBegin + 1;
+    while(clusterEnd < size && static_cast<int>(ROUND((depthSortedPixels[clusterEnd].first - depthSortedPixels[clusterEnd - 1].first) * 1000)) <= m_maxIntraClusterDepthDiffMm)
     {
-      clusters.push_back(std::vector<int>());
+      ++clusterEnd;
     }
-    lastDepth = depth;
 
-    clusters.back().push_back(it->second);
-  }
-
-  for(size_t i = 0, clusterCount = clusters.size(); i < clusterCount; ++i)
-  {
-    const std::vector<int>& cluster = clusters[i];
-    const size_t clusterSize = cluster.size();
-
-    if(clusterSize < minClusterSize)
+    if(static_cast<int>(clusterEnd - clusterBegin) < m_minClusterSize)
     {
-      for(size_t j = 0; j < clusterSize; ++j)
+      for(size_t j = clusterBegin; j < clusterEnd; ++j)
       {
-        cvChangeMask.data[cluster[j]] = 0;
-        changeMaskPtr[cluster[j]] = 0;
+        changeMaskPtr[depthSortedPixels[j].second] = 0;
       }
     }
+
+    clusterBegin = clusterEnd;
   }
 
 #if DEBUGGING
   // Show the debugging window for the change mask.
-  OpenCVUtil::show_greyscale_figure(debugWindowName, changeMask->GetData(MEMORYDEVICE_CPU), width, height, OpenCVUtil::ROW_MAJOR);
+  OpenCVUtil::show_greyscale_figure("Change Mask", changeMaskPtr, width, height, OpenCVUtil::ROW_MAJOR);
 #endif
 
-  return changeMask;
+  return ws.changeMask;
 }
 
 ITMUCharImage_CPtr BackgroundSubtractingObjectSegmenter::make_hand_mask(const ITMFloatImage_CPtr& depthInput, const ORUtils::SE3Pose& pose, const RenderState_CPtr& renderState) const
 {
-  rigging::MoveableCamera_CPtr camera(new rigging::SimpleCamera(CameraPoseConverter::pose_to_camera(pose)));
-  m_touchDetector->determine_touch_points(camera, depthInput, renderState);
+  run_touch_detector(depthInput, pose, renderState);
   return m_touchDetector->get_touch_mask();
 }
 
-//#################### PRIVATE STATIC MEMBER FUNCTIONS ####################
-
-void BackgroundSubtractingObjectSegmenter::remove_small_components(cv::Mat1b& mask, int minimumComponentSize)
+void BackgroundSubtractingObjectSegmenter::remove_small_components(cv::Mat1b& mask, int minimumComponentSize, cv::Mat1b *complementMask) const
 {
   // Find the connected components of the mask.
-  cv::Mat1i ccsImage, stats;
-  cv::Mat1d centroids;
-  cv::connectedComponentsWithStats(mask, ccsImage, stats, centroids);
+  cv::connectedComponentsWithStats(mask, m_workspace.components, m_workspace.componentStats, m_workspace.componentCentroids);
 
-  // Update the mask to only contain components over a certain size.
-  const int *ccsData = reinterpret_cast<int*>(ccsImage.data);
+  // Update the mask to only contain components over a certain size, adding any pixels that are removed to the complement mask (if any).
+  const int *ccsData = reinterpret_cast<int*>(m_workspace.components.data);
+  const cv::Mat1i& stats = m_workspace.componentStats;
+  uchar *complementMaskPtr = complementMask ? complementMask->data : NULL;
   const int pixelCount = mask.rows * mask.cols;
 
 #if WITH_OPENMP
@@ -478,12 +430,18 @@ void BackgroundSubtractingObjectSegmenter::remove_small_components(cv::Mat1b& ma
 #endif
   for(int i = 0; i < pixelCount; ++i)
   {
-    int componentSize = stats(ccsData[i], cv::CC_STAT_AREA);
-    if(componentSize < minimumComponentSize)
+    if(mask.data[i] && stats(ccsData[i], cv::CC_STAT_AREA) < minimumComponentSize)
     {
       mask.data[i] = 0;
+      if(complementMaskPtr) complementMaskPtr[i] = 255;
     }
   }
 }
 
+void BackgroundSubtractingObjectSegmenter::run_touch_detector(const ITMFloatImage_CPtr& depthInput, const ORUtils::SE3Pose& pose, const RenderState_CPtr& renderState) const
+{
+  m_workspace.camera->set_from(CameraPoseConverter::pose_to_camera(pose));
+  m_touchDetector->determine_touch_points(m_workspace.camera, depthInput, renderState);
+}
+
 }
@@ -5,71 +5,135 @@
 
 #include "segmentation/ColourAppearanceModel.h"
 
-#include <itmx/util/ColourConversion_Shared.h>
-using namespace itmx;
-
-#include <tvgutil/containers/MapUtil.h>
-using namespace tvgutil;
-
 namespace spaint {
 
 //#################### CONSTRUCTORS ####################
 
 ColourAppearanceModel::ColourAppearanceModel(int binsCb, int binsCr)
-: m_binsCb(binsCb), m_binsCr(binsCr)
-{}
+: m_binsCb(binsCb),
+  m_binsCr(binsCr),
+  m_cbLookup(3 * 256),
+  m_countColourGivenObject(0),
+  m_countColourGivenNotObject(0),
+  m_crLookup(3 * 256),
+  m_histColourGivenObject(binsCb * binsCr, 0),
+  m_histColourGivenNotObject(binsCb * binsCr, 0)
+{
+  // Precompute the contributions of each channel value to the bin coordinates of a colour. The coefficients are those used by
+  // itmx::convert_rgb_to_ycbcr, pre-scaled to map the [0,255] range of Cb and Cr onto the bins of the histogram.
+  const float cbScale = (m_binsCb - 1) / 255.0f;
+  const float crScale = (m_binsCr - 1) / 255.0f;
+  for(int i = 0; i < 256; ++i)
+  {
+    m_cbLookup[i] = (127.5f - 0.169f * i) * cbScale;
+    m_cbLookup[256 + i] = -0.331f * i * cbScale;
+    m_cbLookup[512 + i] = 0.5f * i * cbScale;
+
+    m_crLookup[i] = (127.5f + 0.5f * i) * crScale;
+    m_crLookup[256 + i] = -0.419f * i * crScale;
+    m_crLookup[512 + i] = -0.081f * i * crScale;
+  }
+}
 
 //#################### PUBLIC MEMBER FUNCTIONS ####################
 
 float ColourAppearanceModel::compute_posterior_probability(const Vector3u& rgbColour) const
 {
   // If we haven't yet seen enough training data to successfully build our appearance model, early out.
-  if(!m_pmfColourGivenObject || !m_pmfColourGivenNotObject) return 0.5f;
-
-  /*
-  P(object | colour) =                   P(colour | object) * P(object)
-                       -----------------------------------------------------------------
-                       P(colour | object) * P(object) + P(colour | !object) * P(!object)
-
-  For simplicity, assume that P(object) = P(!object) = 0.5. Then:
+  if(m_posteriors.empty()) return 0.5f;
 
-  P(object | colour) =            P(colour | object)
-                       ----------------------------------------
-                       P(colour | object) + P(colour | !object)
-  */
-  int bin = compute_bin(rgbColour);
-  float colourGivenObject = MapUtil::lookup(m_pmfColourGivenObject->get_masses(), bin, 0.0f);
-  float colourGivenNotObject = MapUtil::lookup(m_pmfColourGivenNotObject->get_masses(), bin, 0.0f);
-  float denom = colourGivenObject + colourGivenNotObject;
-  return denom > 0.0f ? colourGivenObject / denom : 0.5f;
+  return m_posteriors[compute_bin(rgbColour)];
 }
 
 void ColourAppearanceModel::train(const ITMUChar4Image_CPtr& image, const ITMUCharImage_CPtr& objectMask)
 {
-  // Update the likelihood histograms based on the colour image and object mask.
   const Vector4u *imagePtr = image->GetData(MEMORYDEVICE_CPU);
   const uchar *objectMaskPtr = objectMask->GetData(MEMORYDEVICE_CPU);
-  for(int i = 0, size = static_cast<int>(image->dataSize); i < size; ++i)
+  const int binCount = m_binsCb * m_binsCr;
+  const int size = static_cast<int>(image->dataSize);
+
+  // Update the likelihood histograms based on the colour image and object mask. Each thread accumulates its own
+  // pair of histograms over part of the image, after which the per-thread histograms are merged.
+#ifdef WITH_OPENMP
+  #pragma omp parallel
+#endif
   {
-    int bin = compute_bin(imagePtr[i].toVector3());
-    (objectMaskPtr[i] ? m_histColourGivenObject : m_histColourGivenNotObject).add(bin);
+    std::vector<size_t> histColourGivenObject(binCount, 0), histColourGivenNotObject(binCount, 0);
+    size_t countColourGivenObject = 0, countColourGivenNotObject = 0;
+
+#ifdef WITH_OPENMP
+    #pragma omp for nowait
+#endif
+    for(int i = 0; i < size; ++i)
+    {
+      int bin = compute_bin(imagePtr[i].toVector3());
+      if(objectMaskPtr[i])
+      {
+        ++histColourGivenObject[bin];
+        ++countColourGivenObject;
+      }
+      else
+      {
+        ++histColourGivenNotObject[bin];
+        ++countColourGivenNotObject;
+      }
+    }
+
+#ifdef WITH_OPENMP
+    #pragma omp critical
+#endif
+    {
+      for(int bin = 0; bin < binCount; ++bin)
+      {
+        m_histColourGivenObject[bin] += histColourGivenObject[bin];
+        m_histColourGivenNotObject[bin] += histColourGivenNotObject[bin];
+      }
+
+      m_countColourGivenObject += countColourGivenObject;
+      m_countColourGivenNotObject += countColourGivenNotObject;
+    }
   }
 
-  // Update the likelihood PMFs from the histograms.
-  if(m_histColourGivenObject.get_count() > 0) m_pmfColourGivenObject.reset(new ProbabilityMassFunction<int>(m_histColourGivenObject));
-  if(m_histColourGivenNotObject.get_count() > 0) m_pmfColourGivenNotObject.reset(new ProbabilityMassFunction<int>(m_histColourGivenNotObject));
+  // Update the posterior table from the histograms.
+  update_posteriors();
 }
 
 //#################### PRIVATE MEMBER FUNCTIONS ####################
 
 int ColourAppearanceModel::compute_bin(const Vector3u& rgbColour) const
 {
-  Vector3f yccColour = convert_rgb_to_ycbcr(rgbColour);
-  float cbFrac = yccColour.y / 255.0f;
-  float crFrac = yccColour.z / 255.0f;
-  int x = (int)CLAMP(ROUND(cbFrac * (m_binsCb - 1)), 0, m_binsCb - 1);
-  int y = (int)CLAMP(ROUND(crFrac * (m_binsCr - 1)), 0, m_binsCr - 1);
+  float cb = m_cbLookup[rgbColour.r] + m_cbLookup[256 + rgbColour.g] + m_cbLookup[512 + rgbColour.b];
+  float cr = m_crLookup[rgbColour.r] + m_crLookup[256 + rgbColour.g] + m_crLookup[512 + rgbColour.b];
+  int x = (int)CLAMP(ROUND(cb), 0, m_binsCb - 1);
+  int y = (int)CLAMP(ROUND(cr), 0, m_binsCr - 1);
   return y * m_binsCb + x;
 }
 
+void ColourAppearanceModel::update_posteriors()
+{
+  // If we haven't yet seen enough training data to successfully build our appearance model, early out.
+  if(m_countColourGivenObject == 0 || m_countColourGivenNotObject == 0) return;
+
+  /*
+  P(object | colour) =                   P(colour | object) * P(object)
+                       -----------------------------------------------------------------
+                       P(colour | object) * P(object) + P(colour | !object) * P(!object)
+
+  For simplicity, assume that P(object) = P(!object) = 0.5. Then:
+
+  P(object | colour) =            P(colour | object)
+                       ----------------------------------------
+                       P(colour | object) + P(colour | !object)
+  */
+  const int binCount = m_binsCb * m_binsCr;
+  m_posteriors.resize(binCount);
+  for(int bin = 0; bin < binCount; ++bin)
+  {
+    float colourGivenObject = static_cast<float>(m_histColourGivenObject[bin]) / m_countColourGivenObject;
+    float colourGivenNotObject = static_cast<float>(m_histColourGivenNotObject[bin]) / m_countColourGivenNotObject;
+    float denom = colourGivenObject + colourGivenNotObject;
+    m_posteriors[bin] = denom > 0.0f ? colourGivenObject / denom : 0.5f;
+  }
+}
+
 }
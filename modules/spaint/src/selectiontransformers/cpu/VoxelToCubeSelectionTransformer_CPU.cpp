@@ -6,7 +6,57 @@
 #include "selectiontransformers/cpu/VoxelToCubeSelectionTransformer_CPU.h"
 using namespace ITMLib;
 
-#include "selectiontransformers/shared/VoxelToCubeSelectionTransformer_Shared.h"
+#include <algorithm>
+#include <cstring>
+
+#include <boost/cstdint.hpp>
+#include <boost/unordered_map.hpp>
+
+namespace {
+
+//#################### LOCAL FUNCTIONS ####################
+
+/**
+ * \brief Counts the number of bits that are set in a byte.
+ *
+ * \param bits  The byte.
+ * \return      The number of bits that are set in the byte.
+ */
+inline int count_bits(unsigned char bits)
+{
+  int count = 0;
+  for(; bits != 0; bits &= bits - 1) ++count;
+  return count;
+}
+
+/**
+ * \brief Divides one integer by another, rounding the result towards negative infinity.
+ *
+ * \param x The dividend.
+ * \param d The (positive) divisor.
+ * \return  The quotient, rounded towards negative infinity.
+ */
+inline int floor_div(int x, int d)
+{
+  return x >= 0 ? x / d : (x - d + 1) / d;
+}
+
+/**
+ * \brief Makes a key that can be used to look up the voxel block at the specified position.
+ *
+ * \param blockPos  The position of the voxel block (in blocks).
+ * \return          The key.
+ */
+inline boost::uint64_t make_block_key(const Vector3i& blockPos)
+{
+  const int offset = 1 << 20;
+  return
+    (static_cast<boost::uint64_t>(blockPos.z + offset) << 42) |
+    (static_cast<boost::uint64_t>(blockPos.y + offset) << 21) |
+    static_cast<boost::uint64_t>(blockPos.x + offset);
+}
+
+}
 
 namespace spaint {
 
@@ -18,20 +68,152 @@ VoxelToCubeSelectionTransformer_CPU::VoxelToCubeSelectionTransformer_CPU(int rad
 
 //#################### PUBLIC MEMBER FUNCTIONS ####################
 
+size_t VoxelToCubeSelectionTransformer_CPU::compute_output_selection_size(const Selection& inputSelectionMB) const
+{
+  BlockMasks blockMasks;
+  build_block_masks(inputSelectionMB, blockMasks);
+  return count_selected_voxels(blockMasks);
+}
+
 void VoxelToCubeSelectionTransformer_CPU::transform_selection(const Selection& inputSelectionMB, Selection& outputSelectionMB) const
 {
-  const int cubeSideLength = cube_side_length();
-  const int cubeSize = cube_size();
+  BlockMasks blockMasks;
+  build_block_masks(inputSelectionMB, blockMasks);
+  write_selected_voxels(blockMasks, outputSelectionMB);
+}
+
+VoxelToCubeSelectionTransformer_CPU::Selection *VoxelToCubeSelectionTransformer_CPU::transform_selection(const Selection& inputSelectionMB) const
+{
+  BlockMasks blockMasks;
+  build_block_masks(inputSelectionMB, blockMasks);
+
+  Selection *outputSelectionMB = new Selection(count_selected_voxels(blockMasks), MEMORYDEVICE_CPU);
+  write_selected_voxels(blockMasks, *outputSelectionMB);
+  return outputSelectionMB;
+}
+
+//#################### PRIVATE MEMBER FUNCTIONS ####################
+
+void VoxelToCubeSelectionTransformer_CPU::build_block_masks(const Selection& inputSelectionMB, BlockMasks& blockMasks) const
+{
+  std::vector<BlockMask>& masks = blockMasks.masks;
+  masks.clear();
+
+  // The indices of the block masks in masks, indexed by block key.
+  boost::unordered_map<boost::uint64_t,int> maskIndices;
+
   const Vector3s *inputSelection = inputSelectionMB.GetData(MEMORYDEVICE_CPU);
+  const int inputVoxelCount = static_cast<int>(inputSelectionMB.dataSize);
+
+  // Add each cube to the block masks, one row of voxels at a time. Each row of a cube spans at most a few blocks, and the
+  // bits for the part of the row that lies within each block can be set in one go (note that this relies on each voxel
+  // row in a block fitting into a single byte).
+  for(int i = 0; i < inputVoxelCount; ++i)
+  {
+    const Vector3i centre = inputSelection[i].toInt();
+    const Vector3i minVoxel(centre.x - m_radius, centre.y - m_radius, centre.z - m_radius);
+    const Vector3i maxVoxel(centre.x + m_radius, centre.y + m_radius, centre.z + m_radius);
+    const int minBlockX = floor_div(minVoxel.x, SDF_BLOCK_SIZE), maxBlockX = floor_div(maxVoxel.x, SDF_BLOCK_SIZE);
+
+    for(int z = minVoxel.z; z <= maxVoxel.z; ++z)
+    {
+      const int blockZ = floor_div(z, SDF_BLOCK_SIZE);
+      for(int y = minVoxel.y; y <= maxVoxel.y; ++y)
+      {
+        const int blockY = floor_div(y, SDF_BLOCK_SIZE);
+        const int rowIndex = (y - blockY * SDF_BLOCK_SIZE) + (z - blockZ * SDF_BLOCK_SIZE) * SDF_BLOCK_SIZE;
+
+        for(int blockX = minBlockX; blockX <= maxBlockX; ++blockX)
+        {
+          // Look up the mask for the block, adding an empty one if necessary.
+          const Vector3i blockPos(blockX, blockY, blockZ);
+          std::pair<boost::unordered_map<boost::uint64_t,int>::iterator,bool> result =
+            maskIndices.insert(std::make_pair(make_block_key(blockPos), static_cast<int>(masks.size())));
+          if(result.second)
+          {
+            BlockMask blockMask;
+            blockMask.blockPos = blockPos;
+            memset(blockMask.rows, 0, sizeof(blockMask.rows));
+            masks.push_back(blockMask);
+          }
+
+          // Set the bits for the part of the row that lies within the block.
+          const int lo = std::max(minVoxel.x - blockX * SDF_BLOCK_SIZE, 0);
+          const int hi = std::min(maxVoxel.x - blockX * SDF_BLOCK_SIZE, SDF_BLOCK_SIZE - 1);
+          masks[result.first->second].rows[rowIndex] |= static_cast<unsigned char>(((1 << (hi + 1)) - 1) & ~((1 << lo) - 1));
+        }
+      }
+    }
+  }
+
+  // Count the selected voxels in each block.
+  const int blockCount = static_cast<int>(masks.size());
+  std::vector<int>& voxelCounts = blockMasks.voxelCounts;
+  voxelCounts.resize(blockCount);
+
+#ifdef WITH_OPENMP
+  #pragma omp parallel for
+#endif
+  for(int i = 0; i < blockCount; ++i)
+  {
+    int count = 0;
+    for(int j = 0; j < SDF_BLOCK_SIZE * SDF_BLOCK_SIZE; ++j)
+    {
+      count += count_bits(masks[i].rows[j]);
+    }
+    voxelCounts[i] = count;
+  }
+}
+
+//#################### PRIVATE STATIC MEMBER FUNCTIONS ####################
+
+size_t VoxelToCubeSelectionTransformer_CPU::count_selected_voxels(const BlockMasks& blockMasks)
+{
+  size_t selectedVoxelCount = 0;
+  for(size_t i = 0, size = blockMasks.voxelCounts.size(); i < size; ++i)
+  {
+    selectedVoxelCount += blockMasks.voxelCounts[i];
+  }
+
+  return selectedVoxelCount;
+}
+
+void VoxelToCubeSelectionTransformer_CPU::write_selected_voxels(const BlockMasks& blockMasks, Selection& outputSelectionMB)
+{
+  // Compute the offset in the output selection at which to write the selected voxels from each block.
+  const int blockCount = static_cast<int>(blockMasks.masks.size());
+  std::vector<int> blockOffsets(blockCount);
+  for(int i = 0, offset = 0; i < blockCount; ++i)
+  {
+    blockOffsets[i] = offset;
+    offset += blockMasks.voxelCounts[i];
+  }
+
+  // Write the selected voxels from each block to the output selection, in the order of their linear indices within the block.
   Vector3s *outputSelection = outputSelectionMB.GetData(MEMORYDEVICE_CPU);
-  int outputVoxelCount = static_cast<int>(outputSelectionMB.dataSize);
 
 #ifdef WITH_OPENMP
   #pragma omp parallel for
 #endif
-  for(int outputVoxelIndex = 0; outputVoxelIndex < outputVoxelCount; ++outputVoxelIndex)
+  for(int i = 0; i < blockCount; ++i)
   {
-    write_voxel_to_output_selection(outputVoxelIndex, cubeSideLength, cubeSize, m_radius, inputSelection, outputSelection);
+    const BlockMask& blockMask = blockMasks.masks[i];
+    const Vector3i blockOrigin = blockMask.blockPos * SDF_BLOCK_SIZE;
+    Vector3s *output = outputSelection + blockOffsets[i];
+
+    for(int z = 0; z < SDF_BLOCK_SIZE; ++z)
+    {
+      for(int y = 0; y < SDF_BLOCK_SIZE; ++y)
+      {
+        const unsigned char row = blockMask.rows[y + z * SDF_BLOCK_SIZE];
+        if(row == 0) continue;
+
+        for(int x = 0; x < SDF_BLOCK_SIZE; ++x)
+        {
+          if(row & (1 << x)) *output++ = Vector3s(blockOrigin.x + x, blockOrigin.y + y, blockOrigin.z + z);
+        }
+      }
+    }
   }
 }
 
@@ -11,8 +11,28 @@ using namespace ORUtils;
 
 namespace spaint {
 
+//#################### CONSTRUCTORS ####################
+
+SLAMState::SLAMState()
+: m_sceneChangeCount(0)
+{}
+
 //#################### PUBLIC MEMBER FUNCTIONS ####################
 
+size_t SLAMState::get_block_fusion_count(const Vector3s& voxelLocation) const
+{
+  // Determine the position of the voxel block containing the voxel (rounding towards negative infinity).
+  Vector3s blockPos;
+  for(int i = 0; i < 3; ++i)
+  {
+    const int x = voxelLocation[i];
+    blockPos[i] = static_cast<short>(x >= 0 ? x / SDF_BLOCK_SIZE : (x - SDF_BLOCK_SIZE + 1) / SDF_BLOCK_SIZE);
+  }
+
+  boost::unordered_map<boost::uint64_t,size_t>::const_iterator it = m_blockFusionCounts.find(make_block_key(blockPos));
+  return it != m_blockFusionCounts.end() ? it->second : 0;
+}
+
 const Vector2i& SLAMState::get_depth_image_size() const
 {
   return m_inputRawDepthImage->noDims;
@@ -77,6 +97,11 @@ const Vector2i& SLAMState::get_rgb_image_size() const
   return m_inputRGBImage->noDims;
 }
 
+size_t SLAMState::get_scene_change_count() const
+{
+  return m_sceneChangeCount;
+}
+
 const SpaintSurfelScene_Ptr& SLAMState::get_surfel_scene()
 {
   return m_surfelScene;
@@ -117,6 +142,21 @@ SpaintVoxelScene_CPtr SLAMState::get_voxel_scene() const
   return m_voxelScene;
 }
 
+void SLAMState::note_blocks_fused(const ORUtils::MemoryBlock<Vector3s>& blockPositionsMB)
+{
+  const Vector3s *blockPositions = blockPositionsMB.GetData(MEMORYDEVICE_CPU);
+  for(size_t i = 0, size = blockPositionsMB.dataSize; i < size; ++i)
+  {
+    ++m_blockFusionCounts[make_block_key(blockPositions[i])];
+  }
+}
+
+void SLAMState::note_scene_changed()
+{
+  ++m_sceneChangeCount;
+  m_blockFusionCounts.clear();
+}
+
 void SLAMState::set_input_mask(const ITMUCharImage_Ptr& inputMask)
 {
   m_inputMask = inputMask;
@@ -165,6 +205,7 @@ void SLAMState::set_view(ITMLib::ITMView *view)
 void SLAMState::set_voxel_scene(const SpaintVoxelScene_Ptr& voxelScene)
 {
   m_voxelScene = voxelScene;
+  note_scene_changed();
 }
 
 void SLAMState::update_fiducials(const std::map<std::string,FiducialMeasurement>& measurements)
@@ -185,4 +226,14 @@ void SLAMState::update_fiducials(const std::map<std::string,FiducialMeasurement>
   }
 }
 
+
+//#################### PRIVATE STATIC MEMBER FUNCTIONS ####################
+
+boost::uint64_t SLAMState::make_block_key(const Vector3s& blockPos)
+{
+  return (static_cast<boost::uint64_t>(static_cast<unsigned short>(blockPos.x)) << 32) |
+         (static_cast<boost::uint64_t>(static_cast<unsigned short>(blockPos.y)) << 16) |
+         static_cast<boost::uint64_t>(static_cast<unsigned short>(blockPos.z));
+}
+
 }
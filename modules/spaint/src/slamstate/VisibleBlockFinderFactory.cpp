@@ -0,0 +1,39 @@
+/**
+ * spaint: VisibleBlockFinderFactory.cpp
+ * Copyright (c) Torr Vision Group, University of Oxford, 2017. All rights reserved.
+ */
+
+#include "slamstate/VisibleBlockFinderFactory.h"
+
+#include "slamstate/cpu/VisibleBlockFinder_CPU.h"
+
+#ifdef WITH_CUDA
+#include "slamstate/cuda/VisibleBlockFinder_CUDA.h"
+#endif
+
+namespace spaint {
+
+//#################### PUBLIC STATIC MEMBER FUNCTIONS ####################
+
+VisibleBlockFinder_CPtr VisibleBlockFinderFactory::make_visible_block_finder(DeviceType deviceType)
+{
+  VisibleBlockFinder_CPtr finder;
+
+  if(deviceType == DEVICE_CUDA)
+  {
+#ifdef WITH_CUDA
+    finder.reset(new VisibleBlockFinder_CUDA);
+#else
+    // This should never happen as things stand - we set deviceType to DEVICE_CPU if CUDA support isn't available.
+    throw std::runtime_error("Error: CUDA support not currently available. Reconfigure in CMake with the WITH_CUDA option set to on.");
+#endif
+  }
+  else
+  {
+    finder.reset(new VisibleBlockFinder_CPU);
+  }
+
+  return finder;
+}
+
+}
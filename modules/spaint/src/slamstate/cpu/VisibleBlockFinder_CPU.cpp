@@ -0,0 +1,33 @@
+/**
+ * spaint: VisibleBlockFinder_CPU.cpp
+ * Copyright (c) Torr Vision Group, University of Oxford, 2017. All rights reserved.
+ */
+
+#include "slamstate/cpu/VisibleBlockFinder_CPU.h"
+using namespace ITMLib;
+
+#include "slamstate/shared/VisibleBlockFinder_Shared.h"
+
+namespace spaint {
+
+//#################### PUBLIC MEMBER FUNCTIONS ####################
+
+void VisibleBlockFinder_CPU::find_visible_blocks(const SpaintVoxelScene *scene, const ITMRenderState_VH *renderState, ORUtils::MemoryBlock<Vector3s>& blockPositionsMB) const
+{
+  const int visibleBlockCount = renderState->noVisibleEntries;
+  const int *visibleEntryIDs = renderState->GetVisibleEntryIDs();
+  const ITMVoxelIndex::IndexData *hashTable = scene->index.getIndexData();
+  Vector3s *blockPositions = blockPositionsMB.GetData(MEMORYDEVICE_CPU);
+
+#ifdef WITH_OPENMP
+  #pragma omp parallel for
+#endif
+  for(int i = 0; i < visibleBlockCount; ++i)
+  {
+    write_visible_block_position(i, visibleEntryIDs, hashTable, blockPositions);
+  }
+
+  blockPositionsMB.dataSize = visibleBlockCount;
+}
+
+}
@@ -0,0 +1,42 @@
+/**
+ * spaint: VisibleBlockFinder_CUDA.cu
+ * Copyright (c) Torr Vision Group, University of Oxford, 2017. All rights reserved.
+ */
+
+#include "slamstate/cuda/VisibleBlockFinder_CUDA.h"
+using namespace ITMLib;
+
+#include "slamstate/shared/VisibleBlockFinder_Shared.h"
+
+namespace spaint {
+
+//#################### CUDA KERNELS ####################
+
+__global__ void ck_find_visible_blocks(const int *visibleEntryIDs, int visibleBlockCount, const ITMVoxelIndex::IndexData *hashTable, Vector3s *blockPositions)
+{
+  int tid = blockDim.x * blockIdx.x + threadIdx.x;
+  if(tid < visibleBlockCount) write_visible_block_position(tid, visibleEntryIDs, hashTable, blockPositions);
+}
+
+//#################### PUBLIC MEMBER FUNCTIONS ####################
+
+void VisibleBlockFinder_CUDA::find_visible_blocks(const SpaintVoxelScene *scene, const ITMRenderState_VH *renderState, ORUtils::MemoryBlock<Vector3s>& blockPositionsMB) const
+{
+  const int visibleBlockCount = renderState->noVisibleEntries;
+  if(visibleBlockCount > 0)
+  {
+    int threadsPerBlock = 256;
+    int numBlocks = (visibleBlockCount + threadsPerBlock - 1) / threadsPerBlock;
+
+    ck_find_visible_blocks<<<numBlocks,threadsPerBlock>>>(
+      renderState->GetVisibleEntryIDs(),
+      visibleBlockCount,
+      scene->index.getIndexData(),
+      blockPositionsMB.GetData(MEMORYDEVICE_CUDA)
+    );
+  }
+
+  blockPositionsMB.dataSize = visibleBlockCount;
+}
+
+}
@@ -63,15 +63,20 @@ const std::string& TouchSettings::get_save_candidate_components_path() const
   return saveCandidateComponentsPath;
 }
 
-TouchSettings::RF_Ptr TouchSettings::load_forest() const
+TouchSettings::FRF_CPtr TouchSettings::load_forest() const
 {
-  // Register the relevant decision function generators with the factory.
+  // If the file contains a flat forest, load it directly.
+  if(rafl::FlatRandomForestFormat::is_flat_forest_file(fullForestPath.string()))
+  {
+    return FRF_CPtr(new FRF(fullForestPath.string()));
+  }
+
+  // Otherwise, register the relevant decision function generators with the factory.
   rafl::DecisionFunctionGeneratorFactory<Label>::instance().register_rafl_makers();
 
-  // Load the forest.
+  // Load the forest, and flatten it.
   RF_Ptr forest = SerializationUtil::load_text(fullForestPath.string(), forest);
-
-  return forest;
+  return FRF_CPtr(new FRF(*forest));
 }
 
 bool TouchSettings::should_save_candidate_components() const
@@ -5,6 +5,8 @@
 
 #include "visualisation/VisualisationGenerator.h"
 
+#include <algorithm>
+
 #include <ITMLib/Engines/Visualisation/ITMSurfelVisualisationEngineFactory.h>
 #include <ITMLib/Engines/Visualisation/ITMVisualisationEngineFactory.h>
 using namespace ITMLib;
@@ -16,6 +18,7 @@ using namespace ITMLib;
 using namespace itmx;
 using namespace rigging;
 
+#include "imageprocessing/NativeMedianFilterer.h"
 #include "visualisation/SemanticVisualiserFactory.h"
 
 namespace spaint {
@@ -25,7 +28,7 @@ namespace spaint {
 VisualisationGenerator::VisualisationGenerator(const Settings_CPtr& settings, const LabelManager_CPtr& labelManager,
                                                const VoxelVisualisationEngine_CPtr& voxelVisualisationEngine,
                                                const SurfelVisualisationEngine_CPtr& surfelVisualisationEngine)
-: m_depthVisualiser(DepthVisualiserFactory::make_depth_visualiser(settings->deviceType)), m_settings(settings)
+: m_depthVisualiser(DepthVisualiserFactory::make_depth_visualiser(settings->deviceType)), m_settings(settings), m_sharingRaycasts(false)
 {
   if(labelManager)
   {
@@ -42,6 +45,18 @@ VisualisationGenerator::VisualisationGenerator(const Settings_CPtr& settings, co
 
 //#################### PUBLIC MEMBER FUNCTIONS ####################
 
+void VisualisationGenerator::begin_raycast_sharing() const
+{
+  m_sharedRaycasts.clear();
+  m_sharingRaycasts = true;
+}
+
+void VisualisationGenerator::end_raycast_sharing() const
+{
+  m_sharedRaycasts.clear();
+  m_sharingRaycasts = false;
+}
+
 void VisualisationGenerator::generate_depth_from_voxels(const ITMFloatImage_Ptr& output, const SpaintVoxelScene_CPtr& scene, const ORUtils::SE3Pose& pose,
                                                         const ITMIntrinsics& intrinsics, VoxelRenderState_Ptr& renderState, DepthVisualiser::DepthType depthType) const
 {
@@ -127,21 +142,22 @@ void VisualisationGenerator::generate_voxel_visualisation(const ITMUChar4Image_P
 
   if(!renderState) renderState.reset(ITMRenderStateFactory<ITMVoxelIndex>::CreateRenderState(output->noDims, scene->sceneParams, m_settings->GetMemoryType()));
 
-  m_voxelVisualisationEngine->FindVisibleBlocks(scene.get(), &pose, &intrinsics, renderState.get());
-  m_voxelVisualisationEngine->CreateExpectedDepths(scene.get(), &pose, &intrinsics, renderState.get());
+  // Raycast the scene (or reuse an existing raycast of it from the same viewpoint), and then shade the raycast result.
+  ensure_voxel_raycast(scene, pose, intrinsics, renderState);
+  const IITMVisualisationEngine::RenderRaycastSelection raycastType = IITMVisualisationEngine::RENDER_FROM_OLD_RAYCAST;
 
   switch(visualisationType)
   {
     case VT_SCENE_COLOUR:
     {
       m_voxelVisualisationEngine->RenderImage(scene.get(), &pose, &intrinsics, renderState.get(), renderState->raycastImage,
-                                              ITMLib::IITMVisualisationEngine::RENDER_COLOUR_FROM_VOLUME);
+                                              ITMLib::IITMVisualisationEngine::RENDER_COLOUR_FROM_VOLUME, raycastType);
       break;
     }
     case VT_SCENE_NORMAL:
     {
       m_voxelVisualisationEngine->RenderImage(scene.get(), &pose, &intrinsics, renderState.get(), renderState->raycastImage,
-                                              ITMLib::IITMVisualisationEngine::RENDER_COLOUR_FROM_NORMAL);
+                                              ITMLib::IITMVisualisationEngine::RENDER_COLOUR_FROM_NORMAL, raycastType);
       break;
     }
     case VT_SCENE_SEMANTICCOLOUR:
@@ -158,7 +174,6 @@ void VisualisationGenerator::generate_voxel_visualisation(const ITMUChar4Image_P
       else if(visualisationType == VT_SCENE_SEMANTICPHONG) lightingType = LT_PHONG;
 
       float labelAlpha = visualisationType == VT_SCENE_SEMANTICCOLOUR ? 0.4f : 1.0f;
-      m_voxelVisualisationEngine->FindSurface(scene.get(), &pose, &intrinsics, renderState.get());
       m_semanticVisualiser->render(scene.get(), &pose, &intrinsics, renderState.get(), labelColours, lightingType, labelAlpha, renderState->raycastImage);
       break;
     }
@@ -166,7 +181,7 @@ void VisualisationGenerator::generate_voxel_visualisation(const ITMUChar4Image_P
     default:
     {
       m_voxelVisualisationEngine->RenderImage(scene.get(), &pose, &intrinsics, renderState.get(), renderState->raycastImage,
-                                              ITMLib::IITMVisualisationEngine::RENDER_SHADED_GREYSCALE);
+                                              ITMLib::IITMVisualisationEngine::RENDER_SHADED_GREYSCALE, raycastType);
       break;
     }
   }
@@ -200,13 +215,73 @@ bool VisualisationGenerator::supports_semantics() const
 
 //#################### PRIVATE MEMBER FUNCTIONS ####################
 
+void VisualisationGenerator::ensure_voxel_raycast(const SpaintVoxelScene_CPtr& scene, const ORUtils::SE3Pose& pose, const ITMIntrinsics& intrinsics,
+                                                  const VoxelRenderState_Ptr& renderState) const
+{
+  const Vector2i& imageSize = renderState->raycastResult->noDims;
+  const Matrix4f poseMatrix = pose.GetM();
+  const Vector4f& projectionParams = intrinsics.projectionParamsSimple.all;
+
+  if(m_sharingRaycasts)
+  {
+    // Look for an existing raycast of the scene from the same viewpoint.
+    for(std::vector<SharedRaycast>::const_iterator it = m_sharedRaycasts.begin(), iend = m_sharedRaycasts.end(); it != iend; ++it)
+    {
+      if(it->scene == scene.get() && it->imageSize == imageSize && it->projectionParams == projectionParams &&
+         std::equal(poseMatrix.m, poseMatrix.m + 16, it->poseMatrix.m))
+      {
+        // If there is one, copy its result into the render state (unless it is already there) and early out.
+        if(it->renderState != renderState)
+        {
+          renderState->raycastResult->SetFrom(
+            it->renderState->raycastResult,
+            m_settings->deviceType == DEVICE_CUDA ? ORUtils::MemoryBlock<Vector4f>::CUDA_TO_CUDA : ORUtils::MemoryBlock<Vector4f>::CPU_TO_CPU
+          );
+        }
+        return;
+      }
+    }
+  }
+
+  // Raycast the scene.
+  m_voxelVisualisationEngine->FindVisibleBlocks(scene.get(), &pose, &intrinsics, renderState.get());
+  m_voxelVisualisationEngine->CreateExpectedDepths(scene.get(), &pose, &intrinsics, renderState.get());
+  m_voxelVisualisationEngine->FindSurface(scene.get(), &pose, &intrinsics, renderState.get());
+
+  if(m_sharingRaycasts)
+  {
+    // Forget any raycast previously recorded for the render state (since its result has now been overwritten), and record the new one.
+    for(size_t i = 0; i < m_sharedRaycasts.size();)
+    {
+      if(m_sharedRaycasts[i].renderState == renderState) m_sharedRaycasts.erase(m_sharedRaycasts.begin() + i);
+      else ++i;
+    }
+
+    SharedRaycast sharedRaycast;
+    sharedRaycast.imageSize = imageSize;
+    sharedRaycast.poseMatrix = poseMatrix;
+    sharedRaycast.projectionParams = projectionParams;
+    sharedRaycast.renderState = renderState;
+    sharedRaycast.scene = scene.get();
+    m_sharedRaycasts.push_back(sharedRaycast);
+  }
+}
+
 void VisualisationGenerator::make_postprocessed_cpu_copy(const ITMUChar4Image *inputRaycast, const boost::optional<Postprocessor>& postprocessor,
                                                          const ITMUChar4Image_Ptr& outputRaycast) const
 {
   // Make sure that the output raycast is of the right size.
   prepare_to_copy_visualisation(inputRaycast->noDims, outputRaycast);
 
-  if(postprocessor)
+  // If the post-processor is a native median filterer, fuse the copy and the filtering by filtering the CPU copy of the
+  // input raycast directly into the output raycast (if we're in CPU mode, the update of the input raycast is a no-op).
+  const NativeMedianFilterer *nativeMedianFilterer = postprocessor ? postprocessor->target<NativeMedianFilterer>() : NULL;
+  if(nativeMedianFilterer)
+  {
+    inputRaycast->UpdateHostFromDevice();
+    nativeMedianFilterer->filter_on_cpu(inputRaycast, outputRaycast.get());
+  }
+  else if(postprocessor)
   {
     // Copy the input raycast to the output raycast on the relevant device (e.g. on the GPU, if that's where the input currently resides).
     outputRaycast->SetFrom(
@@ -209,7 +209,7 @@ public:
    *   - !empty()
    * \return As described
    */
-  Element top()
+  Element top() const
   {
     return m_heap[0];
   }
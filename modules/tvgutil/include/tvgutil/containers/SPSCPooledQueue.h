@@ -0,0 +1,334 @@
+/**
+ * tvgutil: SPSCPooledQueue.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2017. All rights reserved.
+ */
+
+#ifndef H_TVGUTIL_SPSCPOOLEDQUEUE
+#define H_TVGUTIL_SPSCPOOLEDQUEUE
+
+#include <stdexcept>
+#include <vector>
+
+#include <boost/atomic.hpp>
+#include <boost/functional/value_factory.hpp>
+#include <boost/optional.hpp>
+#include <boost/thread.hpp>
+
+#include "PooledQueue.h"
+
+namespace tvgutil {
+
+/**
+ * \brief An instance of an instantiation of this class template represents a single-producer, single-consumer queue that is backed by a pool of reusable elements.
+ *
+ * The queue has the same interface as PooledQueue (begin_push, peek, pop, etc.), but may only be used by one producer thread (which
+ * calls begin_push) and one consumer thread (which calls peek and pop) at a time. In exchange for this restriction, it is implemented
+ * as a ring buffer whose slots double as the pool, and neither pushing nor popping takes a lock or allocates memory unless a thread
+ * actually has to block (i.e. the consumer waits for the queue to become non-empty, or the producer waits for a free slot).
+ *
+ * Since the producer cannot safely remove elements from the queue, and since the ring buffer has a fixed size, only the 'discard'
+ * and 'wait' pool empty strategies are supported.
+ */
+template <typename T>
+class SPSCPooledQueue
+{
+  //#################### NESTED TYPES ####################
+public:
+  /**
+   * \brief An instance of this class can be used to handle the process of pushing an element onto the queue.
+   *
+   * Unlike PooledQueue::PushHandler, this is returned by value (to avoid a heap allocation per push). Copying a push handler transfers
+   * the responsibility for completing the push to the copy. For source compatibility with PooledQueue, push handlers provide operator->
+   * and the PushHandler_Ptr typedef refers to the handler type itself, so that "PushHandler_Ptr h = q.begin_push(); h->get()" works
+   * for both kinds of queue.
+   */
+  class PushHandler
+  {
+    //~~~~~~~~~~~~~~~~~~~~ PRIVATE VARIABLES ~~~~~~~~~~~~~~~~~~~~
+  private:
+    /** Whether or not this handler is still responsible for completing the push. */
+    mutable bool m_active;
+
+    /** A pointer to the queue on which push was called. */
+    SPSCPooledQueue<T> *m_base;
+
+    /** A pointer to the element that is to be pushed onto the queue (if any). */
+    T *m_elt;
+
+    //~~~~~~~~~~~~~~~~~~~~ CONSTRUCTORS ~~~~~~~~~~~~~~~~~~~~
+  public:
+    /**
+     * \brief Constructs a push handler.
+     *
+     * \param base  A pointer to the queue on which push was called.
+     * \param elt   A pointer to the element that is to be pushed onto the queue (if any).
+     */
+    PushHandler(SPSCPooledQueue<T> *base, T *elt)
+    : m_active(true), m_base(base), m_elt(elt)
+    {}
+
+    /**
+     * \brief Copies a push handler, transferring the responsibility for completing the push to the copy.
+     *
+     * \param rhs The push handler to copy.
+     */
+    PushHandler(const PushHandler& rhs)
+    : m_active(rhs.m_active), m_base(rhs.m_base), m_elt(rhs.m_elt)
+    {
+      rhs.m_active = false;
+    }
+
+    //~~~~~~~~~~~~~~~~~~~~ DESTRUCTOR ~~~~~~~~~~~~~~~~~~~~
+  public:
+    /**
+     * \brief Completes the push by pushing the element (if any) onto the queue.
+     */
+    ~PushHandler()
+    {
+      if(m_active && m_elt) m_base->end_push();
+    }
+
+    //~~~~~~~~~~~~~~~~~~~~ ASSIGNMENT OPERATOR ~~~~~~~~~~~~~~~~~~~~
+  private:
+    // Deliberately private and unimplemented.
+    PushHandler& operator=(const PushHandler&);
+
+    //~~~~~~~~~~~~~~~~~~~~ PUBLIC OPERATORS ~~~~~~~~~~~~~~~~~~~~
+  public:
+    /**
+     * \brief Allows the push handler to be used with the same syntax as a PooledQueue::PushHandler_Ptr.
+     *
+     * \return  A pointer to the push handler itself.
+     */
+    PushHandler *operator->()
+    {
+      return this;
+    }
+
+    //~~~~~~~~~~~~~~~~~~~~ PUBLIC MEMBER FUNCTIONS ~~~~~~~~~~~~~~~~~~~~
+  public:
+    /**
+     * \brief Gets a reference to the element that is to be pushed onto the queue (if any).
+     *
+     * \return  A reference to the element that is to be pushed onto the queue (if any).
+     */
+    boost::optional<T&> get()
+    {
+      return m_elt ? boost::optional<T&>(*m_elt) : boost::none;
+    }
+  };
+
+  //#################### TYPEDEFS ####################
+public:
+  typedef PushHandler PushHandler_Ptr;
+
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** Whether or not the consumer is (about to start) waiting for the queue to become non-empty. */
+  mutable boost::atomic<bool> m_consumerWaiting;
+
+  /** The total number of elements that have ever been popped from the queue (the first element in the queue is at this index modulo the capacity). */
+  boost::atomic<size_t> m_head;
+
+  /** The mutex used when a thread needs to block. */
+  mutable boost::mutex m_mutex;
+
+  /** A strategy specifying what should happen when a push is attempted while the pool is empty. */
+  pooled_queue::PoolEmptyStrategy m_poolEmptyStrategy;
+
+  /** A condition variable used to wait for the pool to become non-empty. */
+  boost::condition_variable m_poolNonEmpty;
+
+  /** Whether or not the producer is (about to start) waiting for the pool to become non-empty. */
+  boost::atomic<bool> m_producerWaiting;
+
+  /** A condition variable used to wait for the queue to become non-empty. */
+  mutable boost::condition_variable m_queueNonEmpty;
+
+  /** The slots of the ring buffer (those that are not currently in the queue form the pool). */
+  std::vector<T> m_slots;
+
+  /** The total number of elements that have ever been pushed onto the queue (the next element will be written at this index modulo the capacity). */
+  boost::atomic<size_t> m_tail;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs a single-producer, single-consumer pooled queue.
+   *
+   * \param poolEmptyStrategy   A strategy specifying what should happen when a push is attempted while the pool is empty.
+   * \throws std::runtime_error If the pool empty strategy is not supported by this kind of queue.
+   */
+  explicit SPSCPooledQueue(pooled_queue::PoolEmptyStrategy poolEmptyStrategy = pooled_queue::PES_DISCARD)
+  : m_consumerWaiting(false), m_head(0), m_poolEmptyStrategy(poolEmptyStrategy), m_producerWaiting(false), m_tail(0)
+  {
+    if(poolEmptyStrategy != pooled_queue::PES_DISCARD && poolEmptyStrategy != pooled_queue::PES_WAIT)
+    {
+      throw std::runtime_error("Error: Single-producer, single-consumer pooled queues only support the 'discard' and 'wait' pool empty strategies");
+    }
+  }
+
+  //#################### COPY CONSTRUCTOR & ASSIGNMENT OPERATOR ####################
+private:
+  // Deliberately private and unimplemented.
+  SPSCPooledQueue(const SPSCPooledQueue&);
+  SPSCPooledQueue& operator=(const SPSCPooledQueue&);
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Starts a push operation (this must only be called from the producer thread).
+   *
+   * See PooledQueue::begin_push for details of how push operations work.
+   *
+   * \return  A push handler that will handle the process of pushing an element onto the queue.
+   */
+  PushHandler begin_push()
+  {
+    const size_t tail = m_tail.load(boost::memory_order_relaxed);
+
+    // If there are no free slots, either discard the new element or wait for the consumer to pop an element, as appropriate.
+    if(tail - m_head.load(boost::memory_order_acquire) >= m_slots.size())
+    {
+      if(m_poolEmptyStrategy == pooled_queue::PES_DISCARD || m_slots.empty()) return PushHandler(this, NULL);
+
+      boost::unique_lock<boost::mutex> lock(m_mutex);
+      m_producerWaiting.store(true);
+      while(tail - m_head.load() >= m_slots.size()) m_poolNonEmpty.wait(lock);
+      m_producerWaiting.store(false);
+    }
+
+    // The slot at the tail is not in the queue, so the producer has exclusive access to it until the push is completed.
+    return PushHandler(this, &m_slots[tail % m_slots.size()]);
+  }
+
+  /**
+   * \brief Gets whether or not the queue is empty.
+   *
+   * \return  true, if the queue is empty, or false otherwise.
+   */
+  bool empty() const
+  {
+    return size() == 0;
+  }
+
+  /**
+   * \brief Initialises the pool backing the queue.
+   *
+   * \note  This must be called before the producer starts pushing elements onto the queue.
+   *
+   * \param capacity  The capacity of the pool (this is fixed).
+   * \param maker     A function that can be used to construct new elements (by default, the default constructor for the element type).
+   */
+  void initialise(size_t capacity, const boost::function<T()>& maker = boost::value_factory<T>())
+  {
+    m_slots.clear();
+    m_slots.reserve(capacity);
+    for(size_t i = 0; i < capacity; ++i)
+    {
+      m_slots.push_back(maker());
+    }
+  }
+
+  /**
+   * \brief Gets a reference to the first element in the queue (this must only be called from the consumer thread).
+   *
+   * Note: This will block until the queue is non-empty.
+   *
+   * \return  A reference to the first element in the queue.
+   */
+  T& peek()
+  {
+    const size_t head = m_head.load(boost::memory_order_relaxed);
+    wait_for_element(head);
+    return m_slots[head % m_slots.size()];
+  }
+
+  /**
+   * \brief Gets a reference to the first element in the queue (this must only be called from the consumer thread).
+   *
+   * Note: This will block until the queue is non-empty.
+   *
+   * \return  A reference to the first element in the queue.
+   */
+  const T& peek() const
+  {
+    const size_t head = m_head.load(boost::memory_order_relaxed);
+    wait_for_element(head);
+    return m_slots[head % m_slots.size()];
+  }
+
+  /**
+   * \brief Pops the first element from the queue and returns it to the pool (this must only be called from the consumer thread).
+   *
+   * Note: This will block until the queue is non-empty.
+   */
+  void pop()
+  {
+    const size_t head = m_head.load(boost::memory_order_relaxed);
+    wait_for_element(head);
+
+    // Note: This must be sequentially consistent so that it cannot be reordered with the check of the waiting flag (see end_push).
+    m_head.store(head + 1);
+
+    if(m_producerWaiting.load())
+    {
+      boost::lock_guard<boost::mutex> lock(m_mutex);
+      m_poolNonEmpty.notify_one();
+    }
+  }
+
+  /**
+   * \brief Gets the size of the queue.
+   *
+   * Note: If called from a thread other than the producer or consumer, the result may be out of date by the time it is returned.
+   *
+   * \return  The size of the queue.
+   */
+  size_t size() const
+  {
+    const size_t head = m_head.load(boost::memory_order_acquire);
+    return m_tail.load(boost::memory_order_acquire) - head;
+  }
+
+  //#################### PRIVATE MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Completes a push operation by publishing the element at the tail of the ring buffer to the consumer.
+   *
+   * Note: This is called automatically when the push handler associated with the push is destroyed.
+   */
+  void end_push()
+  {
+    // Note: This must be sequentially consistent so that it cannot be reordered with the subsequent check of the waiting flag.
+    // Together with the corresponding code in wait_for_element, this ensures that either the consumer sees the new element
+    // before it starts waiting, or we see that the consumer is waiting and wake it up.
+    m_tail.store(m_tail.load(boost::memory_order_relaxed) + 1);
+
+    if(m_consumerWaiting.load())
+    {
+      boost::lock_guard<boost::mutex> lock(m_mutex);
+      m_queueNonEmpty.notify_one();
+    }
+  }
+
+  /**
+   * \brief Blocks until the queue contains the element with the specified index.
+   *
+   * \param head  The index of the first element in the queue.
+   */
+  void wait_for_element(size_t head) const
+  {
+    // Fast path: the element is already available, so there is no need to take the lock.
+    if(m_tail.load(boost::memory_order_acquire) != head) return;
+
+    boost::unique_lock<boost::mutex> lock(m_mutex);
+    m_consumerWaiting.store(true);
+    while(m_tail.load() == head) m_queueNonEmpty.wait(lock);
+    m_consumerWaiting.store(false);
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,286 @@
+/**
+ * tvgutil: BoundedThreadPool.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2017. All rights reserved.
+ */
+
+#ifndef H_TVGUTIL_BOUNDEDTHREADPOOL
+#define H_TVGUTIL_BOUNDEDTHREADPOOL
+
+#include <deque>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/function.hpp>
+#include <boost/thread.hpp>
+
+#include "ThreadPool.h"
+
+namespace tvgutil {
+
+namespace bounded_thread_pool {
+
+/**
+ * \brief The values of this enumeration can be used to specify what should happen when a task is posted to a bounded thread pool whose queue is full.
+ */
+enum QueueFullStrategy
+{
+  /** Discard the new task. */
+  QFS_DISCARD,
+
+  /** Discard the oldest task in the queue to make space for the new task. */
+  QFS_DISCARD_OLDEST,
+
+  /** Wait for a task to be taken from the queue for execution, thereby making space for the new task. */
+  QFS_WAIT
+};
+
+/**
+ * \brief The values of this enumeration specify the priorities that can be given to the tasks posted to a bounded thread pool.
+ *
+ * Queued tasks with a higher priority are always executed before queued tasks with a lower priority. Tasks with the same
+ * priority are executed in the order in which they were posted.
+ */
+enum TaskPriority
+{
+  /** A priority suitable for tasks that can be delayed or discarded in preference to any others. */
+  TP_LOW,
+
+  /** The priority given to tasks by default. */
+  TP_NORMAL,
+
+  /** A priority suitable for small tasks whose loss would be costly (e.g. writing the poses for a recorded sequence). */
+  TP_HIGH,
+
+  /** The number of different task priorities. */
+  TP_COUNT
+};
+
+//#################### STREAM OPERATORS ####################
+
+inline std::ostream& operator<<(std::ostream& os, QueueFullStrategy rhs)
+{
+  switch(rhs)
+  {
+    case QFS_DISCARD:         os << "discard"; break;
+    case QFS_DISCARD_OLDEST:  os << "discardoldest"; break;
+    case QFS_WAIT:            os << "wait"; break;
+    default:
+    {
+      // This should never happen.
+      throw std::runtime_error("Error: Unknown queue full strategy");
+    }
+  }
+
+  return os;
+}
+
+inline std::istream& operator>>(std::istream& is, QueueFullStrategy& rhs)
+{
+  std::string temp;
+  is >> temp;
+  if(!is) return is;
+
+  boost::trim(temp);
+  boost::to_lower(temp);
+
+  if(temp == "discard") rhs = QFS_DISCARD;
+  else if(temp == "discardoldest") rhs = QFS_DISCARD_OLDEST;
+  else if(temp == "wait") rhs = QFS_WAIT;
+  else throw std::runtime_error("Error: Unknown queue full strategy '" + temp + "'");
+
+  return is;
+}
+
+}
+
+/**
+ * \brief An instance of this class asynchronously executes tasks taken from a queue of bounded capacity on the threads of a ThreadPool.
+ *
+ * Unlike ThreadPool, which queues an unlimited number of tasks, a bounded thread pool applies a queue full strategy whenever
+ * a task is posted while its queue is at capacity. This makes it suitable for work such as saving images to disk, for which
+ * an unbounded backlog would otherwise grow without limit whenever the tasks are produced faster than they can be executed.
+ *
+ * A bounded thread pool does not own any threads itself. Instead, it executes its tasks on the threads of an underlying
+ * ThreadPool (by default, the global one), whilst limiting the number of its tasks that can be executing at once so that
+ * it cannot monopolise the underlying pool.
+ *
+ * Each task has a priority (see bounded_thread_pool::TaskPriority). Higher-priority tasks are executed first, and when tasks
+ * must be discarded to keep within the capacity, lower-priority tasks are discarded in preference to higher-priority ones.
+ */
+class BoundedThreadPool
+{
+  //#################### NESTED TYPES ####################
+public:
+  /**
+   * \brief An instance of this struct contains statistics about the tasks that have passed through a bounded thread pool.
+   */
+  struct Statistics
+  {
+    /** The number of tasks that have been executed to completion. */
+    size_t completedTaskCount;
+
+    /** The number of tasks that have been discarded because the queue was full. */
+    size_t discardedTaskCount;
+
+    /** The number of tasks that threw an exception whilst being executed. */
+    size_t failedTaskCount;
+
+    /** The largest number of tasks that have ever been waiting in the queue at once. */
+    size_t peakQueueSize;
+
+    /** The number of tasks that have been posted to the pool. */
+    size_t postedTaskCount;
+
+    /** The number of tasks that are currently waiting in the queue. */
+    size_t queueSize;
+
+    Statistics()
+    : completedTaskCount(0), discardedTaskCount(0), failedTaskCount(0), peakQueueSize(0), postedTaskCount(0), queueSize(0)
+    {}
+  };
+
+  //#################### TYPEDEFS ####################
+private:
+  typedef boost::function<void()> Task;
+
+  //#################### PRIVATE MEMBER VARIABLES ####################
+private:
+  /** The number of runners (tasks on the underlying pool that take tasks from the queue and execute them) that are currently active. */
+  size_t m_activeRunnerCount;
+
+  /** The maximum number of tasks that can be waiting in the queue at once. */
+  size_t m_capacity;
+
+  /** The maximum number of runners that can be active at once (and thus the maximum number of tasks that can be executing at once). */
+  size_t m_maxRunnerCount;
+
+  /** The synchronisation mutex. */
+  mutable boost::mutex m_mutex;
+
+  /** The underlying pool on whose threads the tasks are executed. */
+  ThreadPool& m_pool;
+
+  /** A condition variable used to wait for the pool to become idle. */
+  mutable boost::condition_variable m_poolIdle;
+
+  /** The queues of tasks that are waiting to be executed, one for each task priority. */
+  std::deque<Task> m_queues[bounded_thread_pool::TP_COUNT];
+
+  /** A strategy specifying what should happen when a task is posted while the queue is full. */
+  bounded_thread_pool::QueueFullStrategy m_queueFullStrategy;
+
+  /** A condition variable used to wait for the queue to become non-full. */
+  boost::condition_variable m_queueNonFull;
+
+  /** The total number of tasks that are waiting to be executed. */
+  size_t m_queueSize;
+
+  /** Statistics about the tasks that have passed through the pool. */
+  Statistics m_statistics;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs a bounded thread pool.
+   *
+   * \note  Tasks that are posted with the QFS_WAIT strategy must not be posted from threads of the underlying pool,
+   *        since otherwise all of its threads could end up waiting for the queue to become non-full.
+   *
+   * \param maxConcurrency    The maximum number of tasks that can be executing at once.
+   * \param capacity          The maximum number of tasks that can be waiting in the queue at once.
+   * \param queueFullStrategy A strategy specifying what should happen when a task is posted while the queue is full.
+   * \param pool              The underlying pool on whose threads the tasks should be executed.
+   * \throws std::runtime_error If either the maximum concurrency or the capacity is zero.
+   */
+  BoundedThreadPool(size_t maxConcurrency, size_t capacity, bounded_thread_pool::QueueFullStrategy queueFullStrategy = bounded_thread_pool::QFS_WAIT,
+                    ThreadPool& pool = ThreadPool::instance());
+
+  //#################### DESTRUCTOR ####################
+public:
+  /**
+   * \brief Destroys the bounded thread pool.
+   *
+   * \note  Any tasks that are still in the queue will be executed before the pool is destroyed, so this can block.
+   */
+  ~BoundedThreadPool();
+
+  //#################### COPY CONSTRUCTOR & ASSIGNMENT OPERATOR ####################
+private:
+  // Deliberately private and unimplemented.
+  BoundedThreadPool(const BoundedThreadPool&);
+  BoundedThreadPool& operator=(const BoundedThreadPool&);
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Gets the maximum number of tasks that can be waiting in the queue at once.
+   *
+   * \return  The maximum number of tasks that can be waiting in the queue at once.
+   */
+  size_t get_capacity() const;
+
+  /**
+   * \brief Gets statistics about the tasks that have passed through the pool.
+   *
+   * \return  Statistics about the tasks that have passed through the pool.
+   */
+  Statistics get_statistics() const;
+
+  /**
+   * \brief Posts a task to be executed by the thread pool.
+   *
+   * If the queue is full, the pool's queue full strategy determines what happens:
+   *
+   * - QFS_DISCARD: The oldest of the queued tasks with the lowest priority is discarded if its priority is lower than that of
+   *                the new task; otherwise, the new task is discarded.
+   * - QFS_DISCARD_OLDEST: The oldest of the queued tasks with the lowest priority is discarded if its priority is no higher
+   *                       than that of the new task; otherwise, the new task is discarded.
+   * - QFS_WAIT: The caller blocks until space becomes available.
+   *
+   * \param task      The task to execute.
+   * \param priority  The priority of the task.
+   * \return          true, if the task was added to the queue, or false if it was discarded.
+   */
+  bool post_task(const Task& task, bounded_thread_pool::TaskPriority priority = bounded_thread_pool::TP_NORMAL);
+
+  /**
+   * \brief Blocks until the queue is empty and no tasks are being executed.
+   */
+  void wait_until_idle() const;
+
+  //#################### PRIVATE MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Attempts to discard the oldest of the queued tasks with the lowest priority, provided that priority is no higher than the one specified.
+   *
+   * \note  The caller must hold the synchronisation mutex.
+   *
+   * \param maxPriority The highest priority that a discarded task may have.
+   * \return            true, if a task was discarded, or false otherwise.
+   */
+  bool discard_lowest_priority_task(int maxPriority);
+
+  /**
+   * \brief Repeatedly takes tasks from the queue and executes them until the queue is empty.
+   *
+   * This is executed by each runner on a thread of the underlying pool.
+   */
+  void run_tasks();
+};
+
+//#################### STREAM OPERATORS ####################
+
+/**
+ * \brief Outputs the specified bounded thread pool statistics to a stream.
+ *
+ * \param os  The stream to which to output the statistics.
+ * \param rhs The statistics to output.
+ * \return    The stream.
+ */
+std::ostream& operator<<(std::ostream& os, const BoundedThreadPool::Statistics& rhs);
+
+}
+
+#endif
@@ -6,39 +6,211 @@
 #ifndef H_TVGUTIL_THREADPOOL
 #define H_TVGUTIL_THREADPOOL
 
-#include <string>
+#include <algorithm>
+#include <deque>
+#include <iostream>
+#include <vector>
 
+#include <boost/atomic.hpp>
+#include <boost/bind.hpp>
+#include <boost/exception_ptr.hpp>
+#include <boost/function.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/thread.hpp>
-
-#include "../boost/WrappedAsio.h"
+#include <boost/thread/future.hpp>
+#include <boost/utility/result_of.hpp>
 
 namespace tvgutil {
 
 /**
  * \brief An instance of this class represents a pool of threads that can be used to asynchronously execute arbitrary tasks.
+ *
+ * Each thread in the pool has its own double-ended queue of tasks. Tasks posted by a thread in the pool are pushed onto
+ * the back of that thread's queue and popped from the back again (so that recently created tasks, whose data are likely
+ * to still be in cache, are executed first), whilst threads whose own queues are empty steal tasks from the fronts of
+ * the other threads' queues. Tasks posted from outside the pool are distributed over the queues in round-robin order.
+ *
+ * Threads that wait for a task group (see TaskGroup::wait) help to execute the group's own unstarted tasks whilst they
+ * wait, which makes it safe to nest parallel operations (e.g. to call parallel_for from within a task) without exhausting
+ * the pool. They never execute unrelated tasks, so the time for which a waiting thread is blocked is bounded by the time
+ * taken by the tasks in its group.
  */
 class ThreadPool
 {
+  //#################### TYPEDEFS ####################
+private:
+  typedef boost::function<void()> Task;
+
+  //#################### NESTED TYPES ####################
+public:
+  /**
+   * \brief An instance of this class represents a group of tasks whose completion can be waited for as a unit.
+   */
+  class TaskGroup
+  {
+    //~~~~~~~~~~~~~~~~~~~~ NESTED TYPES ~~~~~~~~~~~~~~~~~~~~
+  private:
+    /**
+     * \brief An instance of this struct holds the state of a task group.
+     *
+     * The state is shared with the tasks that the group posts to the pool, since these can outlive the group itself.
+     */
+    struct State
+    {
+      /** The first exception (if any) that was thrown by a task in the group. */
+      boost::exception_ptr exception;
+
+      /** A condition variable used to wait for all of the tasks in the group to finish. */
+      boost::condition_variable finished;
+
+      /** The synchronisation mutex. */
+      boost::mutex mutex;
+
+      /** The number of tasks in the group that have not yet finished. */
+      size_t pendingTaskCount;
+
+      /** The tasks in the group that have not yet been started by any thread. */
+      std::deque<Task> unstartedTasks;
+
+      State() : pendingTaskCount(0) {}
+    };
+
+    typedef boost::shared_ptr<State> State_Ptr;
+
+    //~~~~~~~~~~~~~~~~~~~~ PRIVATE VARIABLES ~~~~~~~~~~~~~~~~~~~~
+  private:
+    /** The thread pool on which the tasks in the group are executed. */
+    ThreadPool& m_pool;
+
+    /** The state of the group. */
+    State_Ptr m_state;
+
+    //~~~~~~~~~~~~~~~~~~~~ CONSTRUCTORS ~~~~~~~~~~~~~~~~~~~~
+  public:
+    /**
+     * \brief Constructs a task group.
+     *
+     * \param pool  The thread pool on which the tasks in the group should be executed.
+     */
+    explicit TaskGroup(ThreadPool& pool = ThreadPool::instance());
+
+    //~~~~~~~~~~~~~~~~~~~~ DESTRUCTOR ~~~~~~~~~~~~~~~~~~~~
+  public:
+    /**
+     * \brief Destroys the task group.
+     *
+     * \note  Since this waits for any unfinished tasks in the group, it can block. Any exception thrown by those tasks is discarded.
+     */
+    ~TaskGroup();
+
+    //~~~~~~~~~~~~~~~~~~~~ COPY CONSTRUCTOR & ASSIGNMENT OPERATOR ~~~~~~~~~~~~~~~~~~~~
+  private:
+    // Deliberately private and unimplemented.
+    TaskGroup(const TaskGroup&);
+    TaskGroup& operator=(const TaskGroup&);
+
+    //~~~~~~~~~~~~~~~~~~~~ PUBLIC MEMBER FUNCTIONS ~~~~~~~~~~~~~~~~~~~~
+  public:
+    /**
+     * \brief Adds a task to the group and posts it to the thread pool for execution.
+     *
+     * \param task  The task to execute.
+     */
+    template <typename TaskType>
+    void run(TaskType task)
+    {
+      {
+        boost::lock_guard<boost::mutex> lock(m_state->mutex);
+        m_state->unstartedTasks.push_back(task);
+        ++m_state->pendingTaskCount;
+      }
+
+      // Post a task to the pool that will execute one of the group's unstarted tasks (if any remain by the time it runs).
+      m_pool.enqueue(boost::bind(&TaskGroup::run_unstarted_task, m_state));
+    }
+
+    /**
+     * \brief Blocks until all of the tasks in the group have finished, helping to execute the group's unstarted tasks in the meantime.
+     *
+     * \throws  The first exception (if any) that was thrown by a task in the group.
+     */
+    void wait();
+
+    //~~~~~~~~~~~~~~~~~~~~ PRIVATE MEMBER FUNCTIONS ~~~~~~~~~~~~~~~~~~~~
+  private:
+    /**
+     * \brief Blocks until all of the tasks in the group have finished, helping to execute the group's unstarted tasks in the meantime.
+     */
+    void wait_for_tasks();
+
+    //~~~~~~~~~~~~~~~~~~~~ PRIVATE STATIC MEMBER FUNCTIONS ~~~~~~~~~~~~~~~~~~~~
+  private:
+    /**
+     * \brief Executes a task in a group, recording any exception it throws and marking it as finished.
+     *
+     * \param state The state of the group.
+     * \param task  The task to execute.
+     */
+    static void execute(const State_Ptr& state, const Task& task);
+
+    /**
+     * \brief Executes the oldest unstarted task (if any) in a group.
+     *
+     * \param state The state of the group.
+     * \return      true, if a task was executed, or false if the group had no unstarted tasks.
+     */
+    static bool run_unstarted_task(const State_Ptr& state);
+  };
+
+private:
+  /**
+   * \brief An instance of this struct represents the queue of tasks belonging to an individual thread in the pool.
+   */
+  struct WorkerQueue
+  {
+    /** The synchronisation mutex. */
+    boost::mutex mutex;
+
+    /** The tasks in the queue. */
+    std::deque<Task> tasks;
+  };
+
+  typedef boost::shared_ptr<WorkerQueue> WorkerQueue_Ptr;
+
   //#################### PRIVATE MEMBER VARIABLES ####################
 private:
-  /** An I/O service used to schedule work for the threads. */
-  boost::asio::io_service m_scheduler;
+  /** The index of the queue to which the next task posted from outside the pool should be added. */
+  boost::atomic<size_t> m_nextQueueIndex;
+
+  /** The number of tasks that are currently waiting in the queues. */
+  boost::atomic<int> m_pendingTaskCount;
+
+  /** The task queues of the threads in the pool. */
+  std::vector<WorkerQueue_Ptr> m_queues;
+
+  /** Whether or not the threads should terminate once the queues have been drained. */
+  bool m_shouldTerminate;
+
+  /** The mutex used when threads go to sleep or are woken up. */
+  boost::mutex m_sleepMutex;
 
   /** The threads in the pool. */
   boost::thread_group m_threads;
 
-  /** A worker variable used to keep the scheduler running until we want it to stop. */
-  boost::shared_ptr<boost::asio::io_service::work> m_worker;
+  /** The index of the calling thread within the pool (not set for threads that are not in the pool). */
+  boost::thread_specific_ptr<size_t> m_threadIndex;
+
+  /** A condition variable used to wake sleeping threads when a task becomes available. */
+  boost::condition_variable m_workAvailable;
 
   //#################### CONSTRUCTORS ####################
 public:
   /**
    * \brief Constructs a thread pool.
    *
-   * \param numThreads  The number of threads that should be in the pool.
+   * \param numThreads  The number of threads that should be in the pool (by default, the number of hardware threads on the machine).
    */
-  explicit ThreadPool(size_t numThreads = 20);
+  explicit ThreadPool(size_t numThreads = default_thread_count());
 
   //#################### DESTRUCTOR ####################
 public:
@@ -57,6 +229,13 @@ private:
 
   //#################### PUBLIC STATIC MEMBER FUNCTIONS ####################
 public:
+  /**
+   * \brief Gets the number of threads that a thread pool contains by default.
+   *
+   * \return  The number of hardware threads on the machine, if it can be determined, or 1 otherwise.
+   */
+  static size_t default_thread_count();
+
   /**
    * \brief Gets a global instance of the thread pool that has been constructed with default parameters.
    *
@@ -68,15 +247,151 @@ public:
 
   //#################### PUBLIC MEMBER FUNCTIONS ####################
 public:
+  /**
+   * \brief Gets the number of threads in the pool.
+   *
+   * \return  The number of threads in the pool.
+   */
+  size_t get_thread_count() const;
+
+  /**
+   * \brief Calls the specified function for every index in the range [begin,end), splitting the range into chunks that are executed by the pool.
+   *
+   * The calling thread helps to execute the chunks, and the function blocks until all of them have finished.
+   *
+   * \param begin     The start of the range.
+   * \param end       The end of the range (exclusive).
+   * \param body      The function to call for each index in the range.
+   * \param grainSize The number of indices in each chunk (if non-positive, a chunk size is chosen that gives each thread several chunks).
+   * \throws          The first exception (if any) that was thrown by the function.
+   */
+  template <typename Body>
+  void parallel_for(int begin, int end, const Body& body, int grainSize = 0)
+  {
+    if(begin >= end) return;
+
+    if(grainSize <= 0)
+    {
+      const int chunkCount = static_cast<int>(4 * m_queues.size());
+      grainSize = std::max(1, (end - begin + chunkCount - 1) / chunkCount);
+    }
+
+    TaskGroup group(*this);
+    for(int chunkBegin = begin; chunkBegin < end; chunkBegin += grainSize)
+    {
+      const int chunkEnd = std::min(end, chunkBegin + grainSize);
+      group.run(boost::bind(&ThreadPool::run_range<Body>, boost::cref(body), chunkBegin, chunkEnd));
+    }
+
+    group.wait();
+  }
+
   /**
    * \brief Posts a task to be executed by the thread pool.
    *
+   * \note  Since there is nobody to whom it could be propagated, any exception thrown by the task is reported and then discarded.
+   *
    * \param task  The task to execute.
    */
-  template <typename Task>
-  void post_task(Task task)
+  template <typename TaskType>
+  void post_task(TaskType task)
+  {
+    // Note: The task is wrapped in a Task first to prevent boost::bind from treating it as a nested bind expression.
+    enqueue(boost::bind(&ThreadPool::run_detached_task, Task(task)));
+  }
+
+  /**
+   * \brief Posts a function to be executed by the thread pool, and returns a future that will contain its result.
+   *
+   * \param f The function to execute.
+   * \return  A future that will contain the result of the function (or the exception it threw).
+   */
+  template <typename F>
+  boost::unique_future<typename boost::result_of<F()>::type> submit(F f)
+  {
+    typedef typename boost::result_of<F()>::type R;
+    boost::shared_ptr<boost::packaged_task<R> > task(new boost::packaged_task<R>(f));
+    boost::unique_future<R> result = task->get_future();
+    enqueue(boost::bind(&ThreadPool::run_packaged_task<R>, task));
+    return boost::move(result);
+  }
+
+  /**
+   * \brief Posts a function and a continuation to be executed by the thread pool, and returns a future that will contain the continuation's result.
+   *
+   * The continuation is called on the result of the function as soon as it is available, on the same thread and without re-queueing.
+   *
+   * \param f             The function to execute (this must not return void).
+   * \param continuation  The continuation to call on the result of the function.
+   * \return              A future that will contain the result of the continuation (or the exception thrown by either function).
+   */
+  template <typename F, typename Continuation>
+  boost::unique_future<typename boost::result_of<Continuation(typename boost::result_of<F()>::type)>::type> submit_then(F f, Continuation continuation)
+  {
+    return submit(boost::bind(continuation, boost::bind(f)));
+  }
+
+  //#################### PRIVATE MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Adds a task to one of the queues and wakes up a sleeping thread (if any) to execute it.
+   *
+   * If the calling thread is in the pool, the task is added to its own queue; if not, the queues are used in round-robin order.
+   *
+   * \param task  The task to add.
+   */
+  void enqueue(const Task& task);
+
+  /**
+   * \brief Repeatedly executes tasks from the queues until the pool is destroyed.
+   *
+   * \param threadIndex The index of the calling thread within the pool.
+   */
+  void run_worker(size_t threadIndex);
+
+  /**
+   * \brief Attempts to take a pending task from one of the queues and execute it on the calling thread.
+   *
+   * The calling thread's own queue (if any) is tried first, after which tasks are stolen from the other queues.
+   *
+   * \return  true, if a task was executed, or false if there were no pending tasks.
+   */
+  bool try_run_pending_task();
+
+  //#################### PRIVATE STATIC MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Executes a fire-and-forget task, reporting any exception that it throws.
+   *
+   * \param task  The task to execute.
+   */
+  static void run_detached_task(const Task& task);
+
+  /**
+   * \brief Executes a packaged task.
+   *
+   * \param task  The packaged task to execute.
+   */
+  template <typename R>
+  static void run_packaged_task(const boost::shared_ptr<boost::packaged_task<R> >& task)
+  {
+    (*task)();
+  }
+
+  /**
+   * \brief Calls the specified function for every index in the range [begin,end).
+   *
+   * \param body  The function to call for each index in the range.
+   * \param begin The start of the range.
+   * \param end   The end of the range (exclusive).
+   */
+  template <typename Body>
+  static void run_range(const Body& body, int begin, int end)
   {
-    m_scheduler.post(task);
+    for(int i = begin; i < end; ++i)
+    {
+      body(i);
+    }
   }
 };
 
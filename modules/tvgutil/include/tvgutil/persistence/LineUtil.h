@@ -36,6 +36,15 @@ struct LineUtil
    */
   static std::vector<std::vector<std::string> > extract_word_lines(std::istream& is, const std::string& delimiters);
 
+  /**
+   * \brief Extracts the words from a single line.
+   *
+   * \param line        The line.
+   * \param delimiters  The delimiters which can separate words in the line.
+   * \return            The words.
+   */
+  static std::vector<std::string> extract_words(const std::string& line, const std::string& delimiters);
+
   /**
    * \brief Outputs lines to a stream.
    *
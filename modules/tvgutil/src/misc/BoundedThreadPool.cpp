@@ -0,0 +1,183 @@
+/**
+ * tvgutil: BoundedThreadPool.cpp
+ * Copyright (c) Torr Vision Group, University of Oxford, 2017. All rights reserved.
+ */
+
+#include "misc/BoundedThreadPool.h"
+
+#include <boost/bind.hpp>
+
+namespace tvgutil {
+
+//#################### CONSTRUCTORS ####################
+
+BoundedThreadPool::BoundedThreadPool(size_t maxConcurrency, size_t capacity, bounded_thread_pool::QueueFullStrategy queueFullStrategy, ThreadPool& pool)
+: m_activeRunnerCount(0), m_capacity(capacity), m_maxRunnerCount(maxConcurrency), m_pool(pool), m_queueFullStrategy(queueFullStrategy), m_queueSize(0)
+{
+  if(maxConcurrency == 0) throw std::runtime_error("Error: A bounded thread pool must be able to execute at least one task at once");
+  if(capacity == 0) throw std::runtime_error("Error: A bounded thread pool must have a non-zero capacity");
+}
+
+//#################### DESTRUCTOR ####################
+
+BoundedThreadPool::~BoundedThreadPool()
+{
+  // Wait for any tasks that are still in the queue to be executed, since the runners refer to the pool.
+  wait_until_idle();
+}
+
+//#################### PUBLIC MEMBER FUNCTIONS ####################
+
+size_t BoundedThreadPool::get_capacity() const
+{
+  return m_capacity;
+}
+
+BoundedThreadPool::Statistics BoundedThreadPool::get_statistics() const
+{
+  boost::lock_guard<boost::mutex> lock(m_mutex);
+  Statistics statistics = m_statistics;
+  statistics.queueSize = m_queueSize;
+  return statistics;
+}
+
+bool BoundedThreadPool::post_task(const Task& task, bounded_thread_pool::TaskPriority priority)
+{
+  using namespace bounded_thread_pool;
+
+  if(priority < 0 || priority >= TP_COUNT) throw std::runtime_error("Error: Invalid task priority");
+
+  boost::unique_lock<boost::mutex> lock(m_mutex);
+  ++m_statistics.postedTaskCount;
+
+  // If the queue is full, we have several options: (i) discard a task (preferring the new task to any queued task with
+  // the same priority); (ii) discard a task (preferring the oldest queued task to a new task with the same priority);
+  // or (iii) block until a worker thread takes a task from the queue. We choose between these options by specifying
+  // a queue full strategy when the pool is constructed. Note that a new task is never allowed to displace a queued
+  // task with a higher priority.
+  if(m_queueSize >= m_capacity)
+  {
+    switch(m_queueFullStrategy)
+    {
+      case QFS_DISCARD:
+      case QFS_DISCARD_OLDEST:
+      {
+        const int maxPriority = m_queueFullStrategy == QFS_DISCARD ? priority - 1 : priority;
+        ++m_statistics.discardedTaskCount;
+        if(!discard_lowest_priority_task(maxPriority)) return false;
+        break;
+      }
+      case QFS_WAIT:
+      {
+        while(m_queueSize >= m_capacity) m_queueNonFull.wait(lock);
+        break;
+      }
+    }
+  }
+
+  m_queues[priority].push_back(task);
+  ++m_queueSize;
+  if(m_queueSize > m_statistics.peakQueueSize) m_statistics.peakQueueSize = m_queueSize;
+
+  // If fewer than the maximum number of runners are active, start another one to help execute the queued tasks.
+  const bool startRunner = m_activeRunnerCount < m_maxRunnerCount;
+  if(startRunner) ++m_activeRunnerCount;
+  lock.unlock();
+
+  if(startRunner) m_pool.post_task(boost::bind(&BoundedThreadPool::run_tasks, this));
+  return true;
+}
+
+void BoundedThreadPool::wait_until_idle() const
+{
+  boost::unique_lock<boost::mutex> lock(m_mutex);
+  while(m_queueSize > 0 || m_activeRunnerCount > 0) m_poolIdle.wait(lock);
+}
+
+//#################### PRIVATE MEMBER FUNCTIONS ####################
+
+bool BoundedThreadPool::discard_lowest_priority_task(int maxPriority)
+{
+  for(int priority = 0; priority <= maxPriority; ++priority)
+  {
+    std::deque<Task>& queue = m_queues[priority];
+    if(!queue.empty())
+    {
+      queue.pop_front();
+      --m_queueSize;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void BoundedThreadPool::run_tasks()
+{
+  for(;;)
+  {
+    // Take the oldest task with the highest priority from the queue. If the queue is empty, the runner finishes.
+    Task task;
+    {
+      boost::lock_guard<boost::mutex> lock(m_mutex);
+      if(m_queueSize == 0)
+      {
+        if(--m_activeRunnerCount == 0) m_poolIdle.notify_all();
+        return;
+      }
+
+      for(int priority = bounded_thread_pool::TP_COUNT - 1; priority >= 0; --priority)
+      {
+        std::deque<Task>& queue = m_queues[priority];
+        if(!queue.empty())
+        {
+          task = queue.front();
+          queue.pop_front();
+          break;
+        }
+      }
+
+      --m_queueSize;
+    }
+
+    m_queueNonFull.notify_one();
+
+    // Execute the task. Since there is nobody to whom we can propagate an exception, we report it and carry on.
+    bool succeeded = true;
+    try
+    {
+      task();
+    }
+    catch(std::exception& e)
+    {
+      std::cerr << "Warning: A task in a bounded thread pool threw an exception: " << e.what() << '\n';
+      succeeded = false;
+    }
+    catch(...)
+    {
+      std::cerr << "Warning: A task in a bounded thread pool threw an unknown exception\n";
+      succeeded = false;
+    }
+
+    {
+      boost::lock_guard<boost::mutex> lock(m_mutex);
+      if(succeeded) ++m_statistics.completedTaskCount;
+      else ++m_statistics.failedTaskCount;
+    }
+  }
+}
+
+//#################### STREAM OPERATORS ####################
+
+std::ostream& operator<<(std::ostream& os, const BoundedThreadPool::Statistics& rhs)
+{
+  os << "posted: " << rhs.postedTaskCount
+     << ", completed: " << rhs.completedTaskCount
+     << ", failed: " << rhs.failedTaskCount
+     << ", discarded: " << rhs.discardedTaskCount
+     << ", queued: " << rhs.queueSize
+     << ", peak queued: " << rhs.peakQueueSize;
+  return os;
+}
+
+}
@@ -5,18 +5,24 @@
 
 #include "misc/ThreadPool.h"
 
-#include <boost/bind.hpp>
-
 namespace tvgutil {
 
 //#################### CONSTRUCTORS ####################
 
 ThreadPool::ThreadPool(size_t numThreads)
-: m_worker(new boost::asio::io_service::work(m_scheduler))
+: m_nextQueueIndex(0), m_pendingTaskCount(0), m_shouldTerminate(false)
 {
+  if(numThreads == 0) numThreads = 1;
+
+  // Note: All of the queues must exist before any of the threads start, since the threads may try to steal from any of them.
+  for(size_t i = 0; i < numThreads; ++i)
+  {
+    m_queues.push_back(WorkerQueue_Ptr(new WorkerQueue));
+  }
+
   for(size_t i = 0; i < numThreads; ++i)
   {
-    m_threads.create_thread(boost::bind(&boost::asio::io_service::run, &m_scheduler));
+    m_threads.create_thread(boost::bind(&ThreadPool::run_worker, this, i));
   }
 }
 
@@ -24,22 +30,213 @@ ThreadPool::ThreadPool(size_t numThreads)
 
 ThreadPool::~ThreadPool()
 {
-  // Stop executing the scheduler's run function, but allow running and queued tasks to finish cleanly.
-  m_worker.reset();
+  // Tell the threads to terminate once they have executed all of the tasks that are still queued.
+  {
+    boost::lock_guard<boost::mutex> lock(m_sleepMutex);
+    m_shouldTerminate = true;
+  }
+
+  m_workAvailable.notify_all();
 
   // Wait for all threads to terminate.
   m_threads.join_all();
-
-  // Cleanly stop the scheduler.
-  m_scheduler.stop();
 }
 
 //#################### PUBLIC STATIC MEMBER FUNCTIONS ####################
 
+size_t ThreadPool::default_thread_count()
+{
+  size_t threadCount = boost::thread::hardware_concurrency();
+  return threadCount > 0 ? threadCount : 1;
+}
+
 ThreadPool& ThreadPool::instance()
 {
   static ThreadPool s_instance;
   return s_instance;
 }
 
+//#################### PUBLIC MEMBER FUNCTIONS ####################
+
+size_t ThreadPool::get_thread_count() const
+{
+  return m_queues.size();
+}
+
+//#################### PRIVATE MEMBER FUNCTIONS ####################
+
+void ThreadPool::enqueue(const Task& task)
+{
+  // Note: We increment the pending task count before adding the task to a queue, so that a thread that
+  // takes the task from the queue can never observe the count without the task having been counted.
+  ++m_pendingTaskCount;
+
+  const size_t *threadIndex = m_threadIndex.get();
+  const size_t queueIndex = threadIndex ? *threadIndex : m_nextQueueIndex++ % m_queues.size();
+
+  {
+    WorkerQueue& queue = *m_queues[queueIndex];
+    boost::lock_guard<boost::mutex> lock(queue.mutex);
+    queue.tasks.push_back(task);
+  }
+
+  // Wake up a sleeping thread (if any) to execute the task. Note that we must briefly acquire the sleep mutex to
+  // avoid a lost wake-up, since the threads check the pending task count whilst holding this mutex.
+  {
+    boost::lock_guard<boost::mutex> lock(m_sleepMutex);
+  }
+
+  m_workAvailable.notify_one();
+}
+
+void ThreadPool::run_worker(size_t threadIndex)
+{
+  m_threadIndex.reset(new size_t(threadIndex));
+
+  for(;;)
+  {
+    if(try_run_pending_task()) continue;
+
+    // If there are no tasks in any of the queues, go to sleep until one is posted (or the pool is destroyed).
+    boost::unique_lock<boost::mutex> lock(m_sleepMutex);
+    while(m_pendingTaskCount == 0 && !m_shouldTerminate) m_workAvailable.wait(lock);
+    if(m_pendingTaskCount == 0 && m_shouldTerminate) return;
+  }
+}
+
+bool ThreadPool::try_run_pending_task()
+{
+  const size_t queueCount = m_queues.size();
+  const size_t *threadIndex = m_threadIndex.get();
+
+  Task task;
+
+  // If the calling thread is in the pool, first try to take the most recently added task from the back of its own queue.
+  if(threadIndex)
+  {
+    WorkerQueue& queue = *m_queues[*threadIndex];
+    boost::lock_guard<boost::mutex> lock(queue.mutex);
+    if(!queue.tasks.empty())
+    {
+      task.swap(queue.tasks.back());
+      queue.tasks.pop_back();
+    }
+  }
+
+  // Otherwise, try to steal the oldest task from the front of one of the other queues.
+  if(!task)
+  {
+    const size_t startIndex = threadIndex ? *threadIndex + 1 : 0;
+    for(size_t i = 0; i < queueCount && !task; ++i)
+    {
+      WorkerQueue& queue = *m_queues[(startIndex + i) % queueCount];
+      boost::lock_guard<boost::mutex> lock(queue.mutex);
+      if(!queue.tasks.empty())
+      {
+        task.swap(queue.tasks.front());
+        queue.tasks.pop_front();
+      }
+    }
+  }
+
+  if(!task) return false;
+
+  --m_pendingTaskCount;
+  task();
+  return true;
+}
+
+//#################### PRIVATE STATIC MEMBER FUNCTIONS ####################
+
+void ThreadPool::run_detached_task(const Task& task)
+{
+  try
+  {
+    task();
+  }
+  catch(std::exception& e)
+  {
+    std::cerr << "Warning: A task in the thread pool threw an exception: " << e.what() << '\n';
+  }
+}
+
+//#################### NESTED TYPES ####################
+
+ThreadPool::TaskGroup::TaskGroup(ThreadPool& pool)
+: m_pool(pool), m_state(new State)
+{}
+
+ThreadPool::TaskGroup::~TaskGroup()
+{
+  wait_for_tasks();
+}
+
+void ThreadPool::TaskGroup::wait()
+{
+  wait_for_tasks();
+
+  boost::exception_ptr exception;
+  {
+    boost::lock_guard<boost::mutex> lock(m_state->mutex);
+    exception = m_state->exception;
+    m_state->exception = boost::exception_ptr();
+  }
+
+  if(exception) boost::rethrow_exception(exception);
+}
+
+void ThreadPool::TaskGroup::wait_for_tasks()
+{
+  for(;;)
+  {
+    {
+      boost::lock_guard<boost::mutex> lock(m_state->mutex);
+      if(m_state->pendingTaskCount == 0) return;
+    }
+
+    // Rather than blocking straight away, help to execute any of the group's tasks that have not yet been started.
+    // This ensures that progress is made even if all of the threads in the pool are themselves waiting for (nested)
+    // task groups. Note that we deliberately never execute tasks from outside the group, since these could block
+    // the calling thread for an arbitrarily long time.
+    if(run_unstarted_task(m_state)) continue;
+
+    // If there are no unstarted tasks, all of the unfinished tasks in the group must be executing on other threads,
+    // so we can safely block until they finish.
+    boost::unique_lock<boost::mutex> lock(m_state->mutex);
+    while(m_state->pendingTaskCount != 0 && m_state->unstartedTasks.empty()) m_state->finished.wait(lock);
+  }
+}
+
+void ThreadPool::TaskGroup::execute(const State_Ptr& state, const Task& task)
+{
+  boost::exception_ptr exception;
+  try
+  {
+    task();
+  }
+  catch(...)
+  {
+    exception = boost::current_exception();
+  }
+
+  boost::lock_guard<boost::mutex> lock(state->mutex);
+  if(exception && !state->exception) state->exception = exception;
+  if(--state->pendingTaskCount == 0) state->finished.notify_all();
+}
+
+bool ThreadPool::TaskGroup::run_unstarted_task(const State_Ptr& state)
+{
+  Task task;
+
+  {
+    boost::lock_guard<boost::mutex> lock(state->mutex);
+    if(state->unstartedTasks.empty()) return false;
+    task.swap(state->unstartedTasks.front());
+    state->unstartedTasks.pop_front();
+  }
+
+  execute(state, task);
+  return true;
+}
+
 }
@@ -5,6 +5,7 @@
 
 #include "persistence/LineUtil.h"
 
+#include <istream>
 #include <stdexcept>
 
 #include <boost/algorithm/string.hpp>
@@ -32,22 +33,25 @@ std::vector<std::vector<std::string> > LineUtil::extract_word_lines(std::istream
 {
   std::vector<std::vector<std::string> > wordLines;
 
-  std::string internalDelimiters = delimiters + '\r';
-
   std::string line;
   while(std::getline(is, line))
   {
-    typedef boost::char_separator<char> sep;
-    typedef boost::tokenizer<sep> tokenizer;
-
-    tokenizer tok(line.begin(), line.end(), sep(internalDelimiters.c_str()));
-    std::vector<std::string> words(tok.begin(), tok.end());
-    wordLines.push_back(words);
+    wordLines.push_back(extract_words(line, delimiters));
   }
 
   return wordLines;
 }
 
+std::vector<std::string> LineUtil::extract_words(const std::string& line, const std::string& delimiters)
+{
+  typedef boost::char_separator<char> sep;
+  typedef boost::tokenizer<sep> tokenizer;
+
+  std::string internalDelimiters = delimiters + '\r';
+  tokenizer tok(line.begin(), line.end(), sep(internalDelimiters.c_str()));
+  return std::vector<std::string>(tok.begin(), tok.end());
+}
+
 void LineUtil::output_lines(std::ostream& os, const std::vector<std::string>& lines)
 {
   if(!os) throw std::runtime_error("Unable to write to the output stream");
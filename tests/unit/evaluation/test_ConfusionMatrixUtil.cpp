@@ -52,4 +52,29 @@ BOOST_AUTO_TEST_CASE(get_conf_mtx_test)
   BOOST_CHECK_EQUAL(testConfMtxNormL1, trueConfMtxNormL1);
 }
 
+BOOST_AUTO_TEST_CASE(large_conf_mtx_test)
+{
+  // Generate enough labels for the confusion matrix to be accumulated in parallel (if OpenMP is available).
+  std::set<Label> classLabels = list_of(-3)(4)(17);
+  std::vector<Label> groundTruthLabels, predictedLabels;
+  const Label labels[] = { -3, 4, 17 };
+  for(int i = 0; i < 10000; ++i)
+  {
+    groundTruthLabels.push_back(labels[i % 3]);
+    predictedLabels.push_back(labels[(i / 3) % 3]);
+  }
+
+  Eigen::MatrixXf testConfMtx = ConfusionMatrixUtil::make_confusion_matrix(classLabels, groundTruthLabels, predictedLabels);
+
+  // Count the expected entries directly.
+  Eigen::MatrixXf trueConfMtx = Eigen::MatrixXf::Zero(3,3);
+  for(int i = 0; i < 10000; ++i)
+  {
+    ++trueConfMtx(i % 3, (i / 3) % 3);
+  }
+
+  BOOST_CHECK_EQUAL(testConfMtx, trueConfMtx);
+  BOOST_CHECK_EQUAL(testConfMtx.sum(), 10000.0f);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -1,8 +1,12 @@
 #define BOOST_TEST_MAIN
 #include <boost/test/unit_test.hpp>
 
+#include <set>
+
 #include <boost/assign/list_of.hpp>
+#include <boost/filesystem.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/thread/mutex.hpp>
 using boost::assign::list_of;
 using boost::assign::map_list_of;
 
@@ -25,6 +29,38 @@ float sum_squares_cost_fn(const ParamSet& params)
   return cost;
 }
 
+/**
+ * \brief An instance of this struct computes a sum of squares cost, counting the number of times it is called
+ *        and (optionally) recording the distinct parameter sets for which it is called.
+ */
+struct CountingCostFn
+{
+  size_t *callCount;
+  std::set<std::string> *distinctParamSets;
+  boost::mutex *mutex;
+
+  CountingCostFn(size_t *callCount_, boost::mutex *mutex_, std::set<std::string> *distinctParamSets_ = NULL)
+  : callCount(callCount_), distinctParamSets(distinctParamSets_), mutex(mutex_)
+  {}
+
+  float operator()(const ParamSet& params) const
+  {
+    {
+      boost::lock_guard<boost::mutex> lock(*mutex);
+      ++*callCount;
+      if(distinctParamSets) distinctParamSets->insert(ParamSetUtil::param_set_to_string(params));
+    }
+    return sum_squares_cost_fn(params);
+  }
+};
+
+void add_test_params(CoordinateDescentParameterOptimiser& optimiser)
+{
+  optimiser.add_param("Foo", NumberSequenceGenerator::generate_stepped<float>(-5.5f, 1.5f, 5.0f))
+           .add_param("Bar", list_of<float>(-2.0f)(-1.0f)(0.0f)(1.0f)(2.0f))
+           .add_param("Boo", list_of<float>(-10.0f)(-5.0f)(-2.0f)(0.0f)(5.0f)(15.0f));
+}
+
 //#################### TESTS ####################
 
 BOOST_AUTO_TEST_SUITE(test_CoordinateDescentParameterOptimiser)
@@ -58,4 +94,56 @@ BOOST_AUTO_TEST_CASE(optimise_for_parameters_test)
   BOOST_CHECK_CLOSE(cost, expectedCost, TOL);
 }
 
+BOOST_AUTO_TEST_CASE(cost_cache_test)
+{
+  const size_t epochCount = 20;
+  size_t callCount = 0;
+  std::set<std::string> distinctParamSets;
+  boost::mutex mutex;
+
+  CoordinateDescentParameterOptimiser optimiser(CountingCostFn(&callCount, &mutex, &distinctParamSets), epochCount, 12345);
+  add_test_params(optimiser);
+
+  float cost;
+  optimiser.optimise_for_parameters(&cost);
+
+  // Each distinct parameter set should have been costed exactly once across all of the restarts, so the cost function
+  // can have been called at most once for each of the 8 * 5 * 6 = 240 possible parameter sets.
+  BOOST_CHECK_CLOSE(cost, 0.25f, 1e-5f);
+  BOOST_CHECK_EQUAL(callCount, distinctParamSets.size());
+  BOOST_CHECK_LE(callCount, 240);
+}
+
+BOOST_AUTO_TEST_CASE(cost_cache_file_test)
+{
+  const boost::filesystem::path cacheFile = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("cdpo-%%%%-%%%%.txt");
+  const size_t epochCount = 5;
+  const unsigned int seed = 12345;
+
+  // Run the optimiser once, saving the costs it computes to the cache file.
+  size_t firstCallCount = 0;
+  boost::mutex mutex;
+  CoordinateDescentParameterOptimiser firstOptimiser(CountingCostFn(&firstCallCount, &mutex), epochCount, seed);
+  add_test_params(firstOptimiser);
+  firstOptimiser.use_cost_cache_file(cacheFile.string());
+
+  float firstCost;
+  ParamSet firstParams = firstOptimiser.optimise_for_parameters(&firstCost);
+  BOOST_CHECK_GT(firstCallCount, 0);
+
+  // Run an identically-seeded optimiser using the same cache file: it should reuse the saved costs rather than recomputing them.
+  size_t secondCallCount = 0;
+  CoordinateDescentParameterOptimiser secondOptimiser(CountingCostFn(&secondCallCount, &mutex), epochCount, seed);
+  add_test_params(secondOptimiser);
+  secondOptimiser.use_cost_cache_file(cacheFile.string());
+
+  float secondCost;
+  ParamSet secondParams = secondOptimiser.optimise_for_parameters(&secondCost);
+  BOOST_CHECK_EQUAL(secondCallCount, 0);
+  BOOST_CHECK_EQUAL(ParamSetUtil::param_set_to_string(secondParams), ParamSetUtil::param_set_to_string(firstParams));
+  BOOST_CHECK_EQUAL(secondCost, firstCost);
+
+  boost::filesystem::remove(cacheFile);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,176 @@
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <sstream>
+
+#include <boost/assign/list_of.hpp>
+#include <boost/bind.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/thread/mutex.hpp>
+using boost::assign::list_of;
+
+#include <evaluation/core/ParallelParamSetEvaluator.h>
+#include <evaluation/core/PerformanceMeasureUtil.h>
+#include <evaluation/splitgenerators/CrossValidationSplitGenerator.h>
+#include <evaluation/util/CartesianProductParameterSetGenerator.h>
+using namespace evaluation;
+
+//#################### HELPER TYPES ####################
+
+typedef ParallelParamSetEvaluator<int> Sweeper;
+
+/**
+ * \brief An instance of this class "evaluates" a learner by summing the validation examples and scaling the sum by a parameter.
+ */
+class SumEvaluator : public LearnerEvaluator<int,PerformanceResult>
+{
+private:
+  size_t *m_callCount;
+  boost::mutex *m_mutex;
+  float m_scale;
+
+public:
+  SumEvaluator(const SplitGenerator_Ptr& splitGenerator, const ParamSet& params, size_t *callCount, boost::mutex *mutex)
+  : LearnerEvaluator<int,PerformanceResult>(splitGenerator), m_callCount(callCount), m_mutex(mutex),
+    m_scale(boost::lexical_cast<float>(params.find("Scale")->second))
+  {}
+
+protected:
+  virtual PerformanceResult average_results(const std::vector<PerformanceResult>& results) const
+  {
+    return PerformanceMeasureUtil::average_results(results);
+  }
+
+  virtual PerformanceResult evaluate_on_split(const std::vector<Example_CPtr>& examples, const SplitGenerator::Split& split) const
+  {
+    {
+      boost::lock_guard<boost::mutex> lock(*m_mutex);
+      ++*m_callCount;
+    }
+
+    float sum = 0.0f;
+    for(size_t i = 0, size = split.second.size(); i < size; ++i) sum += *examples[split.second[i]];
+
+    PerformanceResult result;
+    result.insert(std::make_pair("Sum", PerformanceMeasure(m_scale * sum)));
+    return result;
+  }
+};
+
+//#################### HELPER FUNCTIONS ####################
+
+Sweeper::Evaluator_CPtr make_sum_evaluator(const SplitGenerator_Ptr& splitGenerator, size_t *callCount, boost::mutex *mutex, const ParamSet& params)
+{
+  return Sweeper::Evaluator_CPtr(new SumEvaluator(splitGenerator, params, callCount, mutex));
+}
+
+std::vector<boost::shared_ptr<const int> > make_examples()
+{
+  std::vector<boost::shared_ptr<const int> > examples;
+  for(int i = 0; i < 20; ++i) examples.push_back(boost::shared_ptr<const int>(new int(i)));
+  return examples;
+}
+
+std::vector<ParamSet> make_params()
+{
+  return CartesianProductParameterSetGenerator().add_param("Scale", list_of<float>(1.0f)(2.0f)(3.0f)(4.0f)).generate_param_sets();
+}
+
+/**
+ * \brief Outputs a performance table to a string, sorting its lines so that the result does not depend on the order in which the rows were recorded.
+ */
+std::string table_to_sorted_string(const PerformanceTable& table)
+{
+  std::ostringstream oss;
+  table.output(oss);
+
+  std::istringstream iss(oss.str());
+  std::vector<std::string> lines;
+  std::string line;
+  while(std::getline(iss, line)) lines.push_back(line);
+  std::sort(lines.begin(), lines.end());
+
+  std::string result;
+  for(size_t i = 0, size = lines.size(); i < size; ++i) result += lines[i] + '\n';
+  return result;
+}
+
+//#################### TESTS ####################
+
+BOOST_AUTO_TEST_SUITE(test_ParallelParamSetEvaluator)
+
+BOOST_AUTO_TEST_CASE(matches_serial_test)
+{
+  const unsigned int seed = 12345;
+  const size_t foldCount = 4;
+  std::vector<boost::shared_ptr<const int> > examples = make_examples();
+  std::vector<ParamSet> params = make_params();
+
+  size_t callCount = 0;
+  boost::mutex mutex;
+
+  // Evaluate the parameter sets serially, one after the other.
+  SplitGenerator_Ptr serialSplitGenerator(new CrossValidationSplitGenerator(seed, foldCount));
+  PerformanceTable serialTable(list_of("Sum"));
+  for(size_t i = 0, size = params.size(); i < size; ++i)
+  {
+    SumEvaluator evaluator(serialSplitGenerator, params[i], &callCount, &mutex);
+    serialTable.record_performance(params[i], evaluator.evaluate(examples));
+  }
+
+  // Evaluate the parameter sets in parallel.
+  SplitGenerator_Ptr parallelSplitGenerator(new CrossValidationSplitGenerator(seed, foldCount));
+  PerformanceTable parallelTable(list_of("Sum"));
+  Sweeper sweeper(boost::bind(make_sum_evaluator, parallelSplitGenerator, &callCount, &mutex, _1), 3);
+  sweeper.evaluate(params, examples, parallelTable);
+
+  // Check that each parameter set has the same result in both tables.
+  BOOST_CHECK_EQUAL(callCount, 2 * params.size() * foldCount);
+  BOOST_CHECK_EQUAL(table_to_sorted_string(serialTable), table_to_sorted_string(parallelTable));
+}
+
+BOOST_AUTO_TEST_CASE(checkpoint_test)
+{
+  const std::string checkpointFilename = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string();
+  std::vector<boost::shared_ptr<const int> > examples = make_examples();
+  std::vector<ParamSet> params = make_params();
+  const size_t foldCount = 4;
+
+  // Evaluate the first two parameter sets, checkpointing the results.
+  size_t firstCallCount = 0;
+  boost::mutex mutex;
+  PerformanceTable firstTable(list_of("Sum"));
+  {
+    SplitGenerator_Ptr splitGenerator(new CrossValidationSplitGenerator(12345, foldCount));
+    Sweeper sweeper(boost::bind(make_sum_evaluator, splitGenerator, &firstCallCount, &mutex, _1), 2, checkpointFilename);
+    sweeper.evaluate(std::vector<ParamSet>(params.begin(), params.begin() + 2), examples, firstTable);
+  }
+  BOOST_CHECK_EQUAL(firstCallCount, 2 * foldCount);
+
+  // Evaluate all of the parameter sets, resuming from the checkpoint. Only the last two parameter sets should be evaluated.
+  size_t secondCallCount = 0;
+  PerformanceTable resumedTable(list_of("Sum"));
+  {
+    SplitGenerator_Ptr splitGenerator(new CrossValidationSplitGenerator(12345, foldCount));
+    Sweeper sweeper(boost::bind(make_sum_evaluator, splitGenerator, &secondCallCount, &mutex, _1), 2, checkpointFilename);
+    sweeper.evaluate(params, examples, resumedTable);
+  }
+  BOOST_CHECK_EQUAL(secondCallCount, 2 * foldCount);
+
+  // Evaluate all of the parameter sets from scratch, and check that the results are the same as those of the resumed sweep.
+  size_t thirdCallCount = 0;
+  PerformanceTable freshTable(list_of("Sum"));
+  {
+    SplitGenerator_Ptr splitGenerator(new CrossValidationSplitGenerator(12345, foldCount));
+    Sweeper sweeper(boost::bind(make_sum_evaluator, splitGenerator, &thirdCallCount, &mutex, _1), 2);
+    sweeper.evaluate(params, examples, freshTable);
+  }
+  BOOST_CHECK_EQUAL(thirdCallCount, params.size() * foldCount);
+  BOOST_CHECK_EQUAL(table_to_sorted_string(resumedTable), table_to_sorted_string(freshTable));
+
+  boost::filesystem::remove(checkpointFilename);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
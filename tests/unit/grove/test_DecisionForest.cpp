@@ -0,0 +1,124 @@
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <fstream>
+
+#include <boost/filesystem.hpp>
+
+#include <grove/features/base/Descriptor.h>
+#include <grove/forests/cpu/DecisionForest_CPU.h>
+#include <grove/forests/cpu/DecisionForest_CPU.tpp>
+#include <grove/forests/interface/DecisionForest.tpp>
+using namespace grove;
+
+#include <itmx/base/MemoryBlockFactory.h>
+using namespace itmx;
+
+#include <tvgutil/numbers/RandomNumberGenerator.h>
+using namespace tvgutil;
+
+//#################### HELPER TYPES ####################
+
+typedef Descriptor<16> TestDescriptor;
+typedef DecisionForest_CPU<TestDescriptor,5> Forest;
+
+//#################### HELPER FUNCTIONS ####################
+
+/**
+ * \brief Makes an image of the specified size that is filled with random descriptors.
+ */
+Forest::DescriptorImage_CPtr make_random_descriptors(const Vector2i& size, RandomNumberGenerator& rng)
+{
+  Forest::DescriptorImage_Ptr descriptors = MemoryBlockFactory::instance().make_image<TestDescriptor>(size);
+  TestDescriptor *descriptorsPtr = descriptors->GetData(MEMORYDEVICE_CPU);
+  for(int i = 0, pixelCount = size.x * size.y; i < pixelCount; ++i)
+  {
+    for(int j = 0; j < TestDescriptor::FEATURE_COUNT; ++j)
+    {
+      descriptorsPtr[i].data[j] = rng.generate_real_from_uniform<float>(0.0f, 1.0f);
+    }
+  }
+  return descriptors;
+}
+
+/**
+ * \brief Writes a forest whose trees are complete binary trees of the specified depth with random split functions to a file.
+ */
+void write_random_forest(const std::string& filename, int depth, RandomNumberGenerator& rng)
+{
+  const int treeCount = 5;
+  const int leafCount = 1 << depth, nodeCount = 2 * leafCount - 1;
+
+  std::ofstream fs(filename.c_str());
+  fs << treeCount << '\n';
+  for(int i = 0; i < treeCount; ++i)
+  {
+    fs << nodeCount << ' ' << leafCount << '\n';
+  }
+
+  // The nodes of each tree are written in breadth-first order, so the children of node n are nodes 2n+1 and 2n+2.
+  for(int i = 0; i < treeCount; ++i)
+  {
+    for(int n = 0, leafIdx = 0; n < nodeCount; ++n)
+    {
+      if(n < nodeCount - leafCount)
+      {
+        const int featureIdx = rng.generate_int_from_uniform(0, TestDescriptor::FEATURE_COUNT - 1);
+        fs << 2 * n + 1 << " -1 " << featureIdx << ' ' << rng.generate_real_from_uniform<float>(0.0f, 1.0f) << '\n';
+      }
+      else fs << "-1 " << leafIdx++ << " 0 0\n";
+    }
+  }
+}
+
+//#################### TESTS ####################
+
+BOOST_AUTO_TEST_SUITE(test_DecisionForest)
+
+BOOST_AUTO_TEST_CASE(find_leaves_batch_test)
+{
+  MemoryBlockFactory::instance().set_device_type(DEVICE_CPU);
+  RandomNumberGenerator rng(12345);
+
+  const std::string filename = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string();
+  write_random_forest(filename, 6, rng);
+  Forest forest(filename);
+  boost::filesystem::remove(filename);
+
+  // Make several descriptors images of different sizes (including one whose height is not a multiple of the tile size),
+  // together with leaf indices images that are deliberately the wrong size.
+  std::vector<Forest::DescriptorImage_CPtr> descriptors;
+  std::vector<Forest::LeafIndicesImage_Ptr> batchLeafIndices, singleLeafIndices;
+  for(int i = 0; i < 4; ++i)
+  {
+    descriptors.push_back(make_random_descriptors(Vector2i(16 + 5 * i, 9 + 3 * i), rng));
+    batchLeafIndices.push_back(MemoryBlockFactory::instance().make_image<Forest::LeafIndices>(Vector2i(1, 1)));
+    singleLeafIndices.push_back(MemoryBlockFactory::instance().make_image<Forest::LeafIndices>(Vector2i(1, 1)));
+  }
+
+  // Check that finding the leaves for all of the images at once gives the same results as finding them for each image in turn.
+  forest.find_leaves(descriptors, batchLeafIndices);
+  for(size_t i = 0, size = descriptors.size(); i < size; ++i)
+  {
+    forest.find_leaves(descriptors[i], singleLeafIndices[i]);
+
+    BOOST_REQUIRE(batchLeafIndices[i]->noDims == descriptors[i]->noDims);
+    BOOST_REQUIRE(singleLeafIndices[i]->noDims == descriptors[i]->noDims);
+
+    const Forest::LeafIndices *batchPtr = batchLeafIndices[i]->GetData(MEMORYDEVICE_CPU);
+    const Forest::LeafIndices *singlePtr = singleLeafIndices[i]->GetData(MEMORYDEVICE_CPU);
+    for(int j = 0, pixelCount = descriptors[i]->noDims.x * descriptors[i]->noDims.y; j < pixelCount; ++j)
+    {
+      for(int k = 0; k < 5; ++k)
+      {
+        BOOST_CHECK_EQUAL(batchPtr[j][k], singlePtr[j][k]);
+      }
+    }
+  }
+
+  // Check that the batched version rejects mismatched numbers of descriptors and leaf indices images.
+  std::vector<Forest::LeafIndicesImage_Ptr> tooFewLeafIndices(batchLeafIndices.begin(), batchLeafIndices.end() - 1);
+  BOOST_CHECK_THROW(forest.find_leaves(descriptors, tooFewLeafIndices), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,149 @@
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <boost/math/special_functions/fpclassify.hpp>
+
+#include <infermous/engines/DenseMeanFieldInferenceEngine.h>
+#include <infermous/engines/MeanFieldInferenceEngine.h>
+using namespace infermous;
+
+#include <tvgutil/numbers/RandomNumberGenerator.h>
+using namespace tvgutil;
+
+//#################### HELPERS ####################
+
+enum Colour
+{
+  RED,
+  GREEN,
+  BLUE
+};
+
+namespace Eigen {
+template <> struct NumTraits<Colour> : NumTraits<int> {};
+}
+
+struct PottsPotentialCalculator : PairwisePotentialCalculator<Colour>
+{
+  virtual float calculate_potential(const Colour& l1, const Colour& l2) const
+  {
+    return l1 == l2 ? 0.0f : 0.25f;
+  }
+};
+
+ProbabilitiesGrid_Ptr<Colour> make_random_unaries(int height, int width, unsigned int seed)
+{
+  RandomNumberGenerator rng(seed);
+  ProbabilitiesGrid_Ptr<Colour> unaries(new ProbabilitiesGrid<Colour>(height, width));
+  for(int y = 0; y < height; ++y)
+  {
+    for(int x = 0; x < width; ++x)
+    {
+      std::map<Colour,float>& psi = (*unaries)(y, x);
+      psi[RED] = rng.generate_real_from_uniform<float>(0.1f, 1.0f);
+      psi[GREEN] = rng.generate_real_from_uniform<float>(0.1f, 1.0f);
+      psi[BLUE] = rng.generate_real_from_uniform<float>(0.1f, 1.0f);
+
+      float sum = psi[RED] + psi[GREEN] + psi[BLUE];
+      for(std::map<Colour,float>::iterator it = psi.begin(), iend = psi.end(); it != iend; ++it) it->second /= sum;
+    }
+  }
+  return unaries;
+}
+
+//#################### TESTS ####################
+
+BOOST_AUTO_TEST_SUITE(test_DenseMeanFieldInferenceEngine)
+
+BOOST_AUTO_TEST_CASE(matches_map_based_engine_test)
+{
+  const int height = 12, width = 17;
+  PairwisePotentialCalculator_CPtr<Colour> ppc(new PottsPotentialCalculator);
+  std::vector<Eigen::Vector2i> neighbourOffsets = CRFUtil::make_circular_neighbour_offsets(2);
+
+  CRF2D_Ptr<Colour> crf(new CRF2D<Colour>(make_random_unaries(height, width, 12345), ppc));
+  MeanFieldInferenceEngine<Colour> engine(crf, neighbourOffsets);
+  engine.update_crf(3);
+
+  CRF2D_Ptr<Colour> denseCRF(new CRF2D<Colour>(make_random_unaries(height, width, 12345), ppc));
+  DenseMeanFieldInferenceEngine<Colour> denseEngine(denseCRF, neighbourOffsets);
+  denseEngine.update_crf(3);
+
+  // The two engines should produce the same marginals (up to floating-point error).
+  for(int y = 0; y < height; ++y)
+  {
+    for(int x = 0; x < width; ++x)
+    {
+      const std::map<Colour,float>& Q = crf->get_marginals_at(Eigen::Vector2i(x, y));
+      const std::map<Colour,float>& denseQ = denseCRF->get_marginals_at(Eigen::Vector2i(x, y));
+      BOOST_REQUIRE_EQUAL(Q.size(), denseQ.size());
+      for(std::map<Colour,float>::const_iterator it = Q.begin(), iend = Q.end(); it != iend; ++it)
+      {
+        BOOST_CHECK_CLOSE(it->second, denseQ.find(it->first)->second, 1e-3f);
+      }
+    }
+  }
+
+  // The labels predicted directly from the dense marginals should be consistent with the marginals themselves.
+  Grid<Colour> labels = denseEngine.predict_labels();
+  for(int y = 0; y < height; ++y)
+  {
+    for(int x = 0; x < width; ++x)
+    {
+      const std::map<Colour,float>& denseQ = denseCRF->get_marginals_at(Eigen::Vector2i(x, y));
+      for(std::map<Colour,float>::const_iterator it = denseQ.begin(), iend = denseQ.end(); it != iend; ++it)
+      {
+        BOOST_CHECK(denseQ.find(labels(y, x))->second >= it->second);
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(missing_labels_test)
+{
+  // Make a CRF in which one pixel is missing one of the labels.
+  ProbabilitiesGrid_Ptr<Colour> unaries(new ProbabilitiesGrid<Colour>(1, 2));
+  (*unaries)(0, 0)[RED] = 0.5f;
+  (*unaries)(0, 0)[BLUE] = 0.5f;
+  (*unaries)(0, 1)[RED] = 0.2f;
+  (*unaries)(0, 1)[GREEN] = 0.3f;
+  (*unaries)(0, 1)[BLUE] = 0.5f;
+
+  CRF2D_Ptr<Colour> crf(new CRF2D<Colour>(unaries, PairwisePotentialCalculator_CPtr<Colour>(new PottsPotentialCalculator)));
+  DenseMeanFieldInferenceEngine<Colour> engine(crf, CRFUtil::make_square_neighbour_offsets(1));
+  engine.update_crf(2);
+
+  // The missing label should be treated as having zero probability.
+  BOOST_CHECK_EQUAL(engine.get_labels().size(), 3);
+  BOOST_CHECK_EQUAL(crf->get_marginals_at(Eigen::Vector2i(0, 0)).find(GREEN)->second, 0.0f);
+  BOOST_CHECK_CLOSE(crf->get_marginals_at(Eigen::Vector2i(1, 0)).find(GREEN)->second, 0.3f, 50.0f);
+}
+
+BOOST_AUTO_TEST_CASE(no_unaries_test)
+{
+  // Make a CRF in which one pixel has no unaries at all, and another has only zero-probability unaries.
+  ProbabilitiesGrid_Ptr<Colour> unaries(new ProbabilitiesGrid<Colour>(1, 3));
+  (*unaries)(0, 1)[RED] = 0.0f;
+  (*unaries)(0, 2)[RED] = 0.2f;
+  (*unaries)(0, 2)[GREEN] = 0.3f;
+  (*unaries)(0, 2)[BLUE] = 0.5f;
+
+  CRF2D_Ptr<Colour> crf(new CRF2D<Colour>(unaries, PairwisePotentialCalculator_CPtr<Colour>(new PottsPotentialCalculator)));
+  DenseMeanFieldInferenceEngine<Colour> engine(crf, CRFUtil::make_square_neighbour_offsets(1));
+  engine.update_crf(2);
+
+  // The marginals of every pixel should be finite and sum to one.
+  for(int x = 0; x < 3; ++x)
+  {
+    const std::map<Colour,float>& Q = crf->get_marginals_at(Eigen::Vector2i(x, 0));
+    float sum = 0.0f;
+    for(std::map<Colour,float>::const_iterator it = Q.begin(), iend = Q.end(); it != iend; ++it)
+    {
+      BOOST_CHECK((boost::math::isfinite)(it->second));
+      sum += it->second;
+    }
+    BOOST_CHECK_CLOSE(sum, 1.0f, 1e-3f);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,138 @@
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <boost/math/special_functions/fpclassify.hpp>
+
+#include <infermous/engines/FullyConnectedMeanFieldInferenceEngine.h>
+using namespace infermous;
+
+//#################### HELPERS ####################
+
+enum Colour
+{
+  RED,
+  GREEN,
+  BLUE
+};
+
+struct PottsPotentialCalculator : PairwisePotentialCalculator<Colour>
+{
+  virtual float calculate_potential(const Colour& l1, const Colour& l2) const
+  {
+    return l1 == l2 ? 0.0f : 1.0f;
+  }
+};
+
+typedef FullyConnectedMeanFieldInferenceEngine<Colour> Engine;
+
+Grid<Eigen::Vector3f> make_uniform_colours(int height, int width)
+{
+  Grid<Eigen::Vector3f> colours(height, width);
+  for(int y = 0; y < height; ++y)
+  {
+    for(int x = 0; x < width; ++x)
+    {
+      colours(y, x) = Eigen::Vector3f(128.0f, 128.0f, 128.0f);
+    }
+  }
+  return colours;
+}
+
+//#################### TESTS ####################
+
+BOOST_AUTO_TEST_SUITE(test_FullyConnectedMeanFieldInferenceEngine)
+
+BOOST_AUTO_TEST_CASE(no_pairwise_test)
+{
+  // Make a CRF in which each pixel has a different distribution over the labels.
+  ProbabilitiesGrid_Ptr<Colour> unaries(new ProbabilitiesGrid<Colour>(1, 2));
+  (*unaries)(0, 0)[RED] = 0.7f;
+  (*unaries)(0, 0)[GREEN] = 0.2f;
+  (*unaries)(0, 0)[BLUE] = 0.1f;
+  (*unaries)(0, 1)[RED] = 0.1f;
+  (*unaries)(0, 1)[GREEN] = 0.3f;
+  (*unaries)(0, 1)[BLUE] = 0.6f;
+
+  // If both kernels have zero weight, the marginals should just be the unaries.
+  CRF2D_Ptr<Colour> crf(new CRF2D<Colour>(unaries, PairwisePotentialCalculator_CPtr<Colour>(new PottsPotentialCalculator)));
+  Engine engine(crf, make_uniform_colours(1, 2), Engine::KernelParameters(0.0f, 80.0f, 13.0f, 0.0f, 3.0f));
+  engine.update_crf(3);
+
+  for(int x = 0; x < 2; ++x)
+  {
+    const std::map<Colour,float>& psi = (*unaries)(0, x);
+    const std::map<Colour,float>& Q = crf->get_marginals_at(Eigen::Vector2i(x, 0));
+    BOOST_REQUIRE_EQUAL(Q.size(), psi.size());
+    for(std::map<Colour,float>::const_iterator it = psi.begin(), iend = psi.end(); it != iend; ++it)
+    {
+      BOOST_CHECK_CLOSE(Q.find(it->first)->second, it->second, 1e-3f);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(no_unaries_test)
+{
+  // Make a CRF in which one pixel has no unaries at all, and another has only zero-probability unaries.
+  ProbabilitiesGrid_Ptr<Colour> unaries(new ProbabilitiesGrid<Colour>(1, 3));
+  (*unaries)(0, 1)[RED] = 0.0f;
+  (*unaries)(0, 2)[RED] = 0.2f;
+  (*unaries)(0, 2)[GREEN] = 0.3f;
+  (*unaries)(0, 2)[BLUE] = 0.5f;
+
+  CRF2D_Ptr<Colour> crf(new CRF2D<Colour>(unaries, PairwisePotentialCalculator_CPtr<Colour>(new PottsPotentialCalculator)));
+  Engine engine(crf, make_uniform_colours(1, 3));
+  engine.update_crf(2);
+
+  // The marginals of every pixel should be finite and sum to one.
+  for(int x = 0; x < 3; ++x)
+  {
+    const std::map<Colour,float>& Q = crf->get_marginals_at(Eigen::Vector2i(x, 0));
+    float sum = 0.0f;
+    for(std::map<Colour,float>::const_iterator it = Q.begin(), iend = Q.end(); it != iend; ++it)
+    {
+      BOOST_CHECK((boost::math::isfinite)(it->second));
+      sum += it->second;
+    }
+    BOOST_CHECK_CLOSE(sum, 1.0f, 1e-3f);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(smoothing_test)
+{
+  // Make a CRF in which every pixel prefers red, apart from the centre pixel, which weakly prefers green.
+  const int size = 5;
+  ProbabilitiesGrid_Ptr<Colour> unaries(new ProbabilitiesGrid<Colour>(size, size));
+  for(int y = 0; y < size; ++y)
+  {
+    for(int x = 0; x < size; ++x)
+    {
+      (*unaries)(y, x)[RED] = 0.8f;
+      (*unaries)(y, x)[GREEN] = 0.2f;
+    }
+  }
+  (*unaries)(2, 2)[RED] = 0.4f;
+  (*unaries)(2, 2)[GREEN] = 0.6f;
+
+  // Since all of the pixels have the same colour, the pairwise potentials should pull the centre pixel towards red.
+  CRF2D_Ptr<Colour> crf(new CRF2D<Colour>(unaries, PairwisePotentialCalculator_CPtr<Colour>(new PottsPotentialCalculator)));
+  Engine engine(crf, make_uniform_colours(size, size));
+  engine.update_crf(5);
+
+  Grid<Colour> labels = engine.predict_labels();
+  for(int y = 0; y < size; ++y)
+  {
+    for(int x = 0; x < size; ++x)
+    {
+      BOOST_CHECK_EQUAL(labels(y, x), RED);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(size_mismatch_test)
+{
+  ProbabilitiesGrid_Ptr<Colour> unaries(new ProbabilitiesGrid<Colour>(2, 3));
+  CRF2D_Ptr<Colour> crf(new CRF2D<Colour>(unaries, PairwisePotentialCalculator_CPtr<Colour>(new PottsPotentialCalculator)));
+  BOOST_CHECK_THROW(Engine(crf, make_uniform_colours(3, 2)), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
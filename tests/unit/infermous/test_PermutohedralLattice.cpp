@@ -0,0 +1,115 @@
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <infermous/base/PermutohedralLattice.h>
+using namespace infermous;
+
+#include <tvgutil/numbers/RandomNumberGenerator.h>
+using namespace tvgutil;
+
+//#################### HELPERS ####################
+
+/**
+ * \brief Filters the specified values with a unit-standard-deviation Gaussian in feature space by brute force.
+ */
+std::vector<float> brute_force_filter(const std::vector<float>& features, int featureDim, const std::vector<float>& values)
+{
+  const int pointCount = static_cast<int>(values.size());
+  std::vector<float> result(pointCount, 0.0f);
+  for(int i = 0; i < pointCount; ++i)
+  {
+    for(int j = 0; j < pointCount; ++j)
+    {
+      float distSquared = 0.0f;
+      for(int k = 0; k < featureDim; ++k)
+      {
+        const float delta = features[i * featureDim + k] - features[j * featureDim + k];
+        distSquared += delta * delta;
+      }
+      result[i] += expf(-distSquared / 2) * values[j];
+    }
+  }
+  return result;
+}
+
+//#################### TESTS ####################
+
+BOOST_AUTO_TEST_SUITE(test_PermutohedralLattice)
+
+BOOST_AUTO_TEST_CASE(approximation_test)
+{
+  const int featureDim = 3, pointCount = 500;
+  RandomNumberGenerator rng(12345);
+
+  std::vector<float> features(pointCount * featureDim), values(pointCount);
+  for(size_t i = 0; i < features.size(); ++i) features[i] = rng.generate_real_from_uniform<float>(0.0f, 4.0f);
+  for(int i = 0; i < pointCount; ++i) values[i] = rng.generate_real_from_uniform<float>(0.0f, 1.0f);
+
+  PermutohedralLattice lattice(features, featureDim);
+  BOOST_CHECK_EQUAL(lattice.get_point_count(), pointCount);
+
+  std::vector<float> filtered(pointCount);
+  lattice.filter(&values[0], &filtered[0], 1);
+  std::vector<float> expected = brute_force_filter(features, featureDim, values);
+
+  // The lattice only approximates the Gaussian, so we check that its output is strongly correlated with the exact result
+  // (up to an overall scale factor, which is absorbed by the kernel weights).
+  float dot = 0.0f, filteredNormSquared = 0.0f, expectedNormSquared = 0.0f;
+  for(int i = 0; i < pointCount; ++i)
+  {
+    dot += filtered[i] * expected[i];
+    filteredNormSquared += filtered[i] * filtered[i];
+    expectedNormSquared += expected[i] * expected[i];
+  }
+  BOOST_CHECK_GT(dot / sqrtf(filteredNormSquared * expectedNormSquared), 0.95f);
+}
+
+BOOST_AUTO_TEST_CASE(constant_values_test)
+{
+  const int featureDim = 2;
+  std::vector<float> features;
+  for(int y = 0; y < 20; ++y)
+  {
+    for(int x = 0; x < 20; ++x)
+    {
+      features.push_back(x / 3.0f);
+      features.push_back(y / 3.0f);
+    }
+  }
+
+  PermutohedralLattice lattice(features, featureDim);
+
+  // Filtering several channels at once should be the same as filtering them separately.
+  const int pointCount = lattice.get_point_count();
+  std::vector<float> ones(pointCount, 1.0f), twos(pointCount, 2.0f), interleaved(pointCount * 2);
+  for(int i = 0; i < pointCount; ++i)
+  {
+    interleaved[i * 2] = 1.0f;
+    interleaved[i * 2 + 1] = 2.0f;
+  }
+
+  std::vector<float> filteredOnes(pointCount), filteredTwos(pointCount), filteredInterleaved(pointCount * 2);
+  lattice.filter(&ones[0], &filteredOnes[0], 1);
+  lattice.filter(&twos[0], &filteredTwos[0], 1);
+  lattice.filter(&interleaved[0], &filteredInterleaved[0], 2);
+
+  for(int i = 0; i < pointCount; ++i)
+  {
+    BOOST_CHECK_CLOSE(filteredInterleaved[i * 2], filteredOnes[i], 1e-3f);
+    BOOST_CHECK_CLOSE(filteredInterleaved[i * 2 + 1], filteredTwos[i], 1e-3f);
+    BOOST_CHECK_CLOSE(filteredTwos[i], 2 * filteredOnes[i], 1e-3f);
+  }
+
+  // Away from the boundary of the grid, a constant signal should remain (approximately) constant after filtering.
+  const float centre = filteredOnes[10 * 20 + 10];
+  BOOST_CHECK_CLOSE(filteredOnes[9 * 20 + 11], centre, 10.0f);
+  BOOST_CHECK_CLOSE(filteredOnes[11 * 20 + 9], centre, 10.0f);
+}
+
+BOOST_AUTO_TEST_CASE(invalid_features_test)
+{
+  std::vector<float> features(5);
+  BOOST_CHECK_THROW(PermutohedralLattice(features, 2), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,107 @@
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <fstream>
+
+#include <boost/filesystem.hpp>
+
+#include <rafl/examples/ExampleUtil.h>
+using namespace rafl;
+
+//#################### HELPER TYPES ####################
+
+typedef int Label;
+typedef boost::shared_ptr<const Example<Label> > Example_CPtr;
+
+//#################### HELPER FUNCTIONS ####################
+
+/**
+ * \brief Makes a unique path for a temporary file.
+ *
+ * \return  A unique path for a temporary file.
+ */
+boost::filesystem::path make_temp_path()
+{
+  return boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("rafl-%%%%-%%%%");
+}
+
+/**
+ * \brief Checks that two sets of examples are the same.
+ *
+ * \param lhs The first set of examples.
+ * \param rhs The second set of examples.
+ */
+void check_examples_equal(const std::vector<Example_CPtr>& lhs, const std::vector<Example_CPtr>& rhs)
+{
+  BOOST_REQUIRE_EQUAL(lhs.size(), rhs.size());
+  for(size_t i = 0, size = lhs.size(); i < size; ++i)
+  {
+    BOOST_CHECK_EQUAL(lhs[i]->get_label(), rhs[i]->get_label());
+    BOOST_CHECK(*lhs[i]->get_descriptor() == *rhs[i]->get_descriptor());
+  }
+}
+
+//#################### TESTS ####################
+
+BOOST_AUTO_TEST_SUITE(test_ExampleUtil)
+
+BOOST_AUTO_TEST_CASE(convert_examples_to_binary_test)
+{
+  const boost::filesystem::path textPath = make_temp_path(), binaryPath = make_temp_path();
+  {
+    std::ofstream fs(textPath.string().c_str());
+    fs << "1.5, 2, -3, 7\n"
+       << "0.25 4 5 9\n"
+       << "\n"
+       << "-1, -2.5, 3.75, 7\n";
+  }
+
+  ExampleUtil::convert_examples_to_binary<Label>(textPath.string(), binaryPath.string());
+  BOOST_CHECK(BinaryExampleFormat::is_binary_example_file(binaryPath.string()));
+  BOOST_CHECK(!BinaryExampleFormat::is_binary_example_file(textPath.string()));
+
+  // Loading the binary file should yield the same examples as loading the text file.
+  std::vector<Example_CPtr> textExamples = ExampleUtil::load_examples<Label>(textPath.string());
+  BOOST_CHECK_EQUAL(textExamples.size(), 3);
+  check_examples_equal(ExampleUtil::load_examples<Label>(binaryPath.string()), textExamples);
+
+  boost::filesystem::remove(textPath);
+  boost::filesystem::remove(binaryPath);
+}
+
+BOOST_AUTO_TEST_CASE(read_chunk_test)
+{
+  std::vector<Example_CPtr> examples;
+  for(int i = 0; i < 10; ++i)
+  {
+    Descriptor_Ptr descriptor(new Descriptor(3, static_cast<float>(i)));
+    (*descriptor)[2] = -1.0f;
+    examples.push_back(Example_CPtr(new Example<Label>(descriptor, i % 3)));
+  }
+
+  const boost::filesystem::path binaryPath = make_temp_path();
+  ExampleUtil::save_binary_examples(examples, binaryPath.string());
+
+  // Streaming the examples in chunks should yield all of the examples, in order.
+  BinaryExampleReader<Label> reader(binaryPath.string());
+  BOOST_CHECK_EQUAL(reader.get_example_count(), 10);
+  BOOST_CHECK_EQUAL(reader.get_feature_count(), 3);
+
+  std::vector<Example_CPtr> streamedExamples;
+  while(reader.has_more_examples())
+  {
+    std::vector<Example_CPtr> chunk = reader.read_chunk(4);
+    BOOST_CHECK(chunk.size() == 4 || !reader.has_more_examples());
+    streamedExamples.insert(streamedExamples.end(), chunk.begin(), chunk.end());
+  }
+
+  check_examples_equal(streamedExamples, examples);
+  BOOST_CHECK(reader.read_chunk(4).empty());
+
+  // Reading the file with the wrong label type should fail.
+  BOOST_CHECK_THROW(BinaryExampleReader<double> wrongReader(binaryPath.string()), std::runtime_error);
+
+  boost::filesystem::remove(binaryPath);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,157 @@
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <boost/assign/list_of.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+using boost::assign::list_of;
+using boost::assign::map_list_of;
+
+#include <rafl/core/FlatRandomForest.h>
+#include <rafl/decisionfunctions/FeatureThresholdingDecisionFunctionGenerator.h>
+#include <rafl/decisionfunctions/PairwiseOpAndThresholdDecisionFunctionGenerator.h>
+#include <rafl/examples/UnitCircleExampleGenerator.h>
+using namespace rafl;
+
+//#################### HELPER TYPES ####################
+
+typedef int Label;
+typedef boost::shared_ptr<const Example<Label> > Example_CPtr;
+typedef FlatRandomForest<Label> FRF;
+typedef RandomForest<Label> RF;
+
+//#################### HELPER FUNCTIONS ####################
+
+/**
+ * \brief Checks that two PMFs assign (almost) the same mass to every label, treating missing labels as having a mass of zero.
+ */
+void check_pmfs_match(const tvgutil::ProbabilityMassFunction<Label>& expected, const tvgutil::ProbabilityMassFunction<Label>& actual)
+{
+  const std::map<Label,float>& expectedMasses = expected.get_masses();
+  const std::map<Label,float>& actualMasses = actual.get_masses();
+
+  for(std::map<Label,float>::const_iterator it = expectedMasses.begin(), iend = expectedMasses.end(); it != iend; ++it)
+  {
+    std::map<Label,float>::const_iterator jt = actualMasses.find(it->first);
+    BOOST_REQUIRE(jt != actualMasses.end());
+    BOOST_CHECK_SMALL(it->second - jt->second, 1e-5f);
+  }
+
+  for(std::map<Label,float>::const_iterator it = actualMasses.begin(), iend = actualMasses.end(); it != iend; ++it)
+  {
+    if(expectedMasses.find(it->first) == expectedMasses.end()) BOOST_CHECK_EQUAL(it->second, 0.0f);
+  }
+}
+
+/**
+ * \brief Trains a small random forest on examples drawn from the unit circle, using the specified type of decision function generator.
+ */
+boost::shared_ptr<RF> train_forest(const std::string& decisionFunctionGeneratorType, unsigned int seed)
+{
+  DecisionFunctionGeneratorFactory<Label>::instance().register_rafl_makers();
+
+  std::map<std::string,std::string> properties = map_list_of<std::string,std::string>
+    ("candidateCount", "64")
+    ("decisionFunctionGeneratorParams", "")
+    ("decisionFunctionGeneratorType", decisionFunctionGeneratorType)
+    ("gainThreshold", "0")
+    ("maxClassSize", "1000")
+    ("maxTreeHeight", "10")
+    ("randomSeed", boost::lexical_cast<std::string>(seed))
+    ("seenExamplesThreshold", "20")
+    ("splittabilityThreshold", "0.5")
+    ("usePMFReweighting", "1");
+
+  boost::shared_ptr<RF> forest(new RF(3, DecisionTree<Label>::Settings(properties)));
+
+  UnitCircleExampleGenerator<Label> generator(list_of(1)(2)(3)(4), seed);
+  forest->add_examples(generator.generate_examples(list_of(1)(2)(3)(4), 100));
+  forest->train(100);
+
+  return forest;
+}
+
+/**
+ * \brief Checks that a flat forest gives the same PMFs as an ordinary forest for a set of examples.
+ */
+void check_forests_match(const RF& forest, const FRF& flatForest, const std::vector<Example_CPtr>& examples)
+{
+  for(size_t i = 0, size = examples.size(); i < size; ++i)
+  {
+    const Descriptor_CPtr& descriptor = examples[i]->get_descriptor();
+    check_pmfs_match(forest.calculate_pmf(descriptor), flatForest.calculate_pmf(descriptor));
+    BOOST_CHECK_EQUAL(forest.predict(descriptor), flatForest.predict(descriptor));
+  }
+}
+
+//#################### TESTS ####################
+
+BOOST_AUTO_TEST_SUITE(test_FlatRandomForest)
+
+BOOST_AUTO_TEST_CASE(flatten_test)
+{
+  UnitCircleExampleGenerator<Label> testGenerator(list_of(1)(2)(3)(4), 5678);
+  std::vector<Example_CPtr> testExamples = testGenerator.generate_examples(list_of(1)(2)(3)(4), 50);
+
+  // Check that flattening forests that use either type of decision function preserves their PMFs.
+  boost::shared_ptr<RF> featureThresholdingForest = train_forest(FeatureThresholdingDecisionFunctionGenerator<Label>::get_static_type(), 1234);
+  FRF flatFeatureThresholdingForest(*featureThresholdingForest);
+  BOOST_CHECK_EQUAL(flatFeatureThresholdingForest.get_tree_count(), featureThresholdingForest->get_tree_count());
+  check_forests_match(*featureThresholdingForest, flatFeatureThresholdingForest, testExamples);
+
+  boost::shared_ptr<RF> pairwiseForest = train_forest(PairwiseOpAndThresholdDecisionFunctionGenerator<Label>::get_static_type(), 1234);
+  FRF flatPairwiseForest(*pairwiseForest);
+  check_forests_match(*pairwiseForest, flatPairwiseForest, testExamples);
+
+  // Check that the flat forest has the same number of nodes as the original forest.
+  size_t nodeCount = 0;
+  for(size_t i = 0, size = pairwiseForest->get_tree_count(); i < size; ++i) nodeCount += pairwiseForest->get_tree(i)->get_node_count();
+  BOOST_CHECK_EQUAL(flatPairwiseForest.get_node_count(), nodeCount);
+}
+
+BOOST_AUTO_TEST_CASE(save_load_test)
+{
+  const std::string filename = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string();
+
+  boost::shared_ptr<RF> forest = train_forest(PairwiseOpAndThresholdDecisionFunctionGenerator<Label>::get_static_type(), 9876);
+  FRF flatForest(*forest);
+  BOOST_REQUIRE(flatForest.has_leaf_histograms());
+
+  UnitCircleExampleGenerator<Label> testGenerator(list_of(1)(2)(3)(4), 5678);
+  std::vector<Example_CPtr> testExamples = testGenerator.generate_examples(list_of(1)(2)(3)(4), 50);
+
+  // Check that a forest saved without leaf histograms loads correctly, and does not have any leaf histograms.
+  flatForest.save(filename);
+  BOOST_CHECK(FlatRandomForestFormat::is_flat_forest_file(filename));
+  {
+    FRF loadedForest(filename);
+    BOOST_CHECK_EQUAL(loadedForest.get_node_count(), flatForest.get_node_count());
+    BOOST_CHECK_EQUAL(loadedForest.get_leaf_count(), flatForest.get_leaf_count());
+    BOOST_CHECK(!loadedForest.has_leaf_histograms());
+    check_forests_match(*forest, loadedForest, testExamples);
+  }
+
+  // Check that a forest saved with leaf histograms loads correctly, and has the same leaf histograms as the original.
+  flatForest.save(filename, true);
+  {
+    FRF loadedForest(filename);
+    BOOST_REQUIRE(loadedForest.has_leaf_histograms());
+    check_forests_match(*forest, loadedForest, testExamples);
+    for(size_t i = 0, leafCount = flatForest.get_leaf_count(); i < leafCount; ++i)
+    {
+      BOOST_CHECK(loadedForest.get_leaf_histogram(i).get_bins() == flatForest.get_leaf_histogram(i).get_bins());
+    }
+  }
+
+  // Check that trying to load a flat forest from a file that does not contain one causes a throw.
+  {
+    std::ofstream fs(filename.c_str());
+    fs << "Not a flat forest";
+  }
+  BOOST_CHECK(!FlatRandomForestFormat::is_flat_forest_file(filename));
+  BOOST_CHECK_THROW(FRF loadedForest(filename), std::runtime_error);
+
+  boost::filesystem::remove(filename);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,191 @@
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <boost/assign/list_of.hpp>
+using boost::assign::list_of;
+using boost::assign::map_list_of;
+
+#include <rafl/core/RandomForest.h>
+#include <rafl/decisionfunctions/FeatureThresholdingDecisionFunctionGenerator.h>
+#include <rafl/examples/UnitCircleExampleGenerator.h>
+using namespace rafl;
+
+//#################### HELPER TYPES ####################
+
+typedef int Label;
+typedef boost::shared_ptr<const Example<Label> > Example_CPtr;
+typedef RandomForest<Label> RF;
+
+//#################### HELPER FUNCTIONS ####################
+
+/**
+ * \brief Makes the settings for the trees in a small random forest that will be trained on examples drawn from the unit circle.
+ */
+DecisionTree<Label>::Settings make_settings()
+{
+  DecisionFunctionGeneratorFactory<Label>::instance().register_rafl_makers();
+
+  std::map<std::string,std::string> properties = map_list_of<std::string,std::string>
+    ("candidateCount", "64")
+    ("decisionFunctionGeneratorParams", "")
+    ("decisionFunctionGeneratorType", FeatureThresholdingDecisionFunctionGenerator<Label>::get_static_type())
+    ("gainThreshold", "0")
+    ("maxClassSize", "1000")
+    ("maxTreeHeight", "10")
+    ("randomSeed", "1234")
+    ("seenExamplesThreshold", "20")
+    ("splittabilityThreshold", "0.5")
+    ("usePMFReweighting", "1");
+
+  return DecisionTree<Label>::Settings(properties);
+}
+
+//#################### TESTS ####################
+
+BOOST_AUTO_TEST_SUITE(test_RandomForest)
+
+BOOST_AUTO_TEST_CASE(calculate_pmf_test)
+{
+  RF forest(3, make_settings());
+  UnitCircleExampleGenerator<Label> generator(list_of(1)(2)(3)(4), 1234);
+
+  // Check that calculating a PMF fails if none of the trees has any examples.
+  std::vector<Example_CPtr> testExamples = generator.generate_examples(list_of(1)(2)(3)(4), 10);
+  std::vector<float> denseMasses;
+  BOOST_CHECK_THROW(forest.calculate_pmf(testExamples[0]->get_descriptor(), denseMasses), std::runtime_error);
+  BOOST_CHECK_THROW(forest.calculate_pmf(testExamples[0]->get_descriptor()), std::runtime_error);
+
+  // Train the forest, and then reset one of its trees, so that the leaf that tree reaches for any descriptor is empty.
+  forest.add_examples(generator.generate_examples(list_of(1)(2)(3)(4), 100));
+  forest.train(100);
+  forest.reset_tree(0);
+
+  const std::vector<Label>& labels = forest.get_labels();
+  for(size_t i = 0, size = testExamples.size(); i < size; ++i)
+  {
+    const Descriptor_CPtr& descriptor = testExamples[i]->get_descriptor();
+
+    // Check that the empty tree would throw if its PMF were looked up individually.
+    BOOST_CHECK_THROW(forest.get_tree(0)->lookup_pmf(descriptor), std::runtime_error);
+
+    // Calculate the expected forest PMF by averaging the individual PMFs of the non-empty trees.
+    std::map<Label,float> expectedMasses;
+    for(size_t j = 1, treeCount = forest.get_tree_count(); j < treeCount; ++j)
+    {
+      const tvgutil::ProbabilityMassFunction<Label> treePMF = forest.get_tree(j)->lookup_pmf(descriptor);
+      const std::map<Label,float>& treeMasses = treePMF.get_masses();
+      for(std::map<Label,float>::const_iterator it = treeMasses.begin(), iend = treeMasses.end(); it != iend; ++it)
+      {
+        expectedMasses[it->first] += it->second / (treeCount - 1);
+      }
+    }
+
+    // Check that both the dense and map-based PMFs skip the empty tree and match the expected PMF.
+    forest.calculate_pmf(descriptor, denseMasses);
+    const std::map<Label,float> masses = forest.calculate_pmf(descriptor).get_masses();
+    BOOST_REQUIRE_EQUAL(denseMasses.size(), labels.size());
+    for(size_t k = 0, labelCount = labels.size(); k < labelCount; ++k)
+    {
+      std::map<Label,float>::const_iterator it = expectedMasses.find(labels[k]);
+      const float expectedMass = it != expectedMasses.end() ? it->second : 0.0f;
+      BOOST_CHECK_SMALL(denseMasses[k] - expectedMass, 1e-5f);
+
+      std::map<Label,float>::const_iterator jt = masses.find(labels[k]);
+      BOOST_CHECK_SMALL((jt != masses.end() ? jt->second : 0.0f) - expectedMass, 1e-5f);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(reset_tree_test)
+{
+  RF forest(3, make_settings());
+  UnitCircleExampleGenerator<Label> generator(list_of(1)(2)(3)(4), 1234);
+  forest.add_examples(generator.generate_examples(list_of(1)(2)(3)(4), 100));
+
+  // Start training in the background, and then reset one of the trees whilst the training is in progress.
+  forest.train_in_background(100);
+  forest.reset_tree(0);
+  BOOST_CHECK(forest.is_training_in_background());
+
+  // Wait for the training to finish, and check that the abandoned snapshot has not been swapped in for the reset tree.
+  forest.complete_background_training(true);
+  BOOST_CHECK_EQUAL(forest.get_tree(0)->get_node_count(), 1);
+  BOOST_CHECK_EQUAL(forest.get_tree(0)->get_class_frequencies().get_count(), 0);
+  for(size_t i = 1, size = forest.get_tree_count(); i < size; ++i)
+  {
+    BOOST_CHECK(forest.get_tree(i)->get_node_count() > 1);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(train_for_test)
+{
+  RF forest(3, make_settings());
+  UnitCircleExampleGenerator<Label> generator(list_of(1)(2)(3)(4), 1234);
+  forest.add_examples(generator.generate_examples(list_of(1)(2)(3)(4), 100));
+
+  // Check that training with a zero time budget does not split any nodes.
+  BOOST_CHECK_EQUAL(forest.train_for(boost::chrono::microseconds(0)), 0);
+
+  // Check that training with a generous time budget splits some nodes.
+  BOOST_CHECK(forest.train_for(boost::chrono::seconds(10)) > 0);
+}
+
+BOOST_AUTO_TEST_CASE(train_in_background_skip_test)
+{
+  RF forest(3, make_settings());
+  UnitCircleExampleGenerator<Label> generator(list_of(1)(2)(3)(4), 1234);
+
+  // Check that trees with no nodes worth splitting are not snapshotted.
+  forest.train_in_background(100);
+  BOOST_CHECK(!forest.is_training_in_background());
+
+  // Check that trees with splittable nodes are snapshotted.
+  const boost::chrono::microseconds minSnapshotInterval = boost::chrono::seconds(60);
+  forest.add_examples(generator.generate_examples(list_of(1)(2)(3)(4), 100));
+  forest.train_in_background(100, minSnapshotInterval);
+  BOOST_CHECK(forest.is_training_in_background());
+  forest.complete_background_training(true);
+
+  // Check that the trees are not snapshotted again within the minimum snapshot interval, even if they have become splittable again.
+  forest.add_examples(generator.generate_examples(list_of(1)(2)(3)(4), 100));
+  forest.train_in_background(100, minSnapshotInterval);
+  BOOST_CHECK(!forest.is_training_in_background());
+}
+
+BOOST_AUTO_TEST_CASE(train_in_background_test)
+{
+  RF forest(3, make_settings());
+  UnitCircleExampleGenerator<Label> generator(list_of(1)(2)(3)(4), 1234);
+  forest.add_examples(generator.generate_examples(list_of(1)(2)(3)(4), 100));
+
+  // Start training in the background, and add some more examples whilst the training is in progress.
+  forest.train_in_background(100);
+  BOOST_CHECK(forest.is_training_in_background());
+  BOOST_CHECK_EQUAL(forest.train(100), 0);
+  for(int i = 0; i < 10; ++i)
+  {
+    forest.add_examples(generator.generate_examples(list_of(1)(2)(3)(4), 10));
+  }
+
+  // Wait for the training to finish, and check that the trained trees have been swapped in.
+  forest.complete_background_training(true);
+  BOOST_CHECK(!forest.is_training_in_background());
+
+  for(size_t i = 0, size = forest.get_tree_count(); i < size; ++i)
+  {
+    // Check that no examples were lost whilst the trees were being trained.
+    BOOST_CHECK_EQUAL(forest.get_tree(i)->get_class_frequencies().get_count(), 800);
+
+    // Check that the trees have actually been trained.
+    BOOST_CHECK(forest.get_tree(i)->get_node_count() > 1);
+  }
+
+  // Check that the forest can still be used for prediction.
+  std::vector<Example_CPtr> testExamples = generator.generate_examples(list_of(1)(2)(3)(4), 10);
+  for(size_t i = 0, size = testExamples.size(); i < size; ++i)
+  {
+    BOOST_CHECK_EQUAL(forest.calculate_pmf(testExamples[i]->get_descriptor()).get_masses().empty(), false);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,144 @@
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#include <spaint/imageprocessing/NativeMedianFilterer.h>
+using namespace spaint;
+
+#include <tvgutil/numbers/RandomNumberGenerator.h>
+using namespace tvgutil;
+
+//#################### HELPER FUNCTIONS ####################
+
+/**
+ * \brief Computes the median-filtered version of an RGBA image by brute force.
+ *
+ * Each channel is filtered independently, and pixels beyond the borders of the image are treated as copies
+ * of the nearest pixel inside it.
+ *
+ * \param input       The input image.
+ * \param kernelWidth The kernel width to use for median filtering.
+ * \return            The median-filtered image.
+ */
+ITMUChar4Image_Ptr brute_force_median(const ITMUChar4Image_CPtr& input, int kernelWidth)
+{
+  const int width = input->noDims.x, height = input->noDims.y, radius = kernelWidth / 2;
+  ITMUChar4Image_Ptr output(new ITMUChar4Image(input->noDims, true, false));
+  const Vector4u *inputPtr = input->GetData(MEMORYDEVICE_CPU);
+  Vector4u *outputPtr = output->GetData(MEMORYDEVICE_CPU);
+
+  for(int y = 0; y < height; ++y)
+  {
+    for(int x = 0; x < width; ++x)
+    {
+      for(int c = 0; c < 4; ++c)
+      {
+        std::vector<unsigned char> values;
+        for(int dy = -radius; dy <= radius; ++dy)
+        {
+          for(int dx = -radius; dx <= radius; ++dx)
+          {
+            const int nx = std::min(std::max(x + dx, 0), width - 1);
+            const int ny = std::min(std::max(y + dy, 0), height - 1);
+            values.push_back(inputPtr[ny * width + nx][c]);
+          }
+        }
+
+        std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+        outputPtr[y * width + x][c] = values[values.size() / 2];
+      }
+    }
+  }
+
+  return output;
+}
+
+/**
+ * \brief Checks that two RGBA images are the same.
+ *
+ * \param lhs The first image.
+ * \param rhs The second image.
+ */
+void check_images_equal(const ITMUChar4Image_CPtr& lhs, const ITMUChar4Image_CPtr& rhs)
+{
+  BOOST_REQUIRE_EQUAL(lhs->noDims.x, rhs->noDims.x);
+  BOOST_REQUIRE_EQUAL(lhs->noDims.y, rhs->noDims.y);
+
+  const Vector4u *lhsPtr = lhs->GetData(MEMORYDEVICE_CPU);
+  const Vector4u *rhsPtr = rhs->GetData(MEMORYDEVICE_CPU);
+  for(int i = 0, pixelCount = lhs->noDims.x * lhs->noDims.y; i < pixelCount; ++i)
+  {
+    for(int c = 0; c < 4; ++c)
+    {
+      BOOST_CHECK_EQUAL(static_cast<int>(lhsPtr[i][c]), static_cast<int>(rhsPtr[i][c]));
+    }
+  }
+}
+
+/**
+ * \brief Makes an RGBA image of the specified size that is filled with random pixels.
+ *
+ * \param size  The size of the image.
+ * \param rng   The random number generator to use.
+ * \return      The image.
+ */
+ITMUChar4Image_Ptr make_random_image(const Vector2i& size, RandomNumberGenerator& rng)
+{
+  ITMUChar4Image_Ptr image(new ITMUChar4Image(size, true, false));
+  Vector4u *imagePtr = image->GetData(MEMORYDEVICE_CPU);
+  for(int i = 0, pixelCount = size.x * size.y; i < pixelCount; ++i)
+  {
+    for(int c = 0; c < 4; ++c)
+    {
+      imagePtr[i][c] = static_cast<unsigned char>(rng.generate_int_from_uniform(0, 255));
+    }
+  }
+  return image;
+}
+
+//#################### TESTS ####################
+
+BOOST_AUTO_TEST_SUITE(test_NativeMedianFilterer)
+
+BOOST_AUTO_TEST_CASE(brute_force_test)
+{
+  RandomNumberGenerator rng(12345);
+
+  // Check the filterer against a brute-force median for both kernel widths, on images that are large enough to have an
+  // interior as well as images that are narrower or shorter than the kernel (so that every pixel is affected by the borders).
+  const int kernelWidths[] = { 3, 5 };
+  const Vector2i sizes[] = { Vector2i(17, 11), Vector2i(1, 6), Vector2i(6, 2), Vector2i(1, 1) };
+  for(size_t i = 0; i < sizeof(kernelWidths) / sizeof(int); ++i)
+  {
+    NativeMedianFilterer filterer(kernelWidths[i], DEVICE_CPU);
+    for(size_t j = 0; j < sizeof(sizes) / sizeof(Vector2i); ++j)
+    {
+      ITMUChar4Image_Ptr input = make_random_image(sizes[j], rng);
+      ITMUChar4Image_Ptr output(new ITMUChar4Image(Vector2i(1, 1), true, false));
+      filterer(input, output);
+      check_images_equal(output, brute_force_median(input, kernelWidths[i]));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(in_place_test)
+{
+  RandomNumberGenerator rng(12345);
+  NativeMedianFilterer filterer(5, DEVICE_CPU);
+
+  // Check that filtering an image in place gives the same result as filtering it into a separate image.
+  ITMUChar4Image_Ptr image = make_random_image(Vector2i(13, 9), rng);
+  ITMUChar4Image_Ptr expected = brute_force_median(image, 5);
+  filterer(image, image);
+  check_images_equal(image, expected);
+}
+
+BOOST_AUTO_TEST_CASE(kernel_width_test)
+{
+  BOOST_CHECK_THROW(NativeMedianFilterer(4, DEVICE_CPU), std::invalid_argument);
+  BOOST_CHECK_THROW(NativeMedianFilterer(7, DEVICE_CPU), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
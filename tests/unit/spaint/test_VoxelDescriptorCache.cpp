@@ -0,0 +1,88 @@
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <spaint/features/VoxelDescriptorCache.h>
+using namespace rafl;
+using namespace spaint;
+
+//#################### HELPER FUNCTIONS ####################
+
+/**
+ * \brief Makes a single-element descriptor with the specified value.
+ */
+Descriptor_CPtr make_descriptor(float value)
+{
+  return Descriptor_CPtr(new Descriptor(1, value));
+}
+
+//#################### TESTS ####################
+
+BOOST_AUTO_TEST_SUITE(test_VoxelDescriptorCache)
+
+BOOST_AUTO_TEST_CASE(age_test)
+{
+  VoxelDescriptorCache cache(10, 2);
+  const Vector3s v(1, 2, 3);
+  cache.insert(v, make_descriptor(1.0f), 0, 5);
+
+  // Check that the descriptor can be reused until the voxel's block has been fused into more than the maximum number of times.
+  BOOST_CHECK(cache.lookup(v, 0, 5));
+  BOOST_CHECK(cache.lookup(v, 0, 7));
+  BOOST_CHECK(!cache.lookup(v, 0, 8));
+
+  // Check that the stale descriptor has been removed from the cache.
+  BOOST_CHECK_EQUAL(cache.size(), 0);
+
+  // Check that reinserting the descriptor for the voxel resets its age.
+  cache.insert(v, make_descriptor(2.0f), 0, 8);
+  Descriptor_CPtr descriptor = cache.lookup(v, 0, 10);
+  BOOST_REQUIRE(descriptor);
+  BOOST_CHECK_EQUAL((*descriptor)[0], 2.0f);
+}
+
+BOOST_AUTO_TEST_CASE(lru_test)
+{
+  VoxelDescriptorCache cache(2, 0);
+  const Vector3s a(0, 0, 0), b(0, 0, 1), c(-1, 0, 0);
+  cache.insert(a, make_descriptor(1.0f), 0, 0);
+  cache.insert(b, make_descriptor(2.0f), 0, 0);
+
+  // Use the descriptor for a, so that b becomes the least recently used entry, and then check that inserting
+  // the descriptor for c evicts b rather than a.
+  BOOST_CHECK(cache.lookup(a, 0, 0));
+  cache.insert(c, make_descriptor(3.0f), 0, 0);
+  BOOST_CHECK_EQUAL(cache.size(), 2);
+  BOOST_CHECK(cache.lookup(a, 0, 0));
+  BOOST_CHECK(!cache.lookup(b, 0, 0));
+  BOOST_CHECK(cache.lookup(c, 0, 0));
+
+  // Check that updating an existing entry neither grows the cache nor evicts anything.
+  cache.insert(a, make_descriptor(4.0f), 0, 0);
+  BOOST_CHECK_EQUAL(cache.size(), 2);
+  BOOST_CHECK_EQUAL((*cache.lookup(a, 0, 0))[0], 4.0f);
+  BOOST_CHECK(cache.lookup(c, 0, 0));
+}
+
+BOOST_AUTO_TEST_CASE(scene_change_test)
+{
+  VoxelDescriptorCache cache(10, 2);
+  const Vector3s v(1, 2, 3);
+  cache.insert(v, make_descriptor(1.0f), 0, 0);
+
+  // Check that the descriptor is treated as stale once the scene has changed as a whole, even if the fusion count
+  // of the voxel's block has not moved on (e.g. because the fusion counts were cleared when the scene was reset).
+  BOOST_CHECK(cache.lookup(v, 0, 0));
+  BOOST_CHECK(!cache.lookup(v, 1, 0));
+  BOOST_CHECK_EQUAL(cache.size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(zero_capacity_test)
+{
+  VoxelDescriptorCache cache(0, 0);
+  const Vector3s v(1, 2, 3);
+  cache.insert(v, make_descriptor(1.0f), 0, 0);
+  BOOST_CHECK_EQUAL(cache.size(), 0);
+  BOOST_CHECK(!cache.lookup(v, 0, 0));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,171 @@
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#include <ITMLib/Core/ITMDenseMapper.h>
+using namespace ITMLib;
+
+#include <itmx/base/MemoryBlockFactory.h>
+using namespace itmx;
+
+#include <spaint/markers/cpu/VoxelMarker_CPU.h>
+using namespace spaint;
+
+//#################### HELPER TYPES ####################
+
+typedef SpaintVoxel::PackedLabel PackedLabel;
+
+//#################### FIXTURES ####################
+
+/**
+ * \brief An instance of this class provides the context needed for a voxel marking test.
+ */
+class VoxelMarkerFixture
+{
+  //#################### PUBLIC VARIABLES ####################
+public:
+  /** A voxel in the voxel block at (0,0,0). */
+  Vector3s a;
+
+  /** A voxel in the voxel block at (-1,0,0). */
+  Vector3s b;
+
+  /** A voxel in the (unallocated) voxel block at (1,0,0). */
+  Vector3s c;
+
+  /** The voxel marker. */
+  VoxelMarker_CPU marker;
+
+  /** The scene in which to mark voxels. */
+  boost::shared_ptr<SpaintVoxelScene> scene;
+
+  /** The settings used to construct the scene. */
+  ITMLibSettings settings;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  VoxelMarkerFixture()
+  : a(1, 2, 3), b(-1, 5, 7), c(SDF_BLOCK_SIZE + 1, 0, 0)
+  {
+    MemoryBlockFactory::instance().set_device_type(DEVICE_CPU);
+    settings.deviceType = ITMLibSettings::DEVICE_CPU;
+
+    // Make an empty scene, and then directly allocate the voxel blocks at (0,0,0) and (-1,0,0) in its hash table.
+    scene.reset(new SpaintVoxelScene(&settings.sceneParams, false, MEMORYDEVICE_CPU));
+    ITMDenseMapper<SpaintVoxel,ITMVoxelIndex>(&settings).ResetScene(scene.get());
+
+    ITMHashEntry *hashTable = scene->index.GetEntries();
+    const Vector3s blockPositions[] = { Vector3s(0, 0, 0), Vector3s(-1, 0, 0) };
+    for(int i = 0; i < 2; ++i)
+    {
+      ITMHashEntry& entry = hashTable[hashIndex(blockPositions[i])];
+      entry.pos = blockPositions[i];
+      entry.offset = 0;
+      entry.ptr = i;
+    }
+  }
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Gets the label of the specified voxel in the scene.
+   *
+   * \param loc The location of the voxel.
+   * \return    The label of the voxel.
+   */
+  PackedLabel get_label(const Vector3s& loc) const
+  {
+    bool isFound;
+    const int voxelAddress = findVoxel(scene->index.getIndexData(), loc.toInt(), isFound);
+    BOOST_REQUIRE(isFound);
+    return scene->localVBA.GetVoxelBlocks()[voxelAddress].packedLabel;
+  }
+
+  /**
+   * \brief Marks the specified voxels in the scene with the specified labels.
+   *
+   * \param locs            The locations of the voxels.
+   * \param labels          The labels with which to mark the voxels (one per voxel).
+   * \param mode            The marking mode.
+   * \param oldVoxelLabels  A vector into which to store the old labels of the voxels.
+   */
+  void mark_voxels(const std::vector<Vector3s>& locs, const std::vector<PackedLabel>& labels, MarkingMode mode, std::vector<PackedLabel>& oldVoxelLabels) const
+  {
+    const MemoryBlockFactory& mbf = MemoryBlockFactory::instance();
+    boost::shared_ptr<ORUtils::MemoryBlock<Vector3s> > locsMB = mbf.make_block<Vector3s>(locs.size());
+    boost::shared_ptr<ORUtils::MemoryBlock<PackedLabel> > labelsMB = mbf.make_block<PackedLabel>(labels.size());
+    boost::shared_ptr<ORUtils::MemoryBlock<PackedLabel> > oldLabelsMB = mbf.make_block<PackedLabel>(locs.size());
+    std::copy(locs.begin(), locs.end(), locsMB->GetData(MEMORYDEVICE_CPU));
+    std::copy(labels.begin(), labels.end(), labelsMB->GetData(MEMORYDEVICE_CPU));
+
+    marker.mark_voxels(*locsMB, *labelsMB, scene.get(), mode, oldLabelsMB.get());
+
+    const PackedLabel *oldLabels = oldLabelsMB->GetData(MEMORYDEVICE_CPU);
+    oldVoxelLabels.assign(oldLabels, oldLabels + locs.size());
+  }
+};
+
+//#################### TESTS ####################
+
+BOOST_FIXTURE_TEST_SUITE(test_VoxelMarker, VoxelMarkerFixture)
+
+BOOST_AUTO_TEST_CASE(forced_marking_test)
+{
+  // Mark some voxels with forced marking, including duplicates of a and b, and a voxel in an unallocated block.
+  std::vector<Vector3s> locs;
+  std::vector<PackedLabel> labels;
+  locs.push_back(a); labels.push_back(PackedLabel(1, SpaintVoxel::LG_USER));
+  locs.push_back(b); labels.push_back(PackedLabel(2, SpaintVoxel::LG_USER));
+  locs.push_back(a); labels.push_back(PackedLabel(3, SpaintVoxel::LG_USER));
+  locs.push_back(c); labels.push_back(PackedLabel(4, SpaintVoxel::LG_USER));
+  locs.push_back(b); labels.push_back(PackedLabel(5, SpaintVoxel::LG_FOREST));
+
+  std::vector<PackedLabel> oldLabels;
+  mark_voxels(locs, labels, FORCED_MARKING, oldLabels);
+
+  // The final label of each voxel should be the last one specified for it.
+  BOOST_CHECK(get_label(a) == PackedLabel(3, SpaintVoxel::LG_USER));
+  BOOST_CHECK(get_label(b) == PackedLabel(5, SpaintVoxel::LG_FOREST));
+
+  // Each duplicate of a voxel should have been given the label the voxel had before the call as its old label.
+  const int allocatedIndices[] = { 0, 1, 2, 4 };
+  for(int i = 0; i < 4; ++i)
+  {
+    BOOST_CHECK(oldLabels[allocatedIndices[i]] == PackedLabel());
+  }
+
+  // Forcibly re-marking the voxels with their old labels should undo the operation.
+  std::vector<PackedLabel> undoOldLabels;
+  mark_voxels(locs, oldLabels, FORCED_MARKING, undoOldLabels);
+  BOOST_CHECK(get_label(a) == PackedLabel());
+  BOOST_CHECK(get_label(b) == PackedLabel());
+}
+
+BOOST_AUTO_TEST_CASE(normal_marking_test)
+{
+  // Mark a and b several times each with normal marking. Since whether a label can overwrite another one depends on both
+  // labels, the final labels depend on the order in which the duplicates are applied.
+  std::vector<Vector3s> locs;
+  std::vector<PackedLabel> labels;
+  locs.push_back(a); labels.push_back(PackedLabel(1, SpaintVoxel::LG_FOREST));
+  locs.push_back(b); labels.push_back(PackedLabel(2, SpaintVoxel::LG_USER));
+  locs.push_back(a); labels.push_back(PackedLabel(3, SpaintVoxel::LG_FOREST));
+  locs.push_back(b); labels.push_back(PackedLabel(4, SpaintVoxel::LG_FOREST));
+
+  std::vector<PackedLabel> oldLabels;
+  mark_voxels(locs, labels, NORMAL_MARKING, oldLabels);
+
+  // The final label of each voxel should be the one that marking the entries one by one in input order would give:
+  // the later forest label for a should overwrite the earlier one, but the forest label for b should not overwrite
+  // the user label that precedes it.
+  BOOST_CHECK(get_label(a) == PackedLabel(3, SpaintVoxel::LG_FOREST));
+  BOOST_CHECK(get_label(b) == PackedLabel(2, SpaintVoxel::LG_USER));
+  for(size_t i = 0, size = oldLabels.size(); i < size; ++i)
+  {
+    BOOST_CHECK(oldLabels[i] == PackedLabel());
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,188 @@
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <boost/assign/list_of.hpp>
+#include <boost/bind.hpp>
+using boost::assign::list_of;
+
+#include <tvgutil/misc/BoundedThreadPool.h>
+using namespace tvgutil;
+using namespace tvgutil::bounded_thread_pool;
+
+namespace {
+
+/**
+ * \brief An instance of this struct can be used to block the worker threads of a pool until it is opened.
+ */
+struct Gate
+{
+  boost::mutex mutex;
+  boost::condition_variable opened;
+  bool isOpen;
+
+  Gate() : isOpen(false) {}
+
+  void open()
+  {
+    boost::lock_guard<boost::mutex> lock(mutex);
+    isOpen = true;
+    opened.notify_all();
+  }
+
+  void wait()
+  {
+    boost::unique_lock<boost::mutex> lock(mutex);
+    while(!isOpen) opened.wait(lock);
+  }
+};
+
+void append(boost::mutex *mutex, std::vector<int> *values, int value)
+{
+  boost::lock_guard<boost::mutex> lock(*mutex);
+  values->push_back(value);
+}
+
+void increment(boost::mutex *mutex, int *counter)
+{
+  boost::lock_guard<boost::mutex> lock(*mutex);
+  ++*counter;
+}
+
+void throw_error()
+{
+  throw std::runtime_error("Failed");
+}
+
+void throw_non_standard_error()
+{
+  throw 23;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(test_BoundedThreadPool)
+
+BOOST_AUTO_TEST_CASE(discard_test)
+{
+  Gate gate;
+  BoundedThreadPool pool(1, 2, QFS_DISCARD);
+
+  // Occupy the only worker thread, and wait until it has taken the blocking task from the queue.
+  pool.post_task(boost::bind(&Gate::wait, &gate));
+  while(pool.get_statistics().queueSize != 0) boost::this_thread::yield();
+
+  boost::mutex mutex;
+  int counter = 0;
+  BOOST_CHECK_EQUAL(pool.post_task(boost::bind(&increment, &mutex, &counter)), true);
+  BOOST_CHECK_EQUAL(pool.post_task(boost::bind(&increment, &mutex, &counter)), true);
+  BOOST_CHECK_EQUAL(pool.post_task(boost::bind(&increment, &mutex, &counter)), false);
+
+  BoundedThreadPool::Statistics statistics = pool.get_statistics();
+  BOOST_CHECK_EQUAL(statistics.queueSize, 2);
+  BOOST_CHECK_EQUAL(statistics.peakQueueSize, 2);
+  BOOST_CHECK_EQUAL(statistics.discardedTaskCount, 1);
+
+  gate.open();
+  pool.wait_until_idle();
+  BOOST_CHECK_EQUAL(counter, 2);
+  BOOST_CHECK_EQUAL(pool.get_statistics().completedTaskCount, 3);
+}
+
+BOOST_AUTO_TEST_CASE(discard_oldest_test)
+{
+  Gate gate;
+  BoundedThreadPool pool(1, 1, QFS_DISCARD_OLDEST);
+
+  pool.post_task(boost::bind(&Gate::wait, &gate));
+  while(pool.get_statistics().queueSize != 0) boost::this_thread::yield();
+
+  boost::mutex mutex;
+  int first = 0, second = 0;
+  BOOST_CHECK_EQUAL(pool.post_task(boost::bind(&increment, &mutex, &first)), true);
+  BOOST_CHECK_EQUAL(pool.post_task(boost::bind(&increment, &mutex, &second)), true);
+
+  gate.open();
+  pool.wait_until_idle();
+  BOOST_CHECK_EQUAL(first, 0);
+  BOOST_CHECK_EQUAL(second, 1);
+  BOOST_CHECK_EQUAL(pool.get_statistics().discardedTaskCount, 1);
+}
+
+BOOST_AUTO_TEST_CASE(discard_priority_test)
+{
+  Gate gate;
+  BoundedThreadPool pool(1, 2, QFS_DISCARD);
+
+  pool.post_task(boost::bind(&Gate::wait, &gate));
+  while(pool.get_statistics().queueSize != 0) boost::this_thread::yield();
+
+  boost::mutex mutex;
+  std::vector<int> values;
+  BOOST_CHECK_EQUAL(pool.post_task(boost::bind(&append, &mutex, &values, 0), TP_LOW), true);
+  BOOST_CHECK_EQUAL(pool.post_task(boost::bind(&append, &mutex, &values, 1), TP_HIGH), true);
+
+  // A new high-priority task should displace the queued low-priority task, but not the queued high-priority one.
+  BOOST_CHECK_EQUAL(pool.post_task(boost::bind(&append, &mutex, &values, 2), TP_HIGH), true);
+  BOOST_CHECK_EQUAL(pool.post_task(boost::bind(&append, &mutex, &values, 3), TP_HIGH), false);
+
+  // A new normal-priority task should not displace either of the queued high-priority tasks.
+  BOOST_CHECK_EQUAL(pool.post_task(boost::bind(&append, &mutex, &values, 4)), false);
+
+  gate.open();
+  pool.wait_until_idle();
+  BOOST_CHECK(values == std::vector<int>(list_of(1)(2)));
+  BOOST_CHECK_EQUAL(pool.get_statistics().discardedTaskCount, 3);
+}
+
+BOOST_AUTO_TEST_CASE(exception_test)
+{
+  BoundedThreadPool pool(2, 4);
+  pool.post_task(&throw_error);
+  pool.post_task(&throw_non_standard_error);
+  pool.wait_until_idle();
+  BOOST_CHECK_EQUAL(pool.get_statistics().failedTaskCount, 2);
+  BOOST_CHECK_EQUAL(pool.get_statistics().completedTaskCount, 0);
+}
+
+BOOST_AUTO_TEST_CASE(priority_test)
+{
+  Gate gate;
+  BoundedThreadPool pool(1, 8);
+
+  pool.post_task(boost::bind(&Gate::wait, &gate));
+  while(pool.get_statistics().queueSize != 0) boost::this_thread::yield();
+
+  boost::mutex mutex;
+  std::vector<int> values;
+  pool.post_task(boost::bind(&append, &mutex, &values, 0), TP_LOW);
+  pool.post_task(boost::bind(&append, &mutex, &values, 1), TP_NORMAL);
+  pool.post_task(boost::bind(&append, &mutex, &values, 2), TP_HIGH);
+  pool.post_task(boost::bind(&append, &mutex, &values, 3), TP_NORMAL);
+  pool.post_task(boost::bind(&append, &mutex, &values, 4), TP_HIGH);
+
+  // The tasks should be executed in priority order, and in posting order within each priority.
+  gate.open();
+  pool.wait_until_idle();
+  BOOST_CHECK(values == std::vector<int>(list_of(2)(4)(1)(3)(0)));
+}
+
+BOOST_AUTO_TEST_CASE(wait_test)
+{
+  boost::mutex mutex;
+  int counter = 0;
+
+  {
+    BoundedThreadPool pool(3, 2, QFS_WAIT);
+    for(int i = 0; i < 100; ++i)
+    {
+      BOOST_CHECK_EQUAL(pool.post_task(boost::bind(&increment, &mutex, &counter)), true);
+    }
+
+    BOOST_CHECK(pool.get_statistics().peakQueueSize <= 2);
+  }
+
+  // Destroying the pool should have executed every task that was posted to it.
+  BOOST_CHECK_EQUAL(counter, 100);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,91 @@
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <boost/bind.hpp>
+
+#include <tvgutil/containers/SPSCPooledQueue.h>
+using namespace tvgutil;
+using namespace tvgutil::pooled_queue;
+
+typedef SPSCPooledQueue<int> Queue;
+
+namespace {
+
+void push_values(Queue *queue, int count)
+{
+  for(int i = 0; i < count; ++i)
+  {
+    Queue::PushHandler_Ptr pushHandler = queue->begin_push();
+    boost::optional<int&> elt = pushHandler->get();
+    if(elt) *elt = i;
+  }
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(test_SPSCPooledQueue)
+
+BOOST_AUTO_TEST_CASE(discard_test)
+{
+  Queue queue(PES_DISCARD);
+  queue.initialise(2);
+  BOOST_CHECK(queue.empty());
+
+  push_values(&queue, 3);
+  BOOST_CHECK_EQUAL(queue.size(), 2);
+  BOOST_CHECK_EQUAL(queue.peek(), 0);
+  queue.pop();
+  BOOST_CHECK_EQUAL(queue.peek(), 1);
+  queue.pop();
+  BOOST_CHECK(queue.empty());
+
+  // The slots should be reusable once the elements that occupied them have been popped.
+  push_values(&queue, 1);
+  BOOST_CHECK_EQUAL(queue.size(), 1);
+  BOOST_CHECK_EQUAL(queue.peek(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(push_handler_copy_test)
+{
+  Queue queue(PES_DISCARD);
+  queue.initialise(2);
+
+  {
+    Queue::PushHandler_Ptr pushHandler = queue.begin_push();
+    *pushHandler->get() = 23;
+    Queue::PushHandler_Ptr copy(pushHandler);
+  }
+
+  // Copying the push handler should not have caused the element to be pushed twice.
+  BOOST_CHECK_EQUAL(queue.size(), 1);
+  BOOST_CHECK_EQUAL(queue.peek(), 23);
+}
+
+BOOST_AUTO_TEST_CASE(unsupported_strategy_test)
+{
+  BOOST_CHECK_THROW(Queue queue(PES_GROW), std::runtime_error);
+  BOOST_CHECK_THROW(Queue queue(PES_REPLACE_RANDOM), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(wait_test)
+{
+  const int count = 100000;
+  Queue queue(PES_WAIT);
+  queue.initialise(4);
+
+  // With the 'wait' strategy, every element pushed by the producer should arrive at the consumer, in order.
+  boost::thread producer(boost::bind(&push_values, &queue, count));
+
+  bool inOrder = true;
+  for(int i = 0; i < count; ++i)
+  {
+    if(queue.peek() != i) inOrder = false;
+    queue.pop();
+  }
+
+  producer.join();
+  BOOST_CHECK(inOrder);
+  BOOST_CHECK(queue.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
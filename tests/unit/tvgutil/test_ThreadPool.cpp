@@ -0,0 +1,158 @@
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <stdexcept>
+
+#include <tvgutil/misc/ThreadPool.h>
+using namespace tvgutil;
+
+namespace {
+
+int add_one(int x)
+{
+  return x + 1;
+}
+
+int forty_two()
+{
+  return 42;
+}
+
+void increment(boost::atomic<int> *counter)
+{
+  ++*counter;
+}
+
+void mark(std::vector<int> *marks, int i)
+{
+  ++(*marks)[i];
+}
+
+void nested_parallel_for(ThreadPool *pool, boost::atomic<int> *counter, int)
+{
+  pool->parallel_for(0, 10, boost::bind(&increment, counter));
+}
+
+void throw_error()
+{
+  throw std::runtime_error("Failed");
+}
+
+void wait_for_gate(boost::atomic<bool> *entered, boost::shared_future<void> gate)
+{
+  *entered = true;
+  gate.wait();
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(test_ThreadPool)
+
+BOOST_AUTO_TEST_CASE(default_thread_count_test)
+{
+  ThreadPool pool;
+  BOOST_CHECK_EQUAL(pool.get_thread_count(), ThreadPool::default_thread_count());
+  BOOST_CHECK(pool.get_thread_count() >= 1);
+}
+
+BOOST_AUTO_TEST_CASE(parallel_for_test)
+{
+  ThreadPool pool(4);
+  std::vector<int> marks(1000, 0);
+  pool.parallel_for(0, 1000, boost::bind(&mark, &marks, _1));
+  for(size_t i = 0, size = marks.size(); i < size; ++i)
+  {
+    BOOST_CHECK_EQUAL(marks[i], 1);
+  }
+
+  // Check that empty ranges and explicit grain sizes are handled correctly.
+  pool.parallel_for(5, 5, boost::bind(&mark, &marks, _1));
+  pool.parallel_for(0, 1000, boost::bind(&mark, &marks, _1), 7);
+  BOOST_CHECK_EQUAL(std::count(marks.begin(), marks.end(), 2), 1000);
+}
+
+BOOST_AUTO_TEST_CASE(nested_parallel_for_test)
+{
+  // Since waiting threads help to execute pending tasks, nesting parallel loops must not deadlock, even with a single thread.
+  for(size_t threadCount = 1; threadCount <= 3; ++threadCount)
+  {
+    ThreadPool pool(threadCount);
+    boost::atomic<int> counter(0);
+    pool.parallel_for(0, 20, boost::bind(&nested_parallel_for, &pool, &counter, _1));
+    BOOST_CHECK_EQUAL(counter, 200);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(post_task_test)
+{
+  boost::atomic<int> counter(0);
+
+  {
+    ThreadPool pool(3);
+    pool.post_task(&throw_error);
+    for(int i = 0; i < 100; ++i) pool.post_task(boost::bind(&increment, &counter));
+  }
+
+  // Destroying the pool should have executed every task that was posted to it.
+  BOOST_CHECK_EQUAL(counter, 100);
+}
+
+BOOST_AUTO_TEST_CASE(submit_test)
+{
+  ThreadPool pool(2);
+
+  boost::unique_future<int> result = pool.submit(&forty_two);
+  BOOST_CHECK_EQUAL(result.get(), 42);
+
+  boost::unique_future<int> continuedResult = pool.submit_then(&forty_two, &add_one);
+  BOOST_CHECK_EQUAL(continuedResult.get(), 43);
+}
+
+BOOST_AUTO_TEST_CASE(task_group_test)
+{
+  ThreadPool pool(2);
+  boost::atomic<int> counter(0);
+
+  ThreadPool::TaskGroup group(pool);
+  for(int i = 0; i < 50; ++i) group.run(boost::bind(&increment, &counter));
+  group.wait();
+  BOOST_CHECK_EQUAL(counter, 50);
+
+  group.run(&throw_error);
+  BOOST_CHECK_THROW(group.wait(), std::runtime_error);
+
+  // The exception should only be rethrown once.
+  group.wait();
+}
+
+BOOST_AUTO_TEST_CASE(task_group_isolation_test)
+{
+  boost::atomic<int> groupCounter(0), unrelatedCounter(0);
+  boost::promise<void> gate;
+
+  {
+    ThreadPool pool(1);
+
+    // Occupy the only thread in the pool, and wait until it has started executing the blocking task.
+    boost::atomic<bool> entered(false);
+    pool.post_task(boost::bind(&wait_for_gate, &entered, gate.get_future().share()));
+    while(!entered) boost::this_thread::yield();
+
+    // Post an unrelated task, which will stay queued because the pool's only thread is blocked.
+    pool.post_task(boost::bind(&increment, &unrelatedCounter));
+
+    // Waiting for a task group should execute the group's own tasks on the calling thread, but not the unrelated task.
+    ThreadPool::TaskGroup group(pool);
+    for(int i = 0; i < 10; ++i) group.run(boost::bind(&increment, &groupCounter));
+    group.wait();
+    BOOST_CHECK_EQUAL(groupCounter, 10);
+    BOOST_CHECK_EQUAL(unrelatedCounter, 0);
+
+    gate.set_value();
+  }
+
+  // Destroying the pool should have executed the unrelated task.
+  BOOST_CHECK_EQUAL(unrelatedCounter, 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()